@@ -8,7 +8,9 @@ out vec4 frag_color;
 
 void main() {
 
-    frag_color = g_LightingEnabled 
-        ? vec4(color.xyz * frag_intensity * g_LightColor.xyz, color.w) 
-        : color;
+#ifdef LIGHTING
+    frag_color = vec4(color.xyz * frag_intensity * g_LightColor.xyz, color.w);
+#else
+    frag_color = color;
+#endif
 }
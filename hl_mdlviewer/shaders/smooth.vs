@@ -1,26 +1,20 @@
 #version 330 core
 
-#include "base.in"
+#include "skinning.in"
 #include "lighting.in"
 
 out float frag_intensity;
 
-uniform bool useFlatShade;
-uniform bool applyBoneTransform;
-uniform bool applyOffsetMatrix;
 uniform float pointSize;
 
 void main() {
     gl_PointSize = pointSize;
 
-    mat4 worldMatrix = g_Model * g_SceneTransform;
-    if (applyBoneTransform)
-        worldMatrix = worldMatrix * g_BoneMatrix;
-    if (applyOffsetMatrix)
-        worldMatrix = worldMatrix * g_BoneOffsetMatrix;
+    mat4 worldMatrix = getWorldMatrix();
         
     gl_Position = g_Projection * g_View * worldMatrix * vec4(position, 1.0);
     
-    if (g_LightingEnabled)
-        frag_intensity = calculateLightingIntensity(mat3(worldMatrix) * normal, useFlatShade);
+#ifdef LIGHTING
+    frag_intensity = calculateLightingIntensity(mat3(worldMatrix) * normal);
+#endif
 }
@@ -6,18 +6,86 @@ in vec2 frag_uv;
 in float frag_intensity;
 out vec4 color;
 
-uniform bool masked;
-uniform vec3 maskColor;
-
+// The texture atlas, and the place of the texture in it:
+// the offset and the size in texels.
 uniform sampler2D myTexture;
+uniform vec4 textureRect;
+
+#ifdef PALETTIZED
+// The texture holds palette indices, and the palette of
+// the texture is a row of this texture.
+uniform sampler2D palette;
+uniform int paletteRow;
+
+// The mip levels of the atlas, each halves the places.
+uniform int numLevels;
+
+// The index of the transparent color of masked textures.
+const int MASK_INDEX = 255;
+
+// The texels are clamped to the texture, as GL_CLAMP_TO_EDGE.
+int paletteIndex(ivec2 texel, int level) {
+    ivec2 offset = ivec2(textureRect.xy) >> level;
+    ivec2 size = max((ivec2(textureRect.zw) + (1 << level) - 1) >> level, ivec2(1));
+    texel = clamp(texel, ivec2(0), size - 1) + offset;
+    return int(texelFetch(myTexture, texel, level).r * 255.0 + 0.5);
+}
+
+vec4 paletteColor(int index) {
+    return texelFetch(palette, ivec2(index, paletteRow), 0);
+}
+
+// Indices cannot be filtered, so the colors are bilinear when
+// magnified, and the nearest of the closest mip level when minified.
+vec4 sampleBilinear(vec2 uv) {
+    vec2 position = uv * textureRect.zw - 0.5;
+
+    ivec2 base = ivec2(floor(position));
+    vec2 f = position - vec2(base);
+
+    vec4 c00 = paletteColor(paletteIndex(base, 0));
+    vec4 c10 = paletteColor(paletteIndex(base + ivec2(1, 0), 0));
+    vec4 c01 = paletteColor(paletteIndex(base + ivec2(0, 1), 0));
+    vec4 c11 = paletteColor(paletteIndex(base + ivec2(1, 1), 0));
+
+    return mix(mix(c00, c10, f.x), mix(c01, c11, f.x), f.y);
+}
+#else
+// The coordinates are clamped half a texel inside the texture, as
+// GL_CLAMP_TO_EDGE, the padding around it covers the filtering.
+vec4 sampleAtlas(vec2 uv) {
+    vec2 size = textureRect.zw;
+    vec2 position = clamp(uv * size, vec2(0.5), size - 0.5);
+    return texture(myTexture, (textureRect.xy + position) / vec2(textureSize(myTexture, 0)));
+}
+#endif
 
 void main() {
 
-    color =  texture(myTexture, frag_uv);
-    
-    if (masked && color.rgb == maskColor)
+#ifdef PALETTIZED
+    vec2 footprint = fwidth(frag_uv * textureRect.zw);
+    float scale = max(footprint.x, footprint.y);
+    bool minified = scale > 1.0;
+    int level = minified ? min(int(log2(scale) + 0.5), numLevels - 1) : 0;
+    ivec2 texel = ivec2(floor(frag_uv * textureRect.zw / float(1 << level)));
+
+#ifdef MASKED
+    if (paletteIndex(texel, level) == MASK_INDEX)
         discard;
-        
-    if (g_LightingEnabled)
-        color = vec4(color.xyz * frag_intensity * g_LightColor.xyz, 1.0f);
+#endif
+
+    color = minified ? paletteColor(paletteIndex(texel, level)) : sampleBilinear(frag_uv);
+#else
+    color = sampleAtlas(frag_uv);
+
+    // The masked texels have an alpha of 0, kept by the mip levels.
+#ifdef MASKED
+    if (color.a < 0.5)
+        discard;
+#endif
+#endif
+
+#ifdef LIGHTING
+    color = vec4(color.xyz * frag_intensity * g_LightColor.xyz, 1.0f);
+#endif
 }
@@ -0,0 +1,96 @@
+/**
+* \file async_file_writer.cpp
+* \brief Implementation for the asynchronous file writer class.
+*/
+
+#include "pch.h"
+#include "async_file_writer.h"
+
+namespace hl_mdlviewer {
+
+AsyncFileWriter::AsyncFileWriter(size_t max_pending_writes) :
+    mutex_(),
+    queue_not_empty_(),
+    queue_not_full_(),
+    idle_(),
+    queue_(),
+    max_pending_writes_(std::max(max_pending_writes, static_cast<size_t>(1))),
+    writing_(false),
+    stopping_(false),
+    thread_()
+{
+    thread_ = std::thread(&AsyncFileWriter::writer_main, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+
+    queue_not_empty_.notify_one();
+    thread_.join();
+}
+
+void AsyncFileWriter::write(WriteFunction write_function, CompletionFunction completion_function)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_not_full_.wait(lock, [this] { return queue_.size() < max_pending_writes_; });
+
+    queue_.push_back({ std::move(write_function), std::move(completion_function) });
+
+    lock.unlock();
+    queue_not_empty_.notify_one();
+}
+
+void AsyncFileWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return queue_.empty() && !writing_; });
+}
+
+void AsyncFileWriter::writer_main()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for (;;)
+    {
+        queue_not_empty_.wait(lock, [this] { return !queue_.empty() || stopping_; });
+
+        // Pending writes are still done when stopping.
+        if (queue_.empty())
+            break;
+
+        PendingWrite pending_write = std::move(queue_.front());
+        queue_.pop_front();
+        writing_ = true;
+
+        lock.unlock();
+        queue_not_full_.notify_one();
+
+        std::string error;
+
+        try
+        {
+            pending_write.write();
+        }
+        catch (const std::exception& e)
+        {
+            error = e.what();
+            if (error.empty())
+                error = "Unknown write error";
+        }
+
+        if (pending_write.completion)
+            pending_write.completion(error);
+
+        lock.lock();
+        writing_ = false;
+
+        if (queue_.empty())
+            idle_.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,73 @@
+/**
+* \file async_file_writer.h
+* \brief Declaration for the asynchronous file writer class.
+*/
+
+#ifndef HLMDLVIEWER_ASYNC_FILE_WRITER_H_
+#define HLMDLVIEWER_ASYNC_FILE_WRITER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace hl_mdlviewer {
+
+/** \brief Runs file writes, including their encoding, on a background
+* thread, in submission order.
+*
+* The queue is bounded so that producers faster than the disk block
+* instead of accumulating images in memory.
+*/
+class AsyncFileWriter
+{
+public:
+    /** \brief Encode and write a file. Throws on failure. */
+    using WriteFunction = std::function<void()>;
+
+    /** \brief Called on the writer thread once a write is done, with an
+    * empty string on success or the error message otherwise. */
+    using CompletionFunction = std::function<void(const std::string& error)>;
+
+    explicit AsyncFileWriter(size_t max_pending_writes = 8);
+
+    /** \brief Wait for the pending writes and stop the thread. */
+    ~AsyncFileWriter();
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    /** \brief Queue a write. Blocks while the queue is full. */
+    void write(WriteFunction write_function, CompletionFunction completion_function = nullptr);
+
+    /** \brief Wait until all queued writes are done. */
+    void flush();
+
+private:
+
+    void writer_main();
+
+    struct PendingWrite
+    {
+        WriteFunction write;
+        CompletionFunction completion;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable queue_not_empty_;
+    std::condition_variable queue_not_full_;
+    std::condition_variable idle_;
+
+    std::deque<PendingWrite> queue_;
+    size_t max_pending_writes_;
+    bool writing_;
+    bool stopping_;
+
+    std::thread thread_;
+};
+
+}
+
+#endif // HLMDLVIEWER_ASYNC_FILE_WRITER_H_
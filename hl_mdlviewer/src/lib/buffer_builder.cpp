@@ -5,10 +5,16 @@
 
 #include "pch.h"
 #include "buffer_builder.h"
+#include "vertex_cache_optimizer.h"
+#include <cstring>
 
 namespace hl_mdlviewer {
 
-BufferBuilder::BufferBuilder()
+BufferBuilder::BufferBuilder() :
+    vertices_(),
+    indices_(),
+    optimize_meshes_(false),
+    statistics_()
 {
 }
 
@@ -22,6 +28,9 @@ void BufferBuilder::append(
     stride.indice_start_index = static_cast<int>(indices_.size());
     stride.num_vertices = static_cast<int>(vertices.size());
     stride.num_indices = static_cast<int>(indices.size());
+    stride.index_size = sizeof(unsigned int);
+    stride.index_offset = indices_.size() * sizeof(unsigned int);
+    stride.base_vertex = 0;
 
     for (auto it = vertices.begin(); it != vertices.end(); ++it)
         vertices_.push_back(*it);
@@ -45,6 +54,9 @@ void BufferBuilder::append_indices(
     stride.indice_start_index = static_cast<int>(indices_.size());
     stride.num_vertices = previous_stride.num_vertices;
     stride.num_indices = static_cast<int>(indices.size());
+    stride.index_size = sizeof(unsigned int);
+    stride.index_offset = indices_.size() * sizeof(unsigned int);
+    stride.base_vertex = 0;
 
     for (auto it = indices.begin(); it != indices.end(); ++it)
     {
@@ -55,6 +67,137 @@ void BufferBuilder::append_indices(
     }
 }
 
+void BufferBuilder::append_triangles(
+    const std::vector<glvertex>& vertices,
+    const std::vector<unsigned int>& indices,
+    MeshBufferStride& stride)
+{
+    if (!optimize_meshes_ || indices.size() % 3 != 0)
+    {
+        append(vertices, indices, PRIMITIVE_RESTART_INDEX, stride);
+        return;
+    }
+
+    std::vector<glvertex> optimized_vertices(vertices);
+    std::vector<unsigned int> optimized_indices(indices);
+
+    statistics_.num_triangles += indices.size() / 3;
+    statistics_.num_cache_misses_before += count_vertex_cache_misses(optimized_indices);
+
+    optimize_vertex_cache(optimized_indices, optimized_vertices.size());
+    optimize_vertex_fetch(optimized_vertices, optimized_indices);
+
+    statistics_.num_cache_misses_after += count_vertex_cache_misses(optimized_indices);
+    ++statistics_.num_strides;
+
+    if (optimized_vertices.size() <= USHRT_MAX)
+    {
+        append_short_indices(optimized_vertices, optimized_indices, stride);
+        ++statistics_.num_short_strides;
+    }
+    else
+    {
+        append(optimized_vertices, optimized_indices, PRIMITIVE_RESTART_INDEX, stride);
+    }
+}
+
+void BufferBuilder::append_short_indices(
+    const std::vector<glvertex>& vertices,
+    const std::vector<unsigned int>& indices,
+    MeshBufferStride& stride)
+{
+    stride.vertex_start_index = static_cast<int>(vertices_.size());
+    stride.indice_start_index = static_cast<int>(indices_.size());
+    stride.num_vertices = static_cast<int>(vertices.size());
+    stride.num_indices = static_cast<int>(indices.size());
+    stride.index_size = sizeof(unsigned short);
+    stride.index_offset = indices_.size() * sizeof(unsigned int);
+
+    // The "indices" stay relative to the mesh, the first vertex
+    // is added back when drawing.
+    stride.base_vertex = stride.vertex_start_index;
+
+    vertices_.insert(vertices_.end(), vertices.begin(), vertices.end());
+
+    push_short_indices(indices);
+}
+
+void BufferBuilder::push_short_indices(const std::vector<unsigned int>& indices)
+{
+    // Pack two 16-bit "indices" per element, in memory order. An odd
+    // count is padded so that the next stride stays aligned.
+    for (size_t i = 0; i < indices.size(); i += 2)
+    {
+        const unsigned short first = static_cast<unsigned short>(indices[i]);
+        const unsigned short second = i + 1 < indices.size()
+            ? static_cast<unsigned short>(indices[i + 1])
+            : 0;
+
+        unsigned int packed = 0;
+        unsigned short pair[2] = { first, second };
+        std::memcpy(&packed, pair, sizeof(packed));
+        indices_.push_back(packed);
+    }
+}
+
+void BufferBuilder::append_lod_indices(
+    const MeshBufferStride& stride,
+    const std::vector<unsigned int>& indices,
+    MeshBufferStride& lod_stride)
+{
+    lod_stride = stride;
+    lod_stride.indice_start_index = static_cast<int>(indices_.size());
+    lod_stride.num_indices = static_cast<int>(indices.size());
+    lod_stride.index_offset = indices_.size() * sizeof(unsigned int);
+
+    if (stride.index_size == sizeof(unsigned short))
+    {
+        push_short_indices(indices);
+    }
+    else
+    {
+        for (unsigned int index : indices)
+            indices_.push_back(stride.vertex_start_index + index);
+    }
+}
+
+void BufferBuilder::get_triangles(
+    const MeshBufferStride& stride,
+    std::vector<glvertex>& vertices,
+    std::vector<unsigned int>& indices) const
+{
+    vertices.assign(vertices_.begin() + stride.vertex_start_index,
+        vertices_.begin() + stride.vertex_start_index + stride.num_vertices);
+
+    indices.resize(stride.num_indices);
+
+    if (stride.index_size == sizeof(unsigned short))
+    {
+        std::vector<unsigned short> short_indices(stride.num_indices + 1);
+        std::memcpy(short_indices.data(), &indices_[stride.indice_start_index],
+            ((stride.num_indices + 1) / 2) * sizeof(unsigned int));
+
+        std::copy_n(short_indices.begin(), stride.num_indices, indices.begin());
+    }
+    else
+    {
+        for (int i = 0; i < stride.num_indices; ++i)
+            indices[i] = indices_[stride.indice_start_index + i] - stride.vertex_start_index;
+    }
+}
+
+bool BufferBuilder::can_pack_vertices() const
+{
+    return std::all_of(vertices_.begin(), vertices_.end(), can_pack_vertex);
+}
+
+void BufferBuilder::get_packed_vertices(std::vector<glvertex_packed>& vertices) const
+{
+    vertices.resize(vertices_.size());
+    for (size_t i = 0; i < vertices_.size(); ++i)
+        vertices[i] = pack_vertex(vertices_[i]);
+}
+
 void BufferBuilder::reserve(const size_t num_vertices, const size_t num_indices)
 {
     vertices_.reserve(num_vertices);
@@ -12,6 +12,40 @@
 
 namespace hl_mdlviewer {
 
+/** \brief Statistics gathered by the mesh optimization pass. */
+struct BufferBuilderStatistics
+{
+    BufferBuilderStatistics() :
+        num_triangles(0),
+        num_cache_misses_before(0),
+        num_cache_misses_after(0),
+        num_strides(0),
+        num_short_strides(0)
+    {
+    }
+
+    /** \brief Get the average cache miss ratio, the number of
+    *          transformed vertices per triangle, before optimization. */
+    inline float acmr_before() const {
+        return num_triangles ? static_cast<float>(num_cache_misses_before) / num_triangles : 0.0f;
+    }
+
+    /** \brief Get the average cache miss ratio after optimization. */
+    inline float acmr_after() const {
+        return num_triangles ? static_cast<float>(num_cache_misses_after) / num_triangles : 0.0f;
+    }
+
+    size_t num_triangles;
+    size_t num_cache_misses_before;
+    size_t num_cache_misses_after;
+
+    /** \brief The number of triangle strides. */
+    size_t num_strides;
+
+    /** \brief The number of triangle strides using 16-bit "indices". */
+    size_t num_short_strides;
+};
+
 /** \brief A convinient way to combine multiple set of vertices and
 * indices to form a single buffer. */
 class BufferBuilder
@@ -31,6 +65,20 @@ public:
         const unsigned int primitive_restart_index,
         MeshBufferStride& stride);
 
+    /** \brief Append a triangle list to the buffer.
+    *
+    * When mesh optimization is enabled, triangles are reordered for the
+    * post-transform vertex cache, vertices are reordered for fetch
+    * locality, and 16-bit "indices" are used if the mesh has fewer
+    * than 65536 vertices.
+    * \param[in] vertices A list of vertices to append to the buffer.
+    * \param[in] indices A triangle list to append to the buffer.
+    * \param[out] stride The stride info.
+    */
+    void append_triangles(const std::vector<glvertex>& vertices,
+        const std::vector<unsigned int>& indices,
+        MeshBufferStride& stride);
+
     /** \brief Append \p indices to the buffer while reusing the vertices
     *          stride info from \p previous_stride.
     * \param[in] previous_stride A stride from which the vertex stride info 
@@ -45,9 +93,45 @@ public:
         const unsigned int primitive_restart_index,
         MeshBufferStride& stride);
 
+    /** \brief Append another triangle list over the vertices of \p stride,
+    *          i.e. a simplified version of the mesh.
+    * \param[in] stride The stride whose vertices are used.
+    * \param[in] indices A triangle list, relative to the first vertex of \p stride.
+    * \param[out] lod_stride The stride info, with the same "index" size as \p stride.
+    */
+    void append_lod_indices(const MeshBufferStride& stride,
+        const std::vector<unsigned int>& indices,
+        MeshBufferStride& lod_stride);
+
+    /** \brief Get back the vertices and triangles of a stride.
+    * \param[in] stride The stride.
+    * \param[out] vertices The vertices of the stride.
+    * \param[out] indices The "indices", relative to the first vertex of \p stride.
+    */
+    void get_triangles(const MeshBufferStride& stride,
+        std::vector<glvertex>& vertices,
+        std::vector<unsigned int>& indices) const;
+
     void reserve(const size_t num_vertices, const size_t num_indices);
 
+    inline void set_optimize_meshes(bool enabled) { optimize_meshes_ = enabled; }
+    inline bool optimize_meshes() const { return optimize_meshes_; }
+
+    const BufferBuilderStatistics& statistics() const { return statistics_; }
+
     const std::vector<glvertex>& get_vertices() const { return vertices_; }
+
+    /** \brief Check whether the vertices can be converted to
+    *          \ref glvertex_packed without losing data.
+    *          \see can_pack_vertex */
+    bool can_pack_vertices() const;
+
+    /** \brief Convert the vertices to the packed vertex layout.
+    * \param[out] vertices The packed vertices.
+    */
+    void get_packed_vertices(std::vector<glvertex_packed>& vertices) const;
+    /** \brief Get the index buffer content. Strides with 16-bit "indices"
+    *          are packed two per element. */
     const std::vector<unsigned int>& get_indices() const { return indices_; }
 
 private:
@@ -55,8 +139,19 @@ private:
     /** \brief The resulting vertices. */
     std::vector<glvertex> vertices_;
 
+    void append_short_indices(const std::vector<glvertex>& vertices,
+        const std::vector<unsigned int>& indices,
+        MeshBufferStride& stride);
+
+    /** \brief Pack 16-bit "indices" two per element at the end of the buffer. */
+    void push_short_indices(const std::vector<unsigned int>& indices);
+
     /** \brief The resulting indices. */
     std::vector<unsigned int> indices_;
+
+    bool optimize_meshes_;
+
+    BufferBuilderStatistics statistics_;
 };
 
 }
@@ -0,0 +1,53 @@
+/**
+* \file content_hash.cpp
+* \brief Implementation for the content hash functions.
+*/
+
+#include "pch.h"
+#include "content_hash.h"
+#include <fstream>
+
+namespace hl_mdlviewer {
+
+uint64_t hash_bytes_64(const void* data, size_t size, uint64_t hash)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+bool hash_file_64(const std::string& file_path, uint64_t& hash)
+{
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    std::vector<char> chunk(64 * 1024);
+
+    while (file)
+    {
+        file.read(chunk.data(), chunk.size());
+        hash = hash_bytes_64(chunk.data(), static_cast<size_t>(file.gcount()), hash);
+    }
+
+    return !file.bad();
+}
+
+std::string hash_to_string(uint64_t hash)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    std::string result(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4)
+        result[i] = digits[hash & 0xF];
+
+    return result;
+}
+
+}
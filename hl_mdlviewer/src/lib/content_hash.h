@@ -0,0 +1,40 @@
+/**
+* \file content_hash.h
+* \brief Declaration for the content hash functions.
+*/
+
+#ifndef HLMDLVIEWER_CONTENT_HASH_H_
+#define HLMDLVIEWER_CONTENT_HASH_H_
+
+#include <cstdint>
+#include <string>
+
+namespace hl_mdlviewer {
+
+const uint64_t FNV1A_64_OFFSET_BASIS = 14695981039346656037ull;
+
+/** \brief Hash bytes with 64-bit FNV-1a.
+* \param[in] data The bytes.
+* \param[in] size The number of bytes.
+* \param[in] hash The hash to continue, to hash several buffers as one.
+* \return The hash.
+*/
+uint64_t hash_bytes_64(const void* data, size_t size, uint64_t hash = FNV1A_64_OFFSET_BASIS);
+
+inline uint64_t hash_string_64(const std::string& value, uint64_t hash = FNV1A_64_OFFSET_BASIS) {
+    return hash_bytes_64(value.data(), value.size(), hash);
+}
+
+/** \brief Continue a hash with the contents of a file.
+* \param[in] file_path The file.
+* \param[in, out] hash The hash to continue.
+* \return true if the file could be read; false otherwise.
+*/
+bool hash_file_64(const std::string& file_path, uint64_t& hash);
+
+/** \brief Format a hash as 16 hexadecimal digits. */
+std::string hash_to_string(uint64_t hash);
+
+}
+
+#endif // HLMDLVIEWER_CONTENT_HASH_H_
@@ -5,66 +5,555 @@
 
 #include "pch.h"
 #include "file_system.h"
+#include <cctype>
+#include <cstring>
 #include <filesystem>
 
+#ifdef __linux__
+#define HLMDLVIEWER_FILE_SYSTEM_INOTIFY
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif defined _WIN32
+#define HLMDLVIEWER_FILE_SYSTEM_CHANGE_NOTIFICATION
+#endif
+
 namespace fs = std::filesystem;
 
 namespace hl_mdlviewer {
 
+namespace {
+
+/** \brief Get the key of a path in the tables: lower case, with '/'
+*          separators and without "." and ".." components.
+*/
+std::string normalize_path(const std::string& path)
+{
+    std::vector<std::string> components;
+    std::string component;
+
+    for (size_t i = 0; i <= path.size(); ++i)
+    {
+        const char c = i < path.size() ? path[i] : '/';
+        if (c != '/' && c != '\\')
+        {
+            component += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            continue;
+        }
+
+        if (component == "..")
+        {
+            if (!components.empty() && components.back() != "..")
+                components.pop_back();
+            else
+                components.push_back(component);
+        }
+        else if (!component.empty() && component != ".")
+        {
+            components.push_back(component);
+        }
+
+        component.clear();
+    }
+
+    std::string result;
+    for (const std::string& name : components)
+    {
+        if (!result.empty())
+            result += '/';
+        result += name;
+    }
+
+    return result;
+}
+
+struct ArchiveEntry
+{
+    std::string name;
+    size_t offset;
+    size_t size;
+};
+
+int32_t read_int32(const uint8_t* data)
+{
+    // Archives are little-endian, like the platforms we run on.
+    int32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+/** \brief Get a fixed size name, which is only null terminated when shorter. */
+std::string read_name(const uint8_t* data, size_t max_length)
+{
+    const char* name = reinterpret_cast<const char*>(data);
+    return std::string(name, std::find(name, name + max_length, '\0'));
+}
+
+/** \brief Read the directory of a Quake or Half-Life PAK archive. */
+void read_pak_directory(const MappedFile& archive, std::vector<ArchiveEntry>& entries)
+{
+    const size_t HEADER_SIZE = 12;
+    const size_t ENTRY_SIZE = 64;
+    const size_t NAME_LENGTH = 56;
+
+    const uint8_t* data = archive.data();
+    const size_t directory_offset = static_cast<uint32_t>(read_int32(data + 4));
+    const size_t directory_size = static_cast<uint32_t>(read_int32(data + 8));
+    if (directory_offset < HEADER_SIZE || directory_size % ENTRY_SIZE != 0 ||
+        directory_offset > archive.size() || directory_size > archive.size() - directory_offset)
+        throw std::runtime_error("Invalid PAK directory in " + archive.file_path() + ".");
+
+    entries.resize(directory_size / ENTRY_SIZE);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const uint8_t* entry = data + directory_offset + i * ENTRY_SIZE;
+        entries[i].name = read_name(entry, NAME_LENGTH);
+        entries[i].offset = static_cast<uint32_t>(read_int32(entry + NAME_LENGTH));
+        entries[i].size = static_cast<uint32_t>(read_int32(entry + NAME_LENGTH + 4));
+    }
+}
+
+/** \brief Read the directory of a Half-Life WAD3 texture archive. The
+*          entries are named after their lumps.
+*/
+void read_wad_directory(const MappedFile& archive, std::vector<ArchiveEntry>& entries)
+{
+    const size_t HEADER_SIZE = 12;
+    const size_t LUMP_SIZE = 32;
+    const size_t NAME_LENGTH = 16;
+
+    const uint8_t* data = archive.data();
+    const size_t num_lumps = static_cast<uint32_t>(read_int32(data + 4));
+    const size_t directory_offset = static_cast<uint32_t>(read_int32(data + 8));
+    if (directory_offset < HEADER_SIZE || directory_offset > archive.size() ||
+        num_lumps > (archive.size() - directory_offset) / LUMP_SIZE)
+        throw std::runtime_error("Invalid WAD directory in " + archive.file_path() + ".");
+
+    entries.reserve(num_lumps);
+    for (size_t i = 0; i < num_lumps; ++i)
+    {
+        const uint8_t* lump = data + directory_offset + i * LUMP_SIZE;
+
+        // Compressed lumps cannot be viewed in place, the game never made any.
+        const uint8_t compression = lump[13];
+        if (compression != 0)
+            continue;
+
+        ArchiveEntry entry;
+        entry.offset = static_cast<uint32_t>(read_int32(lump));
+        entry.size = static_cast<uint32_t>(read_int32(lump + 4));
+        entry.name = read_name(lump + 16, NAME_LENGTH);
+        entries.push_back(std::move(entry));
+    }
+}
+
+void read_archive_directory(const MappedFile& archive, std::vector<ArchiveEntry>& entries)
+{
+    if (archive.size() >= 12 && std::memcmp(archive.data(), "PACK", 4) == 0)
+        read_pak_directory(archive, entries);
+    else if (archive.size() >= 12 && std::memcmp(archive.data(), "WAD3", 4) == 0)
+        read_wad_directory(archive, entries);
+    else
+        throw std::runtime_error("Unknown archive format of " + archive.file_path() + ".");
+
+    for (const ArchiveEntry& entry : entries)
+    {
+        if (entry.offset > archive.size() || entry.size > archive.size() - entry.offset)
+            throw std::runtime_error("Entry " + entry.name + " is out of " + archive.file_path() + ".");
+    }
+}
+
+}
+
+FileView::FileView() :
+    file_(),
+    data_(nullptr),
+    size_(0)
+{
+}
+
+FileView::FileView(std::shared_ptr<const MappedFile> file, size_t offset, size_t size) :
+    file_(std::move(file)),
+    data_(file_->data() + offset),
+    size_(size)
+{
+}
+
 FileSystem::FileSystem() :
-    search_paths_()
+    mounts_(),
+    current_directory_files_(),
+    current_directory_(),
+    watch_descriptor_(-1),
+    watched_directories_(),
+    watch_changes_(false),
+    mutex_()
+{
+}
+
+FileSystem::~FileSystem()
 {
+    set_watch_changes(false);
 }
 
-void FileSystem::add_search_path(const char* path)
+void FileSystem::add_search_path(const char* path, int priority)
 {
-    search_paths_.push_back(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    insert_mount(path, priority);
+}
+
+void FileSystem::add_archive(const char* path, int priority, const char* root)
+{
+    auto archive = std::make_shared<const MappedFile>(path);
+
+    std::vector<ArchiveEntry> entries;
+    read_archive_directory(*archive, entries);
+
+    std::string prefix = normalize_path(root);
+    if (!prefix.empty())
+        prefix += '/';
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Mount& mount = insert_mount(path, priority);
+    mount.archive = archive;
+    mount.indexed = true;
+
+    for (const ArchiveEntry& entry : entries)
+    {
+        const std::string name = normalize_path(entry.name);
+        if (name.compare(0, prefix.size(), prefix) != 0)
+            continue;
+
+        add_entry(mount, name.substr(prefix.size()), FileEntry{ std::string(), entry.offset, entry.size, 0 });
+    }
 }
 
-bool FileSystem::find_file(const char* file_name, 
+bool FileSystem::find_file(const char* file_name,
     std::string& full_file_path,
     SearchFlags search_flags)
 {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    process_changes();
+
     // Start by checking for the file at the root of the current directory.
-    fs::path path(fs::current_path());
-    path.append(file_name);
+    if (find_in_current_directory(file_name, full_file_path))
+        return true;
+
+    const Mount* mount;
+    const FileEntry* entry = find_entry(file_name, search_flags, false, mount);
+    if (!entry)
+        return false;
+
+    full_file_path = entry->path;
+    return true;
+}
+
+bool FileSystem::open_file(const char* file_name,
+    FileView& view,
+    SearchFlags search_flags)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    process_changes();
+
+    const auto map_file = [&view](const std::string& file_path) {
+        auto file = std::make_shared<const MappedFile>(file_path);
+        view = FileView(file, 0, file->size());
+    };
+
+    std::string file_path;
+    if (find_in_current_directory(file_name, file_path))
+    {
+        map_file(file_path);
+        return true;
+    }
+
+    const Mount* mount;
+    const FileEntry* entry = find_entry(file_name, search_flags, true, mount);
+    if (!entry)
+        return false;
+
+    // Archive entries are views of the archive mapping.
+    if (mount->archive)
+        view = FileView(mount->archive, entry->offset, entry->size);
+    else
+        map_file(entry->path);
 
-    if (fs::exists(path))
+    return true;
+}
+
+void FileSystem::invalidate()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (auto& mount : mounts_)
+        mount.indexed = mount.indexed && mount.archive;
+
+    current_directory_files_.clear();
+}
+
+bool FileSystem::set_watch_changes(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+#ifdef HLMDLVIEWER_FILE_SYSTEM_INOTIFY
+    if (enabled == (watch_descriptor_ >= 0))
+        return true;
+
+    if (enabled)
     {
-        full_file_path = path.string();
+        watch_descriptor_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (watch_descriptor_ < 0)
+            return false;
+    }
+    else
+    {
+        // Closing the descriptor removes all of its watches.
+        close(watch_descriptor_);
+        watch_descriptor_ = -1;
+        watched_directories_.clear();
+    }
+
+    // The folders to watch are gathered during the scan.
+    for (auto& mount : mounts_)
+    {
+        mount.watches.clear();
+        mount.indexed = mount.indexed && mount.archive;
+    }
+
+    return true;
+#elif defined HLMDLVIEWER_FILE_SYSTEM_CHANGE_NOTIFICATION
+    if (enabled == watch_changes_)
         return true;
+
+    watch_changes_ = enabled;
+
+    // The folders to watch get their notification during the scan.
+    for (auto& mount : mounts_)
+    {
+        remove_watches(mount);
+        mount.indexed = mount.indexed && mount.archive;
+    }
+
+    return true;
+#else
+    return !enabled;
+#endif
+}
+
+FileSystem::Mount& FileSystem::insert_mount(const char* path, int priority)
+{
+    auto position = std::find_if(mounts_.begin(), mounts_.end(),
+        [priority](const Mount& mount) { return mount.priority < priority; });
+
+    Mount& mount = *mounts_.emplace(position);
+    mount.path = path;
+    mount.priority = priority;
+    mount.indexed = false;
+    mount.change_notification = nullptr;
+    return mount;
+}
+
+void FileSystem::add_entry(Mount& mount, const std::string& relative_path, const FileEntry& entry)
+{
+    // Files that only differ in case keep the first one found.
+    mount.files.emplace(relative_path, entry);
+
+    // The same file relative to each of its parent folders. The closest
+    // to the mount wins.
+    FileEntry nested_entry = entry;
+    nested_entry.depth = 0;
+    for (size_t pos = relative_path.find('/'); pos != std::string::npos; pos = relative_path.find('/', pos + 1))
+    {
+        ++nested_entry.depth;
+
+        auto result = mount.nested_files.emplace(relative_path.substr(pos + 1), nested_entry);
+        if (!result.second && result.first->second.depth > nested_entry.depth)
+            result.first->second = nested_entry;
     }
+}
 
-    // Look for the file using all search paths.
-    for (auto& search_path : search_paths_)
+const FileSystem::FileEntry* FileSystem::find_entry(const char* file_name, SearchFlags search_flags, bool archives,
+    const Mount*& mount)
+{
+    const std::string key = normalize_path(file_name);
+
+    // Look for the file using all mounts.
+    for (auto& candidate : mounts_)
     {
-        path.clear();
-        path.append(search_path);
-        path.append(file_name);
-        if (fs::exists(path))
-        {
-            full_file_path = path.string();
-            return true;
-        }
+        if (candidate.archive && !archives)
+            continue;
+
+        if (!candidate.indexed)
+            index_search_path(candidate);
+
+        mount = &candidate;
+
+        auto file = candidate.files.find(key);
+        if (file != candidate.files.end())
+            return &file->second;
 
         // If allowed to search recursively in all sub folders, do so.
         if (search_flags & SearchFlags::Recursive)
         {
-            for (auto& sub_directory : fs::recursive_directory_iterator(search_path))
+            auto nested_file = candidate.nested_files.find(key);
+            if (nested_file != candidate.nested_files.end())
+                return &nested_file->second;
+        }
+    }
+
+    mount = nullptr;
+    return nullptr;
+}
+
+void FileSystem::index_search_path(Mount& mount)
+{
+    mount.files.clear();
+    mount.nested_files.clear();
+    remove_watches(mount);
+
+    std::vector<std::string> directories = { mount.path };
+    const fs::path root(mount.path);
+
+    std::error_code error;
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, error);
+    for (; !error && it != fs::recursive_directory_iterator(); it.increment(error))
+    {
+        if (it->is_directory(error))
+        {
+            directories.push_back(it->path().string());
+            continue;
+        }
+
+        add_entry(mount, normalize_path(it->path().lexically_relative(root).generic_string()),
+            FileEntry{ it->path().string(), 0, 0, 0 });
+    }
+
+    add_watches(mount, directories);
+
+    mount.indexed = true;
+}
+
+void FileSystem::add_watches(Mount& mount, const std::vector<std::string>& directories)
+{
+#ifdef HLMDLVIEWER_FILE_SYSTEM_INOTIFY
+    if (watch_descriptor_ < 0)
+        return;
+
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+    // Folders past the watch limit of the user are not watched.
+    for (const std::string& directory : directories)
+    {
+        const int watch = inotify_add_watch(watch_descriptor_, directory.c_str(), mask);
+        if (watch < 0)
+            continue;
+
+        mount.watches.push_back(watch);
+        watched_directories_[watch] = &mount;
+    }
+#elif defined HLMDLVIEWER_FILE_SYSTEM_CHANGE_NOTIFICATION
+    (void)directories;
+    if (!watch_changes_)
+        return;
+
+    // A single notification covers the sub folders.
+    const HANDLE notification = FindFirstChangeNotificationA(mount.path.c_str(), TRUE,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME);
+    if (notification != INVALID_HANDLE_VALUE)
+        mount.change_notification = notification;
+#else
+    (void)mount;
+    (void)directories;
+#endif
+}
+
+void FileSystem::remove_watches(Mount& mount)
+{
+#ifdef HLMDLVIEWER_FILE_SYSTEM_INOTIFY
+    for (int watch : mount.watches)
+    {
+        inotify_rm_watch(watch_descriptor_, watch);
+        watched_directories_.erase(watch);
+    }
+#elif defined HLMDLVIEWER_FILE_SYSTEM_CHANGE_NOTIFICATION
+    if (mount.change_notification)
+        FindCloseChangeNotification(mount.change_notification);
+    mount.change_notification = nullptr;
+#endif
+
+    mount.watches.clear();
+}
+
+void FileSystem::process_changes()
+{
+#ifdef HLMDLVIEWER_FILE_SYSTEM_INOTIFY
+    if (watch_descriptor_ < 0)
+        return;
+
+    alignas(inotify_event) char buffer[4096];
+
+    ssize_t length;
+    while ((length = read(watch_descriptor_, buffer, sizeof(buffer))) > 0)
+    {
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            // Events were lost, anything may have changed.
+            if (event->mask & IN_Q_OVERFLOW)
             {
-                path.clear();
-                path.append(sub_directory.path().string());
-                path.append(file_name);
-                if (fs::exists(path))
-                {
-                    full_file_path = path.string();
-                    return true;
-                }
+                for (auto& mount : mounts_)
+                    mount.indexed = mount.indexed && mount.archive;
+                continue;
             }
+
+            auto directory = watched_directories_.find(event->wd);
+            if (directory != watched_directories_.end())
+                directory->second->indexed = false;
         }
     }
+#elif defined HLMDLVIEWER_FILE_SYSTEM_CHANGE_NOTIFICATION
+    // The notification stays signaled until the folder is scanned again,
+    // which replaces it.
+    for (auto& mount : mounts_)
+    {
+        if (mount.change_notification && WaitForSingleObject(mount.change_notification, 0) == WAIT_OBJECT_0)
+            mount.indexed = false;
+    }
+#endif
+}
+
+bool FileSystem::find_in_current_directory(const std::string& file_name, std::string& full_file_path)
+{
+    // The current directory is not scanned, it may be any folder of the
+    // user. Only the names looked up are remembered.
+    std::error_code error;
+    const fs::path current_path = fs::current_path(error);
+    if (error)
+        return false;
+
+    if (current_path.string() != current_directory_)
+    {
+        current_directory_ = current_path.string();
+        current_directory_files_.clear();
+    }
+
+    auto file = current_directory_files_.find(file_name);
+    if (file == current_directory_files_.end())
+    {
+        const fs::path path = current_path / file_name;
+        file = current_directory_files_.emplace(file_name,
+            fs::exists(path, error) ? path.string() : std::string()).first;
+    }
+
+    if (file->second.empty())
+        return false;
 
-    return false;
+    full_file_path = file->second;
+    return true;
 }
 
 }
@@ -8,14 +8,50 @@
 
 #include <list>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "mapped_file.h"
 
 namespace hl_mdlviewer {
 
-/** \brief A class that can perform various IO file operations. */
+/** \brief A read-only view of the contents of a file, in memory.
+*
+* Loose files and archive entries alike are memory-mapped, nothing is
+* copied. The view keeps its file mapped while it is alive.
+*/
+class FileView
+{
+public:
+    FileView();
+    FileView(std::shared_ptr<const MappedFile> file, size_t offset, size_t size);
+
+    inline const uint8_t* data() const { return data_; }
+    inline size_t size() const { return size_; }
+    inline bool empty() const { return size_ == 0; }
+
+private:
+    std::shared_ptr<const MappedFile> file_;
+    const uint8_t* data_;
+    size_t size_;
+};
+
+/** \brief A class that can perform various IO file operations.
+*
+* Files are searched in mounts: folders and archives, ordered by priority.
+* Each folder is scanned once, on the first lookup after it was added or
+* invalidated, into a table of its files. Lookups are then answered from
+* memory, without touching the disk. File names are matched without regard
+* to case, and with either path separator, like the game does.
+*/
 class FileSystem
 {
 public:
     FileSystem();
+    FileSystem(const FileSystem&) = delete;
+    ~FileSystem();
 
     enum SearchFlags
     {
@@ -23,14 +59,129 @@ public:
         Recursive = 1, // Allow search in sub folders.
     };
 
-    void add_search_path(const char* path);
+    /** \brief Mount a folder.
+    * \param[in] path The folder.
+    * \param[in] priority Mounts of a higher priority are searched first,
+    *            mounts of the same priority in the order they were added.
+    */
+    void add_search_path(const char* path, int priority = 0);
+
+    /** \brief Mount a PAK or WAD3 archive. The archive is mapped and its
+    *          directory read at once. Throws if it is not a valid archive.
+    *
+    * The entries of a WAD3 archive are named after their lumps.
+    * \param[in] path The archive file.
+    * \param[in] priority See \ref add_search_path.
+    * \param[in] root Only the entries in this folder of the archive are
+    *            mounted, relative to it. Empty for all entries.
+    */
+    void add_archive(const char* path, int priority = 0, const char* root = "");
 
+    /** \brief Find a file on disk, in the current directory then in the
+    *          mounted folders. Archive entries are not files on disk, see
+    *          \ref open_file.
+    * \param[in] file_name The file name, relative to a mount.
+    * \param[out] full_file_path The path to the file on disk.
+    * \param[in] search_flags With \ref SearchFlags::Recursive, the file name
+    *            may also be relative to any sub folder of a mount.
+    * \return false if no such file exists.
+    */
     bool find_file(const char* file_name,
         std::string& full_file_path,
         SearchFlags search_flags = SearchFlags::None);
 
+    /** \brief Map a file, from the current directory, a mounted folder or
+    *          an archive. Throws if the file exists but cannot be mapped.
+    * \param[in] file_name See \ref find_file.
+    * \param[out] view The contents of the file.
+    * \param[in] search_flags See \ref find_file.
+    * \return false if no such file exists.
+    */
+    bool open_file(const char* file_name,
+        FileView& view,
+        SearchFlags search_flags = SearchFlags::None);
+
+    /** \brief Forget the indexed files. The mounted folders are scanned
+    *          again on the next lookup. Needed once files are added or
+    *          removed, unless changes are watched. Archives are not read
+    *          again.
+    */
+    void invalidate();
+
+    /** \brief Watch the mounted folders for added, removed and renamed
+    *          files, and scan them again once they changed. Uses inotify
+    *          on Linux and change notifications on Windows.
+    * \return false if changes cannot be watched.
+    */
+    bool set_watch_changes(bool enabled);
+
 private:
-    std::list<std::string> search_paths_;
+
+    struct FileEntry
+    {
+        std::string path;   // The file on disk, for folders.
+        size_t offset;      // The entry in the archive, for archives.
+        size_t size;
+        size_t depth;       // The number of folders between the mount and the sub folder.
+    };
+
+    struct Mount
+    {
+        std::string path;
+        int priority;
+        bool indexed;
+
+        /** The mapped archive, null for folders. */
+        std::shared_ptr<const MappedFile> archive;
+
+        /** Files by their normalized path, relative to the mount. */
+        std::unordered_map<std::string, FileEntry> files;
+
+        /** Files by their normalized path, relative to a sub folder. */
+        std::unordered_map<std::string, FileEntry> nested_files;
+
+        /** The inotify watches of the folders. */
+        std::vector<int> watches;
+
+        /** The change notification of the folder tree, on Windows. */
+        void* change_notification;
+    };
+
+    Mount& insert_mount(const char* path, int priority);
+
+    static void add_entry(Mount& mount, const std::string& relative_path, const FileEntry& entry);
+
+    /** \brief Look for a file in the mounts.
+    * \param[in] archives Whether to look in the archives too.
+    * \return The entry, or null.
+    */
+    const FileEntry* find_entry(const char* file_name, SearchFlags search_flags, bool archives,
+        const Mount*& mount);
+
+    void index_search_path(Mount& mount);
+
+    void add_watches(Mount& mount, const std::vector<std::string>& directories);
+
+    void remove_watches(Mount& mount);
+
+    /** \brief Invalidate the mounts whose folders changed. */
+    void process_changes();
+
+    bool find_in_current_directory(const std::string& file_name, std::string& full_file_path);
+
+    std::list<Mount> mounts_;
+
+    /** Files looked up in the current directory, an empty path if missing. */
+    std::unordered_map<std::string, std::string> current_directory_files_;
+    std::string current_directory_;
+
+    int watch_descriptor_;
+    std::unordered_map<int, Mount*> watched_directories_;
+
+    /** Whether the folders get change notifications, on Windows. */
+    bool watch_changes_;
+
+    std::mutex mutex_;
 };
 
 }
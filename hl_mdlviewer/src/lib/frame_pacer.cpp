@@ -0,0 +1,93 @@
+/**
+* \file frame_pacer.cpp
+* \brief Implementation for the frame pacer class.
+*/
+
+#include "pch.h"
+#include "frame_pacer.h"
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+namespace hl_mdlviewer {
+
+FramePacer::FramePacer() :
+    max_frame_rate_(60.0f),
+    last_frame_time_(0.0),
+    idle_(false),
+    idle_start_time_(0.0),
+    idle_start_cpu_time_(0.0),
+    idle_statistics_()
+{
+}
+
+void FramePacer::set_max_frame_rate(float frame_rate)
+{
+    max_frame_rate_ = std::max(frame_rate, 0.0f);
+}
+
+double FramePacer::get_wait_time(double now, bool animating, bool dirty) const
+{
+    // A change is drawn right away, then the loop sleeps.
+    if (!animating)
+        return dirty ? 0.0 : -1.0;
+
+    if (max_frame_rate_ <= 0.0f)
+        return 0.0;
+
+    return std::max(last_frame_time_ + 1.0 / max_frame_rate_ - now, 0.0);
+}
+
+bool FramePacer::frame_due(double now) const
+{
+    return max_frame_rate_ <= 0.0f || now >= last_frame_time_ + 1.0 / max_frame_rate_;
+}
+
+void FramePacer::begin_wait(double now, bool idle)
+{
+    // Keep measuring from the start of the wait if the loop woke up
+    // without drawing.
+    if (!idle || idle_)
+        return;
+
+    idle_ = true;
+    idle_start_time_ = now;
+    idle_start_cpu_time_ = get_process_cpu_time();
+}
+
+void FramePacer::end_frame(double now)
+{
+    last_frame_time_ = now;
+
+    if (!idle_)
+        return;
+
+    idle_ = false;
+    idle_statistics_.idle_time += now - idle_start_time_;
+    idle_statistics_.cpu_time += get_process_cpu_time() - idle_start_cpu_time_;
+    ++idle_statistics_.num_wakeups;
+}
+
+double get_process_cpu_time()
+{
+#ifdef _WIN32
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
+        return 0.0;
+
+    // In 100 nanosecond units.
+    const auto to_seconds = [](const FILETIME& t) {
+        return ((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7;
+    };
+
+    return to_seconds(kernel_time) + to_seconds(user_time);
+#else
+    timespec t;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t) != 0)
+        return 0.0;
+
+    return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
+
+}
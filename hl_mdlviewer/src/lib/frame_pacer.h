@@ -0,0 +1,98 @@
+/**
+* \file frame_pacer.h
+* \brief Declaration for the frame pacer class.
+*/
+
+#ifndef HLMDLVIEWER_FRAME_PACER_H_
+#define HLMDLVIEWER_FRAME_PACER_H_
+
+#include <cstddef>
+
+namespace hl_mdlviewer {
+
+/** \brief The time spent waiting for events while nothing was drawn. */
+struct IdleStatistics
+{
+    IdleStatistics() :
+        idle_time(0.0),
+        cpu_time(0.0),
+        num_wakeups(0)
+    {
+    }
+
+    /** \brief The wall time spent idle, in seconds. */
+    double idle_time;
+
+    /** \brief The process CPU time used while idle, in seconds. */
+    double cpu_time;
+
+    /** \brief The number of times the loop woke up from an idle wait. */
+    size_t num_wakeups;
+
+    /** \brief Get the CPU time used per second of idle time, in seconds. */
+    inline double cpu_time_per_idle_second() const { return idle_time > 0.0 ? cpu_time / idle_time : 0.0; }
+};
+
+/** \brief Decides when a render-on-demand loop draws the next frame.
+*
+* While something animates, frames are drawn continuously, capped to a
+* maximum frame rate. Otherwise frames are only drawn when something
+* changed, and the loop sleeps until the next event in between.
+*/
+class FramePacer
+{
+public:
+    FramePacer();
+    FramePacer(const FramePacer&) = delete;
+
+    /** \brief Set the frame rate cap while animating, 0 for no cap. */
+    void set_max_frame_rate(float frame_rate);
+    inline float max_frame_rate() const { return max_frame_rate_; }
+
+    /** \brief Get how long to wait for events before the next frame.
+    * \param[in] now The current time, in seconds.
+    * \param[in] animating Whether frames are drawn continuously.
+    * \param[in] dirty Whether the last frame is out of date.
+    * \return The time to wait, in seconds, 0 to draw right away, or a
+    *         negative value to wait for the next event.
+    */
+    double get_wait_time(double now, bool animating, bool dirty) const;
+
+    /** \brief Whether the next animated frame is due. */
+    bool frame_due(double now) const;
+
+    /** \brief Mark the start of a wait for events.
+    * The waits that start with nothing to draw are measured as idle time.
+    * \param[in] now The current time, in seconds.
+    * \param[in] idle Whether there is nothing to draw.
+    */
+    void begin_wait(double now, bool idle);
+
+    /** \brief Record that a frame was drawn.
+    * \param[in] now The current time, in seconds.
+    */
+    void end_frame(double now);
+
+    inline const IdleStatistics& idle_statistics() const { return idle_statistics_; }
+
+private:
+
+    float max_frame_rate_;
+
+    /** \brief The time the last frame was drawn, in seconds. */
+    double last_frame_time_;
+
+    /** \brief Whether an idle wait is being measured. */
+    bool idle_;
+    double idle_start_time_;
+    double idle_start_cpu_time_;
+
+    IdleStatistics idle_statistics_;
+};
+
+/** \brief Get the CPU time used by the process so far, in seconds. */
+double get_process_cpu_time();
+
+}
+
+#endif // HLMDLVIEWER_FRAME_PACER_H_
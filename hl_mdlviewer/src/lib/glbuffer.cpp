@@ -5,6 +5,7 @@
 
 #include "pch.h"
 #include "glbuffer.h"
+#include "render_backend.h"
 
 namespace hl_mdlviewer
 {
@@ -13,6 +14,8 @@ glbuffer::glbuffer() :
     vao_(0),
     vbo_(0), 
     ibo_(0), 
+    format_(VertexFormat::STANDARD),
+    num_vertices_(0),
     num_indices_(0)
 {
 }
@@ -26,55 +29,107 @@ void glbuffer::initialize(
     const std::vector<unsigned int>& indices,
     const GLenum usage)
 {
+    format_ = VertexFormat::STANDARD;
     num_vertices_ = static_cast<int>(vertices.size());
+
+    create_buffers(vertices.data(),
+        sizeof(glvertex) * vertices.size(),
+        indices,
+        usage);
+}
+
+void glbuffer::initialize(
+    const std::vector<glvertex_packed>& vertices,
+    const std::vector<unsigned int>& indices,
+    const GLenum usage)
+{
+    format_ = VertexFormat::PACKED;
+    num_vertices_ = static_cast<int>(vertices.size());
+
+    create_buffers(vertices.data(),
+        sizeof(glvertex_packed) * vertices.size(),
+        indices,
+        usage);
+}
+
+void glbuffer::create_buffers(
+    const void* vertices,
+    const size_t vertices_size,
+    const std::vector<unsigned int>& indices,
+    const GLenum usage)
+{
     num_indices_ = static_cast<int>(indices.size());
 
-    glGenVertexArrays(1, &vao_);
-    glGenBuffers(1, &vbo_);
-    glGenBuffers(1, &ibo_);
+    RenderBackend& backend = render_backend();
 
-    glBindVertexArray(vao_);
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glEnableVertexAttribArray(2);
-    glEnableVertexAttribArray(3);
+    vao_ = backend.create_vertex_array();
+    vbo_ = backend.create_buffer();
+    ibo_ = backend.create_buffer();
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER,
-        sizeof(glvertex) * vertices.size(),
-        vertices.data(),
+    backend.bind_vertex_array(vao_);
+    backend.enable_vertex_attrib_array(0);
+    backend.enable_vertex_attrib_array(1);
+    backend.enable_vertex_attrib_array(2);
+    backend.enable_vertex_attrib_array(3);
+
+    backend.bind_buffer(GL_ARRAY_BUFFER, vbo_);
+    backend.buffer_data(GL_ARRAY_BUFFER,
+        vertices_size,
+        vertices,
         usage);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glvertex), (void*)offsetof(glvertex, position));
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glvertex), (void*)offsetof(glvertex, normal));
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(glvertex), (void*)offsetof(glvertex, uv));
-    glVertexAttribIPointer(3, 1, GL_INT, sizeof(glvertex), (void*)offsetof(glvertex, boneid));
+    setup_vertex_attributes();
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+    backend.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
+    backend.buffer_data(GL_ELEMENT_ARRAY_BUFFER,
         sizeof(unsigned int) * indices.size(),
         indices.data(),
         usage);
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    backend.bind_vertex_array(0);
+    backend.bind_buffer(GL_ARRAY_BUFFER, 0);
+    backend.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void glbuffer::setup_vertex_attributes()
+{
+    RenderBackend& backend = render_backend();
+
+    switch (format_)
+    {
+    case VertexFormat::STANDARD:
+        backend.vertex_attrib_pointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glvertex), offsetof(glvertex, position));
+        backend.vertex_attrib_pointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glvertex), offsetof(glvertex, normal));
+        backend.vertex_attrib_pointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(glvertex), offsetof(glvertex, uv));
+        backend.vertex_attrib_ipointer(3, 1, GL_INT, sizeof(glvertex), offsetof(glvertex, boneid));
+        break;
+    case VertexFormat::PACKED:
+        // The shaders see the same attribute types, the unpacking is
+        // done by the vertex fetch.
+        backend.vertex_attrib_pointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glvertex_packed), offsetof(glvertex_packed, position));
+        backend.vertex_attrib_pointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(glvertex_packed), offsetof(glvertex_packed, normal));
+        backend.vertex_attrib_pointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(glvertex_packed), offsetof(glvertex_packed, uv));
+        backend.vertex_attrib_ipointer(3, 1, GL_UNSIGNED_BYTE, sizeof(glvertex_packed), offsetof(glvertex_packed, boneid));
+        break;
+    };
 }
 
 void glbuffer::delete_buffer()
 {
-    glDeleteVertexArrays(1, &vao_);
-    glDeleteBuffers(1, &vbo_);
-    glDeleteBuffers(1, &ibo_);
+    RenderBackend& backend = render_backend();
+    backend.delete_vertex_array(vao_);
+    backend.delete_buffer(vbo_);
+    backend.delete_buffer(ibo_);
     vao_ = vbo_ = ibo_ = 0;
     num_vertices_ = num_indices_ = 0;
 }
 
 void glbuffer::draw_arrays(const GLenum mode, int first, int count)
 {
-    glBindVertexArray(vao_);
-    glDrawArrays(mode, first, count);
-    glBindVertexArray(0);
+    RenderBackend& backend = render_backend();
+    backend.bind_vertex_array(vao_);
+    backend.draw_arrays(mode, first, count);
+    backend.bind_vertex_array(0);
 }
 
 void glbuffer::draw_arrays(const GLenum mode)
@@ -84,7 +139,7 @@ void glbuffer::draw_arrays(const GLenum mode)
 
 void glbuffer::draw_arrays_unbinded(const GLenum mode, int first, int count)
 {
-    glDrawArrays(mode, first, count);
+    render_backend().draw_arrays(mode, first, count);
 }
 
 void glbuffer::draw_arrays_unbinded(const GLenum mode)
@@ -94,9 +149,10 @@ void glbuffer::draw_arrays_unbinded(const GLenum mode)
 
 void glbuffer::draw_indexed(const GLenum mode, int count)
 {
-    glBindVertexArray(vao_);
-    glDrawElements(mode, count, GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+    RenderBackend& backend = render_backend();
+    backend.bind_vertex_array(vao_);
+    backend.draw_elements(mode, count, GL_UNSIGNED_INT, 0, 0);
+    backend.bind_vertex_array(0);
 }
 
 void glbuffer::draw_indexed(const GLenum mode)
@@ -106,9 +162,10 @@ void glbuffer::draw_indexed(const GLenum mode)
 
 void glbuffer::draw_indexed_unbinded(const GLenum mode, int count)
 {
-    glBindVertexArray(vao_);
-    glDrawElements(mode, count, GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+    RenderBackend& backend = render_backend();
+    backend.bind_vertex_array(vao_);
+    backend.draw_elements(mode, count, GL_UNSIGNED_INT, 0, 0);
+    backend.bind_vertex_array(0);
 }
 
 void glbuffer::draw_indexed_unbinded(const GLenum mode)
@@ -116,27 +173,56 @@ void glbuffer::draw_indexed_unbinded(const GLenum mode)
     draw_indexed_unbinded(mode, num_indices_);
 }
 
-void glbuffer::draw_indexed_range_unbinded(const GLenum mode, int start, int num_indices)
+void glbuffer::draw_elements_unbinded(const GLenum mode, int count, GLenum type, size_t offset, int base_vertex)
 {
-    void* indices[1] = { (void*)(start * sizeof(unsigned int)) };
-    GLint count[1] = { num_indices };
-    GLint drawcount = ARRAYSIZE(count);
+    render_backend().draw_elements(
+        mode,
+        count,
+        type,
+        offset,
+        base_vertex);
+}
 
-    glMultiDrawElements(
+void glbuffer::draw_elements_instanced_unbinded(const GLenum mode, int count, GLenum type, size_t offset,
+    int base_vertex, int instance_count)
+{
+    render_backend().draw_elements_instanced(
         mode,
         count,
-        GL_UNSIGNED_INT,
-        indices,
-        drawcount);
+        type,
+        offset,
+        base_vertex,
+        instance_count);
 }
 
 void glbuffer::set_vertices(const std::vector<glvertex>& vertices, const size_t offset)
 {
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    char* ptr = (char*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-    memcpy(ptr + offset * sizeof(glvertex), vertices.data(), vertices.size() * sizeof(glvertex));
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (vertices.empty())
+        return;
+
+    RenderBackend& backend = render_backend();
+
+    // Only map the updated vertices, the rest of the buffer may still be
+    // in use by the GPU.
+    backend.bind_buffer(GL_ARRAY_BUFFER, vbo_);
+    char* ptr = (char*)backend.map_buffer_range(GL_ARRAY_BUFFER,
+        offset * vertex_size(),
+        vertices.size() * vertex_size(),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+
+    if (format_ == VertexFormat::PACKED)
+    {
+        glvertex_packed* packed = reinterpret_cast<glvertex_packed*>(ptr);
+        for (size_t i = 0; i < vertices.size(); ++i)
+            packed[i] = pack_vertex(vertices[i]);
+    }
+    else
+    {
+        memcpy(ptr, vertices.data(), vertices.size() * sizeof(glvertex));
+    }
+
+    backend.unmap_buffer(GL_ARRAY_BUFFER);
+    backend.bind_buffer(GL_ARRAY_BUFFER, 0);
 }
 
 void glbuffer::set_vertices(const std::vector<glvertex>& vertices)
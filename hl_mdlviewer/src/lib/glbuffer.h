@@ -8,6 +8,7 @@
 
 #include "glad.h"
 #include "glvertex.h"
+#include "render_backend.h"
 
 namespace hl_mdlviewer {
 
@@ -23,12 +24,23 @@ public:
     inline const GLuint index_buffer_id() const { return ibo_; }
     inline const int num_vertices() const { return num_vertices_; }
     inline const int num_indices() const { return num_indices_; }
+    inline const VertexFormat vertex_format() const { return format_; }
+
+    /** \brief Get the size of a single vertex in the buffer. */
+    inline const size_t vertex_size() const {
+        return format_ == VertexFormat::PACKED ? sizeof(glvertex_packed) : sizeof(glvertex);
+    }
 
     void initialize(
         const std::vector<glvertex>& vertices,
         const std::vector<unsigned int>& indices,
         const GLenum usage = GL_STATIC_DRAW);
 
+    void initialize(
+        const std::vector<glvertex_packed>& vertices,
+        const std::vector<unsigned int>& indices,
+        const GLenum usage = GL_STATIC_DRAW);
+
     void delete_buffer();
 
     void draw_arrays(const GLenum mode, int first, int count);
@@ -38,24 +50,47 @@ public:
 
     void draw_indexed(const GLenum mode, int count);
     void draw_indexed(const GLenum mode);
-    void draw_indexed_range_unbinded(const GLenum mode, int start, int count);
+
+    /** \brief Draw a range of the index buffer.
+    * \param[in] mode The primitive mode.
+    * \param[in] count The number of indices.
+    * \param[in] type The index type, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+    * \param[in] offset The offset of the first index, in bytes.
+    * \param[in] base_vertex The value added to each index.
+    */
+    void draw_elements_unbinded(const GLenum mode, int count, GLenum type, size_t offset, int base_vertex);
+    void draw_elements_instanced_unbinded(const GLenum mode, int count, GLenum type, size_t offset,
+        int base_vertex, int instance_count);
     void draw_indexed_unbinded(const GLenum mode, int count);
     void draw_indexed_unbinded(const GLenum mode);
 
+    /** \brief Update vertices, converting them to the buffer vertex format.
+    * \param[in] vertices The new vertices.
+    * \param[in] offset The index of the first vertex to update.
+    */
     void set_vertices(const std::vector<glvertex>& vertices, const size_t offset);
     void set_vertices(const std::vector<glvertex>& vertices);
 
     inline void bind() {
-        glBindVertexArray(vao_);
+        render_backend().bind_vertex_array(vao_);
     }
 
     inline void unbind() {
-        glBindVertexArray(0);
+        render_backend().bind_vertex_array(0);
     }
 
 private:
 
+    void create_buffers(
+        const void* vertices,
+        const size_t vertices_size,
+        const std::vector<unsigned int>& indices,
+        const GLenum usage);
+
+    void setup_vertex_attributes();
+
     GLuint vao_, vbo_, ibo_;
+    VertexFormat format_;
     int num_vertices_;
     int num_indices_;
 };
@@ -0,0 +1,43 @@
+/**
+* \file glcapabilities.cpp
+* \brief Implementation for OpenGL capability queries.
+*/
+
+#include "pch.h"
+#include "glcapabilities.h"
+#include <cstring>
+
+namespace hl_mdlviewer {
+
+bool has_gl_extension(const char* name)
+{
+    GLint num_extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+
+    for (GLint i = 0; i < num_extensions; ++i)
+    {
+        const char* extension = reinterpret_cast<const char*>(
+            glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+bool has_gl_buffer_storage()
+{
+    // glad only loads the entry point for a 4.4 context, so the
+    // extension alone is not enough.
+    if (glBufferStorage == nullptr)
+        return false;
+
+    return GLAD_GL_VERSION_4_4 || has_gl_extension("GL_ARB_buffer_storage");
+}
+
+bool has_gl_texture_compression_s3tc()
+{
+    return has_gl_extension("GL_EXT_texture_compression_s3tc");
+}
+
+}
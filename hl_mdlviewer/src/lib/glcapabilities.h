@@ -0,0 +1,29 @@
+/**
+* \file glcapabilities.h
+* \brief Declaration for OpenGL capability queries.
+*/
+
+#ifndef HLMDLVIEWER_GLCAPABILITIES_H_
+#define HLMDLVIEWER_GLCAPABILITIES_H_
+
+namespace hl_mdlviewer {
+
+/** \brief Check whether the current OpenGL context exposes an extension.
+* \param[in] name The extension name, i.e. "GL_ARB_buffer_storage".
+* \return true if the extension is supported; false otherwise.
+*/
+bool has_gl_extension(const char* name);
+
+/** \brief Check whether persistent mapped buffers can be created.
+* \return true if glBufferStorage is available; false otherwise.
+*/
+bool has_gl_buffer_storage();
+
+/** \brief Check whether BC1 and BC3 textures can be created.
+* \return true if GL_EXT_texture_compression_s3tc is supported; false otherwise.
+*/
+bool has_gl_texture_compression_s3tc();
+
+}
+
+#endif // HLMDLVIEWER_GLCAPABILITIES_H_
@@ -5,13 +5,34 @@
 
 #include "pch.h"
 #include "glprogram.h"
+#include "render_backend.h"
 #include "shader_parser.h"
+#include "content_hash.h"
+#include <algorithm>
 #include <initializer_list>
 
 namespace hl_mdlviewer
 {
 
-glprogram::glprogram() : id_(0)
+namespace {
+
+/** \brief Changes the keys of every program, for changes of how programs
+* are built that their sources do not show, i.e. the bound attributes. */
+const uint64_t PROGRAM_BINARY_KEY_VERSION = 1;
+
+}
+
+glprogram::glprogram() :
+    id_(0),
+    shader_files_(),
+    shader_parser_(nullptr),
+    features_(),
+    on_variant_created_(),
+    variants_(),
+    pending_variants_(),
+    binary_cache_(nullptr),
+    binary_key_(0),
+    pending_shaders_()
 {
 }
 
@@ -21,39 +42,228 @@ glprogram::~glprogram()
 
 void glprogram::initialize_with_files(
     ShaderInitializerList&& shader_initializer_list,
-    FileSystem* file_system)
+    ShaderParser* shader_parser,
+    const ShaderParser::Defines& defines)
 {
-    glshader temp_shader;
-    ShaderParser parser(file_system);
+    shader_files_.assign(shader_initializer_list.begin(), shader_initializer_list.end());
+    build_with_files(shader_parser, defines);
+    finish_build();
+}
 
-    id_ = glCreateProgram();
-    for (auto file_path_shader_type : std::move(shader_initializer_list))
+void glprogram::build_with_files(ShaderParser* shader_parser, const ShaderParser::Defines& defines)
+{
+    RenderBackend& backend = render_backend();
+
+    std::vector<std::string> sources(shader_files_.size());
+    for (size_t i = 0; i < shader_files_.size(); ++i)
+        shader_parser->parse(shader_files_[i].first, defines, sources[i]);
+
+    id_ = backend.create_program();
+
+    if (binary_cache_ && binary_cache_->enabled())
     {
-        std::string parsed_shader_string;
-        parser.parse(file_path_shader_type.first, parsed_shader_string);
-        temp_shader.create_from_string(parsed_shader_string, file_path_shader_type.second);
-        glAttachShader(id_, temp_shader.id());
+        binary_key_ = binary_cache_->get_driver_hash();
+        binary_key_ = hash_bytes_64(&PROGRAM_BINARY_KEY_VERSION, sizeof(PROGRAM_BINARY_KEY_VERSION), binary_key_);
+        for (size_t i = 0; i < shader_files_.size(); ++i)
+        {
+            const GLenum type = shader_files_[i].second;
+            binary_key_ = hash_bytes_64(&type, sizeof(type), binary_key_);
+            binary_key_ = hash_string_64(sources[i], binary_key_);
+        }
+
+        if (load_binary())
+            return;
     }
 
-    update();
+    bind_attributes();
+    if (binary_cache_ && binary_cache_->enabled())
+        backend.program_parameter(id_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    // Nothing waits for the compiler until finish_build.
+    pending_shaders_.resize(shader_files_.size());
+    for (size_t i = 0; i < shader_files_.size(); ++i)
+    {
+        pending_shaders_[i].compile(sources[i], shader_files_[i].second);
+        backend.attach_shader(id_, pending_shaders_[i].id());
+    }
+
+    backend.link_program(id_);
+}
+
+bool glprogram::load_binary()
+{
+    GLenum format;
+    std::vector<uint8_t> binary;
+    if (!binary_cache_->load(binary_key_, format, binary))
+        return false;
+
+    RenderBackend& backend = render_backend();
+    if (backend.program_binary(id_, format, binary.data(), static_cast<GLsizei>(binary.size())))
+        return true;
+
+    // Rejected, i.e. after a driver update: start again from the sources,
+    // with a program that no failed binary was loaded into.
+    binary_cache_->on_binary_rejected();
+    backend.delete_program(id_);
+    id_ = backend.create_program();
+    return false;
+}
+
+void glprogram::finish_build()
+{
+    if (!pending_shaders_.empty())
+    {
+        try
+        {
+            for (glshader& shader : pending_shaders_)
+                shader.check_compile_status();
+
+            check_link_status();
+        }
+        catch (...)
+        {
+            for (glshader& shader : pending_shaders_)
+                shader.delete_shader();
+            pending_shaders_.clear();
+            throw;
+        }
+
+        validate_program();
+        store_binary();
+
+        // The program keeps its code once linked.
+        for (glshader& shader : pending_shaders_)
+            shader.delete_shader();
+        pending_shaders_.clear();
+    }
+
+    if (on_variant_created_)
+        on_variant_created_(*this, 0);
+}
+
+void glprogram::store_binary()
+{
+    if (!binary_cache_ || !binary_cache_->enabled())
+        return;
+
+    GLenum format;
+    std::vector<uint8_t> binary;
+    if (render_backend().get_program_binary(id_, format, binary))
+        binary_cache_->store(binary_key_, format, binary);
+}
+
+void glprogram::initialize_variants(
+    ShaderInitializerList&& shader_initializer_list,
+    ShaderParser* shader_parser,
+    const FeatureList& features,
+    VariantCallback on_variant_created)
+{
+    shader_parser_ = shader_parser;
+    features_ = features;
+    on_variant_created_ = on_variant_created;
+
+    shader_files_.assign(shader_initializer_list.begin(), shader_initializer_list.end());
+    build_with_files(shader_parser, ShaderParser::Defines());
+}
+
+glprogram& glprogram::variant(unsigned int features)
+{
+    if (features == 0)
+        return *this;
+
+    auto it = variants_.find(features);
+    if (it != variants_.end())
+    {
+        auto pending = std::find(pending_variants_.begin(), pending_variants_.end(), features);
+        if (pending != pending_variants_.end())
+        {
+            pending_variants_.erase(pending);
+            finish_variant(*it->second, features);
+        }
+
+        return *it->second;
+    }
+
+    std::unique_ptr<glprogram> program = create_variant(features);
+    finish_variant(*program, features);
+
+    glprogram& result = *program;
+    variants_.emplace(features, std::move(program));
+    return result;
+}
+
+void glprogram::submit_variants(const std::vector<unsigned int>& feature_sets)
+{
+    for (unsigned int features : feature_sets)
+    {
+        if (features == 0 || variants_.count(features))
+            continue;
+
+        variants_.emplace(features, create_variant(features));
+        pending_variants_.push_back(features);
+    }
+}
+
+void glprogram::finish_variants(bool wait)
+{
+    std::vector<unsigned int> pending;
+    pending.swap(pending_variants_);
+
+    for (unsigned int features : pending)
+    {
+        glprogram& program = *variants_[features];
+        if (wait || program.build_completed())
+            finish_variant(program, features);
+        else
+            pending_variants_.push_back(features);
+    }
+}
+
+bool glprogram::build_completed()
+{
+    return pending_shaders_.empty() || render_backend().is_program_completed(id_);
+}
+
+std::unique_ptr<glprogram> glprogram::create_variant(unsigned int features)
+{
+    ShaderParser::Defines defines;
+    for (size_t i = 0; i < features_.size(); ++i)
+    {
+        if (features & (1u << i))
+            defines.push_back(features_[i]);
+    }
+
+    std::unique_ptr<glprogram> program(new glprogram());
+    program->shader_files_ = shader_files_;
+    program->binary_cache_ = binary_cache_;
+    program->build_with_files(shader_parser_, defines);
+    return program;
+}
+
+void glprogram::finish_variant(glprogram& program, unsigned int features)
+{
+    program.finish_build();
+
+    if (on_variant_created_)
+        on_variant_created_(program, features);
 }
 
 void glprogram::initialize_with_shaders(std::initializer_list<glshader>&& shaders)
 {
-    id_ = glCreateProgram();
+    id_ = render_backend().create_program();
     add_shaders(std::move(shaders));
     update();
 }
 
 void glprogram::add_shader(const glshader& shader)
 {
-    glAttachShader(id_, shader.id());
+    render_backend().attach_shader(id_, shader.id());
 }
 
 void glprogram::add_shaders(std::initializer_list<glshader>&& shaders)
 {
     for (auto shader : std::move(shaders))
-        glAttachShader(id_, shader.id());
+        render_backend().attach_shader(id_, shader.id());
 }
 
 void glprogram::update()
@@ -65,56 +275,63 @@ void glprogram::update()
 
 void glprogram::delete_program()
 {
-    glDeleteProgram(id_);
+    for (auto& variant : variants_)
+        variant.second->delete_program();
+    variants_.clear();
+    pending_variants_.clear();
+
+    for (glshader& shader : pending_shaders_)
+        shader.delete_shader();
+    pending_shaders_.clear();
+
+    render_backend().delete_program(id_);
     id_ = 0;
 }
 
 void glprogram::bind_attributes()
 {
-    glBindAttribLocation(id_, 0, "position");
-    glBindAttribLocation(id_, 1, "normal");
-    glBindAttribLocation(id_, 2, "uv");
-    glBindAttribLocation(id_, 3, "boneid");
+    RenderBackend& backend = render_backend();
+    backend.bind_attrib_location(id_, 0, "position");
+    backend.bind_attrib_location(id_, 1, "normal");
+    backend.bind_attrib_location(id_, 2, "uv");
+    backend.bind_attrib_location(id_, 3, "boneid");
 }
 
 void glprogram::bind_uniform_index(const char* name, GLuint index)
 {
-    GLuint uniform_block_index = glGetUniformBlockIndex(id_, name);
+    RenderBackend& backend = render_backend();
+    GLuint uniform_block_index = backend.get_uniform_block_index(id_, name);
     validate_uniform_block_index(uniform_block_index, name);
-    glUniformBlockBinding(id_, uniform_block_index, index);
+    backend.uniform_block_binding(id_, uniform_block_index, index);
 }
 
 void glprogram::link()
 {
-    glLinkProgram(id_);
-
-    GLint status;
-    glGetProgramiv(id_, GL_LINK_STATUS, &status);
+    render_backend().link_program(id_);
+    check_link_status();
+}
 
-    if (status == GL_FALSE)
-        throw_info_log_exception();
+void glprogram::check_link_status()
+{
+    std::string info_log;
+    if (!render_backend().get_link_status(id_, info_log))
+        throw_info_log_exception(info_log);
 }
 
 void glprogram::validate_program()
 {
-    glValidateProgram(id_);
-
-    GLint status;
-    glGetProgramiv(id_, GL_VALIDATE_STATUS, &status);
-
-    if (status == GL_FALSE)
-        throw_info_log_exception();
+#ifndef NDEBUG
+    // Validation depends on the state at the time of the call, i.e. the
+    // sampler units are not set yet, so a failure is not an error here.
+    // It also waits for the driver, hence debug builds only.
+    std::string info_log;
+    render_backend().validate_program(id_, info_log);
+#endif
 }
 
-void glprogram::throw_info_log_exception()
+void glprogram::throw_info_log_exception(const std::string& info_log)
 {
-    GLint log_length;
-    glGetProgramiv(id_, GL_INFO_LOG_LENGTH, &log_length);
-
-    std::string error_message;
-    error_message.resize(log_length);
-    GLsizei num_read_characters;
-    glGetProgramInfoLog(id_, log_length, &num_read_characters, &error_message[0]);
+    throw std::runtime_error(info_log);
 }
 
 }
@@ -7,10 +7,15 @@
 #define HLMDLVIEWER_GLPROGRAM_H_
 
 #include <string>
+#include <map>
+#include <memory>
+#include <functional>
 #include "glshader.h"
 #include <glm/gtc/type_ptr.hpp>
 #include "glad.h"
-#include "file_system.h"
+#include "render_backend.h"
+#include "shader_parser.h"
+#include "program_binary_cache.h"
 
 namespace hl_mdlviewer {
 
@@ -23,8 +28,76 @@ public:
 
     using ShaderInitializerList = std::initializer_list<std::pair<std::string, GLenum>>;
 
+    /** \brief The preprocessor definitions of each feature. Feature
+    * i is enabled by bit (1 << i) of a feature mask. */
+    using FeatureList = std::vector<std::string>;
+
+    /** \brief Called once for each variant, right after it is linked. */
+    using VariantCallback = std::function<void(glprogram& variant, unsigned int features)>;
+
     void initialize_with_files(ShaderInitializerList&& shader_initializer_list,
-        FileSystem* file_system);
+        ShaderParser* shader_parser,
+        const ShaderParser::Defines& defines = ShaderParser::Defines());
+
+    /** \brief Initialize a program that can be specialized by features.
+    *
+    * This program is the variant with no features. Other variants are
+    * built by \ref submit_variants, or on first use by \ref variant,
+    * and cached.
+    *
+    * The program is only submitted to the driver, call \ref finish_build
+    * before using it. Submitting every program before finishing any lets
+    * the driver compile them in parallel.
+    * \param[in] shader_initializer_list The shader files.
+    * \param[in] shader_parser The parser to load the files with. Sharing
+    *            it between programs shares the files it read.
+    * \param[in] features The preprocessor definitions of each feature.
+    * \param[in] on_variant_created Called for each variant, i.e. to
+    *            bind uniform blocks.
+    */
+    void initialize_variants(ShaderInitializerList&& shader_initializer_list,
+        ShaderParser* shader_parser,
+        const FeatureList& features,
+        VariantCallback on_variant_created = VariantCallback());
+
+    /** \brief Get the program specialized for \p features, building
+    *          it if needed. Building it here waits for the driver, so
+    *          variants should be submitted beforehand.
+    * \param[in] features The feature mask.
+    * \return The specialized program.
+    */
+    glprogram& variant(unsigned int features);
+
+    /** \brief Submit the variants of \p feature_sets that are not built
+    *          yet, without waiting for them. Call \ref finish_variants
+    *          before drawing.
+    * \param[in] feature_sets The feature masks of the variants.
+    */
+    void submit_variants(const std::vector<unsigned int>& feature_sets);
+
+    /** \brief Finish the variants submitted by \ref submit_variants.
+    *          Throws the compiler or linker log on failure.
+    * \param[in] wait Whether to wait for all of them, or to only finish
+    *            those the driver completed in the background.
+    * \see RenderBackend::has_parallel_shader_compile
+    */
+    void finish_variants(bool wait = true);
+
+    inline bool has_pending_variants() const { return !pending_variants_.empty(); }
+
+    /** \brief Wait for the program submitted by \ref initialize_variants
+    *          to link, and store its binary. Throws the compiler or linker
+    *          log on failure.
+    */
+    void finish_build();
+
+    /** \brief Load the programs built from files from binaries, and store
+    *          their binaries once linked. Shared with the variants.
+    * \param[in] cache The cache, or null to always compile.
+    */
+    inline void set_binary_cache(ProgramBinaryCache* cache) { binary_cache_ = cache; }
+
+    inline size_t num_variants() const { return variants_.size() + 1; }
     void initialize_with_shaders(std::initializer_list<glshader>&& shaders);
 
     void add_shader(const glshader& shader);
@@ -37,76 +110,83 @@ public:
 
     void bind_uniform_index(const char* name, GLuint index);
 
+    inline bool has_uniform_block(const char* name) {
+        return render_backend().get_uniform_block_index(id_, name) != GL_INVALID_INDEX;
+    }
+
     inline void bind() {
-        glUseProgram(id_);
+        render_backend().use_program(id_);
     }
 
     inline void unbind() {
-        glUseProgram(0);
+        render_backend().use_program(0);
     }
 
     inline GLint get_attrib_location(const char* name) {
-        return glGetAttribLocation(id_, name);
+        return render_backend().get_attrib_location(id_, name);
     }
 
     inline GLint get_uniform_location(const char* name) {
-        return glGetUniformLocation(id_, name);
+        return render_backend().get_uniform_location(id_, name);
     }
 
     inline void set_uniform(const char* name, const glm::vec2& value) {
-        GLint location = glGetUniformLocation(id_, name);
+        GLint location = get_uniform_location(name);
         validate_uniform_location(location, name);
-        glUniform2fv(location, 1,  glm::value_ptr(value));
+        render_backend().uniform_2fv(location, glm::value_ptr(value));
     }
 
     inline void set_uniform(const char* name, const glm::vec3& value) {
-        GLint location = glGetUniformLocation(id_, name);
+        GLint location = get_uniform_location(name);
         validate_uniform_location(location, name);
-        glUniform3fv(location, 1,  glm::value_ptr(value));
+        render_backend().uniform_3fv(location, glm::value_ptr(value));
     }
 
     inline void set_uniform(const char* name, const glm::vec4& value) {
-        GLint location = glGetUniformLocation(id_, name);
+        GLint location = get_uniform_location(name);
         validate_uniform_location(location, name);
-        glUniform4fv(location, 1,  glm::value_ptr(value));
+        render_backend().uniform_4fv(location, glm::value_ptr(value));
     }
 
     inline void set_uniform(const char* name, const glm::mat4& value, bool transpose = false) {
-        GLint location = glGetUniformLocation(id_, name);
+        GLint location = get_uniform_location(name);
         validate_uniform_location(location, name);
-        glUniformMatrix4fv(location, 1, transpose ? GL_TRUE : GL_FALSE,  glm::value_ptr(value));
+        render_backend().uniform_matrix_4fv(location, transpose ? GL_TRUE : GL_FALSE, glm::value_ptr(value));
     }
 
     inline void set_uniform(const char* name, const bool value) {
-        GLint location = glGetUniformLocation(id_, name);
+        GLint location = get_uniform_location(name);
         validate_uniform_location(location, name);
-        glUniform1i(location, value);
+        render_backend().uniform_1i(location, value);
     }
 
     inline void set_uniform(const char* name, const GLint value) {
-        GLint location = glGetUniformLocation(id_, name);
+        GLint location = get_uniform_location(name);
         validate_uniform_location(location, name);
-        glUniform1i(location, value);
+        render_backend().uniform_1i(location, value);
     }
 
     inline void set_uniform(const char* name, const GLuint value) {
-        GLint location = glGetUniformLocation(id_, name);
+        GLint location = get_uniform_location(name);
         validate_uniform_location(location, name);
-        glUniform1ui(location, value);
+        render_backend().uniform_1ui(location, value);
     }
 
     inline void set_uniform(const char* name, const GLfloat value) {
-        GLint location = glGetUniformLocation(id_, name);
+        GLint location = get_uniform_location(name);
         validate_uniform_location(location, name);
-        glUniform1f(location, value);
+        render_backend().uniform_1f(location, value);
     }
 
 protected:
 
     void bind_attributes();
     void link();
+
+    /** \brief Wait for the program submitted by \ref link_program to link. */
+    void check_link_status();
     void validate_program();
-    void throw_info_log_exception();
+    void throw_info_log_exception(const std::string& info_log);
 
     inline void validate_uniform_location(GLint location, const char* name)
     {
@@ -122,7 +202,50 @@ protected:
 
 private:
 
+    /** \brief Submit the program, from its binary if cached, else from its
+    *          sources. See \ref finish_build. */
+    void build_with_files(ShaderParser* shader_parser, const ShaderParser::Defines& defines);
+
+    /** \brief Load the program from its cached binary.
+    * \return false if it is not cached, or the driver rejected it.
+    */
+    bool load_binary();
+
+    void store_binary();
+
+    /** \brief Create the variant for \p features and submit it. */
+    std::unique_ptr<glprogram> create_variant(unsigned int features);
+
+    /** \brief Whether the program submitted by \ref build_with_files
+    *          is linked, without waiting for it. */
+    bool build_completed();
+
+    /** \brief Wait for a submitted variant to link, then set it up. */
+    void finish_variant(glprogram& program, unsigned int features);
+
     GLuint id_;
+
+    /** \brief The shader files, kept to build variants. */
+    std::vector<std::pair<std::string, GLenum>> shader_files_;
+    ShaderParser* shader_parser_;
+
+    FeatureList features_;
+    VariantCallback on_variant_created_;
+
+    /** \brief The variants built so far, by feature mask. */
+    std::map<unsigned int, std::unique_ptr<glprogram>> variants_;
+
+    /** \brief The variants submitted but not finished yet. */
+    std::vector<unsigned int> pending_variants_;
+
+    ProgramBinaryCache* binary_cache_;
+
+    /** \brief The key of the program in the binary cache. */
+    uint64_t binary_key_;
+
+    /** \brief The shaders compiling, until \ref finish_build. Empty if the
+    * program was loaded from its binary. */
+    std::vector<glshader> pending_shaders_;
 };
 
 }
@@ -5,6 +5,7 @@
 
 #include "pch.h"
 #include "glshader.h"
+#include "render_backend.h"
 
 #include <fstream>
 #include <stdexcept>
@@ -21,27 +22,23 @@ glshader::~glshader()
 
 void glshader::create_from_string(const std::string& str, GLenum type)
 {
-    id_ = glCreateShader(type);
-
-    const GLchar* const shader_source = str.c_str();
-    glShaderSource(id_, 1, &shader_source, nullptr);
-
-    glCompileShader(id_);
+    compile(str, type);
+    check_compile_status();
+}
 
-    GLint status;
-    glGetShaderiv(id_, GL_COMPILE_STATUS, &status);
+void glshader::compile(const std::string& str, GLenum type)
+{
+    RenderBackend& backend = render_backend();
 
-    if (status == GL_FALSE)
-    {
-        GLint log_length;
-        glGetShaderiv(id_, GL_INFO_LOG_LENGTH, &log_length);
+    id_ = backend.create_shader(type);
+    backend.compile_shader(id_, str);
+}
 
-        std::string error_message;
-        error_message.resize(log_length);
-        GLsizei num_read_characters;
-        glGetShaderInfoLog(id_, log_length, &num_read_characters, &error_message[0]);
+void glshader::check_compile_status()
+{
+    std::string error_message;
+    if (!render_backend().get_compile_status(id_, error_message))
         throw std::runtime_error(error_message);
-    }
 }
 
 void glshader::load(const std::string& file_path, GLenum type)
@@ -61,7 +58,7 @@ void glshader::load(const std::string& file_path, GLenum type)
 
 void glshader::delete_shader()
 {
-    glDeleteShader(id_);
+    render_backend().delete_shader(id_);
     id_ = 0;
 }
 
@@ -19,6 +19,14 @@ public:
     ~glshader();
 
     void create_from_string(const std::string& str, GLenum type);
+
+    /** \brief Create the shader and submit it for compilation, without
+    *          waiting for it. See \ref check_compile_status. */
+    void compile(const std::string& str, GLenum type);
+
+    /** \brief Wait for the shader to compile. Throws the compiler log on
+    *          failure. */
+    void check_compile_status();
     void load(const std::string& file_path, GLenum type);
 
     void delete_shader();
@@ -0,0 +1,193 @@
+/**
+* \file glstate.cpp
+* \brief Implementation for the OpenGL state tracker class.
+*/
+
+#include "pch.h"
+#include "glstate.h"
+#include "render_backend.h"
+
+namespace hl_mdlviewer
+{
+
+glstate::glstate() :
+    capabilities_(),
+    blend_source_factor_(0),
+    blend_destination_factor_(0),
+    depth_func_(0),
+    cull_face_(0),
+    polygon_mode_(0),
+    program_(UNKNOWN),
+    vertex_array_(UNKNOWN),
+    active_texture_unit_(UNKNOWN),
+    texture_bindings_(),
+    uniform_buffer_bindings_()
+{
+    reset_counters();
+}
+
+glstate::~glstate()
+{
+}
+
+void glstate::invalidate()
+{
+    capabilities_.clear();
+    blend_source_factor_ = blend_destination_factor_ = 0;
+    depth_func_ = 0;
+    cull_face_ = 0;
+    polygon_mode_ = 0;
+    program_ = UNKNOWN;
+    vertex_array_ = UNKNOWN;
+    active_texture_unit_ = UNKNOWN;
+    texture_bindings_.clear();
+    uniform_buffer_bindings_.clear();
+}
+
+void glstate::enable(GLenum capability)
+{
+    set_enabled(capability, true);
+}
+
+void glstate::disable(GLenum capability)
+{
+    set_enabled(capability, false);
+}
+
+void glstate::set_enabled(GLenum capability, bool enabled)
+{
+    auto it = std::find_if(capabilities_.begin(), capabilities_.end(),
+        [&](const Capability& c) { return c.capability == capability; });
+
+    if (!count(ENABLE, it == capabilities_.end() || it->enabled != enabled))
+        return;
+
+    if (it != capabilities_.end())
+        it->enabled = enabled;
+    else
+        capabilities_.push_back({ capability, enabled });
+
+    if (enabled)
+        render_backend().enable(capability);
+    else
+        render_backend().disable(capability);
+}
+
+void glstate::blend_func(GLenum source_factor, GLenum destination_factor)
+{
+    if (!count(BLEND_FUNC, source_factor != blend_source_factor_ ||
+        destination_factor != blend_destination_factor_))
+        return;
+
+    blend_source_factor_ = source_factor;
+    blend_destination_factor_ = destination_factor;
+    render_backend().blend_func(source_factor, destination_factor);
+}
+
+void glstate::depth_func(GLenum func)
+{
+    if (!count(DEPTH_FUNC, func != depth_func_))
+        return;
+
+    depth_func_ = func;
+    render_backend().depth_func(func);
+}
+
+void glstate::cull_face(GLenum mode)
+{
+    if (!count(CULL_FACE, mode != cull_face_))
+        return;
+
+    cull_face_ = mode;
+    render_backend().cull_face(mode);
+}
+
+void glstate::polygon_mode(GLenum mode)
+{
+    if (!count(POLYGON_MODE, mode != polygon_mode_))
+        return;
+
+    polygon_mode_ = mode;
+    render_backend().polygon_mode(GL_FRONT_AND_BACK, mode);
+}
+
+void glstate::use_program(GLuint program)
+{
+    if (!count(USE_PROGRAM, program != program_))
+        return;
+
+    program_ = program;
+    render_backend().use_program(program);
+}
+
+void glstate::bind_vertex_array(GLuint vertex_array)
+{
+    if (!count(BIND_VERTEX_ARRAY, vertex_array != vertex_array_))
+        return;
+
+    vertex_array_ = vertex_array;
+    render_backend().bind_vertex_array(vertex_array);
+}
+
+void glstate::active_texture(GLuint unit)
+{
+    if (!count(ACTIVE_TEXTURE, unit != active_texture_unit_))
+        return;
+
+    active_texture_unit_ = unit;
+    render_backend().active_texture(unit);
+}
+
+void glstate::bind_texture(GLuint unit, GLenum target, GLuint texture)
+{
+    auto it = std::find_if(texture_bindings_.begin(), texture_bindings_.end(),
+        [&](const TextureBinding& b) { return b.unit == unit && b.target == target; });
+
+    if (!count(BIND_TEXTURE, it == texture_bindings_.end() || it->texture != texture))
+        return;
+
+    if (it != texture_bindings_.end())
+        it->texture = texture;
+    else
+        texture_bindings_.push_back({ unit, target, texture });
+
+    active_texture(unit);
+    render_backend().bind_texture(target, texture);
+}
+
+void glstate::bind_uniform_buffer_range(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    auto it = std::find_if(uniform_buffer_bindings_.begin(), uniform_buffer_bindings_.end(),
+        [&](const UniformBufferBinding& b) { return b.index == index; });
+
+    const bool changed = it == uniform_buffer_bindings_.end() ||
+        it->buffer != buffer || it->offset != offset || it->size != size;
+
+    if (!count(BIND_UNIFORM_BUFFER, changed))
+        return;
+
+    if (it != uniform_buffer_bindings_.end())
+        *it = { index, buffer, offset, size };
+    else
+        uniform_buffer_bindings_.push_back({ index, buffer, offset, size });
+
+    render_backend().bind_buffer_range(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+}
+
+size_t glstate::num_forwarded_calls() const
+{
+    return std::accumulate(forwarded_, forwarded_ + COUNT, size_t(0));
+}
+
+size_t glstate::num_skipped_calls() const
+{
+    return std::accumulate(skipped_, skipped_ + COUNT, size_t(0));
+}
+
+void glstate::reset_counters()
+{
+    std::fill(forwarded_, forwarded_ + COUNT, size_t(0));
+    std::fill(skipped_, skipped_ + COUNT, size_t(0));
+}
+
+}
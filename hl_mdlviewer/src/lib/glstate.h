@@ -0,0 +1,144 @@
+/**
+* \file glstate.h
+* \brief Declaration for the OpenGL state tracker class.
+*/
+
+#ifndef HLMDLVIEWER_GLSTATE_H_
+#define HLMDLVIEWER_GLSTATE_H_
+
+#include <vector>
+#include "glad.h"
+
+namespace hl_mdlviewer {
+
+/** \brief Shadows a subset of the OpenGL state and only forwards calls
+* that actually change it.
+*
+* The tracker assumes it is the only one changing the state it shadows.
+* Call \ref invalidate whenever other code may have changed it, i.e. at
+* the start of every frame.
+*/
+class glstate
+{
+public:
+    /** \brief The kinds of calls the tracker filters. */
+    enum Call
+    {
+        ENABLE,
+        BLEND_FUNC,
+        DEPTH_FUNC,
+        CULL_FACE,
+        POLYGON_MODE,
+        USE_PROGRAM,
+        BIND_VERTEX_ARRAY,
+        ACTIVE_TEXTURE,
+        BIND_TEXTURE,
+        BIND_UNIFORM_BUFFER,
+        COUNT // Must be last.
+    };
+
+    glstate();
+    ~glstate();
+
+    /** \brief Forget the shadowed state, so that the next call of
+    *          each kind is always forwarded. */
+    void invalidate();
+
+    void enable(GLenum capability);
+    void disable(GLenum capability);
+    void set_enabled(GLenum capability, bool enabled);
+
+    void blend_func(GLenum source_factor, GLenum destination_factor);
+    void depth_func(GLenum func);
+    void cull_face(GLenum mode);
+
+    /** \brief Set the polygon mode of both faces, the only mode a
+    *          core profile accepts. */
+    void polygon_mode(GLenum mode);
+
+    void use_program(GLuint program);
+    void bind_vertex_array(GLuint vertex_array);
+
+    /** \brief Select the active texture unit.
+    * \param[in] unit The texture unit, starting at 0.
+    */
+    void active_texture(GLuint unit);
+
+    /** \brief Bind a texture to a texture unit.
+    * \param[in] unit The texture unit, starting at 0.
+    * \param[in] target The texture target, i.e. GL_TEXTURE_2D.
+    * \param[in] texture The texture.
+    */
+    void bind_texture(GLuint unit, GLenum target, GLuint texture);
+
+    void bind_uniform_buffer_range(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    inline size_t num_forwarded_calls(Call call) const { return forwarded_[call]; }
+    inline size_t num_skipped_calls(Call call) const { return skipped_[call]; }
+
+    size_t num_forwarded_calls() const;
+    size_t num_skipped_calls() const;
+
+    void reset_counters();
+
+private:
+
+    /** \brief Count a call.
+    * \param[in] call The kind of call.
+    * \param[in] changed Whether or not the call changes the state.
+    * \return \p changed.
+    */
+    inline bool count(Call call, bool changed) {
+        ++(changed ? forwarded_[call] : skipped_[call]);
+        return changed;
+    }
+
+    struct Capability
+    {
+        GLenum capability;
+        bool enabled;
+    };
+
+    struct TextureBinding
+    {
+        GLuint unit;
+        GLenum target;
+        GLuint texture;
+    };
+
+    struct UniformBufferBinding
+    {
+        GLuint index;
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    /** \brief A value for unknown object bindings. */
+    static const GLuint UNKNOWN = ~0u;
+
+    std::vector<Capability> capabilities_;
+
+    /** \brief The blend factors, or 0 when unknown. */
+    GLenum blend_source_factor_;
+    GLenum blend_destination_factor_;
+
+    GLenum depth_func_;
+    GLenum cull_face_;
+    GLenum polygon_mode_;
+
+    GLuint program_;
+    GLuint vertex_array_;
+
+    GLuint active_texture_unit_;
+    std::vector<TextureBinding> texture_bindings_;
+
+    std::vector<UniformBufferBinding> uniform_buffer_bindings_;
+
+    size_t forwarded_[COUNT];
+    size_t skipped_[COUNT];
+};
+
+}
+
+#endif // HLMDLVIEWER_GLSTATE_H_
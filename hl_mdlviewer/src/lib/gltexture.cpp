@@ -5,6 +5,7 @@
 
 #include "pch.h"
 #include "gltexture.h"
+#include "render_backend.h"
 
 namespace hl_mdlviewer
 {
@@ -22,29 +23,89 @@ void gltexture::create_from_data(
     GLint internalFormat, GLint format,
     unsigned char* pixels)
 {
-    glGenTextures(1, &id_);
-    glBindTexture(GL_TEXTURE_2D, id_);
+    RenderBackend& backend = render_backend();
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    id_ = backend.create_texture();
+    backend.bind_texture(GL_TEXTURE_2D, id_);
 
-    glTexImage2D(
-        GL_TEXTURE_2D, 0,
-        internalFormat,
-        width, height,
-        0, format,
-        GL_UNSIGNED_BYTE,
-        pixels);
+    backend.tex_parameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    backend.tex_parameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    backend.tex_parameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    backend.tex_parameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+    specify_texture_level(0, width, height, internalFormat, format, pixels, 0);
+
+    backend.bind_texture(GL_TEXTURE_2D, 0);
+}
+
+void gltexture::create_from_levels(
+    const std::vector<MipLevel>& levels,
+    GLint internalFormat, GLint format,
+    bool pixels)
+{
+    RenderBackend& backend = render_backend();
+
+    id_ = backend.create_texture();
+    backend.bind_texture(GL_TEXTURE_2D, id_);
+
+    backend.tex_parameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    backend.tex_parameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    backend.tex_parameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    backend.tex_parameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+        levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    backend.tex_parameter(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+        static_cast<GLint>(std::max(levels.size(), static_cast<size_t>(1)) - 1));
+
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        const MipLevel& level = levels[i];
+        specify_texture_level(static_cast<GLint>(i), level.width, level.height,
+            internalFormat, format,
+            pixels ? level.pixels.data() : nullptr,
+            level.pixels.size());
+    }
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    backend.bind_texture(GL_TEXTURE_2D, 0);
 }
 
 void gltexture::delete_texture()
 {
-    glDeleteTextures(1, &id_);
+    render_backend().delete_texture(id_);
     id_ = 0;
 }
 
+void specify_texture_level(GLint level,
+    unsigned int width, unsigned int height,
+    GLint internal_format, GLint format,
+    const void* pixels, size_t size)
+{
+    RenderBackend& backend = render_backend();
+
+    if (format == 0)
+    {
+        backend.compressed_tex_image_2d(
+            GL_TEXTURE_2D, level,
+            internal_format,
+            width, height,
+            static_cast<GLsizei>(size),
+            pixels);
+        return;
+    }
+
+    // Rows of single byte texels are not 4 byte aligned.
+    if (format == GL_RED)
+        backend.pixel_store(GL_UNPACK_ALIGNMENT, 1);
+
+    backend.tex_image_2d(
+        GL_TEXTURE_2D, level,
+        internal_format,
+        width, height,
+        format,
+        GL_UNSIGNED_BYTE,
+        pixels);
+
+    if (format == GL_RED)
+        backend.pixel_store(GL_UNPACK_ALIGNMENT, 4);
+}
+
 }
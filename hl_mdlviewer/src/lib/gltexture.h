@@ -7,7 +7,10 @@
 #define HLMDLVIEWER_GLTEXTURE_H_
 
 #include <string>
+#include <vector>
 #include "glad.h"
+#include "image.h"
+#include "render_backend.h"
 
 namespace hl_mdlviewer {
 
@@ -23,21 +26,49 @@ public:
         GLint internalFormat, GLint format,
         unsigned char* pixels);
 
+    /** \brief Create a texture with mip levels, filtered trilinearly.
+    * \param[in] levels The levels, from the largest. Only their sizes are
+    *            used if \p pixels is false.
+    * \param[in] internalFormat The texture format.
+    * \param[in] format The format of the texels, or 0 if \p internalFormat
+    *            is compressed and the levels hold compressed blocks.
+    * \param[in] pixels Whether to specify the texels, or to only allocate
+    *            the storage.
+    */
+    void create_from_levels(
+        const std::vector<MipLevel>& levels,
+        GLint internalFormat, GLint format,
+        bool pixels = true);
+
     void delete_texture();
 
     inline const GLuint id() const { return id_; }
 
     inline void bind() {
-        glBindTexture(GL_TEXTURE_2D, id_);
+        render_backend().bind_texture(GL_TEXTURE_2D, id_);
     }
     inline void unbind() {
-        glBindTexture(GL_TEXTURE_2D, 0);
+        render_backend().bind_texture(GL_TEXTURE_2D, 0);
     }
 
 private:
     GLuint id_;
 };
 
+/** \brief Specify a level of the bound 2D texture.
+* \param[in] level The mip level.
+* \param[in] width The level width.
+* \param[in] height The level height.
+* \param[in] internal_format The texture format.
+* \param[in] format The format of the texels, or 0 for compressed blocks.
+* \param[in] pixels The texels, or an offset in the bound pixel unpack buffer.
+* \param[in] size The size of the texels, in bytes.
+*/
+void specify_texture_level(GLint level,
+    unsigned int width, unsigned int height,
+    GLint internal_format, GLint format,
+    const void* pixels, size_t size);
+
 }
 
 #endif // HLMDLVIEWER_GLTEXTURE_H_
@@ -0,0 +1,72 @@
+/**
+* \file gltexturebuffer.cpp
+* \brief Implementation for the OpenGL texture buffer class.
+*/
+
+#include "pch.h"
+#include "gltexturebuffer.h"
+#include "render_backend.h"
+
+namespace hl_mdlviewer
+{
+
+gltexturebuffer::gltexturebuffer() :
+    texture_(0),
+    buffer_(0),
+    internal_format_(GL_RGBA32F),
+    capacity_(0)
+{
+}
+
+gltexturebuffer::~gltexturebuffer()
+{
+}
+
+void gltexturebuffer::initialize(GLenum internal_format)
+{
+    internal_format_ = internal_format;
+    capacity_ = 0;
+
+    RenderBackend& backend = render_backend();
+
+    buffer_ = backend.create_buffer();
+    texture_ = backend.create_texture();
+
+    backend.bind_buffer(GL_TEXTURE_BUFFER, buffer_);
+    backend.bind_texture(GL_TEXTURE_BUFFER, texture_);
+    backend.tex_buffer(GL_TEXTURE_BUFFER, internal_format_, buffer_);
+    backend.bind_texture(GL_TEXTURE_BUFFER, 0);
+    backend.bind_buffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void gltexturebuffer::delete_buffer()
+{
+    RenderBackend& backend = render_backend();
+    backend.delete_texture(texture_);
+    backend.delete_buffer(buffer_);
+    texture_ = buffer_ = 0;
+    capacity_ = 0;
+}
+
+void gltexturebuffer::set_data(const void* data, size_t size_in_bytes)
+{
+    RenderBackend& backend = render_backend();
+
+    backend.bind_buffer(GL_TEXTURE_BUFFER, buffer_);
+
+    // Grow geometrically so that a growing crowd does not reallocate
+    // every frame. Orphan the store otherwise.
+    if (size_in_bytes > capacity_)
+        capacity_ = std::max(size_in_bytes, capacity_ * 2);
+
+    backend.buffer_data(GL_TEXTURE_BUFFER, capacity_, NULL, GL_STREAM_DRAW);
+    backend.buffer_sub_data(GL_TEXTURE_BUFFER, 0, size_in_bytes, data);
+    backend.bind_buffer(GL_TEXTURE_BUFFER, 0);
+}
+
+GLint gltexturebuffer::max_texels()
+{
+    return render_backend().get_integer(GL_MAX_TEXTURE_BUFFER_SIZE);
+}
+
+}
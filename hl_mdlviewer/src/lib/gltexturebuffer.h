@@ -0,0 +1,55 @@
+/**
+* \file gltexturebuffer.h
+* \brief Declaration for the OpenGL texture buffer class.
+*/
+
+#ifndef HLMDLVIEWER_GLTEXTUREBUFFER_H_
+#define HLMDLVIEWER_GLTEXTUREBUFFER_H_
+
+#include "glad.h"
+#include "render_backend.h"
+
+namespace hl_mdlviewer {
+
+/** A class that wraps an OpenGL buffer texture, which lets shaders
+* fetch large arrays of data with texelFetch. */
+class gltexturebuffer
+{
+public:
+    gltexturebuffer();
+    ~gltexturebuffer();
+
+    inline const GLuint texture_id() const { return texture_; }
+    inline const GLuint buffer_id() const { return buffer_; }
+
+    void initialize(GLenum internal_format = GL_RGBA32F);
+
+    void delete_buffer();
+
+    /** \brief Replace the buffer content, orphaning the previous store
+    *          so that pending draws do not stall the upload.
+    * \param[in] data The data to upload.
+    * \param[in] size_in_bytes The size of \p data.
+    */
+    void set_data(const void* data, size_t size_in_bytes);
+
+    inline void bind(GLuint texture_unit) {
+        RenderBackend& backend = render_backend();
+        backend.active_texture(texture_unit);
+        backend.bind_texture(GL_TEXTURE_BUFFER, texture_);
+        backend.active_texture(0);
+    }
+
+    /** \brief Get the maximum number of texels a buffer texture may hold. */
+    static GLint max_texels();
+
+private:
+    GLuint texture_;
+    GLuint buffer_;
+    GLenum internal_format_;
+    size_t capacity_;
+};
+
+}
+
+#endif // HLMDLVIEWER_GLTEXTUREBUFFER_H_
@@ -5,12 +5,16 @@
 
 #include "pch.h"
 #include "gluniformbuffer.h"
+#include "render_backend.h"
 
 namespace hl_mdlviewer
 {
 
 gluniformbuffer::gluniformbuffer() :
-    id_(0)
+    id_(0),
+    size_(0),
+    usage_(GL_STATIC_DRAW),
+    mapped_(false)
 {
 }
 
@@ -23,11 +27,71 @@ void gluniformbuffer::initialize(
     size_t size_in_bytes,
     GLenum usage)
 {
-    glGenBuffers(1, &id_);
-    glBindBuffer(GL_UNIFORM_BUFFER, id_);
-    glBufferData(GL_UNIFORM_BUFFER, size_in_bytes, NULL, usage);
-    glBindBufferRange(GL_UNIFORM_BUFFER, block_index, id_, 0, size_in_bytes);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    create(size_in_bytes, usage);
+    render_backend().bind_buffer_range(GL_UNIFORM_BUFFER, block_index, id_, 0, size_in_bytes);
+}
+
+void gluniformbuffer::create(size_t size_in_bytes, GLenum usage)
+{
+    size_ = size_in_bytes;
+    usage_ = usage;
+
+    RenderBackend& backend = render_backend();
+
+    id_ = backend.create_buffer();
+    backend.bind_buffer(GL_UNIFORM_BUFFER, id_);
+    backend.buffer_data(GL_UNIFORM_BUFFER, size_in_bytes, NULL, usage);
+    backend.bind_buffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void* gluniformbuffer::create_persistent(size_t size_in_bytes)
+{
+    const GLbitfield flags =
+        GL_MAP_WRITE_BIT |
+        GL_MAP_PERSISTENT_BIT |
+        GL_MAP_COHERENT_BIT;
+
+    size_ = size_in_bytes;
+    usage_ = GL_STREAM_DRAW;
+
+    RenderBackend& backend = render_backend();
+
+    id_ = backend.create_buffer();
+    backend.bind_buffer(GL_UNIFORM_BUFFER, id_);
+    backend.buffer_storage(GL_UNIFORM_BUFFER, size_in_bytes, NULL, flags);
+    void* data = backend.map_buffer_range(GL_UNIFORM_BUFFER, 0, size_in_bytes, flags);
+    backend.bind_buffer(GL_UNIFORM_BUFFER, 0);
+
+    if (!data)
+        throw std::runtime_error("Failed to map persistent uniform buffer.");
+
+    mapped_ = true;
+    return data;
+}
+
+void gluniformbuffer::orphan()
+{
+    RenderBackend& backend = render_backend();
+    backend.bind_buffer(GL_UNIFORM_BUFFER, id_);
+    backend.buffer_data(GL_UNIFORM_BUFFER, size_, NULL, usage_);
+    backend.bind_buffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void gluniformbuffer::delete_buffer()
+{
+    RenderBackend& backend = render_backend();
+
+    if (mapped_)
+    {
+        backend.bind_buffer(GL_UNIFORM_BUFFER, id_);
+        backend.unmap_buffer(GL_UNIFORM_BUFFER);
+        backend.bind_buffer(GL_UNIFORM_BUFFER, 0);
+        mapped_ = false;
+    }
+
+    backend.delete_buffer(id_);
+    id_ = 0;
+    size_ = 0;
 }
 
 }
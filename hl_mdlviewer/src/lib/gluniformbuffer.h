@@ -7,6 +7,7 @@
 #define HLMDLVIEWER_GLUNIFORMBUFFER_H_
 
 #include "glad.h"
+#include "render_backend.h"
 #include <type_traits>
 
 namespace hl_mdlviewer {
@@ -25,12 +26,37 @@ public:
         size_t size_in_bytes, 
         GLenum usage = GL_STATIC_DRAW);
 
+    /** \brief Allocate the buffer store without binding it to a block.
+    * \param[in] size_in_bytes The buffer size.
+    * \param[in] usage The buffer usage hint.
+    */
+    void create(size_t size_in_bytes, GLenum usage = GL_STREAM_DRAW);
+
+    /** \brief Allocate an immutable store and map it persistently.
+    * \param[in] size_in_bytes The buffer size.
+    * \return The coherent write pointer to the whole buffer.
+    */
+    void* create_persistent(size_t size_in_bytes);
+
+    /** \brief Detach the current store so that the driver can hand
+    *          out fresh memory instead of waiting on pending draws.
+    */
+    void orphan();
+
+    void delete_buffer();
+
+    inline const size_t size() const { return size_; }
+
+    inline void bind_range(GLuint block_index, GLintptr offset, size_t size_in_bytes) {
+        render_backend().bind_buffer_range(GL_UNIFORM_BUFFER, block_index, id_, offset, size_in_bytes);
+    }
+
     inline void bind() {
-        glBindBuffer(GL_UNIFORM_BUFFER, id_);
+        render_backend().bind_buffer(GL_UNIFORM_BUFFER, id_);
     }
 
     inline void unbind() {
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        render_backend().bind_buffer(GL_UNIFORM_BUFFER, 0);
     }
 
     inline void set_data_unbinded(GLintptr offset, bool value) {
@@ -146,13 +172,13 @@ public:
     }
 
     inline void set_data_with_size(GLintptr offset, const void* data, size_t size_in_bytes) {
-        glBindBuffer(GL_UNIFORM_BUFFER, id_);
-        glBufferSubData(GL_UNIFORM_BUFFER, offset, size_in_bytes, data);
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        render_backend().bind_buffer(GL_UNIFORM_BUFFER, id_);
+        render_backend().buffer_sub_data(GL_UNIFORM_BUFFER, offset, size_in_bytes, data);
+        render_backend().bind_buffer(GL_UNIFORM_BUFFER, 0);
     }
 
     inline void set_data_unbinded_with_size(GLintptr offset, const void* data, size_t size_in_bytes) {
-        glBufferSubData(GL_UNIFORM_BUFFER, offset, size_in_bytes, data);
+        render_backend().buffer_sub_data(GL_UNIFORM_BUFFER, offset, size_in_bytes, data);
     }
 
 
@@ -160,19 +186,22 @@ protected:
 
     template<typename T, size_t SizeInBytes>
     inline void internal_set_data_unbinded(GLintptr offset, const T* data) {
-        glBufferSubData(GL_UNIFORM_BUFFER, offset, SizeInBytes, data);
+        render_backend().buffer_sub_data(GL_UNIFORM_BUFFER, offset, SizeInBytes, data);
     }
 
     template<typename T, size_t SizeInBytes>
     inline void internal_set_data(GLintptr offset, const T* data) {
-        glBindBuffer(GL_UNIFORM_BUFFER, id_);
-        glBufferSubData(GL_UNIFORM_BUFFER, offset, SizeInBytes, data);
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        render_backend().bind_buffer(GL_UNIFORM_BUFFER, id_);
+        render_backend().buffer_sub_data(GL_UNIFORM_BUFFER, offset, SizeInBytes, data);
+        render_backend().bind_buffer(GL_UNIFORM_BUFFER, 0);
     }
 
 private:
 
     GLuint id_;
+    size_t size_;
+    GLenum usage_;
+    bool mapped_;
 };
 
 }
@@ -0,0 +1,151 @@
+/**
+* \file gluniformringbuffer.cpp
+* \brief Implementation for the OpenGL streaming uniform buffer class.
+*/
+
+#include "pch.h"
+#include "gluniformringbuffer.h"
+#include "glcapabilities.h"
+#include "render_backend.h"
+#include <cstring>
+
+namespace hl_mdlviewer
+{
+
+gluniformringbuffer::gluniformringbuffer() :
+    buffer_(),
+    mapped_data_(nullptr),
+    region_size_(0),
+    alignment_(1),
+    num_regions_(0),
+    region_(0),
+    cursor_(0),
+    fences_()
+{
+}
+
+gluniformringbuffer::~gluniformringbuffer()
+{
+}
+
+void gluniformringbuffer::initialize(size_t region_size_in_bytes, int num_regions)
+{
+    const GLint alignment = render_backend().get_integer(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT);
+    alignment_ = static_cast<size_t>(std::max(alignment, 1));
+
+    // Round up so that every region starts on a valid binding offset.
+    region_size_ = (region_size_in_bytes + alignment_ - 1) / alignment_ * alignment_;
+
+    if (has_gl_buffer_storage())
+    {
+        num_regions_ = std::max(num_regions, 1);
+        mapped_data_ = static_cast<char*>(
+            buffer_.create_persistent(region_size_ * num_regions_));
+    }
+    else
+    {
+        // Orphaning gives us a fresh store every frame, so a single
+        // region is all we need.
+        num_regions_ = 1;
+        mapped_data_ = nullptr;
+        buffer_.create(region_size_, GL_STREAM_DRAW);
+    }
+
+    fences_.assign(num_regions_, nullptr);
+    region_ = 0;
+    cursor_ = 0;
+}
+
+void gluniformringbuffer::delete_buffer()
+{
+    for (auto& fence : fences_)
+    {
+        if (fence)
+            render_backend().delete_sync(fence);
+        fence = nullptr;
+    }
+    fences_.clear();
+
+    buffer_.delete_buffer();
+    mapped_data_ = nullptr;
+    region_size_ = 0;
+    num_regions_ = 0;
+}
+
+void gluniformringbuffer::begin_frame()
+{
+    cursor_ = 0;
+
+    if (persistent())
+    {
+        region_ = (region_ + 1) % num_regions_;
+        wait_for_region(region_);
+    }
+    else
+    {
+        buffer_.orphan();
+    }
+}
+
+void gluniformringbuffer::end_frame()
+{
+    if (!persistent())
+        return;
+
+    RenderBackend& backend = render_backend();
+
+    if (fences_[region_])
+        backend.delete_sync(fences_[region_]);
+    fences_[region_] = backend.fence_sync();
+}
+
+GLintptr gluniformringbuffer::push(const void* data, size_t size_in_bytes, size_t range_size_in_bytes)
+{
+    const size_t offset_in_region = (cursor_ + alignment_ - 1) / alignment_ * alignment_;
+    const size_t reserved_size = std::max(size_in_bytes, range_size_in_bytes);
+
+    if (offset_in_region + reserved_size > region_size_)
+        throw std::runtime_error("Uniform ring buffer region is full. Increase the region size.");
+
+    cursor_ = offset_in_region + reserved_size;
+
+    const GLintptr offset = static_cast<GLintptr>(region_ * region_size_ + offset_in_region);
+
+    if (persistent())
+    {
+        std::memcpy(mapped_data_ + offset, data, size_in_bytes);
+    }
+    else
+    {
+        buffer_.set_data_with_size(offset, data, size_in_bytes);
+    }
+
+    return offset;
+}
+
+void gluniformringbuffer::wait_for_region(int region)
+{
+    GLsync fence = fences_[region];
+    if (!fence)
+        return;
+
+    // Flush on the first wait only, otherwise we could wait forever on
+    // commands that were never submitted.
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    const GLuint64 timeout_ns = 1000000000;
+
+    for (;;)
+    {
+        GLenum result = render_backend().client_wait_sync(fence, flags, timeout_ns);
+        if (result == GL_ALREADY_SIGNALED ||
+            result == GL_CONDITION_SATISFIED ||
+            result == GL_WAIT_FAILED)
+            break;
+        flags = 0;
+    }
+
+    render_backend().delete_sync(fence);
+    fences_[region] = nullptr;
+}
+
+}
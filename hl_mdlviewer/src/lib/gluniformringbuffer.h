@@ -0,0 +1,87 @@
+/**
+* \file gluniformringbuffer.h
+* \brief Declaration for the OpenGL streaming uniform buffer class.
+*/
+
+#ifndef HLMDLVIEWER_GLUNIFORMRINGBUFFER_H_
+#define HLMDLVIEWER_GLUNIFORMRINGBUFFER_H_
+
+#include "glad.h"
+#include "gluniformbuffer.h"
+
+namespace hl_mdlviewer {
+
+/** \brief A streaming allocator for per-draw uniform data.
+*
+* The buffer is split into regions, one per frame in flight. Each frame
+* writes into its own region and fences it, so the CPU never overwrites
+* data the GPU may still be reading. When persistent mapping is not
+* available, the buffer is orphaned at the start of every frame instead.
+*/
+class gluniformringbuffer
+{
+public:
+    gluniformringbuffer();
+    ~gluniformringbuffer();
+
+    inline const GLuint id() const { return buffer_.id(); }
+    inline const bool persistent() const { return mapped_data_ != nullptr; }
+    inline const size_t region_size() const { return region_size_; }
+
+    /** \brief Create the buffer.
+    * \param[in] region_size_in_bytes The amount of data that can be
+    *            pushed during a single frame.
+    * \param[in] num_regions The number of frames that may be in flight.
+    */
+    void initialize(size_t region_size_in_bytes, int num_regions = 3);
+
+    void delete_buffer();
+
+    /** \brief Move to the next region, waiting on its fence if the GPU
+    *          has not consumed it yet. */
+    void begin_frame();
+
+    /** \brief Fence the current region. */
+    void end_frame();
+
+    /** \brief Copy \p data to the current region.
+    * \param[in] data The data to copy.
+    * \param[in] size_in_bytes The size of \p data.
+    * \param[in] range_size_in_bytes The size to reserve, which must
+    *            cover the uniform block that will read it.
+    * \return The offset of the data within the buffer.
+    */
+    GLintptr push(const void* data, size_t size_in_bytes, size_t range_size_in_bytes);
+
+    inline GLintptr push(const void* data, size_t size_in_bytes) {
+        return push(data, size_in_bytes, size_in_bytes);
+    }
+
+    inline void bind_range(GLuint block_index, GLintptr offset, size_t size_in_bytes) {
+        buffer_.bind_range(block_index, offset, size_in_bytes);
+    }
+
+private:
+
+    void wait_for_region(int region);
+
+    gluniformbuffer buffer_;
+
+    /** \brief The persistent write pointer, or null when orphaning. */
+    char* mapped_data_;
+
+    size_t region_size_;
+    size_t alignment_;
+
+    int num_regions_;
+    int region_;
+
+    /** \brief Write offset, relative to the current region. */
+    size_t cursor_;
+
+    std::vector<GLsync> fences_;
+};
+
+}
+
+#endif // HLMDLVIEWER_GLUNIFORMRINGBUFFER_H_
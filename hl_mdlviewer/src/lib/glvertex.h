@@ -5,6 +5,8 @@
 #ifndef HLMDLVIEWER_GLVERTEX_H_
 #define HLMDLVIEWER_GLVERTEX_H_
 
+#include <cstdint>
+#include <cmath>
 #include <glm/glm.hpp>
 
 namespace hl_mdlviewer {
@@ -18,6 +20,101 @@ struct glvertex
     int boneid;
 };
 
+/** \brief Represents a single vertex in a compact layout.
+*
+* The position stays in floating point so that vertices can be updated
+* at runtime without knowing the bounds of the whole buffer. The normal
+* is stored as signed normalized 10:10:10:2, the uv as unsigned
+* normalized 16 bits and the bone index as 8 bits.
+*/
+struct glvertex_packed
+{
+    glm::vec3 position;
+    uint32_t normal;
+    uint16_t uv[2];
+    uint8_t boneid;
+    uint8_t padding[3];
+};
+
+static_assert(sizeof(glvertex_packed) == 24, "glvertex_packed must be 24 bytes.");
+
+/** \brief The vertex layouts a buffer can be created with. */
+enum class VertexFormat
+{
+    STANDARD,   // glvertex
+    PACKED      // glvertex_packed
+};
+
+/** \brief The largest bone index a packed vertex can hold. */
+const int PACKED_VERTEX_MAX_BONE_INDEX = UINT8_MAX;
+
+inline uint32_t pack_snorm_10_10_10_2(const glm::vec3& v)
+{
+    auto pack = [](float value) -> uint32_t {
+        const float clamped = glm::clamp(value, -1.0f, 1.0f);
+        return static_cast<uint32_t>(static_cast<int32_t>(std::round(clamped * 511.0f))) & 0x3FF;
+    };
+
+    return pack(v.x) | (pack(v.y) << 10) | (pack(v.z) << 20);
+}
+
+inline glm::vec3 unpack_snorm_10_10_10_2(uint32_t packed)
+{
+    auto unpack = [](uint32_t bits) -> float {
+        // Sign extend the 10 bits.
+        const int32_t value = static_cast<int32_t>(bits << 22) >> 22;
+        return glm::max(static_cast<float>(value) / 511.0f, -1.0f);
+    };
+
+    return glm::vec3(unpack(packed & 0x3FF), unpack((packed >> 10) & 0x3FF), unpack((packed >> 20) & 0x3FF));
+}
+
+inline uint16_t pack_unorm_16(float value)
+{
+    return static_cast<uint16_t>(std::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+inline float unpack_unorm_16(uint16_t value)
+{
+    return static_cast<float>(value) / 65535.0f;
+}
+
+/** \brief Check whether a vertex only loses precision when packed, i.e.
+*          its UVs are in [0, 1] and its bone index fits in 8 bits. */
+inline bool can_pack_vertex(const glvertex& vertex)
+{
+    return vertex.uv.x >= 0.0f && vertex.uv.x <= 1.0f &&
+        vertex.uv.y >= 0.0f && vertex.uv.y <= 1.0f &&
+        vertex.boneid >= 0 && vertex.boneid <= PACKED_VERTEX_MAX_BONE_INDEX;
+}
+
+/** \brief Convert a vertex to the packed layout.
+* UVs outside [0, 1] are clamped and bone indices above
+* \ref PACKED_VERTEX_MAX_BONE_INDEX are truncated, see \ref can_pack_vertex.
+*/
+inline glvertex_packed pack_vertex(const glvertex& vertex)
+{
+    glvertex_packed packed;
+    packed.position = vertex.position;
+    packed.normal = pack_snorm_10_10_10_2(vertex.normal);
+    packed.uv[0] = pack_unorm_16(vertex.uv.x);
+    packed.uv[1] = pack_unorm_16(vertex.uv.y);
+    packed.boneid = static_cast<uint8_t>(vertex.boneid);
+    packed.padding[0] = packed.padding[1] = packed.padding[2] = 0;
+    return packed;
+}
+
+/** \brief Convert a packed vertex back, as the shaders read it. */
+inline glvertex unpack_vertex(const glvertex_packed& packed)
+{
+    glvertex vertex;
+    vertex.position = packed.position;
+    vertex.normal = unpack_snorm_10_10_10_2(packed.normal);
+    vertex.uv = glm::vec2(unpack_unorm_16(packed.uv[0]), unpack_unorm_16(packed.uv[1]));
+    vertex.boneid = packed.boneid;
+    return vertex;
+}
+
 const unsigned int PRIMITIVE_RESTART_INDEX = UINT_MAX;
 
 }
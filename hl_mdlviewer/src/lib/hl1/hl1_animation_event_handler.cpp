@@ -11,7 +11,8 @@ namespace hl1 {
 
 AnimationEventHandler::AnimationEventHandler(SoundSystem* sound_system) :
     last_event_frame_(-1),
-    sound_system_(sound_system)
+    sound_system_(sound_system),
+    event_sounds_()
 {
 }
 
@@ -25,39 +26,63 @@ void AnimationEventHandler::on_sequence_finished(const Sequence* sequence)
     last_event_frame_ = -1;
 }
 
-void AnimationEventHandler::handle_event(const AnimationEvent* event)
+void AnimationEventHandler::precache_sounds(const StudioModel* studio_model)
 {
-    if (event->event == SCRIPT_EVENT_SOUND)
+    clear_sounds();
+
+    if (!sound_system_)
+        return;
+
+    event_sounds_.resize(studio_model->sequences.size());
+    for (size_t i = 0; i < studio_model->sequences.size(); ++i)
     {
-        if (sound_system_)
+        const std::vector<AnimationEvent>& events = studio_model->sequences[i].events;
+        event_sounds_[i].assign(events.size(), INVALID_SOUND_HANDLE);
+
+        for (size_t j = 0; j < events.size(); ++j)
         {
-            char* pc = const_cast<char*>(event->options.c_str());
-            if (*pc != '\0')
-            {
-                while (*pc == '*' && *pc != '\0')
-                    pc++;
+            if (events[j].event != SCRIPT_EVENT_SOUND)
+                continue;
 
-                // Play the sound if we have a sound system.
-                sound_system_->play_sound(pc);
-            }
+            // The '*' prefixes are stream flags of the game, not part of the path.
+            const size_t path_begin = events[j].options.find_first_not_of('*');
+            if (path_begin == std::string::npos)
+                continue;
+
+            event_sounds_[i][j] = sound_system_->precache_sound(events[j].options.c_str() + path_begin);
         }
     }
 }
 
+void AnimationEventHandler::clear_sounds()
+{
+    event_sounds_.clear();
+}
+
+void AnimationEventHandler::handle_event(const Sequence* sequence, size_t event_index)
+{
+    const size_t sequence_index = static_cast<size_t>(sequence->index);
+    if (!sound_system_ || sequence_index >= event_sounds_.size() ||
+        event_index >= event_sounds_[sequence_index].size())
+        return;
+
+    // Play the sound if we have a sound system.
+    const SoundHandle sound = event_sounds_[sequence_index][event_index];
+    if (sound != INVALID_SOUND_HANDLE)
+        sound_system_->play_sound(sound);
+}
+
 void AnimationEventHandler::process_events(const Sequence* sequence, int frame)
 {
     if (last_event_frame_ < frame)
     {
-        const AnimationEvent* event = nullptr;
-
         for (size_t i = 0; i < sequence->events.size(); ++i)
         {
-            event = &sequence->events[i];
-            if (event->frame == frame)
+            if (sequence->events[i].frame == frame)
             {
                 last_event_frame_ = frame;
 
-                handle_event(event);
+                handle_event(sequence, i);
             }
         }
     }
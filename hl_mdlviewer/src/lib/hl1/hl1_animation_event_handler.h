@@ -10,6 +10,7 @@
 #include "hl1_sequence_listener.h"
 #include "sound_system.h"
 #include "file_system.h"
+#include <vector>
 
 namespace hl_mdlviewer {
 namespace hl1 {
@@ -27,6 +28,15 @@ public:
     */
     void process_events(const Sequence* sequence, int frame);
 
+    /** \brief Precache the sounds of the events of a model, so that
+    *          firing them does no file access.
+    * \param[in] studio_model The model.
+    */
+    void precache_sounds(const StudioModel* studio_model);
+
+    /** \brief Forget the sounds of the model. The sound system keeps them. */
+    void clear_sounds();
+
     // See SequenceListener interface for more info.
     virtual void on_change_sequence(const Sequence* old_sequence, const Sequence* new_sequence);
     
@@ -36,14 +46,19 @@ public:
 protected:
 
     /** \brief Called when an animation event is processed. 
-    * \param[in] event The animation event.
+    * \param[in] sequence The sequence of the event.
+    * \param[in] event_index The index of the event in the sequence.
     */
-    void handle_event(const AnimationEvent* event);
+    void handle_event(const Sequence* sequence, size_t event_index);
 
 private:
 
     int last_event_frame_;
     SoundSystem* sound_system_;
+
+    /** \brief The sound of each event, by sequence then by event.
+    * \ref INVALID_SOUND_HANDLE for the events without sound. */
+    std::vector<std::vector<SoundHandle>> event_sounds_;
 };
 
 }
@@ -0,0 +1,240 @@
+/**
+* \file hl1_animation_lod_scheduler.cpp
+* \brief Implementation for the HL1 animation level of detail scheduler class.
+*/
+
+#include "pch.h"
+#include "hl1_animation_lod_scheduler.h"
+#include <chrono>
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+AnimationLODScheduler::AnimationLODScheduler() :
+    settings_(),
+    model_masks_(),
+    instance_states_(),
+    interval_scale_(1.0f),
+    statistics_()
+{
+}
+
+void AnimationLODScheduler::set_settings(const AnimationLODSettings& settings)
+{
+    settings_ = settings;
+    interval_scale_ = 1.0f;
+}
+
+void AnimationLODScheduler::reset()
+{
+    model_masks_.clear();
+    instance_states_.clear();
+    statistics_ = AnimationLODStatistics();
+}
+
+void AnimationLODScheduler::compute_bone_masks(const StudioModel& studio_model,
+    std::vector<uint8_t> (&bone_masks)[NUM_ANIMATION_BONE_LEVELS])
+{
+    const int num_bones = static_cast<int>(studio_model.bones.size());
+
+    // The length of the longest chain of children of each bone. Children
+    // always come after their parent.
+    std::vector<int> heights(num_bones, 0);
+    for (int i = num_bones - 1; i >= 0; --i)
+    {
+        for (const Bone* child : studio_model.bones[i].children)
+            heights[i] = std::max(heights[i], heights[child->index] + 1);
+    }
+
+    // Bones that are hit or controlled are always animated.
+    std::vector<bool> important(num_bones, false);
+    for (int i = 0; i < num_bones; ++i)
+        important[i] = !studio_model.bones[i].bone_controllers.empty();
+
+    for (const Hitbox& hitbox : studio_model.hitboxes)
+    {
+        if (hitbox.bone && hitbox.bone->index >= 0 && hitbox.bone->index < num_bones)
+            important[hitbox.bone->index] = true;
+    }
+
+    for (int level = 0; level < NUM_ANIMATION_BONE_LEVELS; ++level)
+    {
+        bone_masks[level].resize(num_bones);
+        for (int i = 0; i < num_bones; ++i)
+            bone_masks[level][i] = (important[i] || heights[i] >= level) ? 1 : 0;
+    }
+}
+
+void AnimationLODScheduler::apply_frame_budget()
+{
+    if (settings_.frame_budget <= 0.0f)
+    {
+        interval_scale_ = 1.0f;
+        return;
+    }
+
+    // Back off quickly when over budget, recover slowly to avoid oscillating.
+    const double animation_time = statistics_.animation_time * 1e6;
+    if (animation_time > settings_.frame_budget)
+        interval_scale_ = std::min(interval_scale_ * 1.25f, static_cast<float>(settings_.max_update_interval));
+    else if (animation_time < settings_.frame_budget * 0.75f)
+        interval_scale_ = std::max(interval_scale_ / 1.05f, 1.0f);
+}
+
+void AnimationLODScheduler::schedule(const StudioModelScene& scene,
+    const glm::mat4& view_projection,
+    int viewport_height)
+{
+    apply_frame_budget();
+
+    statistics_.num_updated = 0;
+    statistics_.num_interpolated = 0;
+    statistics_.animation_time = 0.0;
+    statistics_.interval_scale = interval_scale_;
+
+    // Rebuild the masks of the models that changed.
+    model_masks_.resize(scene.num_models());
+    for (size_t i = 0; i < scene.num_models(); ++i)
+    {
+        if (model_masks_[i].studio_model != scene.get_studio_model(i))
+        {
+            model_masks_[i].studio_model = scene.get_studio_model(i);
+            compute_bone_masks(*model_masks_[i].studio_model, model_masks_[i].bone_masks);
+        }
+    }
+
+    if (instance_states_.size() != scene.num_instances())
+    {
+        InstanceState state;
+        state.model = 0;
+        state.sequence = -1;
+        state.interval = 1;
+        state.bone_level = 0;
+        state.age = 0;
+        state.num_poses = 0;
+        instance_states_.resize(scene.num_instances(), state);
+    }
+
+    // The screen height of a sphere is its diameter scaled by the vertical
+    // projection factor, over the distance.
+    const float projection_scale = glm::length(
+        glm::vec3(view_projection[0][1], view_projection[1][1], view_projection[2][1]));
+
+    for (uint32_t index : scene.visible_instances())
+    {
+        InstanceState& state = instance_states_[index];
+
+        if (!settings_.enabled)
+        {
+            state.interval = 1;
+            state.bone_level = 0;
+            continue;
+        }
+
+        glm::vec3 bbmin, bbmax;
+        scene.get_world_bounds(index, bbmin, bbmax);
+
+        const glm::vec3 center = (bbmin + bbmax) * 0.5f;
+        const float radius = glm::length(bbmax - bbmin) * 0.5f;
+        const float w = view_projection[0][3] * center.x + view_projection[1][3] * center.y +
+            view_projection[2][3] * center.z + view_projection[3][3];
+
+        // Full detail when the camera is inside the bounds.
+        const float size = w > radius
+            ? radius * projection_scale / w * viewport_height
+            : settings_.full_detail_size;
+
+        int interval = 1;
+        if (size < settings_.full_detail_size)
+            interval = static_cast<int>(std::ceil(settings_.full_detail_size / std::max(size, 1.0f)));
+        interval = static_cast<int>(std::ceil(interval * interval_scale_));
+        state.interval = std::min(std::max(interval, 1), std::max(settings_.max_update_interval, 1));
+
+        if (size >= settings_.reduced_bones_size)
+            state.bone_level = 0;
+        else if (size >= settings_.minimal_bones_size)
+            state.bone_level = 1;
+        else
+            state.bone_level = 2;
+    }
+}
+
+void AnimationLODScheduler::compute_bone_transforms(StudioModelScene& scene, size_t index,
+    std::vector<glm::mat4>& bones_transform)
+{
+    InstanceState& state = instance_states_[index];
+
+    const size_t model = scene.get_model(index);
+    const int sequence = scene.get_sequence(index);
+
+    // The poses of another sequence or model cannot be interpolated.
+    if (state.model != model || state.sequence != sequence)
+    {
+        state.model = model;
+        state.sequence = sequence;
+        state.num_poses = 0;
+    }
+
+    if (state.num_poses == 0 || state.age + 1 >= state.interval)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        const std::vector<uint8_t>* bone_mask = state.bone_level > 0
+            ? &model_masks_[model].bone_masks[state.bone_level]
+            : nullptr;
+
+        state.previous_pose.swap(state.current_pose);
+        state.previous_rotations.swap(state.current_rotations);
+        scene.compute_bone_transforms(index, bone_mask, state.current_pose);
+
+        state.current_rotations.resize(state.current_pose.size());
+        for (size_t i = 0; i < state.current_pose.size(); ++i)
+            state.current_rotations[i] = glm::quat_cast(glm::mat3(state.current_pose[i]));
+
+        statistics_.animation_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++statistics_.num_updated;
+
+        // Spread the updates of the instances over the interval.
+        state.age = state.num_poses == 0 ? static_cast<int>(index % state.interval) : 0;
+        state.num_poses = std::min(state.num_poses + 1, 2);
+    }
+    else
+    {
+        ++state.age;
+        ++statistics_.num_interpolated;
+    }
+
+    if (state.num_poses < 2 || state.interval <= 1 ||
+        state.previous_pose.size() != state.current_pose.size())
+    {
+        bones_transform = state.current_pose;
+        return;
+    }
+
+    const float t = std::min(static_cast<float>(state.age + 1) / state.interval, 1.0f);
+    const size_t num_bones = state.current_pose.size();
+
+    // Lerping the matrices would shrink and shear the bones in between.
+    bones_transform.resize(num_bones);
+    for (size_t i = 0; i < num_bones; ++i)
+    {
+        const glm::quat rotation = glm::slerp(state.previous_rotations[i], state.current_rotations[i], t);
+        const glm::vec4 origin = state.previous_pose[i][3] + (state.current_pose[i][3] - state.previous_pose[i][3]) * t;
+
+        bones_transform[i] = glm::mat4_cast(rotation);
+        bones_transform[i][3] = origin;
+    }
+}
+
+int AnimationLODScheduler::get_update_interval(size_t index) const
+{
+    return index < instance_states_.size() ? instance_states_[index].interval : 1;
+}
+
+int AnimationLODScheduler::get_bone_level(size_t index) const
+{
+    return index < instance_states_.size() ? instance_states_[index].bone_level : 0;
+}
+
+}
+}
@@ -0,0 +1,183 @@
+/**
+* \file hl1_animation_lod_scheduler.h
+* \brief Declaration for the HL1 animation level of detail scheduler class.
+*/
+
+#ifndef HLMDLVIEWER_HL1_ANIMATION_LOD_SCHEDULER_H_
+#define HLMDLVIEWER_HL1_ANIMATION_LOD_SCHEDULER_H_
+
+#include <cstdint>
+#include <vector>
+#include "hl1_studiomodel.h"
+#include "hl1_studiomodel_scene.h"
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+/** \brief The number of bone subsets, from all bones to the fewest. */
+const int NUM_ANIMATION_BONE_LEVELS = 3;
+
+struct AnimationLODSettings
+{
+    AnimationLODSettings() :
+        enabled(true),
+        full_detail_size(200.0f),
+        reduced_bones_size(80.0f),
+        minimal_bones_size(30.0f),
+        max_update_interval(8),
+        frame_budget(0.0f)
+    {
+    }
+
+    bool enabled;
+
+    /** \brief The screen height, in pixels, from which instances are
+    *          animated every frame. Smaller instances are updated less often. */
+    float full_detail_size;
+
+    /** \brief The screen heights below which the bone levels 1 and 2 are used. */
+    float reduced_bones_size;
+    float minimal_bones_size;
+
+    /** \brief The most frames between two pose updates of an instance. */
+    int max_update_interval;
+
+    /** \brief The time allowed for pose updates per frame, in microseconds,
+    *          or 0 for no budget. */
+    float frame_budget;
+};
+
+/** \brief The counters of the last frame of a \ref AnimationLODScheduler. */
+struct AnimationLODStatistics
+{
+    AnimationLODStatistics() :
+        num_updated(0),
+        num_interpolated(0),
+        animation_time(0.0),
+        interval_scale(1.0f)
+    {
+    }
+
+    /** \brief The instances whose pose was computed. */
+    size_t num_updated;
+
+    /** \brief The instances whose pose was interpolated. */
+    size_t num_interpolated;
+
+    /** \brief The time spent computing poses, in seconds. */
+    double animation_time;
+
+    /** \brief The factor applied to the update intervals by the frame budget. */
+    float interval_scale;
+};
+
+/** \brief Chooses how often, and with which bones, the visible instances
+*          of a scene are animated.
+*
+* Instances small on screen compute their pose every few frames only, and
+* leave the bones of least importance, such as fingers and faces, in their
+* bind pose. In between, the bone transforms are interpolated from the last
+* two computed poses, so the poses lag by one update interval. The bones
+* are rigid: their rotations are slerped and their origins lerped.
+*/
+class AnimationLODScheduler
+{
+public:
+    AnimationLODScheduler();
+    AnimationLODScheduler(const AnimationLODScheduler&) = delete;
+
+    void set_settings(const AnimationLODSettings& settings);
+    inline const AnimationLODSettings& settings() const { return settings_; }
+
+    /** \brief Forget the poses of the instances, i.e. once they changed. */
+    void reset();
+
+    /** \brief Choose the update interval and bones of the visible instances.
+    *
+    * Must be called once per frame, after the scene is culled and before
+    * the bone transforms are computed.
+    * \param[in] scene The scene.
+    * \param[in] view_projection The matrix the scene was culled with.
+    * \param[in] viewport_height The viewport height, in pixels.
+    */
+    void schedule(const StudioModelScene& scene, const glm::mat4& view_projection, int viewport_height);
+
+    /** \brief Compute or interpolate the bone transforms of a visible instance.
+    * \param[in] scene The scene.
+    * \param[in] index The instance index.
+    * \param[out] bones_transform The bone transforms in absolute space.
+    */
+    void compute_bone_transforms(StudioModelScene& scene, size_t index,
+        std::vector<glm::mat4>& bones_transform);
+
+    /** \brief Get the frames between two pose updates of an instance. */
+    int get_update_interval(size_t index) const;
+
+    /** \brief Get the bone level of an instance, 0 for all bones. */
+    int get_bone_level(size_t index) const;
+
+    inline const AnimationLODStatistics& statistics() const { return statistics_; }
+
+    /** \brief Compute the bones animated at each bone level of a model.
+    *
+    * A bone is dropped from level n if its longest chain of children is
+    * shorter than n bones, i.e. the leaves go first, unless it has a hitbox
+    * or a bone controller.
+    * \param[in] studio_model The model.
+    * \param[out] bone_masks The masks, non-zero for the animated bones.
+    */
+    static void compute_bone_masks(const StudioModel& studio_model,
+        std::vector<uint8_t> (&bone_masks)[NUM_ANIMATION_BONE_LEVELS]);
+
+private:
+
+    struct ModelMasks
+    {
+        ModelMasks() :
+            studio_model(nullptr)
+        {
+        }
+
+        const StudioModel* studio_model;
+        std::vector<uint8_t> bone_masks[NUM_ANIMATION_BONE_LEVELS];
+    };
+
+    struct InstanceState
+    {
+        size_t model;
+        int sequence;
+        int interval;
+        int bone_level;
+
+        /** \brief The frames since the pose was last computed. */
+        int age;
+
+        /** \brief The number of poses computed, up to 2. */
+        int num_poses;
+
+        std::vector<glm::mat4> previous_pose;
+        std::vector<glm::mat4> current_pose;
+
+        /** \brief The rotations of the bone transforms of the poses. */
+        std::vector<glm::quat> previous_rotations;
+        std::vector<glm::quat> current_rotations;
+    };
+
+    /** \brief Adapt the interval scale to the time spent last frame. */
+    void apply_frame_budget();
+
+    AnimationLODSettings settings_;
+
+    std::vector<ModelMasks> model_masks_;
+    std::vector<InstanceState> instance_states_;
+
+    /** \brief The factor applied to the update intervals in frame budget mode. */
+    float interval_scale_;
+
+    AnimationLODStatistics statistics_;
+};
+
+}
+}
+
+#endif // HLMDLVIEWER_HL1_ANIMATION_LOD_SCHEDULER_H_
@@ -0,0 +1,185 @@
+/**
+* \file hl1_instancing_benchmark.cpp
+* \brief Implementation for the HL1 instancing benchmark class.
+*/
+
+#include "pch.h"
+#include "hl1_instancing_benchmark.h"
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+InstancingBenchmark::InstancingBenchmark() :
+    running_(false),
+    instance_counts_(),
+    step_(0),
+    warmup_frames_(0),
+    measured_frames_(0),
+    frame_(0),
+    frame_start_(),
+    last_frame_start_(),
+    frame_time_total_(0),
+    num_frame_samples_(0),
+    cpu_time_total_(0),
+    gpu_time_total_(0),
+    num_gpu_samples_(0),
+    queries_(),
+    query_pending_(),
+    query_measured_(),
+    query_index_(0),
+    results_()
+{
+}
+
+InstancingBenchmark::~InstancingBenchmark()
+{
+}
+
+void InstancingBenchmark::start(const std::vector<int>& instance_counts,
+    int warmup_frames,
+    int measured_frames)
+{
+    if (running_)
+        stop();
+
+    if (instance_counts.empty())
+        return;
+
+    instance_counts_ = instance_counts;
+    warmup_frames_ = std::max(warmup_frames, 1);
+    measured_frames_ = std::max(measured_frames, 1);
+    results_.clear();
+
+    glGenQueries(NUM_QUERIES, queries_);
+    for (int i = 0; i < NUM_QUERIES; ++i)
+    {
+        query_pending_[i] = false;
+        query_measured_[i] = false;
+    }
+    query_index_ = 0;
+
+    step_ = 0;
+    frame_ = 0;
+    frame_time_total_ = 0;
+    num_frame_samples_ = 0;
+    cpu_time_total_ = 0;
+    gpu_time_total_ = 0;
+    num_gpu_samples_ = 0;
+
+    running_ = true;
+}
+
+void InstancingBenchmark::stop()
+{
+    if (!running_)
+        return;
+
+    glDeleteQueries(NUM_QUERIES, queries_);
+    running_ = false;
+}
+
+int InstancingBenchmark::instance_count() const
+{
+    return running_ ? instance_counts_[step_] : 0;
+}
+
+void InstancingBenchmark::begin_frame()
+{
+    if (!running_)
+        return;
+
+    frame_start_ = clock::now();
+
+    // The first measured frame has no previous frame to compare with.
+    if (frame_ > warmup_frames_)
+    {
+        frame_time_total_ += std::chrono::duration<double, std::milli>(
+            frame_start_ - last_frame_start_).count();
+        ++num_frame_samples_;
+    }
+    last_frame_start_ = frame_start_;
+
+    read_queries(false);
+
+    // All queries are in flight, wait for the oldest one.
+    if (query_pending_[query_index_])
+        read_queries(true);
+
+    glBeginQuery(GL_TIME_ELAPSED, queries_[query_index_]);
+}
+
+void InstancingBenchmark::end_frame()
+{
+    if (!running_)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+
+    const bool measured = frame_ >= warmup_frames_;
+
+    query_pending_[query_index_] = true;
+    query_measured_[query_index_] = measured;
+    query_index_ = (query_index_ + 1) % NUM_QUERIES;
+
+    if (measured)
+    {
+        cpu_time_total_ += std::chrono::duration<double, std::milli>(
+            clock::now() - frame_start_).count();
+    }
+
+    if (++frame_ >= warmup_frames_ + measured_frames_)
+        next_step();
+}
+
+void InstancingBenchmark::read_queries(bool wait)
+{
+    for (int i = 0; i < NUM_QUERIES; ++i)
+    {
+        if (!query_pending_[i])
+            continue;
+
+        if (!wait)
+        {
+            GLint available = 0;
+            glGetQueryObjectiv(queries_[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+        }
+
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(queries_[i], GL_QUERY_RESULT, &elapsed_ns);
+        query_pending_[i] = false;
+
+        if (query_measured_[i])
+        {
+            gpu_time_total_ += static_cast<double>(elapsed_ns) / 1000000.0;
+            ++num_gpu_samples_;
+        }
+    }
+}
+
+void InstancingBenchmark::next_step()
+{
+    // Collect the queries of this step before the instance count changes.
+    read_queries(true);
+
+    InstancingBenchmarkResult result;
+    result.instance_count = instance_counts_[step_];
+    result.frame_time_ms = num_frame_samples_ ? frame_time_total_ / num_frame_samples_ : 0;
+    result.cpu_time_ms = cpu_time_total_ / measured_frames_;
+    result.gpu_time_ms = num_gpu_samples_ ? gpu_time_total_ / num_gpu_samples_ : 0;
+    results_.push_back(result);
+
+    frame_ = 0;
+    frame_time_total_ = 0;
+    num_frame_samples_ = 0;
+    cpu_time_total_ = 0;
+    gpu_time_total_ = 0;
+    num_gpu_samples_ = 0;
+
+    if (++step_ >= instance_counts_.size())
+        stop();
+}
+
+}
+}
@@ -0,0 +1,104 @@
+/**
+* \file hl1_instancing_benchmark.h
+* \brief Declaration for the HL1 instancing benchmark class.
+*/
+
+#ifndef HLMDLVIEWER_HL1_INSTANCING_BENCHMARK_H_
+#define HLMDLVIEWER_HL1_INSTANCING_BENCHMARK_H_
+
+#include <chrono>
+#include <vector>
+#include "glad.h"
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+/** \brief The timings measured for a single instance count. */
+struct InstancingBenchmarkResult
+{
+    int instance_count;
+
+    /** \brief The average time between two frames, in milliseconds. */
+    double frame_time_ms;
+
+    /** \brief The average CPU time spent drawing, in milliseconds. */
+    double cpu_time_ms;
+
+    /** \brief The average GPU time spent drawing, in milliseconds. */
+    double gpu_time_ms;
+};
+
+/** \brief Steps through a list of instance counts, measuring frame time
+* for each of them.
+*
+* The benchmark is driven by the draw loop: call \ref begin_frame and
+* \ref end_frame around the drawing code, and render \ref instance_count
+* instances in between. GPU timer queries are read back a few frames late
+* so that the benchmark never stalls the pipeline.
+*/
+class InstancingBenchmark
+{
+public:
+    InstancingBenchmark();
+    ~InstancingBenchmark();
+
+    /** \brief Start the benchmark.
+    * \param[in] instance_counts The instance counts to measure.
+    * \param[in] warmup_frames The number of frames to skip after each change.
+    * \param[in] measured_frames The number of frames to measure.
+    */
+    void start(const std::vector<int>& instance_counts,
+        int warmup_frames = 30,
+        int measured_frames = 120);
+
+    void stop();
+
+    inline bool running() const { return running_; }
+
+    /** \brief Get the number of instances to render this frame. */
+    int instance_count() const;
+
+    void begin_frame();
+    void end_frame();
+
+    /** \brief Get the results of the steps done, all of them once the
+    *          benchmark is no longer running. */
+    const std::vector<InstancingBenchmarkResult>& results() const { return results_; }
+
+private:
+    using clock = std::chrono::high_resolution_clock;
+
+    void read_queries(bool wait);
+    void next_step();
+
+    static const int NUM_QUERIES = 4;
+
+    bool running_;
+
+    std::vector<int> instance_counts_;
+    size_t step_;
+    int warmup_frames_;
+    int measured_frames_;
+    int frame_;
+
+    clock::time_point frame_start_;
+    clock::time_point last_frame_start_;
+
+    double frame_time_total_;
+    int num_frame_samples_;
+    double cpu_time_total_;
+    double gpu_time_total_;
+    int num_gpu_samples_;
+
+    GLuint queries_[NUM_QUERIES];
+    bool query_pending_[NUM_QUERIES];
+    bool query_measured_[NUM_QUERIES];
+    int query_index_;
+
+    std::vector<InstancingBenchmarkResult> results_;
+};
+
+}
+}
+
+#endif // HLMDLVIEWER_HL1_INSTANCING_BENCHMARK_H_
@@ -9,13 +9,35 @@
 #include "hl1_mdlviewer_view.h"
 #include "hl1_studiomodel_setup.h"
 #include "hl1_ui_setup.h"
+#include "glcapabilities.h"
+#include <filesystem>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+namespace fs = std::filesystem;
+
 namespace hl_mdlviewer {
 namespace hl1 {
 
+namespace {
+
+/** \brief The processed textures and the linked programs are cached with
+* the temporary files.
+* \param[in] name The folder of the cache.
+*/
+std::string get_default_cache_directory(const char* name)
+{
+    std::error_code error;
+    const fs::path directory = fs::temp_directory_path(error);
+    if (error)
+        return std::string();
+
+    return (directory / "hl_mdlviewer" / name).string();
+}
+
+}
+
 HL1MDLViewerPresenter::HL1MDLViewerPresenter(HL1MDLViewerView* view) :
     file_system_(),
     sound_system_(&file_system_),
@@ -29,8 +51,20 @@ HL1MDLViewerPresenter::HL1MDLViewerPresenter(HL1MDLViewerView* view) :
         &event_handler_,
         &frame_interpolation_),
     model_loaded_(false),
-    scene_(nullptr)
+    vertex_format_(VertexFormat::PACKED),
+    texture_settings_(),
+    scene_(nullptr),
+    instances_(),
+    animation_lod_(),
+    canvas_height_(1),
+    instance_bones_transform_(),
+    instancing_benchmark_(),
+    crowd_size_before_benchmark_(0),
+    dirty_flags_(0)
 {
+    texture_settings_.cache_directory = get_default_cache_directory("textures");
+    model_render_.set_program_cache_directory(get_default_cache_directory("programs"));
+
     view_->set_presenter(this);
 }
 
@@ -38,10 +72,33 @@ void HL1MDLViewerPresenter::setup_default_search_paths()
 {
     file_system_.add_search_path(HLMDLVIEWER_SHADERS_SEARCH_PATH);
     file_system_.add_search_path(HLMDLVIEWER_GAME_SOUNDS_SEARCH_PATH);
+
+    // The sounds shipped in the game archives, under the loose files. The
+    // last archive overrides the previous ones, like in the game.
+    const fs::path game_directory = fs::path(HLMDLVIEWER_GAME_SOUNDS_SEARCH_PATH).parent_path();
+    std::vector<fs::path> archives;
+    std::error_code error;
+    while (fs::exists(game_directory / ("pak" + std::to_string(archives.size()) + ".pak"), error))
+        archives.push_back(game_directory / ("pak" + std::to_string(archives.size()) + ".pak"));
+
+    for (auto archive = archives.rbegin(); archive != archives.rend(); ++archive)
+    {
+        try
+        {
+            file_system_.add_archive(archive->string().c_str(), -1, "sound");
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+    }
 }
 
 void HL1MDLViewerPresenter::initialize()
 {
+    // Files added while the viewer runs, e.g. sounds, are found without a
+    // refresh where the platform can watch the folders.
+    file_system_.set_watch_changes(true);
     setup_default_search_paths();
     
     view_->initialize();
@@ -54,6 +111,15 @@ void HL1MDLViewerPresenter::run()
     view_->run();
 }
 
+void HL1MDLViewerPresenter::refresh_files()
+{
+    file_system_.invalidate();
+
+    // Look for the sounds of the model again.
+    if (model_loaded_)
+        event_handler_.precache_sounds(&studio_model_);
+}
+
 void HL1MDLViewerPresenter::dispose()
 {
     view_->dispose();
@@ -74,8 +140,17 @@ void HL1MDLViewerPresenter::load_model(const std::string& file_path)
 
         // Convert the loaded MDL file to Studiomodel data.
         StudioModelSetup model_setup;
+        model_setup.set_texture_uploader(model_render_.get_texture_uploader());
+
+        TextureSetupSettings texture_settings = texture_settings_;
+        texture_settings.compress = texture_settings.compress && has_gl_texture_compression_s3tc();
+        model_setup.set_texture_settings(texture_settings);
         glm::mat4 scene_transform(1.0f);
-        model_setup.setup_model(scene_, &studio_model_, model_render_.get_buffer(), scene_transform);
+        model_setup.setup_model(scene_, &studio_model_, model_render_.get_buffer(), scene_transform,
+            vertex_format_);
+
+        // Load the event sounds while the rest of the model is set up.
+        event_handler_.precache_sounds(&studio_model_);
 
         // Notify of a new Studiomodel.
         model_animation_.on_model_changed();
@@ -83,6 +158,8 @@ void HL1MDLViewerPresenter::load_model(const std::string& file_path)
 
         model_render_.set_scene_transform(scene_transform);
 
+        instances_.add_model(&studio_model_, &model_animation_, model_render_.get_buffer(), scene_transform);
+
         // Set renderer sequence bounds.
         const auto* current_sequence = &studio_model_.sequences[animation_data()->sequence];
         model_render_.set_sequence_bounds(
@@ -100,6 +177,7 @@ void HL1MDLViewerPresenter::load_model(const std::string& file_path)
 
         // Give the UI data to the view.
         view_->setup_ui(ui_data);
+        update_mesh_lods();
 
         // Use the view interface to update the view.
         set_bodypart(0);
@@ -139,6 +217,7 @@ void HL1MDLViewerPresenter::load_model(const std::string& file_path)
     }
 
     // Tell the view to redraw itself.
+    invalidate_frame(DIRTY_MODEL | DIRTY_POSE);
     view_->invalidate();
 }
 
@@ -146,12 +225,18 @@ void HL1MDLViewerPresenter::unload_model()
 {
     studio_model_.clear();
 
+    event_handler_.clear_sounds();
     model_animation_.reset();
     model_render_.reset();
 
+    instancing_benchmark_.stop();
+    instances_.clear();
+    animation_lod_.reset();
+
     bodypart_ = 0;
 
     model_loaded_ = false;
+    dirty_flags_ = DIRTY_MODEL;
 }
 
 void HL1MDLViewerPresenter::set_bodypart(int bodypart)
@@ -172,6 +257,7 @@ void HL1MDLViewerPresenter::set_bodypart(int bodypart)
 void HL1MDLViewerPresenter::set_bodypart_model(int model)
 {
     model_render_.set_model(bodypart_, model);
+    invalidate_frame(DIRTY_SETTINGS);
 
     view_->set_model(bodypart_, model,
         studio_model_.bodyparts[bodypart_].models[model]->name.c_str());
@@ -180,12 +266,14 @@ void HL1MDLViewerPresenter::set_bodypart_model(int model)
 void HL1MDLViewerPresenter::set_skin(int skin)
 {
     model_render_.set_skin(skin);
+    invalidate_frame(DIRTY_SETTINGS);
     view_->set_skin(skin);
 }
 
 void HL1MDLViewerPresenter::set_bone_controller(int index, float value)
 {
     model_animation_.set_bone_controller(index, value);
+    invalidate_frame(DIRTY_POSE);
     view_->set_bone_controller(index, value);
 }
 
@@ -195,116 +283,333 @@ void HL1MDLViewerPresenter::set_sequence(int value)
     model_render_.set_sequence_bounds(
         studio_model_.sequences[value].bbmin,
         studio_model_.sequences[value].bbmax);
+    invalidate_frame(DIRTY_POSE | DIRTY_SETTINGS);
     view_->set_sequence(value, studio_model_.sequences[value].name.c_str());
 }
 
 void HL1MDLViewerPresenter::set_playback_rate(float value)
 {
     model_animation_.set_playback_rate(value);
+    invalidate_frame(DIRTY_POSE);
     view_->set_playback_rate(value);
 }
 
 void HL1MDLViewerPresenter::set_blending(int index, uint8_t value)
 {
     model_animation_.set_blending(index, value);
+    invalidate_frame(DIRTY_POSE);
     view_->set_blend_controller(index, value);
 }
 
 void HL1MDLViewerPresenter::set_render_mode(RenderMode render_mode)
 {
     model_render_.set_render_mode(render_mode);
+    invalidate_frame(DIRTY_SETTINGS);
     view_->set_render_mode(render_mode);
 }
 
 void HL1MDLViewerPresenter::set_show_normals(bool enabled)
 {
     model_render_.set_show_normals(enabled);
+    invalidate_frame(DIRTY_SETTINGS);
     view_->set_show_normals(enabled);
 }
 
 void HL1MDLViewerPresenter::set_show_bones(bool enabled)
 {
     model_render_.set_show_bones(enabled);
+    invalidate_frame(DIRTY_SETTINGS);
     view_->set_show_bones(enabled);
 }
 
 void HL1MDLViewerPresenter::set_show_attachments(bool enabled)
 {
     model_render_.set_show_attachments(enabled);
+    invalidate_frame(DIRTY_SETTINGS);
     view_->set_show_attachments(enabled);
 }
 
 void HL1MDLViewerPresenter::set_show_hitboxes(bool enabled)
 {
     model_render_.set_show_hitboxes(enabled);
+    invalidate_frame(DIRTY_SETTINGS);
     view_->set_show_hitboxes(enabled);
 }
 
 void HL1MDLViewerPresenter::set_show_sequence_bbox(bool enabled)
 {
     model_render_.set_show_sequence_bbox(enabled);
+    invalidate_frame(DIRTY_SETTINGS);
     view_->set_show_sequence_bbox(enabled);
 }
 
 void HL1MDLViewerPresenter::set_highlight_models(bool enabled)
 {
     model_render_.set_highlight_models(enabled);
+    invalidate_frame(DIRTY_SETTINGS);
     view_->set_highlight_models(enabled);
 }
 
 void HL1MDLViewerPresenter::set_draw_wireframe(bool enabled)
 {
     model_render_.set_draw_wireframe(enabled);
+    invalidate_frame(DIRTY_SETTINGS);
     view_->set_draw_wireframe(enabled);
 }
 
 void HL1MDLViewerPresenter::set_draw_chrome_effects(bool enabled)
 {
     model_render_.set_draw_chrome_effects(enabled);
+    invalidate_frame(DIRTY_SETTINGS);
     view_->set_draw_chrome_effects(enabled);
 }
 
 void HL1MDLViewerPresenter::set_lighting_enabled(bool enabled)
 {
     model_render_.set_lighting_enabled(enabled);
+    invalidate_frame(DIRTY_SETTINGS);
     view_->set_lighting_enabled(enabled);
 }
 
 void HL1MDLViewerPresenter::draw_model(float frame_time)
 {
     if (!model_loaded_)
+    {
+        dirty_flags_ = 0;
         return;
+    }
 
-    model_animation_.update(frame_time);
+    // A paused pose is only computed again once it changed.
+    if (is_animating())
+        model_animation_.update(frame_time);
+    else if (dirty_flags_ & DIRTY_POSE)
+        model_animation_.update(0.0f);
 
+    if (instancing_benchmark_.running())
+    {
+        if (static_cast<int>(instances_.num_instances()) != instancing_benchmark_.instance_count())
+            set_crowd_size(instancing_benchmark_.instance_count());
+        instancing_benchmark_.begin_frame();
+    }
+
+    model_render_.begin_frame();
     model_render_.set_bones_transform(model_animation_.get_bone_transforms());
     model_render_.setup_view();
     model_render_.render();
+    draw_instances(frame_time);
+    model_render_.end_frame();
+
+    dirty_flags_ = 0;
+
+    if (instancing_benchmark_.running())
+    {
+        instancing_benchmark_.end_frame();
+
+        // Restore the crowd and show the results once the last step is done.
+        if (!instancing_benchmark_.running())
+        {
+            set_crowd_size(crowd_size_before_benchmark_);
+            view_->set_instancing_benchmark_results(instancing_benchmark_.results());
+            view_->invalidate();
+        }
+    }
+}
+
+bool HL1MDLViewerPresenter::is_animating() const
+{
+    if (!model_loaded_)
+        return false;
+
+    // A paused crowd is only drawn again when something changes.
+    if (instances_.has_playing_instances() || instancing_benchmark_.running())
+        return true;
+
+    const StudioModelAnimationData* data = animation_data();
+    if (data->sequence < 0 || data->sequence >= static_cast<int>(studio_model_.sequences.size()))
+        return false;
+
+    // Sequences always loop, so a playing sequence never comes to rest.
+    return studio_model_.sequences[data->sequence].num_frames > 1 && data->playback_rate > 0.0f;
+}
+
+void HL1MDLViewerPresenter::draw_instances(float frame_time)
+{
+    if (instances_.num_instances() == 0)
+        return;
+
+    // Only the visible instances are animated and drawn.
+    const glm::mat4 view_projection = model_render_.get_view_projection_matrix();
+    instances_.cull(view_projection);
+    instances_.animate(frame_time);
+    animation_lod_.schedule(instances_, view_projection, canvas_height_);
+
+    const std::vector<uint32_t>& visible_instances = instances_.visible_instances();
+    model_render_.set_instance_count(visible_instances.size());
+
+    const size_t num_instances = model_render_.instance_count();
+    for (size_t i = 0; i < num_instances; ++i)
+    {
+        const uint32_t index = visible_instances[i];
+
+        animation_lod_.compute_bone_transforms(instances_, index, instance_bones_transform_);
+
+        model_render_.set_instance(i, instances_.get_transform(index), instances_.get_skin(index),
+            instance_bones_transform_);
+    }
+
+    model_render_.render_instanced();
+}
+
+void HL1MDLViewerPresenter::set_instances(const std::vector<StudioModelInstance>& instances)
+{
+    instances_.clear_instances();
+    animation_lod_.reset();
+    invalidate_frame(DIRTY_MODEL);
+
+    if (!model_loaded_)
+        return;
+
+    for (const StudioModelInstance& instance : instances)
+        instances_.add_instance(0, instance);
+}
+
+void HL1MDLViewerPresenter::clear_instances()
+{
+    instances_.clear_instances();
+    animation_lod_.reset();
+    invalidate_frame(DIRTY_MODEL);
+}
+
+void HL1MDLViewerPresenter::set_crowd_size(int count)
+{
+    instances_.clear_instances();
+    animation_lod_.reset();
+    invalidate_frame(DIRTY_MODEL);
+
+    if (!model_loaded_ || count <= 0)
+        return;
+
+    const int sequence_index = animation_data()->sequence;
+    const Sequence& sequence = studio_model_.sequences[sequence_index];
+
+    // Space the instances by the horizontal extent of the sequence bounds.
+    const glm::vec3 size = sequence.bbmax - sequence.bbmin;
+    const float spacing = std::max(std::max(size.x, size.y), 1.0f) * 1.25f;
+
+    // Find the smallest odd grid that fits the instances around the model.
+    int side = 1;
+    while (side * side - 1 < count)
+        side += 2;
+
+    std::vector<glm::ivec2> cells;
+    const int half_side = side / 2;
+    for (int z = -half_side; z <= half_side; ++z)
+    {
+        for (int x = -half_side; x <= half_side; ++x)
+        {
+            // The model itself sits at the origin.
+            if (x != 0 || z != 0)
+                cells.emplace_back(x, z);
+        }
+    }
+
+    // Fill the grid from the center outward.
+    std::stable_sort(cells.begin(), cells.end(),
+        [](const glm::ivec2& a, const glm::ivec2& b) {
+            return std::max(std::abs(a.x), std::abs(a.y)) < std::max(std::abs(b.x), std::abs(b.y));
+        });
+
+    const int num_skins = std::max(static_cast<int>(studio_model_.stats.num_skin_families), 1);
+
+    for (int i = 0; i < count; ++i)
+    {
+        StudioModelInstance instance;
+        instance.transform = glm::translate(glm::mat4(1.0f),
+            glm::vec3(cells[i].x * spacing, 0, cells[i].y * spacing));
+        instance.skin = i % num_skins;
+        instance.sequence = sequence_index;
+        instance.playback_rate = animation_data()->playback_rate;
+
+        // Stagger the instances so they do not all play in lockstep.
+        instance.frame = sequence.num_frames > 1
+            ? static_cast<float>((i * 7) % (sequence.num_frames - 1))
+            : 0.0f;
+
+        instances_.add_instance(0, instance);
+    }
+}
+
+void HL1MDLViewerPresenter::set_animation_lod_settings(const AnimationLODSettings& settings)
+{
+    animation_lod_.set_settings(settings);
+    invalidate_frame(DIRTY_SETTINGS);
+}
+
+void HL1MDLViewerPresenter::start_instancing_benchmark()
+{
+    if (!model_loaded_)
+        return;
+
+    crowd_size_before_benchmark_ = static_cast<int>(instances_.num_instances());
+
+    instancing_benchmark_.start({ 1, 10, 50, 100, 250, 500, 1000 });
+    view_->set_instancing_benchmark_results(instancing_benchmark_.results());
 }
 
 void HL1MDLViewerPresenter::set_canvas_dimensions(int width, int height)
 {
     model_render_.setup_projection_matrix(width, height);
+    canvas_height_ = std::max(height, 1);
+    invalidate_frame(DIRTY_VIEW);
+
+    if (model_loaded_)
+    {
+        update_mesh_lods();
+        view_->invalidate();
+    }
+}
+
+void HL1MDLViewerPresenter::update_mesh_lods()
+{
+    const StudioModelBuffer* buffer = model_render_.get_buffer();
+    const std::vector<size_t>& num_triangles = buffer->statistics.mesh_lod_triangles;
+
+    std::vector<UIMeshLOD> mesh_lods(num_triangles.size());
+    for (size_t i = 0; i < mesh_lods.size(); ++i)
+    {
+        const int lod = static_cast<int>(i);
+        mesh_lods[i].level = lod;
+        mesh_lods[i].num_triangles = num_triangles[i];
+        mesh_lods[i].num_full_triangles = num_triangles[0];
+        mesh_lods[i].max_error = lod > 0 ? buffer->mesh_lod_errors[i - 1] : 0.0f;
+        mesh_lods[i].min_distance = lod > 0 ? model_render_.mesh_lod_distance(lod) : 0.0f;
+    }
+
+    view_->set_mesh_lods(mesh_lods);
 }
 
 void HL1MDLViewerPresenter::update_angles(const glm::vec2& delta)
 {
     model_render_.update_angles(delta);
+    invalidate_frame(DIRTY_VIEW);
 }
 
 void HL1MDLViewerPresenter::update_pan(const glm::vec2& delta)
 {
     model_render_.update_pan(delta);
+    invalidate_frame(DIRTY_VIEW);
 }
 
 void HL1MDLViewerPresenter::update_camera_distance(const float distance)
 {
     model_render_.update_camera_distance(distance);
+    invalidate_frame(DIRTY_VIEW);
 }
 
 void HL1MDLViewerPresenter::update_camera_distance_zoom_step(const bool forward)
 {
     model_render_.update_camera_distance_zoom_step(forward);
+    invalidate_frame(DIRTY_VIEW);
 }
 
 }
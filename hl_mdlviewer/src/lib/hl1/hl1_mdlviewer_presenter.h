@@ -9,6 +9,11 @@
 #include "mdlviewer_presenter.h"
 #include "hl1_studiomodel_animation.h"
 #include "hl1_studiomodel_render.h"
+#include "hl1_studiomodel_instance.h"
+#include "hl1_studiomodel_scene.h"
+#include "hl1_studiomodel_setup.h"
+#include "hl1_animation_lod_scheduler.h"
+#include "hl1_instancing_benchmark.h"
 #include "sound_system.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -18,6 +23,15 @@ namespace hl1 {
 
 class HL1MDLViewerView;
 
+/** \brief What changed since the last frame was drawn. */
+enum FrameDirtyFlags : unsigned int
+{
+    DIRTY_POSE = 1 << 0,
+    DIRTY_VIEW = 1 << 1,
+    DIRTY_SETTINGS = 1 << 2,
+    DIRTY_MODEL = 1 << 3
+};
+
 class HL1MDLViewerPresenter : public MDLViewerPresenter
 {
 public:
@@ -27,6 +41,11 @@ public:
     virtual void load_model(const std::string& file_path);
     virtual void dispose();
 
+    /** \brief Scan the folders and the current directory again, for files
+    *          added or removed since, e.g. sounds. The folders are also
+    *          scanned again once they change, where they can be watched. */
+    virtual void refresh_files();
+
     virtual void setup_default_search_paths();
 
     virtual void set_bodypart(int value);
@@ -47,13 +66,59 @@ public:
     virtual void set_draw_chrome_effects(bool enabled);
     virtual void set_lighting_enabled(bool enabled);
 
+    /** \brief Set the vertex layout used by models loaded from now on.
+    * \param[in] vertex_format The vertex layout.
+    */
+    virtual void set_vertex_format(VertexFormat vertex_format) { vertex_format_ = vertex_format; }
+
+    /** \brief Set how the textures of the models loaded from now on are
+    *          processed. Compression is ignored without S3TC support. */
+    virtual void set_texture_settings(const TextureSetupSettings& settings) { texture_settings_ = settings; }
+    const TextureSetupSettings& texture_settings() const { return texture_settings_; }
+
     virtual void draw_model(float frame_time);
+
+    /** \brief Whether frames must be drawn continuously, i.e. a sequence
+    *          or instances are playing. */
+    bool is_animating() const;
+
+    /** \brief Whether something changed since the last frame was drawn,
+    *          or textures are still being uploaded. */
+    inline bool needs_redraw() const { return dirty_flags_ != 0 || model_render_.has_pending_uploads(); }
+
+    /** \brief Request a new frame, e.g. after a change outside the presenter. */
+    inline void invalidate_frame(unsigned int flags) { dirty_flags_ |= flags; }
+
     virtual void set_canvas_dimensions(int width, int height);
     virtual void update_angles(const glm::vec2& delta);
     virtual void update_pan(const glm::vec2& delta);
     virtual void update_camera_distance(const float distance);
     virtual void update_camera_distance_zoom_step(const bool forward);
 
+    /** \brief Set the instances drawn around the model.
+    * \param[in] instances The instances. Their transform is relative to the model.
+    */
+    virtual void set_instances(const std::vector<StudioModelInstance>& instances);
+    virtual void clear_instances();
+
+    /** \brief Get the instances, and the culling statistics of the last frame. */
+    const StudioModelScene& instances() const { return instances_; }
+
+    /** \brief Set how the distant instances are animated. */
+    void set_animation_lod_settings(const AnimationLODSettings& settings);
+    const AnimationLODScheduler& animation_lod() const { return animation_lod_; }
+
+    /** \brief Lay out \p count instances on a grid around the model.
+    * \param[in] count The number of instances.
+    */
+    virtual void set_crowd_size(int count);
+
+    /** \brief Measure frame time against a growing number of instances.
+    * The results are given to the view once the last step is done. */
+    virtual void start_instancing_benchmark();
+
+    const InstancingBenchmark& instancing_benchmark() const { return instancing_benchmark_; }
+
 protected:
 
     const StudioModelAnimationData* animation_data() const { return model_animation_.animation_data(); }
@@ -68,6 +133,13 @@ protected:
 
     void unload_model();
 
+    /** \brief Cull the instances, then advance and render the visible ones. */
+    void draw_instances(float frame_time);
+
+    /** \brief Show the triangles of the mesh levels of detail, and the
+    *          distances they are drawn from with the current projection. */
+    void update_mesh_lods();
+
 private:
 
     FileSystem file_system_;
@@ -78,6 +150,12 @@ private:
 
     bool model_loaded_;
 
+    /** \brief The vertex layout used when loading models. */
+    VertexFormat vertex_format_;
+
+    /** \brief How the textures are processed when loading models. */
+    TextureSetupSettings texture_settings_;
+
     /** \brief The active bodypart. */
     int bodypart_;
 
@@ -92,6 +170,26 @@ private:
     StudioModelAnimation model_animation_;
     AnimationEventHandler event_handler_;
     FrameInterpolation frame_interpolation_;
+
+    /** \brief The instances of the model, model 0 of the scene. */
+    StudioModelScene instances_;
+
+    /** \brief Chooses how often, and with which bones, the instances are animated. */
+    AnimationLODScheduler animation_lod_;
+
+    /** \brief The canvas height, to measure the instances on screen. */
+    int canvas_height_;
+
+    /** \brief Scratch bone transforms used when animating instances. */
+    std::vector<glm::mat4> instance_bones_transform_;
+
+    InstancingBenchmark instancing_benchmark_;
+
+    /** \brief The crowd size before the benchmark started. */
+    int crowd_size_before_benchmark_;
+
+    /** \brief The \ref FrameDirtyFlags of the changes not drawn yet. */
+    unsigned int dirty_flags_;
 };
 
 }
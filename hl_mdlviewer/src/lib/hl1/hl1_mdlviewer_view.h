@@ -7,6 +7,7 @@
 #define HLMDLVIEWER_HL1_MDLVIEWER_VIEW_H_
 
 #include "mdlviewer_view.h"
+#include "hl1_instancing_benchmark.h"
 #include "hl1_model_render_settings.h"
 #include "hl1_ui_data.h"
 
@@ -40,6 +41,12 @@ public:
     virtual void set_lighting_enabled(bool enabled) = 0;
 
     virtual void setup_ui(const UIData& ui_data) = 0;
+
+    /** \brief Show the triangles of each mesh level of detail. */
+    virtual void set_mesh_lods(const std::vector<UIMeshLOD>& mesh_lods) = 0;
+
+    /** \brief Show the frame times measured for each instance count. */
+    virtual void set_instancing_benchmark_results(const std::vector<InstancingBenchmarkResult>& results) = 0;
 };
 
 }
@@ -32,6 +32,8 @@ struct ModelRenderSettings
         render_wireframe(false),
         render_chrome_effects(false),
         lighting_enabled(false),
+        mesh_lod_enabled(true),
+        mesh_lod_max_screen_error(1.0f),
         attachment_color(glm::vec4(1,1,1,1)),
         bone_segment_color(glm::vec4(1,1,0,1)),
         bone_vertex_color(glm::vec4(1,0,0,1)),
@@ -52,6 +54,13 @@ struct ModelRenderSettings
     bool render_wireframe;
     bool render_chrome_effects;
     bool lighting_enabled;
+
+    /** Whether instances use the simplified meshes when small on screen. */
+    bool mesh_lod_enabled;
+
+    /** The simplification error allowed on screen, in pixels. */
+    float mesh_lod_max_screen_error;
+
     glm::vec4 attachment_color;
     glm::vec4 bone_segment_color;
     glm::vec4 bone_vertex_color;
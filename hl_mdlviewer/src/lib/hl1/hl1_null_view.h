@@ -50,6 +50,8 @@ public:
     virtual void set_lighting_enabled(bool enabled) {}
 
     virtual void setup_ui(const UIData& ui_data) {}
+    virtual void set_mesh_lods(const std::vector<UIMeshLOD>& mesh_lods) {}
+    virtual void set_instancing_benchmark_results(const std::vector<InstancingBenchmarkResult>& results) {}
 };
 
 }
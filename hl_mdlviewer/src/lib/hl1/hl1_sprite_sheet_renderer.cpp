@@ -0,0 +1,506 @@
+/**
+* \file hl1_sprite_sheet_renderer.cpp
+* \brief Implementation for the HL1 sprite sheet renderer class.
+*/
+
+#include "pch.h"
+#include "hl1_sprite_sheet_renderer.h"
+#include "hl1_animation_event_handler.h"
+#include "hl1_frame_interpolation.h"
+#include "hl1_studiomodel_animation.h"
+#include "hl1_studiomodel_bounds.h"
+#include "hl1_studiomodel_render_data.h"
+#include "hl1_studiomodel_setup.h"
+#include "async_file_writer.h"
+#include "content_hash.h"
+#include "png_writer.h"
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+namespace {
+
+/** \brief Changed when the output of a given model and settings changes. */
+const char* const SPRITE_SHEET_VERSION = "2";
+
+/** \brief The margin around the framed sequence bounds. */
+const float FRAMING_MARGIN = 1.05f;
+
+/** \brief The number of sequence group files looked for, as with modelXX.mdl. */
+const int MAX_SEQUENCE_GROUPS = 32;
+
+/** \brief Get the camera matrices of a cell.
+* \param[in] view_settings The field of view and clip planes.
+* \param[in] camera The camera.
+* \param[in] bounds The bounds to frame, in the model scene space, or null.
+* \param[in] scene_transform The scene transform of the model.
+* \param[in] width The cell width.
+* \param[in] height The cell height.
+*/
+void get_camera_matrices(RenderViewSettings view_settings,
+    const CameraPreset& camera,
+    const BoneBounds* bounds,
+    const glm::mat4& scene_transform,
+    unsigned int width, unsigned int height,
+    glm::mat4& projection, glm::mat4& view, glm::mat4& model)
+{
+    model = get_model_matrix(camera.angles);
+
+    glm::vec2 pan(0.0f);
+    view_settings.zdistance = camera.zdistance;
+
+    const glm::vec3 size = bounds ? glm::mat3(scene_transform) * (bounds->bbmax - bounds->bbmin) : glm::vec3(0.0f);
+
+    if (camera.zdistance <= 0.0f && glm::length(size) > 0.0f)
+    {
+        // Fit the bounding sphere in the narrowest field of view.
+        const glm::vec3 center = glm::vec3(model * scene_transform *
+            glm::vec4((bounds->bbmin + bounds->bbmax) * 0.5f, 1.0f));
+        const float radius = glm::length(size) * 0.5f;
+
+        const float half_fov_y = view_settings.fov_radians * 0.5f;
+        const float half_fov_x = std::atan(std::tan(half_fov_y) * width / height);
+        const float distance = radius * FRAMING_MARGIN / std::sin(std::min(half_fov_x, half_fov_y));
+
+        pan = -glm::vec2(center.x, center.y);
+        view_settings.zdistance = center.z + distance;
+        view_settings.zfar = std::max(view_settings.zfar, distance + radius * 2.0f);
+    }
+    else if (camera.zdistance <= 0.0f)
+    {
+        view_settings.zdistance = RenderViewSettings().zdistance;
+    }
+
+    projection = get_projection_matrix(view_settings, width, height);
+    view = get_view_matrix(view_settings, pan);
+}
+
+/** \brief Copy a cell into a sheet. */
+void blit(const Image& source, Image& destination, unsigned int x, unsigned int y)
+{
+    const size_t row_size = static_cast<size_t>(source.width) * 4;
+
+    for (unsigned int row = 0; row < source.height; ++row)
+        std::copy(source.pixel(0, row), source.pixel(0, row) + row_size, destination.pixel(x, y + row));
+}
+
+}
+
+const char* const SpriteSheetRenderer::MANIFEST_FILE_NAME = "sprite_sheets.manifest";
+
+const std::vector<CameraPreset>& get_camera_presets()
+{
+    static const std::vector<CameraPreset> presets = {
+        { "front", glm::vec3(0.0f, 0.0f, 0.0f), 0.0f },
+        { "side", glm::vec3(0.0f, M_PI_F * 0.5f, 0.0f), 0.0f },
+        { "back", glm::vec3(0.0f, M_PI_F, 0.0f), 0.0f },
+        { "three_quarter", glm::vec3(M_PI_F / 12.0f, M_PI_F * 0.25f, 0.0f), 0.0f },
+        { "top", glm::vec3(M_PI_F * 0.5f, 0.0f, 0.0f), 0.0f }
+    };
+
+    return presets;
+}
+
+const CameraPreset* find_camera_preset(const std::string& name)
+{
+    for (const CameraPreset& preset : get_camera_presets())
+    {
+        if (preset.name == name)
+            return &preset;
+    }
+
+    return nullptr;
+}
+
+std::string SpriteSheetSettings::to_key() const
+{
+    std::ostringstream key;
+
+    auto write_list = [&key](const std::vector<int>& values) {
+        key << '[';
+        for (int value : values)
+            key << value << ',';
+        key << ']';
+    };
+
+    key << SPRITE_SHEET_VERSION << ' '
+        << cell_width << 'x' << cell_height << ' '
+        << columns << ' ' << frames_per_sequence << ' ';
+    write_list(sequences);
+    write_list(skins);
+    write_list(bodies);
+
+    for (const CameraPreset& camera : cameras)
+    {
+        key << camera.name << '(' << camera.angles.x << ',' << camera.angles.y << ','
+            << camera.angles.z << ',' << camera.zdistance << ')';
+    }
+
+    key << ' ' << view_settings.fov_radians << ' ' << view_settings.znear << ' ' << view_settings.zfar
+        << ' ' << render_settings.render_mode
+        << ' ' << render_settings.lighting_enabled
+        << ' ' << render_settings.render_chrome_effects
+        << ' ' << render_settings.smooth_color.x << ',' << render_settings.smooth_color.y
+        << ',' << render_settings.smooth_color.z << ',' << render_settings.smooth_color.w
+        << ' ' << background_color.x << ',' << background_color.y
+        << ',' << background_color.z << ',' << background_color.w;
+
+    return key.str();
+}
+
+SpriteSheetRenderer::SpriteSheetRenderer(const SpriteSheetSettings& settings, size_t num_threads) :
+    settings_(settings),
+    settings_key_(),
+    thread_pool_(num_threads),
+    renderers_()
+{
+    if (settings_.cell_width == 0 || settings_.cell_height == 0)
+        throw std::runtime_error("The sprite sheet cells must not be empty");
+
+    if (settings_.frames_per_sequence < 1)
+        settings_.frames_per_sequence = 1;
+
+    if (settings_.cameras.empty())
+        settings_.cameras.push_back(*find_camera_preset("front"));
+
+    settings_key_ = settings_.to_key();
+
+    for (size_t i = 0; i < thread_pool_.num_threads(); ++i)
+    {
+        // Models are rendered in parallel, so each renderer is single threaded.
+        renderers_.push_back(std::make_unique<StudioModelSoftwareRender>());
+        renderers_.back()->resize(settings_.cell_width, settings_.cell_height);
+        renderers_.back()->set_clear_color(settings_.background_color);
+    }
+}
+
+size_t SpriteSheetRenderer::render_model(const std::string& model_path, Image& sheet, size_t thread_index)
+{
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(model_path, aiProcess_ValidateDataStructure | aiProcess_PopulateArmatureData);
+    if (!scene)
+        throw std::runtime_error(importer.GetErrorString());
+
+    // The model is only needed on the CPU, and never drawn again.
+    StudioModel studio_model;
+    StudioModelBuffer buffer;
+    glm::mat4 scene_transform(1.0f);
+
+    StudioModelSetup model_setup;
+    model_setup.set_num_mesh_lods(0);
+    model_setup.setup_model(scene, &studio_model, &buffer, scene_transform,
+        VertexFormat::STANDARD, false, BufferStorage::CPU);
+
+    AnimationEventHandler animation_event_handler;
+    FrameInterpolation frame_interpolation;
+    StudioModelAnimation animation(&studio_model, &animation_event_handler, &frame_interpolation);
+    animation.on_model_changed();
+
+    std::vector<int> sequences = settings_.sequences;
+    if (sequences.empty())
+    {
+        sequences.resize(std::max(studio_model.sequences.size(), static_cast<size_t>(1)));
+        std::iota(sequences.begin(), sequences.end(), 0);
+    }
+
+    sequences.erase(std::remove_if(sequences.begin(), sequences.end(), [&studio_model](int sequence) {
+        return sequence < 0 || (sequence > 0 && sequence >= static_cast<int>(studio_model.sequences.size()));
+    }), sequences.end());
+
+    // Skins past the last skin family fall back to the default one.
+    size_t num_skins = 1;
+    for (const Texture& texture : studio_model.textures)
+        num_skins = std::max(num_skins, texture.skin_textures.size() + 1);
+
+    std::vector<int> skins = settings_.skins.empty() ? std::vector<int>(1, 0) : settings_.skins;
+    skins.erase(std::remove_if(skins.begin(), skins.end(), [num_skins](int skin) {
+        return skin < 0 || skin >= static_cast<int>(num_skins);
+    }), skins.end());
+
+    const std::vector<int> bodies = settings_.bodies.empty() ? std::vector<int>(1, 0) : settings_.bodies;
+
+    const size_t num_frames = settings_.frames_per_sequence;
+    const size_t num_cells = sequences.size() * skins.size() * bodies.size() * settings_.cameras.size() * num_frames;
+
+    if (num_cells == 0)
+        throw std::runtime_error("No sequence or skin to render");
+
+    const unsigned int columns = settings_.columns ? settings_.columns : static_cast<unsigned int>(num_frames);
+    const unsigned int rows = static_cast<unsigned int>((num_cells + columns - 1) / columns);
+
+    sheet = Image(columns * settings_.cell_width, rows * settings_.cell_height);
+
+    StudioModelSoftwareRender& renderer = *renderers_[thread_index];
+    StudioModelRenderData render_data;
+    size_t cell = 0;
+
+    StudioModelBounds model_bounds;
+    model_bounds.setup(studio_model, buffer);
+
+    std::vector<std::vector<glm::mat4>> frames_bones_transform(num_frames);
+
+    for (int sequence : sequences)
+    {
+        const Sequence* studio_sequence = studio_model.sequences.empty() ? nullptr : &studio_model.sequences[sequence];
+
+        // Frame the vertices of the rendered frames, rather than the
+        // sequence bounds which are often much larger.
+        BoneBounds sequence_bounds;
+        bool has_bounds = false;
+
+        for (size_t i = 0; i < num_frames; ++i)
+        {
+            // Frames are interpolated with the next one, so the last
+            // frame itself is never sampled.
+            const float frame = studio_sequence
+                ? static_cast<float>(i) * (studio_sequence->num_frames - 1) / num_frames
+                : 0.0f;
+
+            animation.compute_bone_transforms(studio_sequence ? sequence : 0, frame, frames_bones_transform[i]);
+
+            glm::vec3 bbmin, bbmax;
+            if (model_bounds.compute(frames_bones_transform[i], BoundsMode::VERTICES, bbmin, bbmax))
+            {
+                sequence_bounds.bbmin = has_bounds ? glm::min(sequence_bounds.bbmin, bbmin) : bbmin;
+                sequence_bounds.bbmax = has_bounds ? glm::max(sequence_bounds.bbmax, bbmax) : bbmax;
+                has_bounds = true;
+            }
+        }
+
+        if (!has_bounds && studio_sequence)
+        {
+            sequence_bounds.bbmin = studio_sequence->bbmin;
+            sequence_bounds.bbmax = studio_sequence->bbmax;
+            has_bounds = true;
+        }
+
+        for (int skin : skins)
+        {
+            for (int body : bodies)
+            {
+                render_data.initialize(skin, studio_model.bodyparts.size());
+                get_body_models(studio_model, body, render_data.model);
+
+                for (const CameraPreset& camera : settings_.cameras)
+                {
+                    glm::mat4 projection, view, model;
+                    get_camera_matrices(settings_.view_settings, camera, has_bounds ? &sequence_bounds : nullptr, scene_transform,
+                        settings_.cell_width, settings_.cell_height, projection, view, model);
+                    renderer.set_matrices(projection, view, model, scene_transform);
+
+                    for (size_t i = 0; i < num_frames; ++i, ++cell)
+                    {
+                        renderer.render(studio_model, buffer, render_data, settings_.render_settings,
+                            frames_bones_transform[i]);
+
+                        blit(renderer.color_buffer(), sheet,
+                            static_cast<unsigned int>(cell % columns) * settings_.cell_width,
+                            static_cast<unsigned int>(cell / columns) * settings_.cell_height);
+                    }
+                }
+            }
+        }
+    }
+
+    return num_cells;
+}
+
+bool SpriteSheetRenderer::get_model_hash(const std::string& model_path, uint64_t& hash) const
+{
+    hash = hash_string_64(settings_key_);
+
+    if (!hash_file_64(model_path, hash))
+        return false;
+
+    // The texture and sequence group files, named after the model.
+    const fs::path path(model_path);
+    const std::string base = (path.parent_path() / path.stem()).string();
+    const std::string extension = path.extension().string();
+
+    std::vector<std::string> companion_files;
+    companion_files.push_back(base + "T" + extension);
+
+    for (int i = 1; i < MAX_SEQUENCE_GROUPS; ++i)
+        companion_files.push_back(base + (i < 10 ? "0" : "") + std::to_string(i) + extension);
+
+    for (const std::string& file : companion_files)
+    {
+        std::error_code error;
+        if (!fs::exists(file, error))
+            continue;
+
+        hash = hash_string_64(fs::path(file).filename().string(), hash);
+
+        if (!hash_file_64(file, hash))
+            return false;
+    }
+
+    return true;
+}
+
+void SpriteSheetRenderer::get_body_models(const StudioModel& studio_model, int body, std::vector<int>& models)
+{
+    models.assign(studio_model.bodyparts.size(), 0);
+
+    int base = 1;
+
+    for (size_t i = 0; i < studio_model.bodyparts.size(); ++i)
+    {
+        const int num_models = static_cast<int>(studio_model.bodyparts[i].models.size());
+        if (num_models == 0)
+            continue;
+
+        models[i] = (body / base) % num_models;
+        base *= num_models;
+    }
+}
+
+SpriteSheetBatchResult SpriteSheetRenderer::render_batch(const std::vector<std::string>& model_paths,
+    const std::string& output_directory,
+    bool force)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    SpriteSheetBatchResult result;
+
+    fs::create_directories(output_directory);
+
+    const std::string manifest_path = (fs::path(output_directory) / MANIFEST_FILE_NAME).string();
+
+    std::map<std::string, std::string> previous_hashes;
+    read_manifest(manifest_path, previous_hashes);
+
+    std::vector<std::string> file_names;
+    get_output_file_names(model_paths, file_names);
+
+    std::ofstream manifest(manifest_path, std::ios::app);
+    if (!manifest.is_open())
+        throw std::runtime_error("Failed to open \"" + manifest_path + "\"");
+
+    std::mutex result_mutex;
+
+    auto add_error = [&](const std::string& path, const std::string& error) {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        ++result.num_failed;
+        result.errors.push_back(path + ": " + error);
+    };
+
+    {
+        AsyncFileWriter writer;
+
+        thread_pool_.parallel_for(model_paths.size(), [&](size_t index, size_t thread_index) {
+            const std::string& model_path = model_paths[index];
+            const std::string& file_name = file_names[index];
+            const std::string output_path = (fs::path(output_directory) / file_name).string();
+
+            uint64_t hash = 0;
+            if (!get_model_hash(model_path, hash))
+            {
+                add_error(model_path, "Failed to read the model");
+                return;
+            }
+
+            const std::string hash_string = hash_to_string(hash);
+
+            if (!force)
+            {
+                auto it = previous_hashes.find(file_name);
+                std::error_code error;
+
+                if (it != previous_hashes.end() && it->second == hash_string && fs::exists(output_path, error))
+                {
+                    std::lock_guard<std::mutex> lock(result_mutex);
+                    ++result.num_skipped;
+                    return;
+                }
+            }
+
+            auto sheet = std::make_shared<Image>();
+            size_t num_cells = 0;
+
+            try
+            {
+                num_cells = render_model(model_path, *sheet, thread_index);
+            }
+            catch (const std::exception& e)
+            {
+                add_error(model_path, e.what());
+                return;
+            }
+
+            writer.write(
+                [sheet, output_path] {
+                    write_png(output_path, *sheet);
+                },
+                [&, num_cells, hash_string, file_name, model_path, output_path](const std::string& error) {
+                    if (!error.empty())
+                    {
+                        add_error(output_path, error);
+                        return;
+                    }
+
+                    // Only record the sheets that made it to the disk.
+                    std::lock_guard<std::mutex> lock(result_mutex);
+                    ++result.num_rendered;
+                    result.num_cells += num_cells;
+                    manifest << hash_string << '\t' << file_name << '\t' << model_path << std::endl;
+                });
+        });
+
+        writer.flush();
+    }
+
+    result.elapsed_time = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start_time).count();
+
+    return result;
+}
+
+void SpriteSheetRenderer::read_manifest(const std::string& manifest_path,
+    std::map<std::string, std::string>& hashes)
+{
+    std::ifstream manifest(manifest_path);
+    std::string line;
+
+    while (std::getline(manifest, line))
+    {
+        const size_t hash_end = line.find('\t');
+        if (hash_end == std::string::npos)
+            continue;
+
+        const size_t file_name_end = line.find('\t', hash_end + 1);
+        if (file_name_end == std::string::npos)
+            continue;
+
+        hashes[line.substr(hash_end + 1, file_name_end - hash_end - 1)] = line.substr(0, hash_end);
+    }
+}
+
+void SpriteSheetRenderer::get_output_file_names(const std::vector<std::string>& model_paths,
+    std::vector<std::string>& file_names)
+{
+    std::map<std::string, int> stem_counts;
+
+    file_names.clear();
+
+    for (const std::string& model_path : model_paths)
+    {
+        const std::string stem = fs::path(model_path).stem().string();
+        const int count = stem_counts[stem]++;
+
+        file_names.push_back(count ? stem + "_" + std::to_string(count) + ".png" : stem + ".png");
+    }
+}
+
+}
+}
@@ -0,0 +1,205 @@
+/**
+* \file hl1_sprite_sheet_renderer.h
+* \brief Declaration for the HL1 sprite sheet renderer class.
+*/
+
+#ifndef HLMDLVIEWER_HL1_SPRITE_SHEET_RENDERER_H_
+#define HLMDLVIEWER_HL1_SPRITE_SHEET_RENDERER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "hl1_model_render_settings.h"
+#include "hl1_studiomodel.h"
+#include "hl1_studiomodel_software_render.h"
+#include "render_view_settings.h"
+#include "image.h"
+#include "thread_pool.h"
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+/** \brief A fixed camera, orbiting the model as the viewer does. */
+struct CameraPreset
+{
+    std::string name;
+
+    /** \brief The model angles, in radians. */
+    glm::vec3 angles;
+
+    /** \brief The camera distance, or 0 to frame the sequence bounds. */
+    float zdistance;
+};
+
+/** \brief Get the built-in camera presets: front, side, back, three_quarter and top. */
+const std::vector<CameraPreset>& get_camera_presets();
+
+/** \brief Find a built-in camera preset by name.
+* \return The preset, or null if there is none with that name.
+*/
+const CameraPreset* find_camera_preset(const std::string& name);
+
+/** \brief What to render in each sprite sheet.
+*
+* A sheet holds one cell for each combination of sequence, skin, body,
+* camera and frame, in this order, laid out row by row.
+*/
+struct SpriteSheetSettings
+{
+    SpriteSheetSettings() :
+        cell_width(128),
+        cell_height(128),
+        columns(0),
+        sequences(),
+        frames_per_sequence(4),
+        skins(),
+        bodies(),
+        cameras(),
+        view_settings(),
+        render_settings(),
+        background_color(0.0f, 0.0f, 0.0f, 0.0f)
+    {
+        render_settings.lighting_enabled = true;
+    }
+
+    unsigned int cell_width;
+    unsigned int cell_height;
+
+    /** \brief The number of cells per row, or 0 for one row per
+    * sequence, skin, body and camera. */
+    unsigned int columns;
+
+    /** \brief The sequence indices, or empty for all of them. */
+    std::vector<int> sequences;
+
+    /** \brief The number of frames sampled evenly across each sequence. */
+    int frames_per_sequence;
+
+    /** \brief The skins, or empty for the default skin only. */
+    std::vector<int> skins;
+
+    /** \brief The body values, each selecting a model in every bodypart
+    * as in the game, or empty for the default models only. */
+    std::vector<int> bodies;
+
+    /** \brief The cameras, or empty for the front camera only. */
+    std::vector<CameraPreset> cameras;
+
+    /** \brief The field of view and clip planes. */
+    RenderViewSettings view_settings;
+    ModelRenderSettings render_settings;
+    glm::vec4 background_color;
+
+    /** \brief Get a string identifying the settings that change the
+    * output, so that a change re-renders all models. */
+    std::string to_key() const;
+};
+
+/** \brief The outcome of \ref SpriteSheetRenderer::render_batch. */
+struct SpriteSheetBatchResult
+{
+    SpriteSheetBatchResult() :
+        num_rendered(0),
+        num_skipped(0),
+        num_failed(0),
+        num_cells(0),
+        elapsed_time(0.0),
+        errors()
+    {
+    }
+
+    inline double models_per_second() const {
+        return elapsed_time > 0.0 ? num_rendered / elapsed_time : 0.0;
+    }
+
+    size_t num_rendered;
+
+    /** \brief The models whose sheets were up to date. */
+    size_t num_skipped;
+    size_t num_failed;
+    size_t num_cells;
+
+    /** \brief The wall clock time of the batch, in seconds. */
+    double elapsed_time;
+
+    std::vector<std::string> errors;
+};
+
+/** \brief Renders sprite sheets of HL1 models on the CPU.
+*
+* Models are loaded and rendered in parallel, one model per thread, and
+* the PNG files are encoded and written on a background thread. A
+* manifest in the output directory records the content hash of each
+* rendered model, so that later batches only render the models, or
+* settings, that changed. The manifest is appended after each written
+* sheet, thus an interrupted batch resumes where it stopped.
+*/
+class SpriteSheetRenderer
+{
+public:
+    static const char* const MANIFEST_FILE_NAME;
+
+    /** \param[in] settings The sheet settings.
+    * \param[in] num_threads The number of threads, 0 for the hardware concurrency.
+    */
+    explicit SpriteSheetRenderer(const SpriteSheetSettings& settings, size_t num_threads = 0);
+    SpriteSheetRenderer(const SpriteSheetRenderer&) = delete;
+
+    /** \brief Render the sheets of several models into a directory.
+    * \param[in] model_paths The MDL files.
+    * \param[in] output_directory The directory of the PNG files and manifest.
+    * \param[in] force Whether or not to render up to date models too.
+    * \return The counters and error messages of the batch.
+    */
+    SpriteSheetBatchResult render_batch(const std::vector<std::string>& model_paths,
+        const std::string& output_directory,
+        bool force = false);
+
+    /** \brief Load a model and render its sheet.
+    * \param[in] model_path The MDL file.
+    * \param[out] sheet The sheet.
+    * \param[in] thread_index The index of the calling thread in the pool,
+    *            to select its renderer.
+    * \return The number of cells.
+    */
+    size_t render_model(const std::string& model_path, Image& sheet, size_t thread_index = 0);
+
+    /** \brief Get the content hash of a model with the current settings,
+    *          including its texture and sequence group files.
+    * \param[in] model_path The MDL file.
+    * \param[out] hash The hash.
+    * \return true if the model could be read; false otherwise.
+    */
+    bool get_model_hash(const std::string& model_path, uint64_t& hash) const;
+
+    /** \brief Select the model of each bodypart from a body value.
+    * \param[in] studio_model The model.
+    * \param[in] body The body value.
+    * \param[out] models The model index of each bodypart.
+    */
+    static void get_body_models(const StudioModel& studio_model, int body, std::vector<int>& models);
+
+private:
+
+    /** \brief Read the manifest, the last entry of an output wins. */
+    static void read_manifest(const std::string& manifest_path,
+        std::map<std::string, std::string>& hashes);
+
+    /** \brief Get the output file name of each model, unique within the batch. */
+    static void get_output_file_names(const std::vector<std::string>& model_paths,
+        std::vector<std::string>& file_names);
+
+    SpriteSheetSettings settings_;
+    std::string settings_key_;
+
+    ThreadPool thread_pool_;
+
+    /** \brief The software renderer of each thread. */
+    std::vector<std::unique_ptr<StudioModelSoftwareRender>> renderers_;
+};
+
+}
+}
+
+#endif // HLMDLVIEWER_HL1_SPRITE_SHEET_RENDERER_H_
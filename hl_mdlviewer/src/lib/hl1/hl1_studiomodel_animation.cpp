@@ -62,13 +62,14 @@ bool StudioModelAnimation::model_has_sequences() const
 
 void StudioModelAnimation::interpolate_bone_at_frame(
     const Bone* bone,
+    const Sequence* sequence,
     int frame,
     float s,
     int blend,
     glm::vec3& result_position,
     glm::quat& result_orientation)
 {
-    const aiNodeAnim* pNodeAnim = studio_model_->sequences[animation_data_.sequence].blends[blend]->mChannels[bone->index];
+    const aiNodeAnim* pNodeAnim = sequence->blends[blend]->mChannels[bone->index];
 
     glm::vec3 vFrom = to_glm_vec3(pNodeAnim->mPositionKeys[frame].mValue);
     glm::quat qFrom = to_glm_quat(pNodeAnim->mRotationKeys[frame].mValue);
@@ -110,7 +111,7 @@ void StudioModelAnimation::setup_animated_bone_transform(
 {
     glm::vec3 vInterpolated;
     glm::quat qInterpolated;
-    interpolate_bone_at_frame(bone, frame, s, 0, vInterpolated, qInterpolated);
+    interpolate_bone_at_frame(bone, sequence, frame, s, 0, vInterpolated, qInterpolated);
 
     if (sequence->blends.size() > 1)
     {
@@ -119,7 +120,7 @@ void StudioModelAnimation::setup_animated_bone_transform(
 
         glm::vec3 vInterpolated2;
         glm::quat qInterpolated2;
-        interpolate_bone_at_frame(bone, frame, s, 1, vInterpolated2, qInterpolated2);
+        interpolate_bone_at_frame(bone, sequence, frame, s, 1, vInterpolated2, qInterpolated2);
         qInterpolated = glm::slerp(qInterpolated, qInterpolated2, t1);
 
         vInterpolated = vInterpolated * t2 + vInterpolated2 * t1;
@@ -128,8 +129,8 @@ void StudioModelAnimation::setup_animated_bone_transform(
         {
             glm::vec3 vInterpolated3, vInterpolated4;
             glm::quat qInterpolated3, qInterpolated4;
-            interpolate_bone_at_frame(bone, frame, s, 2, vInterpolated3, qInterpolated3);
-            interpolate_bone_at_frame(bone, frame, s, 3, vInterpolated4, qInterpolated4);
+            interpolate_bone_at_frame(bone, sequence, frame, s, 2, vInterpolated3, qInterpolated3);
+            interpolate_bone_at_frame(bone, sequence, frame, s, 3, vInterpolated4, qInterpolated4);
 
             t1 = clamp(animation_data_.blend_controllers[0] / 255.0f, 0.0f, 1.0f);
             t2 = 1.0f - t1;
@@ -189,9 +190,31 @@ void StudioModelAnimation::setup_bind_pose_bone_transform(const Bone* bone, glm:
     transform[3][2] = local_position.z;
 }
 
-void StudioModelAnimation::apply_bone_parent_transform(const Bone* bone, glm::mat4& transform)
+void StudioModelAnimation::apply_bone_parent_transform(const Bone* bone,
+    const std::vector<glm::mat4>& bones_transform,
+    glm::mat4& transform)
+{
+    transform = bones_transform[bone->parent_index] * transform;
+}
+
+void StudioModelAnimation::setup_bones(const Sequence* sequence, int frame, float s,
+    std::vector<glm::mat4>& bones_transform,
+    const std::vector<uint8_t>* bone_mask)
 {
-    transform = bones_transform_[bone->parent_index] * transform;
+    for (auto& bone : studio_model_->bones)
+    {
+        // Masked out bones keep their bind pose, relative to their parent.
+        const bool animated = !bone_mask ||
+            (bone.index < static_cast<int>(bone_mask->size()) && (*bone_mask)[bone.index]);
+
+        if (sequence && animated)
+            setup_animated_bone_transform(&bone, sequence, frame, s, bones_transform[bone.index]);
+        else
+            setup_bind_pose_bone_transform(&bone, bones_transform[bone.index]);
+
+        if (bone.parent)
+            apply_bone_parent_transform(&bone, bones_transform, bones_transform[bone.index]);
+    }
 }
 
 void StudioModelAnimation::update(const float frame_time)
@@ -209,12 +232,7 @@ void StudioModelAnimation::update(const float frame_time)
 
         float s = animation_data_.frame - iFrame;
 
-        for (auto& bone : studio_model_->bones)
-        {
-            setup_animated_bone_transform(&bone, sequence, iFrame, s, bones_transform_[bone.index]);
-            if (bone.parent)
-                apply_bone_parent_transform(&bone, bones_transform_[bone.index]);
-        }
+        setup_bones(sequence, iFrame, s, bones_transform_);
 
         advance_frame(sequence, frame_time);
 
@@ -223,15 +241,50 @@ void StudioModelAnimation::update(const float frame_time)
     }
     else
     {
-        for (auto& bone : studio_model_->bones)
-        {
-            setup_bind_pose_bone_transform(&bone, bones_transform_[bone.index]);
-            if (bone.parent)
-                apply_bone_parent_transform(&bone, bones_transform_[bone.index]);
-        }
+        setup_bones(nullptr, 0, 0.0f, bones_transform_);
+    }
+}
+
+void StudioModelAnimation::compute_bone_transforms(int sequence, float frame,
+    std::vector<glm::mat4>& bones_transform)
+{
+    compute_bone_transforms(sequence, frame, nullptr, bones_transform);
+}
+
+void StudioModelAnimation::compute_bone_transforms(int sequence, float frame,
+    const std::vector<uint8_t>* bone_mask,
+    std::vector<glm::mat4>& bones_transform)
+{
+    bones_transform.resize(studio_model_->bones.size());
+
+    if (model_has_sequences())
+    {
+        const Sequence* studio_sequence = &studio_model_->sequences[sequence];
+
+        if (studio_sequence->num_frames <= 1)
+            frame = 0;
+
+        int iFrame = (int)frame;
+        setup_bones(studio_sequence, iFrame, frame - iFrame, bones_transform, bone_mask);
+    }
+    else
+    {
+        setup_bones(nullptr, 0, 0.0f, bones_transform);
     }
 }
 
+float StudioModelAnimation::advance_frame(int sequence, float frame, float playback_rate, const float frame_time)
+{
+    if (!model_has_sequences())
+        return 0;
+
+    return frame_interpolation_->advance_frame(
+        &studio_model_->sequences[sequence],
+        frame,
+        playback_rate,
+        frame_time);
+}
+
 void StudioModelAnimation::set_sequence(int value)
 {
     const int old_sequence = animation_data_.sequence;
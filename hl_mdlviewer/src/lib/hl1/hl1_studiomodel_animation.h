@@ -33,6 +33,36 @@ public:
 
     inline const std::vector<glm::mat4>& get_bone_transforms() const { return bones_transform_; }
 
+    /** \brief Compute the bone transforms of a sequence at a given frame
+    *          without advancing the animation or firing events.
+    * \param[in] sequence The sequence index.
+    * \param[in] frame The frame, including the fractional part.
+    * \param[out] bones_transform The bone transforms in absolute space.
+    */
+    void compute_bone_transforms(int sequence, float frame,
+        std::vector<glm::mat4>& bones_transform);
+
+    /** \brief Compute the bone transforms of a sequence at a given frame,
+    *          animating only some of the bones.
+    * \param[in] sequence The sequence index.
+    * \param[in] frame The frame, including the fractional part.
+    * \param[in] bone_mask Non-zero for the bones to animate, the others
+    *            keep their bind pose. All bones are animated if null.
+    * \param[out] bones_transform The bone transforms in absolute space.
+    */
+    void compute_bone_transforms(int sequence, float frame,
+        const std::vector<uint8_t>* bone_mask,
+        std::vector<glm::mat4>& bones_transform);
+
+    /** \brief Advance an independent frame counter, i.e. one of an instance.
+    * \param[in] sequence The sequence index.
+    * \param[in] frame The current frame.
+    * \param[in] playback_rate A factor by which to scale the animation speed.
+    * \param[in] frame_time The elapsed time.
+    * \return The new frame.
+    */
+    float advance_frame(int sequence, float frame, float playback_rate, const float frame_time);
+
     const StudioModelAnimationData* animation_data() const { return &animation_data_; }
     void set_sequence(int value);
     void set_playback_rate(float value);
@@ -48,6 +78,7 @@ protected:
 
     /** \brief Interpolate bone between two consecutive frames.
     * \param[in] bone The bone to interpolate.
+    * \param[in] sequence The sequence.
     * \param[in] frame The frame to interpolate with the next one.
     * \param[in] s The interpolation factor where 0 is \p frame and 1 is \p frame + 1.
     * \param[in] blend The sequence blend index.
@@ -56,6 +87,7 @@ protected:
     */
     void interpolate_bone_at_frame(
         const Bone* bone,
+        const Sequence* sequence,
         int frame,
         float s,
         int blend,
@@ -80,10 +112,24 @@ protected:
 
     /** \brief Apply bone parent transformation to \p transform.
     * \param[in] bone The bone.
+    * \param[in] bones_transform The bone transforms in absolute space.
     * \param[out] transform The transformation matrix to apply
     *             parent transform to.
     */
-    void apply_bone_parent_transform(const Bone* bone, glm::mat4& transform);
+    void apply_bone_parent_transform(const Bone* bone,
+        const std::vector<glm::mat4>& bones_transform,
+        glm::mat4& transform);
+
+    /** \brief Setup all bone transforms in absolute space.
+    * \param[in] sequence The sequence, or null for the bind pose.
+    * \param[in] frame The frame.
+    * \param[in] s The interpolation factor where 0 is \p frame and 1 is \p frame + 1.
+    * \param[out] bones_transform The bone transforms in absolute space.
+    * \param[in] bone_mask Non-zero for the bones to animate, or null for all.
+    */
+    void setup_bones(const Sequence* sequence, int frame, float s,
+        std::vector<glm::mat4>& bones_transform,
+        const std::vector<uint8_t>* bone_mask = nullptr);
     
     /** \brief Apply a single bone controller transformation to 
     *          \p result_position and \p result_orientation.
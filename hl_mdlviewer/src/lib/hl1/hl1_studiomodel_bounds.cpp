@@ -0,0 +1,126 @@
+/**
+* \file hl1_studiomodel_bounds.cpp
+* \brief Implementation for the HL1 Studio model bounds class.
+*/
+
+#include "pch.h"
+#include "hl1_studiomodel_bounds.h"
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+StudioModelBounds::StudioModelBounds() :
+    hitbox_boxes_(),
+    vertex_boxes_()
+{
+}
+
+void StudioModelBounds::clear()
+{
+    hitbox_boxes_.clear();
+    vertex_boxes_.clear();
+}
+
+void StudioModelBounds::add_box(std::vector<BoneBox>& boxes, const BoneBounds& bounds)
+{
+    BoneBox box;
+    box.bone = bounds.bone;
+    box.center = (bounds.bbmin + bounds.bbmax) * 0.5f;
+    box.half_size = (bounds.bbmax - bounds.bbmin) * 0.5f;
+    boxes.push_back(box);
+}
+
+void StudioModelBounds::setup(const StudioModel& studio_model, const StudioModelBuffer& buffer)
+{
+    clear();
+
+    // Merge the hitboxes of each bone, so that a bone is transformed once.
+    const int num_bones = static_cast<int>(studio_model.bones.size());
+    std::vector<BoneBounds> hitbox_bounds(num_bones);
+    std::vector<bool> has_hitbox(num_bones, false);
+
+    for (const Hitbox& hitbox : studio_model.hitboxes)
+    {
+        if (!hitbox.bone || hitbox.bone->index < 0 || hitbox.bone->index >= num_bones)
+            continue;
+
+        BoneBounds& bounds = hitbox_bounds[hitbox.bone->index];
+        if (!has_hitbox[hitbox.bone->index])
+        {
+            bounds.bone = hitbox.bone->index;
+            bounds.bbmin = hitbox.bbmin;
+            bounds.bbmax = hitbox.bbmax;
+            has_hitbox[hitbox.bone->index] = true;
+        }
+        else
+        {
+            bounds.bbmin = glm::min(bounds.bbmin, hitbox.bbmin);
+            bounds.bbmax = glm::max(bounds.bbmax, hitbox.bbmax);
+        }
+    }
+
+    for (int i = 0; i < num_bones; ++i)
+    {
+        if (has_hitbox[i])
+            add_box(hitbox_boxes_, hitbox_bounds[i]);
+    }
+
+    for (const BoneBounds& bounds : buffer.bone_vertex_bounds)
+    {
+        if (bounds.bone >= 0 && bounds.bone < num_bones)
+            add_box(vertex_boxes_, bounds);
+    }
+}
+
+bool StudioModelBounds::compute(const std::vector<glm::mat4>& bones_transform,
+    BoundsMode mode,
+    glm::vec3& bbmin,
+    glm::vec3& bbmax) const
+{
+    return compute(bones_transform, glm::mat4(1.0f), mode, bbmin, bbmax);
+}
+
+bool StudioModelBounds::compute(const std::vector<glm::mat4>& bones_transform,
+    const glm::mat4& transform,
+    BoundsMode mode,
+    glm::vec3& bbmin,
+    glm::vec3& bbmax) const
+{
+    const std::vector<BoneBox>& boxes =
+        (mode == BoundsMode::HITBOXES && !hitbox_boxes_.empty()) ? hitbox_boxes_ : vertex_boxes_;
+
+    bool empty = true;
+
+    for (const BoneBox& box : boxes)
+    {
+        if (box.bone >= static_cast<int>(bones_transform.size()))
+            continue;
+
+        const glm::mat4 m = transform * bones_transform[box.bone];
+
+        // The extents of a transformed box are the box half sizes
+        // projected on each axis by the absolute rotation.
+        const glm::vec3 center = glm::vec3(m * glm::vec4(box.center, 1.0f));
+        const glm::vec3 half_size(
+            std::abs(m[0][0]) * box.half_size.x + std::abs(m[1][0]) * box.half_size.y + std::abs(m[2][0]) * box.half_size.z,
+            std::abs(m[0][1]) * box.half_size.x + std::abs(m[1][1]) * box.half_size.y + std::abs(m[2][1]) * box.half_size.z,
+            std::abs(m[0][2]) * box.half_size.x + std::abs(m[1][2]) * box.half_size.y + std::abs(m[2][2]) * box.half_size.z);
+
+        if (empty)
+        {
+            bbmin = center - half_size;
+            bbmax = center + half_size;
+            empty = false;
+        }
+        else
+        {
+            bbmin = glm::min(bbmin, center - half_size);
+            bbmax = glm::max(bbmax, center + half_size);
+        }
+    }
+
+    return !empty;
+}
+
+}
+}
@@ -0,0 +1,97 @@
+/**
+* \file hl1_studiomodel_bounds.h
+* \brief Declaration for the HL1 Studio model bounds class.
+*/
+
+#ifndef HLMDLVIEWER_HL1_STUDIOMODEL_BOUNDS_H_
+#define HLMDLVIEWER_HL1_STUDIOMODEL_BOUNDS_H_
+
+#include <vector>
+#include "hl1_studiomodel.h"
+#include "hl1_studiomodel_buffer.h"
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+/** \brief How the bounds of a pose are computed. */
+enum class BoundsMode
+{
+    /** The hitboxes of each bone. Cheap, but models are not always
+    * entirely inside their hitboxes. */
+    HITBOXES,
+
+    /** The extents of the vertices of each bone. Always contains the
+    * skinned vertices. */
+    VERTICES
+};
+
+/** \brief Computes the bounds of a model in its current pose.
+*
+* The static sequence bounds cover the whole sequence and are often much
+* larger than a single frame. These bounds are computed from the bone
+* transforms of the frame: the boxes of each bone, computed once at
+* setup in the bone space, are transformed by the bone and merged.
+*/
+class StudioModelBounds
+{
+public:
+    StudioModelBounds();
+    StudioModelBounds(const StudioModelBounds&) = delete;
+
+    /** \brief Merge the hitboxes and vertex extents of each bone.
+    * \param[in] studio_model The model.
+    * \param[in] buffer The model buffer.
+    */
+    void setup(const StudioModel& studio_model, const StudioModelBuffer& buffer);
+
+    void clear();
+
+    /** \brief Compute the bounds of a pose in the model scene space.
+    *
+    * A model without hitboxes uses its vertices in \ref BoundsMode::HITBOXES.
+    * \param[in] bones_transform The bone transforms.
+    * \param[in] mode The boxes to transform.
+    * \param[out] bbmin The min extent of the pose.
+    * \param[out] bbmax The max extent of the pose.
+    * \return false if the model has no box to transform; true otherwise.
+    */
+    bool compute(const std::vector<glm::mat4>& bones_transform,
+        BoundsMode mode,
+        glm::vec3& bbmin,
+        glm::vec3& bbmax) const;
+
+    /** \brief Compute the bounds of a pose, transformed by \p transform,
+    *          i.e. to world space for culling.
+    * \see compute
+    */
+    bool compute(const std::vector<glm::mat4>& bones_transform,
+        const glm::mat4& transform,
+        BoundsMode mode,
+        glm::vec3& bbmin,
+        glm::vec3& bbmax) const;
+
+    inline bool has_hitboxes() const { return !hitbox_boxes_.empty(); }
+
+private:
+
+    /** \brief A box in the space of a bone. */
+    struct BoneBox
+    {
+        int bone;
+        glm::vec3 center;
+        glm::vec3 half_size;
+    };
+
+    static void add_box(std::vector<BoneBox>& boxes, const BoneBounds& bounds);
+
+    /** \brief One merged box per bone with hitboxes. */
+    std::vector<BoneBox> hitbox_boxes_;
+
+    /** \brief One box per bone with vertices. */
+    std::vector<BoneBox> vertex_boxes_;
+};
+
+}
+}
+
+#endif // HLMDLVIEWER_HL1_STUDIOMODEL_BOUNDS_H_
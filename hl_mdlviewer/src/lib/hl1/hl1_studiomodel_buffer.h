@@ -5,24 +5,107 @@
 #ifndef HLMDLVIEWER_HL1_STUDIOMODEL_BUFFER_H_
 #define HLMDLVIEWER_HL1_STUDIOMODEL_BUFFER_H_
 
+#include "buffer_builder.h"
 #include "mesh_buffer.h"
 #include "gltexture.h"
+#include "glvertex.h"
+#include "image.h"
+#include "texture_atlas.h"
 
 namespace hl_mdlviewer {
 namespace hl1 {
 
+/** \brief Where the buffer data of a model is kept. */
+enum class BufferStorage
+{
+    GPU,            // The OpenGL buffer and textures only.
+    GPU_AND_CPU,    // Also the CPU copies, i.e. for software rendering.
+    CPU             // The CPU copies only, without any OpenGL call.
+};
+
+/** \brief An axis aligned box in the space of a bone. */
+struct BoneBounds
+{
+    int bone;
+    glm::vec3 bbmin;
+    glm::vec3 bbmax;
+};
+
+/** \brief Figures about how the buffer of a model was built. */
+struct StudioModelBufferStatistics
+{
+    StudioModelBufferStatistics() :
+        vertex_cache(),
+        mesh_lod_triangles(),
+        expanded_texture_size(0),
+        palettized_texture_size(0),
+        num_shared_textures(0),
+        texture_atlas_width(0),
+        texture_atlas_height(0),
+        texture_atlas_size(0),
+        texture_atlas_used_area(0),
+        texture_atlas_cached(false),
+        texture_atlas_milliseconds(0)
+    {
+    }
+
+    /** \brief The vertex cache optimization of the meshes, empty if the
+    * meshes were not optimized. */
+    BufferBuilderStatistics vertex_cache;
+
+    /** \brief The number of mesh triangles of each level of detail, the
+    * full meshes first. \see StudioModelBuffer::mesh_lod_errors */
+    std::vector<size_t> mesh_lod_triangles;
+
+    /** \brief The size in bytes the palettized textures would take as
+    * BGRA, 0 if the textures were not palettized. */
+    size_t expanded_texture_size;
+
+    /** \brief The size in bytes of the palette indices and the palettes. */
+    size_t palettized_texture_size;
+
+    /** \brief The number of skin textures sharing the indices of another. */
+    size_t num_shared_textures;
+
+    unsigned int texture_atlas_width;
+    unsigned int texture_atlas_height;
+
+    /** \brief The size in bytes of the atlas, all levels included. */
+    size_t texture_atlas_size;
+
+    /** \brief The number of texels of the first level covered by images. */
+    size_t texture_atlas_used_area;
+
+    /** \brief Whether the atlas was loaded from the texture cache. */
+    bool texture_atlas_cached;
+
+    /** \brief The time taken to process or load the atlas. */
+    long long texture_atlas_milliseconds;
+};
+
 /** \brief A structure that holds all Studiomodel mesh buffers 
 * and stride infos. */
 struct StudioModelBuffer
 {
     StudioModelBuffer() :
         meshes(),
+        mesh_lods(),
+        mesh_lod_errors(),
         bones(),
         attachments(),
         hitboxes(),
         sequence_bbox(),
+        bone_vertex_bounds(),
         buffer(),
-        gltextures()
+        texture_atlas(),
+        texture_rects(),
+        texture_levels(1),
+        palettized(false),
+        palette_texture(),
+        vertices(),
+        indices(),
+        images(),
+        statistics()
     {
 
     }
@@ -30,21 +113,41 @@ struct StudioModelBuffer
     void clear()
     {
         meshes.clear();
+        mesh_lods.clear();
+        mesh_lod_errors.clear();
         bones.reset();
         attachments.reset();
         hitboxes.clear();
         sequence_bbox.clear();
+        bone_vertex_bounds.clear();
 
         buffer.delete_buffer();
 
-        for (auto& t : gltextures)
-            t.delete_texture();
-        gltextures.clear();
+        texture_atlas.delete_texture();
+        texture_rects.clear();
+        texture_levels = 1;
+
+        palettized = false;
+        palette_texture.delete_texture();
+
+        vertices.clear();
+        indices.clear();
+        images.clear();
+
+        statistics = StudioModelBufferStatistics();
     }
 
     /** Mesh strides. */
     std::vector<MeshBufferStride> meshes;
 
+    /** \brief The simplified mesh strides, mesh_lods[lod - 1][mesh]. They
+    * use the vertices of the mesh strides, with fewer triangles. */
+    std::vector<std::vector<MeshBufferStride>> mesh_lods;
+
+    /** \brief The largest simplification error of each level of detail,
+    * as a distance in the model space. */
+    std::vector<float> mesh_lod_errors;
+
     /** Bones stride. */
     MeshBufferStride bones;
 
@@ -60,11 +163,44 @@ struct StudioModelBuffer
     */
     std::vector<MeshBufferStride> sequence_bbox;
 
+    /** \brief The extents of the mesh vertices of each bone, in the bone
+    * space. Always computed at setup, whatever the storage. */
+    std::vector<BoneBounds> bone_vertex_bounds;
+
     /** \brief the Studiomodel mesh buffer. */
     MeshBuffer buffer;
 
-    /** \brief the Studiomodel OpenGL textures. */
-    std::vector<gltexture> gltextures;
+    /** \brief All the textures of the model, across skin families, so
+    * that meshes are drawn without binding textures. */
+    gltexture texture_atlas;
+
+    /** \brief The place of each texture in "texture_atlas". Palettized
+    * textures with the same indices share their place. */
+    std::vector<AtlasRect> texture_rects;
+
+    /** \brief The number of mip levels of "texture_atlas". Each level
+    * halves the places of the textures, rounding their sizes up. */
+    unsigned int texture_levels;
+
+    /** \brief Whether "texture_atlas" holds 8 bit palette indices, resolved
+    * through "palette_texture" in the shader. */
+    bool palettized;
+
+    /** \brief The palette of each texture, one row of 256 texels per texture. */
+    gltexture palette_texture;
+
+    /** \brief A copy of the buffer vertices, in the standard layout.
+    * Only kept when requested at setup. \see BufferStorage */
+    std::vector<glvertex> vertices;
+
+    /** \brief A copy of the buffer "indices". \see vertices */
+    std::vector<unsigned int> indices;
+
+    /** \brief A copy of the textures, in RGBA order. \see vertices */
+    std::vector<Image> images;
+
+    /** \brief Figures gathered at setup. */
+    StudioModelBufferStatistics statistics;
 };
 
 }
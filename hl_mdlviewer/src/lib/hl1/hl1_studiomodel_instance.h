@@ -0,0 +1,41 @@
+/**
+* \file hl1_studiomodel_instance.h
+* \brief Declaration for the HL1 Studio model instance structure.
+*/
+
+#ifndef HLMDLVIEWER_HL1_STUDIOMODEL_INSTANCE_H_
+#define HLMDLVIEWER_HL1_STUDIOMODEL_INSTANCE_H_
+
+#include <glm/glm.hpp>
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+/** \brief A copy of the loaded model with its own placement and
+* animation state, drawn with hardware instancing. */
+struct StudioModelInstance
+{
+    StudioModelInstance() :
+        transform(1.0f),
+        skin(0),
+        sequence(0),
+        frame(0),
+        playback_rate(1.0f)
+    {
+    }
+
+    /** \brief The instance transform. */
+    glm::mat4 transform;
+
+    int skin;
+    int sequence;
+
+    /** \brief The current frame in the sequence. */
+    float frame;
+    float playback_rate;
+};
+
+}
+}
+
+#endif // HLMDLVIEWER_HL1_STUDIOMODEL_INSTANCE_H_
@@ -0,0 +1,71 @@
+/**
+* \file hl1_studiomodel_lighting.h
+* \brief Declaration for the HL1 Studio model lighting.
+*/
+
+#ifndef HLMDLVIEWER_HL1_STUDIOMODEL_LIGHTING_H_
+#define HLMDLVIEWER_HL1_STUDIOMODEL_LIGHTING_H_
+
+#include <glm/glm.hpp>
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+/** \brief The light parameters shared by the renderers. */
+struct StudioModelLighting
+{
+    StudioModelLighting() :
+        light_color(1, 1, 1),
+        light_direction(0, -1, 0),
+        ambient_light(32.0f),
+        shade_light(192.0f),
+        lambert(1.5f)
+    {
+    }
+
+    glm::vec3 light_color;
+    glm::vec3 light_direction;
+    float ambient_light;
+    float shade_light;
+    float lambert;
+};
+
+/** \brief Get the lighting intensity of a vertex, as calculateLightingIntensity
+*          in lighting.in.
+* \param[in] lighting The light parameters.
+* \param[in] light_direction The light direction, in world space.
+* \param[in] normal The vertex normal, in world space.
+* \param[in] flat_shade Whether or not the mesh is flat shaded.
+* \return The intensity, in [0, 1].
+*/
+inline float calculate_lighting_intensity(const StudioModelLighting& lighting,
+    const glm::vec3& light_direction,
+    const glm::vec3& normal,
+    bool flat_shade)
+{
+    float illum = lighting.ambient_light;
+
+    if (flat_shade)
+    {
+        illum += lighting.shade_light * 0.8f;
+    }
+    else
+    {
+        float lightcos = glm::dot(glm::normalize(light_direction), glm::normalize(normal));
+        lightcos = glm::clamp(lightcos, -1.0f, 1.0f);
+        illum += lighting.shade_light;
+        const float r = glm::max(lighting.lambert, 1.0f);
+        lightcos = (lightcos + (r - 1.0f)) / r;
+        if (lightcos > 0.0f)
+            illum -= lighting.shade_light * lightcos;
+        if (illum <= 0.0f)
+            illum = 0.0f;
+    }
+
+    return glm::clamp(illum, 0.0f, 255.0f) / 255.0f;
+}
+
+}
+}
+
+#endif // HLMDLVIEWER_HL1_STUDIOMODEL_LIGHTING_H_
@@ -5,14 +5,53 @@
 
 #include "pch.h"
 #include "hl1_studiomodel_render.h"
+#include "hl1_studiomodel_lighting.h"
 #include "bbox_builder.h"
 #include "glprogram.h"
+#include "render_backend.h"
+#include <cfloat>
 
 #define MAXSTUDIOBONES  128
 
+/** The number of bone palettes that can be streamed per frame. */
+#define MAX_BONE_PALETTES_PER_FRAME 16
+
+/** The texture unit the instance buffer is bound to. */
+#define INSTANCE_DATA_TEXTURE_UNIT 1
+
+/** The texture unit of the palettes of palettized textures. */
+#define PALETTE_TEXTURE_UNIT 2
+
 namespace hl_mdlviewer {
 namespace hl1 {
 
+/** \brief The features shaders can be specialized for. */
+enum ShaderFeature : unsigned int
+{
+    SHADER_FEATURE_BONE_TRANSFORM = 1 << 0,
+    SHADER_FEATURE_OFFSET_MATRIX = 1 << 1,
+    SHADER_FEATURE_CHROME = 1 << 2,
+    SHADER_FEATURE_FLAT_SHADE = 1 << 3,
+    SHADER_FEATURE_MASKED = 1 << 4,
+    SHADER_FEATURE_LIGHTING = 1 << 5,
+    SHADER_FEATURE_INSTANCED = 1 << 6,
+    SHADER_FEATURE_PALETTIZED = 1 << 7,
+
+    SHADER_FEATURE_SKINNED = SHADER_FEATURE_BONE_TRANSFORM | SHADER_FEATURE_OFFSET_MATRIX
+};
+
+/** \brief The preprocessor definition of each shader feature, in bit order. */
+static const glprogram::FeatureList SHADER_FEATURE_DEFINES = {
+    "APPLY_BONE_TRANSFORM",
+    "APPLY_OFFSET_MATRIX",
+    "USE_CHROME",
+    "FLAT_SHADE",
+    "MASKED",
+    "LIGHTING",
+    "INSTANCED",
+    "PALETTIZED"
+};
+
 struct GlobalUniformBlock
 {
     glm::mat4 scene_transform;
@@ -21,7 +60,6 @@ struct GlobalUniformBlock
     float ambient_light;
     float shade_light;
     float lambert;
-    bool lighting_enabled;
 };
 
 struct MatricesUniformBlock
@@ -43,26 +81,48 @@ StudioModelRender::StudioModelRender(
     settings_(),
     view_settings_(),
     file_system_(file_system),
+    shader_parser_(file_system),
+    program_binary_cache_(),
     projection_matrix_(),
     flat_program_(),
     smooth_program_(),
     textured_program_(),
     normal_program_(),
     matrices_uniform_buffer_(),
-    bone_matrices_uniform_buffer_(),
+    bone_matrices_ring_buffer_(),
+    bone_matrices_offset_(0),
+    sequence_bbmin_(0.0f),
+    sequence_bbmax_(0.0f),
+    sequence_bounds_valid_(false),
+    sequence_bbox_builder_(),
     global_uniform_buffer_(),
     default_colors_(),
+    state_(),
+    instance_data_buffer_(),
+    instance_data_(),
+    instance_skins_(),
+    instance_lods_(),
+    mesh_lod_(0),
+    instance_upload_data_(),
+    instance_order_(),
+    draw_list_(),
     angles_(),
     pan_(),
+    viewport_height_(1),
+    scene_transform_(1.0f),
     render_data_(),
-    studio_model_buffer_()
+    studio_model_buffer_(),
+    texture_uploader_()
 {
 }
 
 void StudioModelRender::initialize()
 {
     load_shaders();
+
     setup_uniform_buffers();
+
+    instance_data_buffer_.initialize(GL_RGBA32F);
 }
 
 void StudioModelRender::dispose()
@@ -78,10 +138,63 @@ void StudioModelRender::on_model_changed()
     set_model(0, 0);
 
     update_offset_matrices();
+
+    // The bbox vertices of the new buffer are empty.
+    sequence_bounds_valid_ = false;
+
+    // The instance stride depends on the number of bones.
+    set_instance_count(0);
+
+    build_shader_variants();
+}
+
+void StudioModelRender::build_shader_variants()
+{
+    // Every variant the settings can select for the meshes of the model,
+    // so that toggling a setting never compiles one during a frame.
+    std::vector<unsigned int> smooth_variants, textured_variants;
+
+    for (unsigned int global_features : { 0u, static_cast<unsigned int>(SHADER_FEATURE_LIGHTING) })
+    {
+        for (unsigned int instanced : { 0u, static_cast<unsigned int>(SHADER_FEATURE_INSTANCED) })
+        {
+            for (bool chrome : { false, true })
+            {
+                const unsigned int features = SHADER_FEATURE_SKINNED | global_features | instanced;
+                const bool lighting = global_features != 0;
+
+                for (const Mesh& mesh : studio_model_->meshes)
+                {
+                    smooth_variants.push_back(features | mesh_shader_features(&mesh, false, lighting, chrome));
+                    textured_variants.push_back(features | mesh_shader_features(&mesh, true, lighting, chrome));
+                }
+            }
+        }
+    }
+
+    for (std::vector<unsigned int>* variants : { &smooth_variants, &textured_variants })
+    {
+        std::sort(variants->begin(), variants->end());
+        variants->erase(std::unique(variants->begin(), variants->end()), variants->end());
+    }
+
+    smooth_program_.submit_variants(smooth_variants);
+    textured_program_.submit_variants(textured_variants);
+
+    // Linked in the background, the variants are finished by the frames
+    // once completed, see begin_frame. Otherwise the driver only compiles
+    // them when waited for, which is done now that all are submitted.
+    const bool wait = !render_backend().has_parallel_shader_compile();
+    smooth_program_.finish_variants(wait);
+    textured_program_.finish_variants(wait);
 }
 
 void StudioModelRender::reset()
 {
+    texture_uploader_.cancel(studio_model_buffer_.texture_atlas);
+    texture_uploader_.cancel(studio_model_buffer_.palette_texture);
+    texture_uploader_.update();
+
     render_data_.clear();
     studio_model_buffer_.clear();
     reset_camera();
@@ -110,14 +223,16 @@ void StudioModelRender::load_shaders()
         { "normal.fs", GL_FRAGMENT_SHADER }
     });
 
-    std::for_each(shader_programs_.begin(), shader_programs_.end(),
-        [&](glprogram* program)
-        {
-            program->bind_uniform_index("Global", 1);
-            program->bind_uniform_index("Matrices", 2);
-            program->bind_uniform_index("BoneMatrices", 3);
-            program->bind_uniform_index("BoneOffsetMatrices", 4);
-        });
+    // The flat variants do not depend on the model.
+    flat_program_.submit_variants({ SHADER_FEATURE_BONE_TRANSFORM, SHADER_FEATURE_SKINNED });
+
+    // The programs were only submitted: with GL_KHR_parallel_shader_compile
+    // they compile on the driver threads while the others are submitted.
+    for (glprogram* program : shader_programs_)
+    {
+        program->finish_build();
+        program->finish_variants();
+    }
 
     default_colors_ = {
         { 1, 0, 0, 1 },
@@ -146,83 +261,158 @@ void StudioModelRender::setup_uniform_buffers()
         sizeof(MatricesUniformBlock),
         GL_DYNAMIC_DRAW);
 
-    bone_matrices_uniform_buffer_.initialize(
-        3,
-        sizeof(BoneMatricesUniformBlock),
-        GL_DYNAMIC_DRAW);
+    bone_matrices_ring_buffer_.initialize(
+        sizeof(BoneMatricesUniformBlock) * MAX_BONE_PALETTES_PER_FRAME);
 
     bone_offset_matrices_uniform_buffer_.initialize(
         4,
         sizeof(BoneMatricesUniformBlock),
         GL_DYNAMIC_DRAW);
 
-    const glm::vec3 light_color(1, 1, 1);
-    const glm::vec3 light_dir(0, -1, 0);
-    const float ambient_light = 32.0f;
-    const float shade_light = 192.0f;
-    const float lambert = 1.5f;
+    const StudioModelLighting lighting;
 
     global_uniform_buffer_.bind();
     global_uniform_buffer_.set_data_unbinded(
         offsetof(GlobalUniformBlock, GlobalUniformBlock::light_color),
-        light_color);
+        lighting.light_color);
     global_uniform_buffer_.set_data_unbinded(
         offsetof(GlobalUniformBlock, GlobalUniformBlock::light_direction),
-        light_dir);
+        lighting.light_direction);
     global_uniform_buffer_.set_data_unbinded(
         offsetof(GlobalUniformBlock, GlobalUniformBlock::ambient_light),
-        ambient_light);
+        lighting.ambient_light);
     global_uniform_buffer_.set_data_unbinded(
         offsetof(GlobalUniformBlock, GlobalUniformBlock::shade_light),
-        shade_light);
+        lighting.shade_light);
     global_uniform_buffer_.set_data_unbinded(
         offsetof(GlobalUniformBlock, GlobalUniformBlock::lambert),
-        lambert);
-    global_uniform_buffer_.set_data(
-        offsetof(GlobalUniformBlock, GlobalUniformBlock::lighting_enabled),
-        settings_.lighting_enabled);
+        lighting.lambert);
     global_uniform_buffer_.unbind();
 }
 
 void StudioModelRender::add_shader_program(glprogram& program,
     typename glprogram::ShaderInitializerList&& shader_initializer_list)
 {
-    program.initialize_with_files(std::move(shader_initializer_list), file_system_);
+    program.set_binary_cache(&program_binary_cache_);
+    program.initialize_variants(std::move(shader_initializer_list), &shader_parser_,
+        SHADER_FEATURE_DEFINES,
+        [](glprogram& variant, unsigned int features)
+        {
+            // Blocks that a variant does not use are optimized out.
+            const std::pair<const char*, GLuint> uniform_blocks[] = {
+                { "Global", 1 },
+                { "Matrices", 2 },
+                { "BoneMatrices", 3 },
+                { "BoneOffsetMatrices", 4 }
+            };
+
+            for (const auto& block : uniform_blocks)
+            {
+                if (variant.has_uniform_block(block.first))
+                    variant.bind_uniform_index(block.first, block.second);
+            }
+
+            if (features & SHADER_FEATURE_INSTANCED)
+            {
+                variant.bind();
+                variant.set_uniform("g_InstanceData", static_cast<GLint>(INSTANCE_DATA_TEXTURE_UNIT));
+                variant.unbind();
+            }
+
+            if (features & SHADER_FEATURE_PALETTIZED)
+            {
+                variant.bind();
+                variant.set_uniform("palette", static_cast<GLint>(PALETTE_TEXTURE_UNIT));
+                variant.unbind();
+            }
+        });
+
     shader_programs_.push_back(&program);
 }
 
+unsigned int StudioModelRender::global_shader_features() const
+{
+    return settings_.lighting_enabled ? SHADER_FEATURE_LIGHTING : 0;
+}
+
+unsigned int StudioModelRender::mesh_shader_features(const Mesh* mesh, bool textured) const
+{
+    return mesh_shader_features(mesh, textured,
+        settings_.lighting_enabled, settings_.render_chrome_effects);
+}
+
+unsigned int StudioModelRender::mesh_shader_features(const Mesh* mesh, bool textured,
+    bool lighting, bool chrome) const
+{
+    unsigned int features = 0;
+
+    // Flat shading only changes the lighting.
+    if (lighting && mesh->texture->shading_mode == aiShadingMode_Flat)
+        features |= SHADER_FEATURE_FLAT_SHADE;
+
+    if (textured)
+    {
+        if (chrome && mesh->texture->type == Texture::Type::Chrome)
+            features |= SHADER_FEATURE_CHROME;
+
+        if (mesh->texture->flags & aiTextureFlags::aiTextureFlags_UseAlpha)
+            features |= SHADER_FEATURE_MASKED;
+
+        if (studio_model_buffer_.palettized)
+            features |= SHADER_FEATURE_PALETTIZED;
+    }
+
+    return features;
+}
+
+void StudioModelRender::build_draw_list(const std::list<size_t>& meshes,
+    unsigned int features, bool textured)
+{
+    draw_list_.clear();
+
+    for (auto mesh_index : meshes)
+    {
+        draw_list_.emplace_back(
+            features | mesh_shader_features(&studio_model_->meshes[mesh_index], textured),
+            mesh_index);
+    }
+
+    // Group the meshes that share a variant, keeping their order otherwise.
+    std::stable_sort(draw_list_.begin(), draw_list_.end(),
+        [](const std::pair<unsigned int, size_t>& a, const std::pair<unsigned int, size_t>& b) {
+            return a.first < b.first;
+        });
+}
+
+void StudioModelRender::set_instance_uniforms(glprogram& program, size_t first_instance)
+{
+    program.set_uniform("g_InstanceOffset", static_cast<GLint>(first_instance));
+    program.set_uniform("g_InstanceStride", static_cast<GLint>(instance_stride() * 4));
+}
+
 void StudioModelRender::delete_resources()
 {
+    texture_uploader_.dispose();
     studio_model_buffer_.clear();
 
     for (auto prog : shader_programs_)
         prog->delete_program();
     shader_programs_.clear();
+
+    bone_matrices_ring_buffer_.delete_buffer();
+    instance_data_buffer_.delete_buffer();
 }
 
 void StudioModelRender::setup_projection_matrix(int width, int height)
 {
-    projection_matrix_ = glm::perspectiveFov(
-        static_cast<float>(view_settings_.fov_radians),
-        static_cast<float>(width),
-        static_cast<float>(height),
-        view_settings_.znear,
-        view_settings_.zfar);
+    projection_matrix_ = get_projection_matrix(view_settings_, width, height);
+    viewport_height_ = std::max(height, 1);
 }
 
 void StudioModelRender::setup_view()
 {
-    glm::mat4 v = glm::lookAt(
-        glm::vec3(0, 0, view_settings_.zdistance),
-        glm::vec3(0, 0, 0),
-        glm::vec3(0, 1, 0));
-
-    // Apply pan to view matrix.
-    glm::mat4 p = glm::translate(glm::mat4(1.0f), glm::vec3(pan_.x, pan_.y, 0));
-
-    v = p * v;
-
-    glm::mat4 m = glm::eulerAngleXYZ(angles_.x, angles_.y, angles_.z);
+    glm::mat4 v = get_view_matrix(view_settings_, pan_);
+    glm::mat4 m = get_model_matrix(angles_);
 
     matrices_uniform_buffer_.bind();
     matrices_uniform_buffer_.set_data_unbinded(
@@ -237,36 +427,64 @@ void StudioModelRender::setup_view()
     matrices_uniform_buffer_.unbind();
 }
 
+glm::mat4 StudioModelRender::get_view_projection_matrix() const
+{
+    return projection_matrix_ * get_view_matrix(view_settings_, pan_) * get_model_matrix(angles_);
+}
+
+void StudioModelRender::begin_frame()
+{
+    bone_matrices_ring_buffer_.begin_frame();
+    texture_uploader_.update();
+
+    // Only a variant drawn before it completes is waited for.
+    for (glprogram* program : shader_programs_)
+    {
+        if (program->has_pending_variants())
+            program->finish_variants(false);
+    }
+}
+
+void StudioModelRender::end_frame()
+{
+    bone_matrices_ring_buffer_.end_frame();
+}
 
 void StudioModelRender::set_bones_transform(const std::vector<glm::mat4>& bones_transform)
 {
     size_t num_bones = std::min(bones_transform.size(), static_cast<size_t>(MAXSTUDIOBONES));
 
-    bone_matrices_uniform_buffer_.bind();
-    bone_matrices_uniform_buffer_.set_data_unbinded_with_size(
-        offsetof(BoneMatricesUniformBlock, bone_matrices),
+    // Reserve the whole block, the shader declares all 128 matrices.
+    bone_matrices_offset_ = bone_matrices_ring_buffer_.push(
         bones_transform.data(),
-        num_bones * sizeof(glm::mat4));
-    bone_matrices_uniform_buffer_.unbind();
+        num_bones * sizeof(glm::mat4),
+        sizeof(BoneMatricesUniformBlock));
 }
 
 void StudioModelRender::set_sequence_bounds(const glm::vec3& bbmin, const glm::vec3& bbmax)
 {
-    BBoxBuilder bbox_builder;
+    if (sequence_bounds_valid_ && bbmin == sequence_bbmin_ && bbmax == sequence_bbmax_)
+        return;
+
+    sequence_bbmin_ = bbmin;
+    sequence_bbmax_ = bbmax;
+    sequence_bounds_valid_ = true;
 
     // Update sequence bbox vertices positions.
-    bbox_builder.build_vertices(
+    sequence_bbox_builder_.build_vertices(
         bbmin,
         bbmax,
         0);
 
     studio_model_buffer_.buffer.set_vertices(
         studio_model_buffer_.sequence_bbox.front(),
-        bbox_builder.get_vertices());
+        sequence_bbox_builder_.get_vertices());
 }
 
 void StudioModelRender::set_scene_transform(const glm::mat4& transform)
 {
+    scene_transform_ = transform;
+
     global_uniform_buffer_.set_data(
         offsetof(GlobalUniformBlock, GlobalUniformBlock::scene_transform),
         transform);
@@ -334,21 +552,29 @@ void StudioModelRender::reset_camera()
 
 void StudioModelRender::render()
 {
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_PRIMITIVE_RESTART);
-    glEnable(GL_PROGRAM_POINT_SIZE);
+    // The UI changes the GL state between frames.
+    state_.invalidate();
+
+    state_.enable(GL_CULL_FACE);
+    state_.enable(GL_DEPTH_TEST);
+    state_.enable(GL_PRIMITIVE_RESTART);
+    state_.enable(GL_PROGRAM_POINT_SIZE);
 
-    glCullFace(GL_FRONT);
-    glDepthFunc(GL_LEQUAL);
+    state_.cull_face(GL_FRONT);
+    state_.depth_func(GL_LEQUAL);
 
-    studio_model_buffer_.buffer.bind();
-    glPrimitiveRestartIndex(PRIMITIVE_RESTART_INDEX);
+    state_.bind_uniform_buffer_range(3,
+        bone_matrices_ring_buffer_.id(),
+        bone_matrices_offset_,
+        sizeof(BoneMatricesUniformBlock));
+
+    state_.bind_vertex_array(studio_model_buffer_.buffer.vertex_array_id());
+    render_backend().primitive_restart_index(PRIMITIVE_RESTART_INDEX);
 
     render_model();
 
-    glEnable(GL_CULL_FACE);
-    glDepthFunc(GL_ALWAYS);
+    state_.enable(GL_CULL_FACE);
+    state_.depth_func(GL_ALWAYS);
 
     if (settings_.draw_bones)
         render_bones();
@@ -362,19 +588,19 @@ void StudioModelRender::render()
     if (settings_.draw_sequence_bbox)
         render_sequence_bbox();
 
-    studio_model_buffer_.buffer.unbind();
+    state_.bind_vertex_array(0);
 
-    glCullFace(GL_FRONT);
-    glDepthFunc(GL_LEQUAL);
+    state_.cull_face(GL_FRONT);
+    state_.depth_func(GL_LEQUAL);
 
-    glDisable(GL_PRIMITIVE_RESTART);
-    glDisable(GL_PROGRAM_POINT_SIZE);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    state_.disable(GL_PRIMITIVE_RESTART);
+    state_.disable(GL_PROGRAM_POINT_SIZE);
+    state_.polygon_mode(GL_FILL);
 }
 
 void StudioModelRender::render_model()
 {
-    glPolygonMode(GL_FRONT, GL_FILL);
+    state_.polygon_mode(GL_FILL);
 
     switch (settings_.render_mode)
     {
@@ -383,6 +609,13 @@ void StudioModelRender::render_model()
         break;
     case RenderMode::TEXTURED:
     {
+        // Until their textures are uploaded, the meshes are shaded.
+        if (!textures_ready())
+        {
+            render_model_smooth();
+            break;
+        }
+
         render_model_textured();
         render_model_textured_additive();
     }
@@ -398,35 +631,33 @@ void StudioModelRender::render_model()
 
 void StudioModelRender::render_bones()
 {
-    glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+    state_.polygon_mode(GL_POINT);
 
-    flat_program_.bind();
+    glprogram& program = flat_program_.variant(SHADER_FEATURE_BONE_TRANSFORM);
+    state_.use_program(program.id());
 
-    flat_program_.set_uniform("color", settings_.bone_vertex_color);
-    flat_program_.set_uniform("pointSize", 5.0f);
-    flat_program_.set_uniform("applyBoneTransform", true);
-    flat_program_.set_uniform("applyOffsetMatrix", false);
+    program.set_uniform("color", settings_.bone_vertex_color);
+    program.set_uniform("pointSize", 5.0f);
 
     studio_model_buffer_.buffer.draw_arrays_unbinded(GL_POINTS,
         studio_model_buffer_.bones);
 
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    state_.polygon_mode(GL_LINE);
 
-    flat_program_.set_uniform("color", settings_.bone_segment_color);
+    program.set_uniform("color", settings_.bone_segment_color);
     studio_model_buffer_.buffer.draw_indexed_unbinded(GL_LINE_STRIP,
         studio_model_buffer_.bones);
 }
 
 void StudioModelRender::render_attachments()
 {
-    glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+    state_.polygon_mode(GL_POINT);
 
-    flat_program_.bind();
+    glprogram& program = flat_program_.variant(SHADER_FEATURE_BONE_TRANSFORM);
+    state_.use_program(program.id());
 
-    flat_program_.set_uniform("color", settings_.attachment_color);
-    flat_program_.set_uniform("pointSize", 5.0f);
-    flat_program_.set_uniform("applyBoneTransform", true);
-    flat_program_.set_uniform("applyOffsetMatrix", false);
+    program.set_uniform("color", settings_.attachment_color);
+    program.set_uniform("pointSize", 5.0f);
 
     studio_model_buffer_.buffer.draw_arrays_unbinded(GL_POINTS,
         studio_model_buffer_.attachments);
@@ -434,16 +665,15 @@ void StudioModelRender::render_attachments()
 
 void StudioModelRender::render_hitboxes()
 {
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    state_.polygon_mode(GL_LINE);
 
-    flat_program_.bind();
-    flat_program_.set_uniform("applyBoneTransform", true);
-    flat_program_.set_uniform("applyOffsetMatrix", false);
+    glprogram& program = flat_program_.variant(SHADER_FEATURE_BONE_TRANSFORM);
+    state_.use_program(program.id());
 
     for (auto it = studio_model_->hitboxes.cbegin(); it != studio_model_->hitboxes.cend(); ++it)
     {
         const glm::vec4& c = default_colors_[it->group % default_colors_.size()];
-        flat_program_.set_uniform("color", c);
+        program.set_uniform("color", c);
         studio_model_buffer_.buffer.draw_indexed_unbinded(GL_LINE_STRIP,
             studio_model_buffer_.hitboxes[it->index]);
     }
@@ -451,9 +681,9 @@ void StudioModelRender::render_hitboxes()
 
 void StudioModelRender::render_normals()
 {
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    state_.polygon_mode(GL_LINE);
 
-    normal_program_.bind();
+    state_.use_program(normal_program_.id());
     normal_program_.set_uniform("color", settings_.normal_color);
     normal_program_.set_uniform("lineLength", 2.0f);
 
@@ -467,41 +697,38 @@ void StudioModelRender::render_normals()
 
 void StudioModelRender::render_sequence_bbox()
 {
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glCullFace(GL_BACK);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glDepthFunc(GL_LEQUAL);
-
-    flat_program_.bind();
+    state_.enable(GL_CULL_FACE);
+    state_.enable(GL_BLEND);
+    state_.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    state_.cull_face(GL_BACK);
+    state_.polygon_mode(GL_FILL);
+    state_.depth_func(GL_LEQUAL);
+
+    state_.use_program(flat_program_.id());
     flat_program_.set_uniform("color", glm::vec4(1,1,0, 32.0f / 255.0f));
     flat_program_.set_uniform("pointSize", 15.0f);
-    flat_program_.set_uniform("applyBoneTransform", false);
-    flat_program_.set_uniform("applyOffsetMatrix", false);
 
     studio_model_buffer_.buffer.draw_indexed_unbinded(
         GL_TRIANGLE_FAN,
         studio_model_buffer_.sequence_bbox.front());
 
-    glDepthFunc(GL_ALWAYS);
+    state_.depth_func(GL_ALWAYS);
     flat_program_.set_uniform("color", glm::vec4(1, 0, 0, 1));
     studio_model_buffer_.buffer.draw_indexed_unbinded(
         GL_LINE_STRIP,
         studio_model_buffer_.sequence_bbox.back());
 
-    glDisable(GL_BLEND);
+    state_.disable(GL_BLEND);
 }
 
 void StudioModelRender::render_model_wireframe()
 {
-    flat_program_.bind();
+    glprogram& program = flat_program_.variant(SHADER_FEATURE_SKINNED);
+    state_.use_program(program.id());
 
-    flat_program_.set_uniform("color", settings_.wireframe_color);
-    flat_program_.set_uniform("applyBoneTransform", true);
-    flat_program_.set_uniform("applyOffsetMatrix", true);
+    program.set_uniform("color", settings_.wireframe_color);
 
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    state_.polygon_mode(GL_LINE);
 
     for (auto mesh_index : meshes_to_render_)
     {
@@ -511,80 +738,128 @@ void StudioModelRender::render_model_wireframe()
     }
 }
 
+bool StudioModelRender::textures_ready() const
+{
+    return texture_uploader_.is_ready(studio_model_buffer_.texture_atlas) &&
+        texture_uploader_.is_ready(studio_model_buffer_.palette_texture);
+}
+
 void StudioModelRender::render_model_smooth()
 {
-    smooth_program_.bind();
-    smooth_program_.set_uniform("color", settings_.smooth_color);
-    smooth_program_.set_uniform("applyBoneTransform", true);
-    smooth_program_.set_uniform("applyOffsetMatrix", true);
+    draw_meshes_smooth(SHADER_FEATURE_SKINNED | global_shader_features(), 0, 0);
+}
+
+void StudioModelRender::draw_meshes_smooth(unsigned int features,
+    size_t first_instance, int num_instances)
+{
+    build_draw_list(meshes_to_render_, features, false);
+
+    glprogram* program = nullptr;
+    unsigned int program_features = 0;
 
     Mesh* mesh = nullptr;
 
-    for (auto mesh_index : meshes_to_render_)
+    for (const auto& item : draw_list_)
     {
-        mesh = &studio_model_->meshes[mesh_index];
+        if (!program || item.first != program_features)
+        {
+            program_features = item.first;
+            program = &smooth_program_.variant(program_features);
+            state_.use_program(program->id());
+            program->set_uniform("color", settings_.smooth_color);
 
-        smooth_program_.set_uniform("useFlatShade",
-            mesh->texture->shading_mode == aiShadingMode_Flat
-            ? true : false);
+            if (program_features & SHADER_FEATURE_INSTANCED)
+                set_instance_uniforms(*program, first_instance);
+        }
+
+        mesh = &studio_model_->meshes[item.second];
 
         if (settings_.highlight_models)
         {
             const glm::vec4& c = default_colors_[mesh->model->index % default_colors_.size()];
-            smooth_program_.set_uniform("color", c);
+            program->set_uniform("color", c);
         }
 
-        studio_model_buffer_.buffer.draw_indexed_unbinded(
-            GL_TRIANGLES,
-            studio_model_buffer_.meshes[mesh->index]);
+        if (num_instances > 0)
+        {
+            studio_model_buffer_.buffer.draw_indexed_instanced_unbinded(
+                GL_TRIANGLES,
+                mesh_stride(mesh->index),
+                num_instances);
+        }
+        else
+        {
+            studio_model_buffer_.buffer.draw_indexed_unbinded(
+                GL_TRIANGLES,
+                mesh_stride(mesh->index));
+        }
     }
 }
 
 void StudioModelRender::render_meshes_textured(const std::list<size_t>& meshes)
 {
-    textured_program_.bind();
-    textured_program_.set_uniform("applyBoneTransform", true);
-    textured_program_.set_uniform("applyOffsetMatrix", true);
-    if (!settings_.render_chrome_effects)
-        textured_program_.set_uniform("useChrome", false);
+    draw_meshes_textured(meshes, SHADER_FEATURE_SKINNED | global_shader_features(),
+        render_data_.skin, 0, 0);
+}
 
-    glPolygonMode(GL_FRONT, GL_FILL);
+void StudioModelRender::draw_meshes_textured(const std::list<size_t>& meshes,
+    unsigned int features, int skin, size_t first_instance, int num_instances)
+{
+    build_draw_list(meshes, features, true);
+
+    state_.polygon_mode(GL_FILL);
+
+    glprogram* program = nullptr;
+    unsigned int program_features = 0;
 
     Mesh* mesh = nullptr;
     Texture* texture = nullptr;
 
-    for (auto mesh_index : meshes)
+    // The textures are all in the atlas, each draw only sets its place.
+    state_.bind_texture(0, GL_TEXTURE_2D, studio_model_buffer_.texture_atlas.id());
+    if (studio_model_buffer_.palettized)
+        state_.bind_texture(PALETTE_TEXTURE_UNIT, GL_TEXTURE_2D, studio_model_buffer_.palette_texture.id());
+
+    for (const auto& item : draw_list_)
     {
-        mesh = &studio_model_->meshes[mesh_index];
+        if (!program || item.first != program_features)
+        {
+            program_features = item.first;
+            program = &textured_program_.variant(program_features);
+            state_.use_program(program->id());
+
+            if (program_features & SHADER_FEATURE_INSTANCED)
+                set_instance_uniforms(*program, first_instance);
+
+            if (program_features & SHADER_FEATURE_PALETTIZED)
+                program->set_uniform("numLevels", static_cast<GLint>(studio_model_buffer_.texture_levels));
+        }
+
+        mesh = &studio_model_->meshes[item.second];
 
         texture = mesh->texture;
-        if (render_data_.skin > 0 && texture->skin_textures.size())
-            texture = texture->skin_textures[render_data_.skin - 1];
+        if (skin > 0 && texture->skin_textures.size())
+            texture = texture->skin_textures[skin - 1];
 
-        studio_model_buffer_.gltextures[texture->index].bind();
+        const AtlasRect& rect = studio_model_buffer_.texture_rects[texture->index];
+        program->set_uniform("textureRect", glm::vec4(rect.x, rect.y, rect.width, rect.height));
 
-        textured_program_.set_uniform("useFlatShade",
-            mesh->texture->shading_mode == aiShadingMode_Flat
-            ? true : false);
+        if (program_features & SHADER_FEATURE_PALETTIZED)
+            program->set_uniform("paletteRow", static_cast<GLint>(texture->index));
 
-        if (settings_.render_chrome_effects)
+        if (num_instances > 0)
         {
-            textured_program_.set_uniform("useChrome",
-                mesh->texture->type == Texture::Type::Chrome 
-                ? true : false);
+            studio_model_buffer_.buffer.draw_indexed_instanced_unbinded(
+                GL_TRIANGLES,
+                mesh_stride(mesh->index),
+                num_instances);
         }
-
-        if (mesh->texture->flags & aiTextureFlags::aiTextureFlags_UseAlpha)
+        else
         {
-            textured_program_.set_uniform("masked", true);
-            textured_program_.set_uniform("maskColor", texture->mask_color);
+            studio_model_buffer_.buffer.draw_indexed_unbinded(
+                GL_TRIANGLES,
+                mesh_stride(mesh->index));
         }
-        else
-            textured_program_.set_uniform("masked", false);
-
-        studio_model_buffer_.buffer.draw_indexed_unbinded(
-            GL_TRIANGLES,
-            studio_model_buffer_.meshes[mesh->index]);
     }
 }
 
@@ -598,14 +873,212 @@ void StudioModelRender::render_model_textured_additive()
     if (additive_meshes_.empty())
         return;
 
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_DST_ALPHA);
+    state_.disable(GL_DEPTH_TEST);
+    state_.enable(GL_BLEND);
+    state_.blend_func(GL_SRC_ALPHA, GL_DST_ALPHA);
 
     render_meshes_textured(additive_meshes_);
 
-    glDisable(GL_BLEND);
-    glEnable(GL_DEPTH_TEST);
+    state_.disable(GL_BLEND);
+    state_.enable(GL_DEPTH_TEST);
+}
+
+size_t StudioModelRender::instance_stride() const
+{
+    // The instance transform, followed by the bone palette.
+    return 1 + std::min(studio_model_->bones.size(), static_cast<size_t>(MAXSTUDIOBONES));
+}
+
+size_t StudioModelRender::max_instances() const
+{
+    // Each matrix takes 4 RGBA32F texels.
+    return static_cast<size_t>(gltexturebuffer::max_texels()) / (instance_stride() * 4);
+}
+
+void StudioModelRender::set_instance_count(size_t count)
+{
+    count = std::min(count, max_instances());
+
+    instance_data_.resize(count * instance_stride());
+    instance_skins_.resize(count, 0);
+    instance_lods_.resize(count, 0);
+}
+
+void StudioModelRender::set_instance(size_t index, const glm::mat4& transform, int skin,
+    const std::vector<glm::mat4>& bones_transform)
+{
+    if (index >= instance_skins_.size())
+        throw std::runtime_error("Instance index out of range.");
+
+    const size_t stride = instance_stride();
+    const size_t num_bones = std::min(bones_transform.size(), stride - 1);
+
+    glm::mat4* data = &instance_data_[index * stride];
+    data[0] = transform;
+    std::copy(bones_transform.begin(), bones_transform.begin() + num_bones, data + 1);
+
+    instance_skins_[index] = skin;
+    instance_lods_[index] = settings_.mesh_lod_enabled ? select_mesh_lod(transform) : 0;
+}
+
+int StudioModelRender::select_mesh_lod(const glm::mat4& transform) const
+{
+    const std::vector<float>& errors = studio_model_buffer_.mesh_lod_errors;
+    if (errors.empty())
+        return 0;
+
+    const glm::mat4 m = transform * scene_transform_;
+    const glm::vec4 clip = get_view_projection_matrix() * m[3];
+    if (clip.w <= 0.0f)
+        return 0;
+
+    // The errors are in the model space, scale them as the instance.
+    const float scale = std::max(std::max(
+        glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1]))), glm::length(glm::vec3(m[2])));
+
+    for (int lod = static_cast<int>(errors.size()); lod > 0; --lod)
+    {
+        if (clip.w >= mesh_lod_distance(lod) * scale)
+            return lod;
+    }
+
+    return 0;
+}
+
+float StudioModelRender::mesh_lod_distance(int lod) const
+{
+    const float error = studio_model_buffer_.mesh_lod_errors[lod - 1];
+    if (error <= 0.0f)
+        return 0.0f;
+    if (settings_.mesh_lod_max_screen_error <= 0.0f)
+        return FLT_MAX;
+
+    // Where the error covers mesh_lod_max_screen_error pixels.
+    const float pixels_per_unit = projection_matrix_[1][1] * 0.5f * viewport_height_;
+    return error * pixels_per_unit / settings_.mesh_lod_max_screen_error;
+}
+
+const MeshBufferStride& StudioModelRender::mesh_stride(size_t mesh_index) const
+{
+    if (mesh_lod_ > 0 && mesh_lod_ <= static_cast<int>(studio_model_buffer_.mesh_lods.size()))
+        return studio_model_buffer_.mesh_lods[mesh_lod_ - 1][mesh_index];
+
+    return studio_model_buffer_.meshes[mesh_index];
+}
+
+void StudioModelRender::render_instanced()
+{
+    const size_t num_instances = instance_skins_.size();
+    if (num_instances == 0)
+        return;
+
+    const size_t stride = instance_stride();
+
+    state_.invalidate();
+
+    // Sort instances by skin and level of detail so that each pair is a
+    // contiguous range of instance ids.
+    instance_order_.resize(num_instances);
+    for (size_t i = 0; i < num_instances; ++i)
+        instance_order_[i] = i;
+
+    std::stable_sort(instance_order_.begin(), instance_order_.end(),
+        [&](size_t a, size_t b) {
+            if (instance_skins_[a] != instance_skins_[b])
+                return instance_skins_[a] < instance_skins_[b];
+            return instance_lods_[a] < instance_lods_[b];
+        });
+
+    instance_upload_data_.resize(num_instances * stride);
+    for (size_t i = 0; i < num_instances; ++i)
+    {
+        std::copy_n(&instance_data_[instance_order_[i] * stride], stride,
+            &instance_upload_data_[i * stride]);
+    }
+
+    instance_data_buffer_.set_data(instance_upload_data_.data(),
+        instance_upload_data_.size() * sizeof(glm::mat4));
+    state_.bind_texture(INSTANCE_DATA_TEXTURE_UNIT, GL_TEXTURE_BUFFER,
+        instance_data_buffer_.texture_id());
+
+    state_.enable(GL_CULL_FACE);
+    state_.enable(GL_DEPTH_TEST);
+    state_.cull_face(GL_FRONT);
+    state_.depth_func(GL_LEQUAL);
+    state_.polygon_mode(GL_FILL);
+
+    state_.bind_vertex_array(studio_model_buffer_.buffer.vertex_array_id());
+
+    size_t first = 0;
+    while (first < num_instances)
+    {
+        const int skin = instance_skins_[instance_order_[first]];
+        const int lod = instance_lods_[instance_order_[first]];
+
+        size_t last = first + 1;
+        while (last < num_instances &&
+            instance_skins_[instance_order_[last]] == skin &&
+            instance_lods_[instance_order_[last]] == lod)
+            ++last;
+
+        mesh_lod_ = lod;
+
+        switch (settings_.render_mode)
+        {
+        case RenderMode::SMOOTH:
+            render_instances_smooth(first, last - first);
+            break;
+        case RenderMode::TEXTURED:
+            if (textures_ready())
+                render_instances_textured(skin, first, last - first);
+            else
+                render_instances_smooth(first, last - first);
+            break;
+        };
+
+        first = last;
+    }
+
+    mesh_lod_ = 0;
+
+    state_.bind_vertex_array(0);
+
+    state_.polygon_mode(GL_FILL);
+    state_.active_texture(0);
+}
+
+void StudioModelRender::render_instances_smooth(size_t first_instance, size_t num_instances)
+{
+    draw_meshes_smooth(
+        SHADER_FEATURE_SKINNED | SHADER_FEATURE_INSTANCED | global_shader_features(),
+        first_instance,
+        static_cast<int>(num_instances));
+}
+
+void StudioModelRender::render_instances_textured(int skin, size_t first_instance, size_t num_instances)
+{
+    const unsigned int features =
+        SHADER_FEATURE_SKINNED | SHADER_FEATURE_INSTANCED | global_shader_features();
+
+    std::list<size_t> opaque_meshes;
+    std::list<size_t> additive_meshes;
+    split_opaque_and_additive(skin, opaque_meshes, additive_meshes);
+
+    draw_meshes_textured(opaque_meshes, features, skin,
+        first_instance, static_cast<int>(num_instances));
+
+    if (additive_meshes.empty())
+        return;
+
+    state_.disable(GL_DEPTH_TEST);
+    state_.enable(GL_BLEND);
+    state_.blend_func(GL_SRC_ALPHA, GL_DST_ALPHA);
+
+    draw_meshes_textured(additive_meshes, features, skin,
+        first_instance, static_cast<int>(num_instances));
+
+    state_.disable(GL_BLEND);
+    state_.enable(GL_DEPTH_TEST);
 }
 
 void StudioModelRender::update_meshes_to_render()
@@ -636,25 +1109,32 @@ void StudioModelRender::update_meshes_to_render()
 }
 
 void StudioModelRender::update_opaque_and_additive_textures()
+{
+    split_opaque_and_additive(render_data_.skin, opaque_meshes_, additive_meshes_);
+}
+
+void StudioModelRender::split_opaque_and_additive(int skin,
+    std::list<size_t>& opaque_meshes,
+    std::list<size_t>& additive_meshes) const
 {
     const Mesh* mesh = nullptr;
     const Texture* texture = nullptr;
 
-    additive_meshes_.clear();
-    opaque_meshes_.clear();
+    additive_meshes.clear();
+    opaque_meshes.clear();
 
     for (auto mesh_index : meshes_to_render_)
     {
         mesh = &studio_model_->meshes[mesh_index];
 
         texture = mesh->texture;
-        if (render_data_.skin > 0 && texture->skin_textures.size())
-            texture = texture->skin_textures[render_data_.skin - 1];
+        if (skin > 0 && texture->skin_textures.size())
+            texture = texture->skin_textures[skin - 1];
 
         if (texture->blend_mode == aiBlendMode::aiBlendMode_Additive)
-            additive_meshes_.push_back(mesh->index);
+            additive_meshes.push_back(mesh->index);
         else
-            opaque_meshes_.push_back(mesh->index);
+            opaque_meshes.push_back(mesh->index);
     }
 }
 
@@ -726,11 +1206,8 @@ void StudioModelRender::set_draw_chrome_effects(bool enabled)
 }
 void StudioModelRender::set_lighting_enabled(bool enabled)
 {
+    // Selects the LIGHTING variant of the programs, see global_shader_features.
     settings_.lighting_enabled = enabled;
-
-    global_uniform_buffer_.set_data(
-        offsetof(GlobalUniformBlock, GlobalUniformBlock::lighting_enabled),
-        settings_.lighting_enabled);
 }
 
 }
@@ -11,8 +11,13 @@
 #include "render_view_settings.h"
 #include "hl1_studiomodel_render_data.h"
 #include "hl1_studiomodel_buffer.h"
+#include "bbox_builder.h"
 #include "glprogram.h"
+#include "glstate.h"
 #include "gluniformbuffer.h"
+#include "gluniformringbuffer.h"
+#include "gltexturebuffer.h"
+#include "texture_uploader.h"
 #include "file_system.h"
 
 namespace hl_mdlviewer {
@@ -34,6 +39,26 @@ public:
 
     StudioModelBuffer* get_buffer() { return &studio_model_buffer_; }
 
+    /** \brief Get the uploader the model textures are streamed with. */
+    TextureUploader* get_texture_uploader() { return &texture_uploader_; }
+
+    /** \brief Whether the model textures are still being uploaded. Until
+    *          then, textured meshes are drawn smooth shaded. */
+    inline bool has_pending_uploads() const { return texture_uploader_.has_pending_uploads(); }
+
+    /** \brief Set the directory the linked programs are cached in, before
+    *          \ref initialize. Empty to always compile them. */
+    inline void set_program_cache_directory(const std::string& directory) {
+        program_binary_cache_.set_directory(directory);
+    }
+
+    /** \brief Get the cache of the linked programs, to read how many
+    *          were loaded, stored or rejected. */
+    const ProgramBinaryCache& program_binary_cache() const { return program_binary_cache_; }
+
+    /** \brief Get how long the shaders took to read and parse. */
+    const ShaderParserStatistics& shader_parser_statistics() const { return shader_parser_.statistics(); }
+
     const StudioModelRenderData* render_data() const { return &render_data_; }
     const ModelRenderSettings* render_settings() const { return &settings_; }
 
@@ -64,10 +89,24 @@ public:
     void setup_projection_matrix(int width, int height);
     void setup_view();
 
+    /** \brief Get the transform from the scene space, in which instances
+    *          are placed, to clip space. */
+    glm::mat4 get_view_projection_matrix() const;
+
+    /** \brief Start streaming per-frame data. Must be called before
+    *          set_bones_transform. */
+    void begin_frame();
+
+    /** \brief Fence the per-frame data. Must be called after render. */
+    void end_frame();
+
     /** \brief Set the bone transforms to be used by the renderer.
     * \param[in] bones_transform The bone transforms.
     */
     void set_bones_transform(const std::vector<glm::mat4>& bones_transform);
+
+    /** \brief Set the bounds drawn as the sequence bbox. Only the bbox
+    *          vertices are updated, and only when the bounds change. */
     void set_sequence_bounds(const glm::vec3& bbmin, const glm::vec3& bbmax);
 
     void set_scene_transform(const glm::mat4& transform);
@@ -92,6 +131,47 @@ public:
     /** \brief Render the 3D scene. */
     void render();
 
+    /** \brief Get the GL state tracker, i.e. to read its counters. */
+    inline const glstate& gl_state() const { return state_; }
+
+    /** \brief Set the number of instances drawn by \ref render_instanced.
+    * \param[in] count The number of instances. Clamped to \ref max_instances.
+    */
+    void set_instance_count(size_t count);
+
+    inline size_t instance_count() const { return instance_skins_.size(); }
+
+    /** \brief Get the largest number of instances that fit in the
+    *          instance buffer for the current model. */
+    size_t max_instances() const;
+
+    /** \brief Set the per-instance data.
+    * \param[in] index The instance index.
+    * \param[in] transform The instance transform, applied before the scene transform.
+    * \param[in] skin The instance skin.
+    * \param[in] bones_transform The instance bone transforms.
+    */
+    void set_instance(size_t index, const glm::mat4& transform, int skin,
+        const std::vector<glm::mat4>& bones_transform);
+
+    /** \brief Select the simplified meshes an instance is drawn with, from
+    *          its distance and the error allowed on screen.
+    * \param[in] transform The instance transform.
+    * \return The level of detail, 0 for the full meshes.
+    */
+    int select_mesh_lod(const glm::mat4& transform) const;
+
+    /** \brief Get the distance to the camera from which an unscaled
+    *          instance is drawn with a level of detail.
+    * \param[in] lod The level of detail, from 1.
+    * \return The distance, FLT_MAX if no error is allowed on screen.
+    */
+    float mesh_lod_distance(int lod) const;
+
+    /** \brief Render all instances with hardware instancing, one draw
+    *          per mesh and per skin. */
+    void render_instanced();
+
     void on_model_changed();
 
 protected:
@@ -105,6 +185,9 @@ protected:
     void render_model();
     void render_model_wireframe();
     void render_model_smooth();
+
+    /** \brief Whether the textures of the model are uploaded. */
+    bool textures_ready() const;
     void render_model_textured();
     void render_model_textured_additive();
 
@@ -118,8 +201,72 @@ protected:
     void update_opaque_and_additive_textures();
     void update_offset_matrices();
 
+    void render_instances_smooth(size_t first_instance, size_t num_instances);
+    void render_instances_textured(int skin, size_t first_instance, size_t num_instances);
+
+    /** \brief Get the number of matrices stored per instance. */
+    size_t instance_stride() const;
+
+    /** \brief Get the stride of a mesh at the current level of detail. */
+    const MeshBufferStride& mesh_stride(size_t mesh_index) const;
+
 private:
     void render_meshes_textured(const std::list<size_t>& meshes);
+
+    /** \brief Draw textured meshes, one program variant at a time.
+    * \param[in] meshes The meshes to draw.
+    * \param[in] features The shader features shared by all meshes.
+    * \param[in] skin The skin to use.
+    * \param[in] first_instance The first instance, when instanced.
+    * \param[in] num_instances The number of instances, or 0 for a regular draw.
+    */
+    void draw_meshes_textured(const std::list<size_t>& meshes,
+        unsigned int features, int skin, size_t first_instance, int num_instances);
+
+    /** \brief Draw the meshes to render with flat colors.
+    * \see draw_meshes_textured
+    */
+    void draw_meshes_smooth(unsigned int features,
+        size_t first_instance, int num_instances);
+
+    /** \brief Get the shader features that depend on the render settings only. */
+    unsigned int global_shader_features() const;
+
+    /** \brief Get the shader features that depend on the mesh.
+    * \param[in] mesh The mesh.
+    * \param[in] textured Whether or not the mesh is drawn textured.
+    */
+    unsigned int mesh_shader_features(const Mesh* mesh, bool textured) const;
+
+    /** \brief Get the shader features that depend on the mesh, for other
+    *          settings than the current ones.
+    * \param[in] lighting Whether or not lighting is enabled.
+    * \param[in] chrome Whether or not chrome effects are drawn.
+    * \see mesh_shader_features
+    */
+    unsigned int mesh_shader_features(const Mesh* mesh, bool textured,
+        bool lighting, bool chrome) const;
+
+    /** \brief Build the program variants the model can be drawn with. */
+    void build_shader_variants();
+
+    /** \brief Fill \ref draw_list_ with \p meshes, grouped by shader variant.
+    * \param[in] meshes The meshes.
+    * \param[in] features The shader features shared by all meshes.
+    * \param[in] textured Whether or not the meshes are drawn textured.
+    */
+    void build_draw_list(const std::list<size_t>& meshes, unsigned int features, bool textured);
+
+    void set_instance_uniforms(glprogram& program, size_t first_instance);
+
+    /** \brief Split the meshes to render into opaque and additive meshes.
+    * \param[in] skin The skin used to look up the mesh textures.
+    * \param[out] opaque_meshes The opaque meshes.
+    * \param[out] additive_meshes The additive meshes.
+    */
+    void split_opaque_and_additive(int skin,
+        std::list<size_t>& opaque_meshes,
+        std::list<size_t>& additive_meshes) const;
     void delete_resources();
 
     /** \brief A pointer to the Studiomodel. */
@@ -131,9 +278,20 @@ private:
     StudioModelBuffer studio_model_buffer_;
     FileSystem* file_system_;
 
+    /** \brief Shared by the programs and their variants, so that files
+    * and expanded sources are reused between them. */
+    ShaderParser shader_parser_;
+
+    ProgramBinaryCache program_binary_cache_;
+
     /** \brief The current projection matrix. */
     glm::mat4 projection_matrix_;
 
+    /** \brief The viewport height, in pixels. */
+    int viewport_height_;
+
+    glm::mat4 scene_transform_;
+
     /** \brief The current model angles. */
     glm::vec3 angles_;
 
@@ -147,18 +305,53 @@ private:
     std::vector<glprogram*> shader_programs_;
 
     gluniformbuffer matrices_uniform_buffer_;
-    gluniformbuffer bone_matrices_uniform_buffer_;
+    gluniformringbuffer bone_matrices_ring_buffer_;
+
+    /** \brief The offset of the current bone palette within
+    * \ref bone_matrices_ring_buffer_. */
+    GLintptr bone_matrices_offset_;
+
+    /** \brief The bounds in the sequence bbox vertices, to skip
+    * redundant updates. */
+    glm::vec3 sequence_bbmin_;
+    glm::vec3 sequence_bbmax_;
+    bool sequence_bounds_valid_;
+    BBoxBuilder sequence_bbox_builder_;
+
     gluniformbuffer bone_offset_matrices_uniform_buffer_;
     gluniformbuffer global_uniform_buffer_;
     gluniformbuffer global2_uniform_buffer_;
 
     std::vector<glm::vec4> default_colors_;
 
+    /** \brief Filters out redundant state changes of the render passes. */
+    glstate state_;
+
+    /** \brief The per-instance transforms and bone palettes. */
+    gltexturebuffer instance_data_buffer_;
+
+    /** \brief The instance data, \ref instance_stride matrices per instance. */
+    std::vector<glm::mat4> instance_data_;
+    std::vector<int> instance_skins_;
+    std::vector<int> instance_lods_;
+
+    /** \brief The level of detail of the meshes being drawn. */
+    int mesh_lod_;
+
+    /** \brief The instance data sorted by skin and level of detail, as uploaded. */
+    std::vector<glm::mat4> instance_upload_data_;
+    std::vector<size_t> instance_order_;
+
+    /** \brief The meshes to draw, with their shader features. */
+    std::vector<std::pair<unsigned int, size_t>> draw_list_;
+
     std::list<size_t> meshes_to_render_;
 
     /** \brief A list of meshes to render after the opaque meshes. */
     std::list<size_t> additive_meshes_;
     std::list<size_t> opaque_meshes_;
+
+    TextureUploader texture_uploader_;
 };
 
 }
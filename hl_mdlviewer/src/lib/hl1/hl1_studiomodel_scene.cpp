@@ -0,0 +1,432 @@
+/**
+* \file hl1_studiomodel_scene.cpp
+* \brief Implementation for the HL1 Studio model scene class.
+*/
+
+#include "pch.h"
+#include "hl1_studiomodel_scene.h"
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HLMDLVIEWER_SCENE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+namespace {
+
+const int NUM_FRUSTUM_PLANES = 6;
+
+/** \brief Extract the frustum planes of a clip space transform. Points
+* inside the frustum are on the positive side of every plane. The planes
+* are not normalized, which does not change the sign of the tests.
+*/
+void get_frustum_planes(const glm::mat4& m, glm::vec4 planes[NUM_FRUSTUM_PLANES])
+{
+    const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0;    // Left.
+    planes[1] = row3 - row0;    // Right.
+    planes[2] = row3 + row1;    // Bottom.
+    planes[3] = row3 - row1;    // Top.
+    planes[4] = row3 + row2;    // Near.
+    planes[5] = row3 - row2;    // Far.
+}
+
+}
+
+StudioModelScene::StudioModelScene() :
+    bounds_source_(SceneBoundsSource::HITBOXES),
+    models_(),
+    instance_models_(),
+    transforms_(),
+    skins_(),
+    sequences_(),
+    frames_(),
+    playback_rates_(),
+    pending_times_(),
+    center_x_(),
+    center_y_(),
+    center_z_(),
+    half_size_x_(),
+    half_size_y_(),
+    half_size_z_(),
+    bounds_dirty_(),
+    any_bounds_dirty_(false),
+    visible_instances_(),
+    bones_transform_(),
+    statistics_()
+{
+}
+
+size_t StudioModelScene::add_model(const StudioModel* studio_model,
+    StudioModelAnimation* animation,
+    const StudioModelBuffer* buffer,
+    const glm::mat4& scene_transform)
+{
+    std::unique_ptr<SceneModel> model(new SceneModel());
+    model->studio_model = studio_model;
+    model->animation = animation;
+    model->scene_transform = scene_transform;
+    if (buffer)
+        model->bounds.setup(*studio_model, *buffer);
+    else
+        model->bounds.setup(*studio_model, StudioModelBuffer());
+    model->sequence_bounds.resize(studio_model->sequences.size());
+    model->has_sequence_bounds.assign(studio_model->sequences.size(), false);
+
+    models_.push_back(std::move(model));
+    return models_.size() - 1;
+}
+
+void StudioModelScene::clear()
+{
+    clear_instances();
+    models_.clear();
+}
+
+void StudioModelScene::clear_instances()
+{
+    instance_models_.clear();
+    transforms_.clear();
+    skins_.clear();
+    sequences_.clear();
+    frames_.clear();
+    playback_rates_.clear();
+    pending_times_.clear();
+    center_x_.clear();
+    center_y_.clear();
+    center_z_.clear();
+    half_size_x_.clear();
+    half_size_y_.clear();
+    half_size_z_.clear();
+    bounds_dirty_.clear();
+    any_bounds_dirty_ = false;
+    visible_instances_.clear();
+    statistics_ = SceneStatistics();
+}
+
+void StudioModelScene::set_bounds_source(SceneBoundsSource source)
+{
+    if (source == bounds_source_)
+        return;
+
+    bounds_source_ = source;
+    std::fill(bounds_dirty_.begin(), bounds_dirty_.end(), 1);
+    any_bounds_dirty_ = true;
+}
+
+size_t StudioModelScene::add_instance(size_t model, const StudioModelInstance& instance)
+{
+    if (model >= models_.size())
+        throw std::runtime_error("Model index out of range.");
+
+    instance_models_.push_back(static_cast<uint32_t>(model));
+    transforms_.push_back(instance.transform);
+    skins_.push_back(instance.skin);
+    sequences_.push_back(instance.sequence);
+    frames_.push_back(instance.frame);
+    playback_rates_.push_back(instance.playback_rate);
+    pending_times_.push_back(0.0f);
+
+    center_x_.push_back(0.0f);
+    center_y_.push_back(0.0f);
+    center_z_.push_back(0.0f);
+    half_size_x_.push_back(0.0f);
+    half_size_y_.push_back(0.0f);
+    half_size_z_.push_back(0.0f);
+    bounds_dirty_.push_back(1);
+    any_bounds_dirty_ = true;
+
+    return instance_models_.size() - 1;
+}
+
+bool StudioModelScene::has_playing_instances() const
+{
+    for (size_t i = 0; i < instance_models_.size(); ++i)
+    {
+        const SceneModel& model = *models_[instance_models_[i]];
+        if (!model.animation || playback_rates_[i] == 0.0f)
+            continue;
+
+        const int sequence = sequences_[i];
+        if (sequence >= 0 && sequence < static_cast<int>(model.studio_model->sequences.size()) &&
+            model.studio_model->sequences[sequence].num_frames > 1)
+            return true;
+    }
+
+    return false;
+}
+
+StudioModelInstance StudioModelScene::get_instance(size_t index) const
+{
+    StudioModelInstance instance;
+    instance.transform = transforms_[index];
+    instance.skin = skins_[index];
+    instance.sequence = sequences_[index];
+    instance.frame = frames_[index];
+    instance.playback_rate = playback_rates_[index];
+    return instance;
+}
+
+void StudioModelScene::set_instance(size_t index, const StudioModelInstance& instance)
+{
+    if (index >= num_instances())
+        throw std::runtime_error("Instance index out of range.");
+
+    if (instance.transform != transforms_[index] || instance.sequence != sequences_[index])
+    {
+        bounds_dirty_[index] = 1;
+        any_bounds_dirty_ = true;
+    }
+
+    transforms_[index] = instance.transform;
+    skins_[index] = instance.skin;
+    sequences_[index] = instance.sequence;
+    frames_[index] = instance.frame;
+    playback_rates_[index] = instance.playback_rate;
+    pending_times_[index] = 0.0f;
+}
+
+void StudioModelScene::get_world_bounds(size_t index, glm::vec3& bbmin, glm::vec3& bbmax) const
+{
+    const glm::vec3 center(center_x_[index], center_y_[index], center_z_[index]);
+    const glm::vec3 half_size(half_size_x_[index], half_size_y_[index], half_size_z_[index]);
+    bbmin = center - half_size;
+    bbmax = center + half_size;
+}
+
+void StudioModelScene::get_local_bounds(SceneModel& model, int sequence, glm::vec3& bbmin, glm::vec3& bbmax)
+{
+    const std::vector<Sequence>& sequences = model.studio_model->sequences;
+    if (sequence < 0 || sequence >= static_cast<int>(sequences.size()))
+    {
+        bbmin = bbmax = glm::vec3(0.0f);
+        return;
+    }
+
+    const Sequence& studio_sequence = sequences[sequence];
+
+    if (bounds_source_ == SceneBoundsSource::SEQUENCE || !model.animation)
+    {
+        bbmin = studio_sequence.bbmin;
+        bbmax = studio_sequence.bbmax;
+        return;
+    }
+
+    if (!model.has_sequence_bounds[sequence])
+    {
+        // Merge the hitbox bounds of every frame.
+        BoneBounds& sequence_bounds = model.sequence_bounds[sequence];
+        bool has_bounds = false;
+
+        for (int frame = 0; frame < std::max(studio_sequence.num_frames - 1, 1); ++frame)
+        {
+            model.animation->compute_bone_transforms(sequence, static_cast<float>(frame), bones_transform_);
+
+            glm::vec3 frame_bbmin, frame_bbmax;
+            if (!model.bounds.compute(bones_transform_, BoundsMode::HITBOXES, frame_bbmin, frame_bbmax))
+                break;
+
+            sequence_bounds.bbmin = has_bounds ? glm::min(sequence_bounds.bbmin, frame_bbmin) : frame_bbmin;
+            sequence_bounds.bbmax = has_bounds ? glm::max(sequence_bounds.bbmax, frame_bbmax) : frame_bbmax;
+            has_bounds = true;
+        }
+
+        // A model without hitboxes nor vertices.
+        if (!has_bounds)
+        {
+            sequence_bounds.bbmin = studio_sequence.bbmin;
+            sequence_bounds.bbmax = studio_sequence.bbmax;
+        }
+
+        model.has_sequence_bounds[sequence] = true;
+    }
+
+    bbmin = model.sequence_bounds[sequence].bbmin;
+    bbmax = model.sequence_bounds[sequence].bbmax;
+}
+
+void StudioModelScene::update_world_bounds()
+{
+    if (!any_bounds_dirty_)
+        return;
+
+    for (size_t i = 0; i < num_instances(); ++i)
+    {
+        if (!bounds_dirty_[i])
+            continue;
+
+        SceneModel& model = *models_[instance_models_[i]];
+
+        glm::vec3 bbmin, bbmax;
+        get_local_bounds(model, sequences_[i], bbmin, bbmax);
+
+        const glm::mat4 m = transforms_[i] * model.scene_transform;
+        const glm::vec3 center = glm::vec3(m * glm::vec4((bbmin + bbmax) * 0.5f, 1.0f));
+        const glm::vec3 half_size = (bbmax - bbmin) * 0.5f;
+
+        center_x_[i] = center.x;
+        center_y_[i] = center.y;
+        center_z_[i] = center.z;
+        half_size_x_[i] = std::abs(m[0][0]) * half_size.x + std::abs(m[1][0]) * half_size.y + std::abs(m[2][0]) * half_size.z;
+        half_size_y_[i] = std::abs(m[0][1]) * half_size.x + std::abs(m[1][1]) * half_size.y + std::abs(m[2][1]) * half_size.z;
+        half_size_z_[i] = std::abs(m[0][2]) * half_size.x + std::abs(m[1][2]) * half_size.y + std::abs(m[2][2]) * half_size.z;
+
+        bounds_dirty_[i] = 0;
+    }
+
+    any_bounds_dirty_ = false;
+}
+
+void StudioModelScene::cull(const glm::mat4& view_projection)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    update_world_bounds();
+
+    glm::vec4 planes[NUM_FRUSTUM_PLANES];
+    get_frustum_planes(view_projection, planes);
+
+    const size_t count = num_instances();
+    visible_instances_.clear();
+    visible_instances_.reserve(count);
+
+    size_t i = 0;
+
+#ifdef HLMDLVIEWER_SCENE_SSE2
+    const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 cx = _mm_loadu_ps(&center_x_[i]);
+        const __m128 cy = _mm_loadu_ps(&center_y_[i]);
+        const __m128 cz = _mm_loadu_ps(&center_z_[i]);
+        const __m128 hx = _mm_loadu_ps(&half_size_x_[i]);
+        const __m128 hy = _mm_loadu_ps(&half_size_y_[i]);
+        const __m128 hz = _mm_loadu_ps(&half_size_z_[i]);
+
+        // A box is outside if it is entirely behind any plane, i.e. the
+        // distance of its center is less than minus its projected radius.
+        __m128 outside = _mm_setzero_ps();
+
+        for (int p = 0; p < NUM_FRUSTUM_PLANES; ++p)
+        {
+            const __m128 nx = _mm_set1_ps(planes[p].x);
+            const __m128 ny = _mm_set1_ps(planes[p].y);
+            const __m128 nz = _mm_set1_ps(planes[p].z);
+
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+                _mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(planes[p].w)));
+            const __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_and_ps(nx, sign_mask), hx), _mm_mul_ps(_mm_and_ps(ny, sign_mask), hy)),
+                _mm_mul_ps(_mm_and_ps(nz, sign_mask), hz));
+
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        const int outside_mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; ++k)
+        {
+            if (!(outside_mask & (1 << k)))
+                visible_instances_.push_back(static_cast<uint32_t>(i + k));
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        bool outside = false;
+
+        for (int p = 0; p < NUM_FRUSTUM_PLANES && !outside; ++p)
+        {
+            const glm::vec4& plane = planes[p];
+            const float distance = plane.x * center_x_[i] + plane.y * center_y_[i] + plane.z * center_z_[i] + plane.w;
+            const float radius = std::abs(plane.x) * half_size_x_[i] + std::abs(plane.y) * half_size_y_[i] +
+                std::abs(plane.z) * half_size_z_[i];
+
+            outside = distance + radius < 0.0f;
+        }
+
+        if (!outside)
+            visible_instances_.push_back(static_cast<uint32_t>(i));
+    }
+
+    statistics_.num_instances = count;
+    statistics_.num_visible = visible_instances_.size();
+    statistics_.num_culled = count - visible_instances_.size();
+    statistics_.cull_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void StudioModelScene::animate(float frame_time)
+{
+    for (float& pending_time : pending_times_)
+        pending_time += frame_time;
+
+    for (uint32_t index : visible_instances_)
+    {
+        const SceneModel& model = *models_[instance_models_[index]];
+        float pending_time = pending_times_[index];
+        pending_times_[index] = 0.0f;
+
+        // Without an animation, the instance keeps its frame.
+        if (!model.animation)
+            continue;
+
+        // The frames loop, so skip the whole loops of long culled instances.
+        const int sequence = sequences_[index];
+        if (sequence >= 0 && sequence < static_cast<int>(model.studio_model->sequences.size()))
+        {
+            const Sequence& studio_sequence = model.studio_model->sequences[sequence];
+            const float rate = studio_sequence.fps * playback_rates_[index];
+
+            if (studio_sequence.num_frames > 1 && rate > 0.0f)
+                pending_time = std::fmod(pending_time, (studio_sequence.num_frames - 1) / rate);
+        }
+
+        // Frames are advanced by at most 0.1s at a time, catch up in steps.
+        while (pending_time > 0.0f)
+        {
+            const float step = std::min(pending_time, 0.1f);
+            frames_[index] = model.animation->advance_frame(sequence, frames_[index], playback_rates_[index], step);
+            pending_time -= step;
+        }
+    }
+}
+
+void StudioModelScene::compute_bone_transforms(size_t index, std::vector<glm::mat4>& bones_transform)
+{
+    compute_bone_transforms(index, nullptr, bones_transform);
+}
+
+void StudioModelScene::compute_bone_transforms(size_t index, const std::vector<uint8_t>* bone_mask,
+    std::vector<glm::mat4>& bones_transform)
+{
+    const SceneModel& model = *models_[instance_models_[index]];
+    if (model.animation)
+    {
+        model.animation->compute_bone_transforms(sequences_[index], frames_[index], bone_mask, bones_transform);
+        return;
+    }
+
+    // Without an animation, the instance stands in the bind pose.
+    const std::vector<Bone>& bones = model.studio_model->bones;
+    bones_transform.resize(bones.size());
+
+    for (const Bone& bone : bones)
+    {
+        glm::mat4 transform = glm::mat4_cast(bone.local_quat);
+        transform[3] = glm::vec4(bone.local_position, 1.0f);
+
+        bones_transform[bone.index] = bone.parent ? bones_transform[bone.parent_index] * transform : transform;
+    }
+}
+
+}
+}
@@ -0,0 +1,200 @@
+/**
+* \file hl1_studiomodel_scene.h
+* \brief Declaration for the HL1 Studio model scene class.
+*/
+
+#ifndef HLMDLVIEWER_HL1_STUDIOMODEL_SCENE_H_
+#define HLMDLVIEWER_HL1_STUDIOMODEL_SCENE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "hl1_studiomodel.h"
+#include "hl1_studiomodel_animation.h"
+#include "hl1_studiomodel_bounds.h"
+#include "hl1_studiomodel_buffer.h"
+#include "hl1_studiomodel_instance.h"
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+/** \brief The local bounds the instances are culled with. */
+enum class SceneBoundsSource
+{
+    /** The sequence bbmin and bbmax, as stored in the model. */
+    SEQUENCE,
+
+    /** The hitboxes of every frame of the sequence, which are usually
+    * tighter. Computed once per sequence, when first needed. */
+    HITBOXES
+};
+
+/** \brief The counters of the last \ref StudioModelScene::cull. */
+struct SceneStatistics
+{
+    SceneStatistics() :
+        num_instances(0),
+        num_visible(0),
+        num_culled(0),
+        cull_time(0.0)
+    {
+    }
+
+    size_t num_instances;
+    size_t num_visible;
+    size_t num_culled;
+
+    /** \brief The time spent culling, in seconds. */
+    double cull_time;
+};
+
+/** \brief Instances of one or more models placed in a scene.
+*
+* The instance data is stored one array per field, so that the bounds
+* can be culled 4 instances at a time and only the visible instances are
+* animated and drawn. Culled instances keep track of the elapsed time and
+* catch up once visible again.
+*/
+class StudioModelScene
+{
+public:
+    StudioModelScene();
+    StudioModelScene(const StudioModelScene&) = delete;
+
+    /** \brief Add a model the instances can refer to.
+    * \param[in] studio_model The model.
+    * \param[in] animation The animation of the model, to animate the instances
+    *            and compute the hitbox bounds. May be null to only cull with
+    *            the sequence bounds, the instances then stand in the bind
+    *            pose.
+    * \param[in] buffer The model buffer, for the vertex bounds of models
+    *            without hitboxes, or null.
+    * \param[in] scene_transform The scene transform of the model.
+    * \return The index of the model.
+    */
+    size_t add_model(const StudioModel* studio_model,
+        StudioModelAnimation* animation,
+        const StudioModelBuffer* buffer,
+        const glm::mat4& scene_transform);
+
+    inline size_t num_models() const { return models_.size(); }
+    inline const StudioModel* get_studio_model(size_t model) const { return models_[model]->studio_model; }
+
+    /** \brief Remove the models and their instances. */
+    void clear();
+    void clear_instances();
+
+    void set_bounds_source(SceneBoundsSource source);
+    inline SceneBoundsSource bounds_source() const { return bounds_source_; }
+
+    /** \brief Add an instance of a model.
+    * \param[in] model The model index.
+    * \param[in] instance The placement, relative to the scene, and animation state.
+    * \return The index of the instance.
+    */
+    size_t add_instance(size_t model, const StudioModelInstance& instance);
+
+    inline size_t num_instances() const { return instance_models_.size(); }
+
+    /** \brief Whether any instance plays a sequence of more than one frame,
+    *          with an animation and a nonzero playback rate. */
+    bool has_playing_instances() const;
+
+    StudioModelInstance get_instance(size_t index) const;
+    void set_instance(size_t index, const StudioModelInstance& instance);
+
+    inline size_t get_model(size_t index) const { return instance_models_[index]; }
+    inline const glm::mat4& get_transform(size_t index) const { return transforms_[index]; }
+    inline int get_skin(size_t index) const { return skins_[index]; }
+    inline int get_sequence(size_t index) const { return sequences_[index]; }
+    inline float get_frame(size_t index) const { return frames_[index]; }
+
+    /** \brief Get the world bounds of an instance, as last culled. */
+    void get_world_bounds(size_t index, glm::vec3& bbmin, glm::vec3& bbmax) const;
+
+    /** \brief Find the instances inside the view frustum.
+    * \param[in] view_projection The matrix from the scene space to clip space.
+    */
+    void cull(const glm::mat4& view_projection);
+
+    /** \brief Advance the frame of the visible instances. The time of the
+    *          culled instances is accumulated until they are visible.
+    *          Instances of models without an animation keep their frame.
+    * \param[in] frame_time The elapsed time.
+    */
+    void animate(float frame_time);
+
+    /** \brief Compute the bone transforms of an instance at its current
+    *          frame, or in the bind pose if its model has no animation. */
+    void compute_bone_transforms(size_t index, std::vector<glm::mat4>& bones_transform);
+
+    /** \brief Compute the bone transforms of an instance, animating only the
+    *          bones set in \p bone_mask.
+    * \see StudioModelAnimation::compute_bone_transforms
+    */
+    void compute_bone_transforms(size_t index, const std::vector<uint8_t>* bone_mask,
+        std::vector<glm::mat4>& bones_transform);
+
+    /** \brief Get the instances found visible by the last \ref cull, in order. */
+    inline const std::vector<uint32_t>& visible_instances() const { return visible_instances_; }
+
+    inline const SceneStatistics& statistics() const { return statistics_; }
+
+private:
+
+    struct SceneModel
+    {
+        const StudioModel* studio_model;
+        StudioModelAnimation* animation;
+        glm::mat4 scene_transform;
+        StudioModelBounds bounds;
+
+        /** \brief The hitbox bounds of each sequence, once computed. */
+        std::vector<BoneBounds> sequence_bounds;
+        std::vector<bool> has_sequence_bounds;
+    };
+
+    /** \brief Get the local bounds of a sequence of a model. */
+    void get_local_bounds(SceneModel& model, int sequence, glm::vec3& bbmin, glm::vec3& bbmax);
+
+    /** \brief Update the world bounds of the moved instances. */
+    void update_world_bounds();
+
+    SceneBoundsSource bounds_source_;
+
+    std::vector<std::unique_ptr<SceneModel>> models_;
+
+    std::vector<uint32_t> instance_models_;
+    std::vector<glm::mat4> transforms_;
+    std::vector<int> skins_;
+    std::vector<int> sequences_;
+    std::vector<float> frames_;
+    std::vector<float> playback_rates_;
+
+    /** \brief The time elapsed since the instance was last animated. */
+    std::vector<float> pending_times_;
+
+    /** \brief The world bounds, as centers and half sizes. */
+    std::vector<float> center_x_;
+    std::vector<float> center_y_;
+    std::vector<float> center_z_;
+    std::vector<float> half_size_x_;
+    std::vector<float> half_size_y_;
+    std::vector<float> half_size_z_;
+
+    /** \brief Whether the world bounds must be updated. */
+    std::vector<uint8_t> bounds_dirty_;
+    bool any_bounds_dirty_;
+
+    std::vector<uint32_t> visible_instances_;
+
+    /** \brief Scratch bone transforms, for the sequence bounds. */
+    std::vector<glm::mat4> bones_transform_;
+
+    SceneStatistics statistics_;
+};
+
+}
+}
+
+#endif // HLMDLVIEWER_HL1_STUDIOMODEL_SCENE_H_
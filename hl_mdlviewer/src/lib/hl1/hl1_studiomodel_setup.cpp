@@ -7,10 +7,19 @@
 #include "hl1_studiomodel_setup.h"
 #include "glvertex.h"
 #include "bbox_builder.h"
+#include "content_hash.h"
+#include "image_palette.h"
+#include "mesh_simplifier.h"
+#include "texture_cache.h"
+#include "texture_mipmaps.h"
+#include "thread_pool.h"
+#include "vertex_cache_optimizer.h"
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "../code/AssetLib/MDL/HalfLife/HL1ImportDefinitions.h"
 
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <glm/gtx/matrix_decompose.hpp>
@@ -18,13 +27,28 @@
 namespace hl_mdlviewer { 
 namespace hl1 { 
 
+namespace {
+
+/** \brief Changes the keys of the texture cache when the processing changes. */
+const uint32_t TEXTURE_PROCESSING_VERSION = 1;
+
+/** \brief The most mip levels of the texture atlas, whose images are
+*          padded by 2 ^ (levels - 1) texels. */
+const unsigned int MAX_TEXTURE_LEVELS = 6;
+
+}
+
 StudioModelSetup::StudioModelSetup() :
     studio_model_(nullptr),
     studio_model_buffer_(nullptr),
     scene_(nullptr),
     bone_map_(),
     scene_bones_(nullptr),
-    buffer_builder_()
+    buffer_builder_(),
+    storage_(BufferStorage::GPU),
+    num_mesh_lods_(2),
+    texture_settings_(),
+    texture_uploader_(nullptr)
 {
 }
 
@@ -32,11 +56,15 @@ void StudioModelSetup::setup_model(
     const aiScene* scene,
     StudioModel* studio_model,
     StudioModelBuffer* studio_model_buffer,
-    glm::mat4& scene_transform)
+    glm::mat4& scene_transform,
+    VertexFormat vertex_format,
+    bool optimize_meshes,
+    BufferStorage storage)
 {
     scene_ = scene;
     studio_model_ = studio_model;
     studio_model_buffer_ = studio_model_buffer;
+    storage_ = storage;
     bone_map_.clear();
 
     scene_transform = to_glm_mat4(scene_->mRootNode->mTransformation);
@@ -48,11 +76,38 @@ void StudioModelSetup::setup_model(
 
     setup_model_data();
 
+    buffer_builder_.set_optimize_meshes(optimize_meshes);
+
     setup_model_buffers();
 
-    studio_model_buffer_->buffer.initialize(
-        buffer_builder_.get_vertices(),
-        buffer_builder_.get_indices());
+    setup_bone_vertex_bounds();
+
+    studio_model_buffer_->statistics.vertex_cache = buffer_builder_.statistics();
+
+    if (storage_ != BufferStorage::GPU)
+    {
+        studio_model_buffer_->vertices = buffer_builder_.get_vertices();
+        studio_model_buffer_->indices = buffer_builder_.get_indices();
+
+        if (storage_ == BufferStorage::CPU)
+            return;
+    }
+
+    if (vertex_format == VertexFormat::PACKED && buffer_builder_.can_pack_vertices())
+    {
+        std::vector<glvertex_packed> packed_vertices;
+        buffer_builder_.get_packed_vertices(packed_vertices);
+
+        studio_model_buffer_->buffer.initialize(
+            packed_vertices,
+            buffer_builder_.get_indices());
+    }
+    else
+    {
+        studio_model_buffer_->buffer.initialize(
+            buffer_builder_.get_vertices(),
+            buffer_builder_.get_indices());
+    }
 }
 
 void StudioModelSetup::setup_model_data()
@@ -69,6 +124,7 @@ void StudioModelSetup::setup_model_data()
 void StudioModelSetup::setup_model_buffers()
 {
     setup_buffer_meshes();
+    setup_buffer_mesh_lods();
     setup_buffer_bones();
     setup_buffer_attachments();
     setup_buffer_hitboxes();
@@ -76,6 +132,52 @@ void StudioModelSetup::setup_model_buffers()
     setup_buffer_gltextures();
 }
 
+void StudioModelSetup::setup_bone_vertex_bounds()
+{
+    const std::vector<glvertex>& vertices = buffer_builder_.get_vertices();
+    const int num_bones = static_cast<int>(studio_model_->bones.size());
+
+    std::vector<BoneBounds> bounds(num_bones);
+    std::vector<bool> has_vertices(num_bones, false);
+
+    for (const MeshBufferStride& stride : studio_model_buffer_->meshes)
+    {
+        for (int i = 0; i < stride.num_vertices; ++i)
+        {
+            const glvertex& vertex = vertices[stride.vertex_start_index + i];
+            if (vertex.boneid < 0 || vertex.boneid >= num_bones)
+                continue;
+
+            // The vertices are skinned with the bone transform times
+            // the offset matrix.
+            const glm::vec3 position = glm::vec3(
+                studio_model_->bones[vertex.boneid].offset_matrix * glm::vec4(vertex.position, 1.0f));
+
+            BoneBounds& bone_bounds = bounds[vertex.boneid];
+            if (!has_vertices[vertex.boneid])
+            {
+                bone_bounds.bbmin = bone_bounds.bbmax = position;
+                has_vertices[vertex.boneid] = true;
+            }
+            else
+            {
+                bone_bounds.bbmin = glm::min(bone_bounds.bbmin, position);
+                bone_bounds.bbmax = glm::max(bone_bounds.bbmax, position);
+            }
+        }
+    }
+
+    studio_model_buffer_->bone_vertex_bounds.clear();
+    for (int i = 0; i < num_bones; ++i)
+    {
+        if (has_vertices[i])
+        {
+            bounds[i].bone = i;
+            studio_model_buffer_->bone_vertex_bounds.push_back(bounds[i]);
+        }
+    }
+}
+
 void StudioModelSetup::setup_bones()
 {
     if (!scene_bones_)
@@ -431,22 +533,355 @@ void StudioModelSetup::setup_meshes()
 
 void StudioModelSetup::setup_buffer_gltextures()
 {
-    studio_model_buffer_->gltextures.resize(scene_->mNumTextures);
-
     const aiTexture* scene_texture = NULL;
 
+    if (storage_ != BufferStorage::CPU &&
+        (texture_settings_.compress || !setup_buffer_palettized_gltextures()))
+        setup_buffer_bgra_gltextures();
+
+    if (storage_ == BufferStorage::GPU)
+        return;
+
+    studio_model_buffer_->images.resize(scene_->mNumTextures);
+
     for (unsigned int i = 0; i < scene_->mNumTextures; ++i)
     {
         scene_texture = scene_->mTextures[i];
-        studio_model_buffer_->gltextures[i].create_from_data(
-            scene_texture->mWidth,
-            scene_texture->mHeight,
-            GL_RGBA,
-            GL_BGRA,
-            (unsigned char*)scene_texture->pcData);
+
+        Image& image = studio_model_buffer_->images[i];
+        image = Image(scene_texture->mWidth, scene_texture->mHeight);
+
+        for (unsigned int j = 0; j < scene_texture->mWidth * scene_texture->mHeight; ++j)
+        {
+            const aiTexel& texel = scene_texture->pcData[j];
+            uint8_t* pixel = &image.pixels[j * 4];
+            pixel[0] = texel.r;
+            pixel[1] = texel.g;
+            pixel[2] = texel.b;
+            pixel[3] = texel.a;
+        }
     }
 }
 
+bool StudioModelSetup::get_texture_mask_color(unsigned int texture, uint8_t* mask_color) const
+{
+    if (texture >= studio_model_->textures.size() ||
+        !(studio_model_->textures[texture].flags & aiTextureFlags_UseAlpha))
+        return false;
+
+    // In the BGR order of the texels.
+    const glm::vec3& color = studio_model_->textures[texture].mask_color;
+    mask_color[0] = static_cast<uint8_t>(std::round(color.z * 255.0f));
+    mask_color[1] = static_cast<uint8_t>(std::round(color.y * 255.0f));
+    mask_color[2] = static_cast<uint8_t>(std::round(color.x * 255.0f));
+    return true;
+}
+
+void StudioModelSetup::setup_buffer_bgra_gltextures()
+{
+    const unsigned int num_textures = scene_->mNumTextures;
+
+    // The masked texels get an alpha of 0, which the mip levels and the
+    // compression keep, and the shader discards.
+    std::vector<std::vector<uint8_t>> images(num_textures);
+    std::vector<AtlasRect> sizes(num_textures);
+    std::vector<size_t> texture_images(num_textures);
+    bool any_masked = false;
+    uint64_t content_hash = FNV1A_64_OFFSET_BASIS;
+
+    for (unsigned int i = 0; i < num_textures; ++i)
+    {
+        const aiTexture* scene_texture = scene_->mTextures[i];
+        const size_t num_texels = static_cast<size_t>(scene_texture->mWidth) * scene_texture->mHeight;
+
+        std::vector<uint8_t>& image = images[i];
+        image.resize(num_texels * 4);
+        std::memcpy(image.data(), scene_texture->pcData, image.size());
+
+        uint8_t mask_color[3];
+        const bool masked = get_texture_mask_color(i, mask_color);
+        for (size_t j = 0; j < num_texels; ++j)
+        {
+            uint8_t* texel = &image[j * 4];
+            texel[3] = masked && std::memcmp(texel, mask_color, 3) == 0 ? 0 : 255;
+        }
+
+        any_masked = any_masked || masked;
+
+        sizes[i] = AtlasRect(scene_texture->mWidth, scene_texture->mHeight);
+        texture_images[i] = i;
+
+        content_hash = hash_bytes_64(&sizes[i].width, sizeof(sizes[i].width), content_hash);
+        content_hash = hash_bytes_64(&sizes[i].height, sizeof(sizes[i].height), content_hash);
+        content_hash = hash_bytes_64(image.data(), image.size(), content_hash);
+    }
+
+    TextureCompression compression = TextureCompression::NONE;
+    GLint internal_format = GL_RGBA;
+    if (texture_settings_.compress)
+    {
+        compression = any_masked ? TextureCompression::BC3 : TextureCompression::BC1;
+        internal_format = any_masked ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    }
+
+    setup_buffer_texture_atlas(sizes, 4, internal_format, GL_BGRA, compression, texture_images, content_hash,
+        [&images, &sizes](size_t image, unsigned int num_levels, std::vector<MipLevel>& levels) {
+            generate_mipmaps(images[image].data(), sizes[image].width, sizes[image].height, num_levels, levels);
+        });
+}
+
+bool StudioModelSetup::setup_buffer_palettized_gltextures()
+{
+    const unsigned int num_textures = scene_->mNumTextures;
+    if (num_textures == 0)
+        return false;
+
+    // The loader expands the textures to BGRA, the palettes are rebuilt
+    // from their colors.
+    std::vector<PalettizedImage> images(num_textures);
+    std::vector<bool> masked(num_textures);
+    for (unsigned int i = 0; i < num_textures; ++i)
+    {
+        const aiTexture* scene_texture = scene_->mTextures[i];
+
+        uint8_t mask_color[3];
+        masked[i] = get_texture_mask_color(i, mask_color);
+
+        if (!palettize_image(reinterpret_cast<const uint8_t*>(scene_texture->pcData),
+            scene_texture->mWidth, scene_texture->mHeight,
+            masked[i] ? mask_color : nullptr,
+            images[i]))
+            return false;
+    }
+
+    studio_model_buffer_->palettized = true;
+
+    // Skin families that only change the colors share their indices.
+    std::vector<size_t> texture_images(num_textures);
+    std::vector<unsigned int> unique_images;
+    for (unsigned int i = 0; i < num_textures; ++i)
+    {
+        const PalettizedImage& image = images[i];
+
+        size_t image_index = unique_images.size();
+        for (size_t j = 0; j < unique_images.size(); ++j)
+        {
+            const PalettizedImage& other = images[unique_images[j]];
+            if (image.width == other.width && image.height == other.height &&
+                image.indices == other.indices)
+            {
+                image_index = j;
+                break;
+            }
+        }
+
+        if (image_index == unique_images.size())
+            unique_images.push_back(i);
+
+        texture_images[i] = image_index;
+    }
+
+    size_t expanded_size = 0;
+    size_t palettized_size = static_cast<size_t>(PALETTE_SIZE) * 4 * num_textures;
+
+    // The mip levels of shared indices are filtered with the palette of
+    // the first texture, the skins differ by their colors only.
+    std::vector<AtlasRect> sizes(unique_images.size());
+    uint64_t content_hash = FNV1A_64_OFFSET_BASIS;
+    for (size_t i = 0; i < unique_images.size(); ++i)
+    {
+        const PalettizedImage& image = images[unique_images[i]];
+        sizes[i] = AtlasRect(image.width, image.height);
+
+        const uint8_t mask = masked[unique_images[i]] ? 1 : 0;
+        content_hash = hash_bytes_64(&image.width, sizeof(image.width), content_hash);
+        content_hash = hash_bytes_64(&image.height, sizeof(image.height), content_hash);
+        content_hash = hash_bytes_64(&mask, sizeof(mask), content_hash);
+        content_hash = hash_bytes_64(image.indices.data(), image.indices.size(), content_hash);
+        content_hash = hash_bytes_64(image.palette.data(), image.palette.size(), content_hash);
+
+        palettized_size += image.indices.size();
+    }
+
+    setup_buffer_texture_atlas(sizes, 1, GL_R8, GL_RED, TextureCompression::NONE, texture_images, content_hash,
+        [&](size_t image, unsigned int num_levels, std::vector<MipLevel>& levels) {
+            const unsigned int texture = unique_images[image];
+            const PalettizedImage& palettized = images[texture];
+            generate_palettized_mipmaps(palettized.indices.data(),
+                palettized.width, palettized.height,
+                palettized.palette.data(),
+                masked[texture] ? MASK_PALETTE_INDEX : -1,
+                num_levels,
+                levels);
+        });
+
+    std::vector<uint8_t> palettes;
+    palettes.reserve(static_cast<size_t>(PALETTE_SIZE) * 4 * num_textures);
+    for (const PalettizedImage& image : images)
+    {
+        palettes.insert(palettes.end(), image.palette.begin(), image.palette.end());
+        expanded_size += image.indices.size() * 4;
+    }
+
+    create_texture(studio_model_buffer_->palette_texture,
+        PALETTE_SIZE,
+        static_cast<unsigned int>(num_textures),
+        GL_RGBA,
+        GL_BGRA,
+        std::move(palettes));
+
+    StudioModelBufferStatistics& statistics = studio_model_buffer_->statistics;
+    statistics.expanded_texture_size = expanded_size;
+    statistics.palettized_texture_size = palettized_size;
+    statistics.num_shared_textures = num_textures - unique_images.size();
+
+    return true;
+}
+
+void StudioModelSetup::setup_buffer_texture_atlas(std::vector<AtlasRect> sizes,
+    unsigned int bytes_per_texel,
+    GLint internal_format,
+    GLint format,
+    TextureCompression compression,
+    const std::vector<size_t>& texture_images,
+    uint64_t content_hash,
+    const GenerateLevelsFunction& generate_levels)
+{
+    const unsigned int num_levels = std::min(std::max(texture_settings_.num_mip_levels, 1u), MAX_TEXTURE_LEVELS);
+
+    // A border of repeated edge texels keeps the filtering from reading
+    // the neighbor images. It halves with each level, down to one texel,
+    // and the images are aligned so that their levels start on whole
+    // texels, and on whole blocks once compressed.
+    const unsigned int padding = 1u << (num_levels - 1);
+    const unsigned int alignment = compression != TextureCompression::NONE ? std::max(padding, 4u) : padding;
+
+    // OpenGL 3.3 supports at least 1024 texels.
+    const unsigned int max_size = static_cast<unsigned int>(
+        std::max(render_backend().get_integer(GL_MAX_TEXTURE_SIZE), 1024));
+
+    unsigned int atlas_width, atlas_height;
+    if (!pack_atlas(sizes, padding, max_size, atlas_width, atlas_height, alignment))
+        throw std::runtime_error("The model textures do not fit in a texture atlas");
+
+    studio_model_buffer_->texture_levels = num_levels;
+    studio_model_buffer_->texture_rects.resize(texture_images.size());
+    for (size_t i = 0; i < texture_images.size(); ++i)
+        studio_model_buffer_->texture_rects[i] = sizes[texture_images[i]];
+
+    if (sizes.empty())
+        return;
+
+    // The key covers the images, how they are processed, and where they are.
+    uint64_t key = hash_bytes_64(&TEXTURE_PROCESSING_VERSION, sizeof(TEXTURE_PROCESSING_VERSION), content_hash);
+    const int64_t parameters[] = {
+        num_levels, bytes_per_texel, internal_format, format,
+        static_cast<int64_t>(compression), atlas_width, atlas_height
+    };
+    key = hash_bytes_64(parameters, sizeof(parameters), key);
+    for (const AtlasRect& rect : sizes)
+    {
+        const unsigned int place[] = { rect.x, rect.y, rect.width, rect.height };
+        key = hash_bytes_64(place, sizeof(place), key);
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    TextureCache cache;
+    cache.set_directory(texture_settings_.cache_directory);
+
+    std::vector<MipLevel> levels;
+    const bool cached = cache.load(key, levels) && levels.size() == num_levels;
+    if (!cached)
+    {
+        ThreadPool thread_pool;
+
+        std::vector<std::vector<MipLevel>> image_levels(sizes.size());
+        thread_pool.parallel_for(sizes.size(), [&](size_t image, size_t) {
+            generate_levels(image, num_levels, image_levels[image]);
+        });
+
+        levels.resize(num_levels);
+        for (unsigned int level = 0; level < num_levels; ++level)
+        {
+            const unsigned int level_width = atlas_width >> level;
+            const unsigned int level_height = atlas_height >> level;
+            MipLevel atlas_level(level_width, level_height,
+                static_cast<size_t>(level_width) * level_height * bytes_per_texel);
+
+            for (size_t i = 0; i < sizes.size(); ++i)
+            {
+                const MipLevel& image = image_levels[i][level];
+
+                AtlasRect rect(image.width, image.height);
+                rect.x = sizes[i].x >> level;
+                rect.y = sizes[i].y >> level;
+
+                copy_to_atlas(image.pixels.data(), bytes_per_texel, rect, padding >> level,
+                    atlas_level.pixels.data(), level_width);
+            }
+
+            if (compression != TextureCompression::NONE)
+            {
+                MipLevel compressed(level_width, level_height,
+                    get_compressed_size(level_width, level_height, compression));
+                compress_image(atlas_level.pixels.data(), level_width, level_height, compression,
+                    compressed.pixels.data(), &thread_pool);
+                atlas_level = std::move(compressed);
+            }
+
+            levels[level] = std::move(atlas_level);
+        }
+
+        cache.store(key, levels);
+    }
+
+    size_t used_area = 0;
+    for (const AtlasRect& rect : sizes)
+        used_area += static_cast<size_t>(rect.width) * rect.height;
+
+    size_t atlas_size = 0;
+    for (const MipLevel& level : levels)
+        atlas_size += level.pixels.size();
+
+    const auto elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+
+    StudioModelBufferStatistics& statistics = studio_model_buffer_->statistics;
+    statistics.texture_atlas_width = atlas_width;
+    statistics.texture_atlas_height = atlas_height;
+    statistics.texture_atlas_size = atlas_size;
+    statistics.texture_atlas_used_area = used_area;
+    statistics.texture_atlas_cached = cached;
+    statistics.texture_atlas_milliseconds = elapsed_time.count();
+
+    create_texture(studio_model_buffer_->texture_atlas,
+        internal_format,
+        compression != TextureCompression::NONE ? 0 : format,
+        std::move(levels));
+}
+
+void StudioModelSetup::create_texture(gltexture& texture,
+    unsigned int width, unsigned int height,
+    GLint internal_format, GLint format,
+    std::vector<uint8_t> pixels)
+{
+    if (texture_uploader_)
+        texture_uploader_->upload(texture, width, height, internal_format, format, std::move(pixels));
+    else
+        texture.create_from_data(width, height, internal_format, format, pixels.data());
+}
+
+void StudioModelSetup::create_texture(gltexture& texture,
+    GLint internal_format, GLint format,
+    std::vector<MipLevel> levels)
+{
+    if (texture_uploader_)
+        texture_uploader_->upload(texture, internal_format, format, std::move(levels));
+    else
+        texture.create_from_levels(levels, internal_format, format);
+}
+
 void StudioModelSetup::setup_buffer_meshes()
 {
     const aiNode* const scene_bodyparts = scene_->mRootNode->FindNode(AI_MDL_HL1_NODE_BODYPARTS);
@@ -510,13 +945,65 @@ void StudioModelSetup::setup_buffer_meshes()
             }
         }
 
-        buffer_builder_.append(
-            vertices, indices, 
-            PRIMITIVE_RESTART_INDEX,
+        buffer_builder_.append_triangles(
+            vertices, indices,
             studio_model_buffer_->meshes[i]);
     }
 }
 
+void StudioModelSetup::setup_buffer_mesh_lods()
+{
+    const std::vector<MeshBufferStride>& meshes = studio_model_buffer_->meshes;
+
+    studio_model_buffer_->mesh_lods.assign(num_mesh_lods_, std::vector<MeshBufferStride>(meshes.size()));
+    studio_model_buffer_->mesh_lod_errors.assign(num_mesh_lods_, 0.0f);
+
+    if (num_mesh_lods_ == 0)
+        return;
+
+    std::vector<glvertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> lod_indices;
+
+    std::vector<size_t> num_triangles(num_mesh_lods_ + 1, 0);
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        buffer_builder_.get_triangles(meshes[i], vertices, indices);
+        num_triangles[0] += indices.size() / 3;
+
+        // Each level simplifies the previous one, so the errors add up.
+        float mesh_error = 0.0f;
+        for (int lod = 0; lod < num_mesh_lods_; ++lod)
+        {
+            MeshBufferStride& lod_stride = studio_model_buffer_->mesh_lods[lod][i];
+
+            mesh_error += simplify_mesh(vertices, indices, indices.size() / 2, lod_indices);
+
+            // Share the "indices" of the previous level if nothing was removed.
+            if (lod_indices.size() == indices.size())
+            {
+                lod_stride = lod > 0 ? studio_model_buffer_->mesh_lods[lod - 1][i] : meshes[i];
+            }
+            else
+            {
+                if (buffer_builder_.optimize_meshes())
+                    optimize_vertex_cache(lod_indices, vertices.size());
+
+                buffer_builder_.append_lod_indices(meshes[i], lod_indices, lod_stride);
+                indices.swap(lod_indices);
+            }
+
+            float& max_error = studio_model_buffer_->mesh_lod_errors[lod];
+            max_error = std::max(max_error, mesh_error);
+
+            num_triangles[lod + 1] += lod_stride.num_indices / 3;
+        }
+    }
+
+    studio_model_buffer_->statistics.mesh_lod_triangles = std::move(num_triangles);
+}
+
 void StudioModelSetup::setup_buffer_bones()
 {
     std::vector<glvertex> vertices(studio_model_->bones.size());
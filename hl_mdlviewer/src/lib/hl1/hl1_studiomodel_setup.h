@@ -9,12 +9,37 @@
 #include "hl1_studiomodel.h"
 #include "hl1_studiomodel_buffer.h"
 #include "buffer_builder.h"
+#include "texture_compression.h"
+#include "texture_uploader.h"
+#include <functional>
+#include <string>
 #include <assimp/scene.h>
 #include <assimp/types.h>
 
 namespace hl_mdlviewer {
 namespace hl1 {
 
+/** \brief How the textures are processed before they are uploaded. */
+struct TextureSetupSettings
+{
+    TextureSetupSettings() :
+        num_mip_levels(4),
+        compress(false),
+        cache_directory()
+    {
+    }
+
+    /** \brief The number of mip levels, 1 for none. */
+    unsigned int num_mip_levels;
+
+    /** \brief Whether to compress the textures to BC1, or BC3 if a texture
+    * is masked, instead of palettizing them. */
+    bool compress;
+
+    /** \brief Where to cache the processed textures, empty to disable. */
+    std::string cache_directory;
+};
+
 /** \brief This class converts information from an Assimp scene,
 * to a Studiomodel. */
 class StudioModelSetup
@@ -27,11 +52,31 @@ public:
     * \param[in] scene The scene to be converted.
     * \param[in, out] studio_model The output Studiomodel.
     * \param[in, out] studio_model_buffer The output Studiomodel buffer.
+    * \param[in] vertex_format The vertex layout of the buffer. Falls back
+    *            to \ref VertexFormat::STANDARD if the model cannot be packed.
+    * \param[in] optimize_meshes Whether or not to optimize the meshes for
+    *            the vertex cache and use 16-bit "indices" where possible.
+    * \param[in] storage Whether to upload the buffer and textures to
+    *            OpenGL, keep CPU copies of them, or both.
     */
     void setup_model(const aiScene* scene, 
         StudioModel* studio_model, 
         StudioModelBuffer* studio_model_buffer,
-        glm::mat4& scene_transform);
+        glm::mat4& scene_transform,
+        VertexFormat vertex_format = VertexFormat::STANDARD,
+        bool optimize_meshes = true,
+        BufferStorage storage = BufferStorage::GPU);
+
+    /** \brief Set the number of simplified levels of detail generated for
+    *          each mesh, each with half the triangles of the previous one.
+    * \param[in] count The number of levels, 0 to disable. */
+    inline void set_num_mesh_lods(int count) { num_mesh_lods_ = std::max(count, 0); }
+
+    /** \brief Upload the textures over the next frames with \p uploader,
+    *          or right away if nullptr, the default. */
+    inline void set_texture_uploader(TextureUploader* uploader) { texture_uploader_ = uploader; }
+
+    inline void set_texture_settings(const TextureSetupSettings& settings) { texture_settings_ = settings; }
 
 protected:
     void setup_model_data();
@@ -49,6 +94,9 @@ protected:
     void setup_model_stats();
 
     void setup_buffer_meshes();
+
+    /** \brief Append the simplified triangle lists of each mesh. */
+    void setup_buffer_mesh_lods();
     void setup_buffer_bones();
     void build_bone_segments(std::vector<unsigned int>& bone_segments);
 
@@ -57,6 +105,63 @@ protected:
     void setup_buffer_sequence_bbox();
     void setup_buffer_gltextures();
 
+    /** \brief Get the transparent color of a texture, in BGR order.
+    * \return false if the texture is not masked.
+    */
+    bool get_texture_mask_color(unsigned int texture, uint8_t* mask_color) const;
+
+    /** \brief Upload the textures as BGRA, or compressed if requested. */
+    void setup_buffer_bgra_gltextures();
+
+    /** \brief Upload the textures as palette indices, and their palettes.
+    * \return false if a texture has too many colors, in which case nothing
+    *         is uploaded.
+    */
+    bool setup_buffer_palettized_gltextures();
+
+    /** \brief Generates the mip levels of an image, called from worker threads. */
+    using GenerateLevelsFunction = std::function<void(size_t image,
+        unsigned int num_levels, std::vector<MipLevel>& levels)>;
+
+    /** \brief Pack images and their mip levels into the texture atlas, and
+    *          compress it if requested.
+    *
+    * The atlas is loaded from the texture cache if it was processed before.
+    * \param[in] sizes The size of each image.
+    * \param[in] bytes_per_texel The size of a texel, before compression.
+    * \param[in] internal_format The atlas format.
+    * \param[in] format The format of the texels.
+    * \param[in] compression The block compression of the atlas.
+    * \param[in] texture_images The image of each texture.
+    * \param[in] content_hash A hash of the images and of everything their
+    *            levels depend on.
+    * \param[in] generate_levels Generates the levels of an image, not called
+    *            if the atlas is cached.
+    */
+    void setup_buffer_texture_atlas(std::vector<AtlasRect> sizes,
+        unsigned int bytes_per_texel,
+        GLint internal_format,
+        GLint format,
+        TextureCompression compression,
+        const std::vector<size_t>& texture_images,
+        uint64_t content_hash,
+        const GenerateLevelsFunction& generate_levels);
+
+    /** \brief Create a texture, through the texture uploader if set. */
+    void create_texture(gltexture& texture,
+        unsigned int width, unsigned int height,
+        GLint internal_format, GLint format,
+        std::vector<uint8_t> pixels);
+
+    /** \brief Create a texture with mip levels, through the texture uploader
+    *          if set. \see gltexture::create_from_levels */
+    void create_texture(gltexture& texture,
+        GLint internal_format, GLint format,
+        std::vector<MipLevel> levels);
+
+    /** \brief Compute the vertex extents of each bone. */
+    void setup_bone_vertex_bounds();
+
     /** \brief Read scene metadata.
     * \param[in] metadata_key The metadata key.
     * \param[in] value The output value.
@@ -94,6 +199,16 @@ private:
     /** \brief Used to combine all vertices and indices
     * into one buffer. */
     BufferBuilder buffer_builder_;
+
+    /** \brief Where to keep the buffer and textures. */
+    BufferStorage storage_;
+
+    int num_mesh_lods_;
+
+    TextureSetupSettings texture_settings_;
+
+    /** \brief Uploads the textures, or nullptr to upload them right away. */
+    TextureUploader* texture_uploader_;
 };
 
 }
@@ -0,0 +1,278 @@
+/**
+* \file hl1_studiomodel_skinning.cpp
+* \brief Implementation for the HL1 Studio model CPU skinning class.
+*/
+
+#include "pch.h"
+#include "hl1_studiomodel_skinning.h"
+
+#if defined(__AVX__)
+#define HLMDLVIEWER_SKINNING_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HLMDLVIEWER_SKINNING_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+namespace {
+
+/** \brief Transform a run of vertices by a single matrix.
+*
+* The normals use the upper 3x3 matrix, as the vertex shaders, and are
+* not renormalized.
+*/
+void transform_run(const glm::mat4& m,
+    const SkinnedVertices& source,
+    SkinnedVertices& output,
+    size_t first_vertex,
+    size_t count)
+{
+    const float* in_x = source.x.data() + first_vertex;
+    const float* in_y = source.y.data() + first_vertex;
+    const float* in_z = source.z.data() + first_vertex;
+    const float* in_normal_x = source.normal_x.data() + first_vertex;
+    const float* in_normal_y = source.normal_y.data() + first_vertex;
+    const float* in_normal_z = source.normal_z.data() + first_vertex;
+
+    float* out_x = output.x.data() + first_vertex;
+    float* out_y = output.y.data() + first_vertex;
+    float* out_z = output.z.data() + first_vertex;
+    float* out_normal_x = output.normal_x.data() + first_vertex;
+    float* out_normal_y = output.normal_y.data() + first_vertex;
+    float* out_normal_z = output.normal_z.data() + first_vertex;
+
+    size_t i = 0;
+
+#if defined(HLMDLVIEWER_SKINNING_AVX)
+    const __m256 m00 = _mm256_set1_ps(m[0][0]), m01 = _mm256_set1_ps(m[0][1]), m02 = _mm256_set1_ps(m[0][2]);
+    const __m256 m10 = _mm256_set1_ps(m[1][0]), m11 = _mm256_set1_ps(m[1][1]), m12 = _mm256_set1_ps(m[1][2]);
+    const __m256 m20 = _mm256_set1_ps(m[2][0]), m21 = _mm256_set1_ps(m[2][1]), m22 = _mm256_set1_ps(m[2][2]);
+    const __m256 m30 = _mm256_set1_ps(m[3][0]), m31 = _mm256_set1_ps(m[3][1]), m32 = _mm256_set1_ps(m[3][2]);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 x = _mm256_loadu_ps(in_x + i);
+        const __m256 y = _mm256_loadu_ps(in_y + i);
+        const __m256 z = _mm256_loadu_ps(in_z + i);
+
+        _mm256_storeu_ps(out_x + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m10, y)),
+            _mm256_add_ps(_mm256_mul_ps(m20, z), m30)));
+        _mm256_storeu_ps(out_y + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m01, x), _mm256_mul_ps(m11, y)),
+            _mm256_add_ps(_mm256_mul_ps(m21, z), m31)));
+        _mm256_storeu_ps(out_z + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m02, x), _mm256_mul_ps(m12, y)),
+            _mm256_add_ps(_mm256_mul_ps(m22, z), m32)));
+
+        const __m256 nx = _mm256_loadu_ps(in_normal_x + i);
+        const __m256 ny = _mm256_loadu_ps(in_normal_y + i);
+        const __m256 nz = _mm256_loadu_ps(in_normal_z + i);
+
+        _mm256_storeu_ps(out_normal_x + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, nx), _mm256_mul_ps(m10, ny)),
+            _mm256_mul_ps(m20, nz)));
+        _mm256_storeu_ps(out_normal_y + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m01, nx), _mm256_mul_ps(m11, ny)),
+            _mm256_mul_ps(m21, nz)));
+        _mm256_storeu_ps(out_normal_z + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m02, nx), _mm256_mul_ps(m12, ny)),
+            _mm256_mul_ps(m22, nz)));
+    }
+#elif defined(HLMDLVIEWER_SKINNING_SSE2)
+    const __m128 m00 = _mm_set1_ps(m[0][0]), m01 = _mm_set1_ps(m[0][1]), m02 = _mm_set1_ps(m[0][2]);
+    const __m128 m10 = _mm_set1_ps(m[1][0]), m11 = _mm_set1_ps(m[1][1]), m12 = _mm_set1_ps(m[1][2]);
+    const __m128 m20 = _mm_set1_ps(m[2][0]), m21 = _mm_set1_ps(m[2][1]), m22 = _mm_set1_ps(m[2][2]);
+    const __m128 m30 = _mm_set1_ps(m[3][0]), m31 = _mm_set1_ps(m[3][1]), m32 = _mm_set1_ps(m[3][2]);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 x = _mm_loadu_ps(in_x + i);
+        const __m128 y = _mm_loadu_ps(in_y + i);
+        const __m128 z = _mm_loadu_ps(in_z + i);
+
+        _mm_storeu_ps(out_x + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m10, y)),
+            _mm_add_ps(_mm_mul_ps(m20, z), m30)));
+        _mm_storeu_ps(out_y + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, x), _mm_mul_ps(m11, y)),
+            _mm_add_ps(_mm_mul_ps(m21, z), m31)));
+        _mm_storeu_ps(out_z + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m02, x), _mm_mul_ps(m12, y)),
+            _mm_add_ps(_mm_mul_ps(m22, z), m32)));
+
+        const __m128 nx = _mm_loadu_ps(in_normal_x + i);
+        const __m128 ny = _mm_loadu_ps(in_normal_y + i);
+        const __m128 nz = _mm_loadu_ps(in_normal_z + i);
+
+        _mm_storeu_ps(out_normal_x + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, nx), _mm_mul_ps(m10, ny)),
+            _mm_mul_ps(m20, nz)));
+        _mm_storeu_ps(out_normal_y + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, nx), _mm_mul_ps(m11, ny)),
+            _mm_mul_ps(m21, nz)));
+        _mm_storeu_ps(out_normal_z + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m02, nx), _mm_mul_ps(m12, ny)),
+            _mm_mul_ps(m22, nz)));
+    }
+#endif
+
+    // The remaining vertices, or all of them without SIMD.
+    for (; i < count; ++i)
+    {
+        const float x = in_x[i], y = in_y[i], z = in_z[i];
+        out_x[i] = m[0][0] * x + m[1][0] * y + m[2][0] * z + m[3][0];
+        out_y[i] = m[0][1] * x + m[1][1] * y + m[2][1] * z + m[3][1];
+        out_z[i] = m[0][2] * x + m[1][2] * y + m[2][2] * z + m[3][2];
+
+        const float nx = in_normal_x[i], ny = in_normal_y[i], nz = in_normal_z[i];
+        out_normal_x[i] = m[0][0] * nx + m[1][0] * ny + m[2][0] * nz;
+        out_normal_y[i] = m[0][1] * nx + m[1][1] * ny + m[2][1] * nz;
+        out_normal_z[i] = m[0][2] * nx + m[1][2] * ny + m[2][2] * nz;
+    }
+}
+
+}
+
+StudioModelSkinning::StudioModelSkinning() :
+    source_(),
+    runs_(),
+    meshes_(),
+    offset_matrices_(),
+    palette_(),
+    vertex_order_(),
+    output_indices_()
+{
+}
+
+void StudioModelSkinning::clear()
+{
+    source_.resize(0);
+    runs_.clear();
+    meshes_.clear();
+    offset_matrices_.clear();
+    palette_.clear();
+    vertex_order_.clear();
+    output_indices_.clear();
+}
+
+int StudioModelSkinning::simd_width()
+{
+#if defined(HLMDLVIEWER_SKINNING_AVX)
+    return 8;
+#elif defined(HLMDLVIEWER_SKINNING_SSE2)
+    return 4;
+#else
+    return 1;
+#endif
+}
+
+void StudioModelSkinning::setup(const StudioModel& studio_model, const StudioModelBuffer& buffer)
+{
+    clear();
+
+    if (buffer.vertices.empty() && !buffer.meshes.empty())
+        throw std::runtime_error("The model buffer has no CPU copy of its vertices");
+
+    // A model without bones keeps its vertices in place.
+    offset_matrices_.assign(std::max<size_t>(studio_model.bones.size(), 1), glm::mat4(1.0f));
+    for (size_t i = 0; i < studio_model.bones.size(); ++i)
+        offset_matrices_[i] = studio_model.bones[i].offset_matrix;
+
+    palette_.resize(offset_matrices_.size());
+
+    const int max_bone = static_cast<int>(offset_matrices_.size()) - 1;
+
+    size_t num_total_vertices = 0;
+    for (const MeshBufferStride& stride : buffer.meshes)
+        num_total_vertices += std::max(stride.num_vertices, 0);
+
+    source_.resize(num_total_vertices);
+    vertex_order_.reserve(num_total_vertices);
+    output_indices_.assign(buffer.vertices.size(), -1);
+    meshes_.reserve(buffer.meshes.size());
+
+    std::vector<unsigned int> order;
+
+    for (const MeshBufferStride& stride : buffer.meshes)
+    {
+        MeshRuns mesh;
+        mesh.first_run = runs_.size();
+        mesh.first_vertex = vertex_order_.size();
+
+        if (stride.vertex_start_index >= 0 && stride.num_vertices > 0)
+        {
+            order.resize(stride.num_vertices);
+            std::iota(order.begin(), order.end(), static_cast<unsigned int>(stride.vertex_start_index));
+
+            // Stable, to keep the vertex cache order within a bone.
+            std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+                return clamp(buffer.vertices[a].boneid, 0, max_bone) < clamp(buffer.vertices[b].boneid, 0, max_bone);
+            });
+
+            for (unsigned int vertex_index : order)
+            {
+                const glvertex& vertex = buffer.vertices[vertex_index];
+                const int bone = clamp(vertex.boneid, 0, max_bone);
+                const size_t output_index = vertex_order_.size();
+
+                if (runs_.size() == mesh.first_run || runs_.back().bone != bone)
+                    runs_.push_back(BoneRun{ bone, output_index, 0 });
+                ++runs_.back().num_vertices;
+
+                source_.x[output_index] = vertex.position.x;
+                source_.y[output_index] = vertex.position.y;
+                source_.z[output_index] = vertex.position.z;
+                source_.normal_x[output_index] = vertex.normal.x;
+                source_.normal_y[output_index] = vertex.normal.y;
+                source_.normal_z[output_index] = vertex.normal.z;
+
+                output_indices_[vertex_index] = static_cast<int>(output_index);
+                vertex_order_.push_back(vertex_index);
+            }
+        }
+
+        mesh.num_runs = runs_.size() - mesh.first_run;
+        mesh.num_vertices = vertex_order_.size() - mesh.first_vertex;
+        meshes_.push_back(mesh);
+    }
+}
+
+void StudioModelSkinning::skin(const std::vector<glm::mat4>& bones_transform,
+    SkinnedVertices& output,
+    ThreadPool* thread_pool)
+{
+    skin(bones_transform, glm::mat4(1.0f), output, thread_pool);
+}
+
+void StudioModelSkinning::skin(const std::vector<glm::mat4>& bones_transform,
+    const glm::mat4& transform,
+    SkinnedVertices& output,
+    ThreadPool* thread_pool)
+{
+    if (output.size() < num_vertices())
+        throw std::runtime_error("The skinned vertices output is too small");
+
+    // Bones without a transform keep their bind pose, as in the shaders.
+    for (size_t i = 0; i < palette_.size(); ++i)
+    {
+        const glm::mat4 bone_transform = i < bones_transform.size() ? bones_transform[i] : glm::mat4(1.0f);
+        palette_[i] = transform * bone_transform * offset_matrices_[i];
+    }
+
+    if (thread_pool && thread_pool->num_threads() > 1 && meshes_.size() > 1)
+    {
+        thread_pool->parallel_for(meshes_.size(), [&](size_t index, size_t) {
+            skin_mesh(meshes_[index], output);
+        });
+    }
+    else
+    {
+        for (const MeshRuns& mesh : meshes_)
+            skin_mesh(mesh, output);
+    }
+}
+
+void StudioModelSkinning::skin_mesh(const MeshRuns& mesh, SkinnedVertices& output) const
+{
+    for (size_t i = mesh.first_run; i < mesh.first_run + mesh.num_runs; ++i)
+    {
+        const BoneRun& run = runs_[i];
+
+        transform_run(palette_[run.bone], source_, output, run.first_vertex, run.num_vertices);
+    }
+}
+
+}
+}
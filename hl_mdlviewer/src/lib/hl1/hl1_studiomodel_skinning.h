@@ -0,0 +1,155 @@
+/**
+* \file hl1_studiomodel_skinning.h
+* \brief Declaration for the HL1 Studio model CPU skinning class.
+*/
+
+#ifndef HLMDLVIEWER_HL1_STUDIOMODEL_SKINNING_H_
+#define HLMDLVIEWER_HL1_STUDIOMODEL_SKINNING_H_
+
+#include <vector>
+#include "hl1_studiomodel.h"
+#include "hl1_studiomodel_buffer.h"
+#include "thread_pool.h"
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+/** \brief Skinned vertices, one array per component.
+*
+* The caller owns the arrays and sizes them once with \ref resize, so that
+* skinning a frame does not allocate.
+*/
+struct SkinnedVertices
+{
+    SkinnedVertices() :
+        x(), y(), z(),
+        normal_x(), normal_y(), normal_z()
+    {
+    }
+
+    void resize(size_t num_vertices)
+    {
+        x.resize(num_vertices);
+        y.resize(num_vertices);
+        z.resize(num_vertices);
+        normal_x.resize(num_vertices);
+        normal_y.resize(num_vertices);
+        normal_z.resize(num_vertices);
+    }
+
+    inline size_t size() const { return x.size(); }
+
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> normal_x;
+    std::vector<float> normal_y;
+    std::vector<float> normal_z;
+};
+
+/** \brief Skins the mesh vertices of a model on the CPU.
+*
+* At setup, the vertices of each mesh are sorted into contiguous runs of
+* the same bone. As HL1 vertices have a single bone, each run is then
+* transformed by one palette matrix, 8 (AVX) or 4 (SSE2) vertices at a
+* time, and meshes are skinned in parallel.
+*
+* The skinned vertices are in the sorted order, mesh after mesh. Use
+* \ref get_output_index and \ref get_vertex_order to map them from and to
+* the vertices of the model buffer.
+*/
+class StudioModelSkinning
+{
+public:
+    StudioModelSkinning();
+    StudioModelSkinning(const StudioModelSkinning&) = delete;
+
+    /** \brief Sort the mesh vertices of a model by bone.
+    * \param[in] studio_model The model.
+    * \param[in] buffer The model buffer, with CPU copies of its data.
+    */
+    void setup(const StudioModel& studio_model, const StudioModelBuffer& buffer);
+
+    void clear();
+
+    /** \brief Get the number of skinned vertices, the size of the output. */
+    inline size_t num_vertices() const { return vertex_order_.size(); }
+
+    /** \brief Get the buffer vertex index of each skinned vertex. */
+    inline const std::vector<unsigned int>& get_vertex_order() const { return vertex_order_; }
+
+    /** \brief Get the skinned vertex of a buffer vertex.
+    * \return The index in the output, or -1 if the vertex is not part of a mesh.
+    */
+    inline int get_output_index(unsigned int buffer_vertex_index) const {
+        return buffer_vertex_index < output_indices_.size() ? output_indices_[buffer_vertex_index] : -1;
+    }
+
+    /** \brief Get the range of the skinned vertices of a mesh. */
+    inline void get_mesh_range(size_t mesh_index, size_t& first_vertex, size_t& num_vertices) const {
+        first_vertex = meshes_[mesh_index].first_vertex;
+        num_vertices = meshes_[mesh_index].num_vertices;
+    }
+
+    /** \brief Skin the vertices in the model scene space, as the vertex shaders do.
+    * \param[in] bones_transform The bone transforms.
+    * \param[out] output The skinned vertices, of at least \ref num_vertices.
+    * \param[in] thread_pool The pool to skin the meshes on, or null.
+    */
+    void skin(const std::vector<glm::mat4>& bones_transform,
+        SkinnedVertices& output,
+        ThreadPool* thread_pool = nullptr);
+
+    /** \brief Skin the vertices and transform them.
+    * \param[in] bones_transform The bone transforms.
+    * \param[in] transform The transform applied after the bones, i.e. to world space.
+    * \param[out] output The skinned vertices, of at least \ref num_vertices.
+    * \param[in] thread_pool The pool to skin the meshes on, or null.
+    */
+    void skin(const std::vector<glm::mat4>& bones_transform,
+        const glm::mat4& transform,
+        SkinnedVertices& output,
+        ThreadPool* thread_pool = nullptr);
+
+    /** \brief Get the number of vertices transformed at a time. */
+    static int simd_width();
+
+private:
+
+    /** \brief Vertices of a mesh sharing a bone. */
+    struct BoneRun
+    {
+        int bone;
+        size_t first_vertex;
+        size_t num_vertices;
+    };
+
+    struct MeshRuns
+    {
+        size_t first_run;
+        size_t num_runs;
+        size_t first_vertex;
+        size_t num_vertices;
+    };
+
+    void skin_mesh(const MeshRuns& mesh, SkinnedVertices& output) const;
+
+    /** \brief The bind pose vertices, in the sorted order. */
+    SkinnedVertices source_;
+
+    std::vector<BoneRun> runs_;
+    std::vector<MeshRuns> meshes_;
+
+    std::vector<glm::mat4> offset_matrices_;
+
+    /** \brief The matrix of each bone for the current skin call. */
+    std::vector<glm::mat4> palette_;
+
+    std::vector<unsigned int> vertex_order_;
+    std::vector<int> output_indices_;
+};
+
+}
+}
+
+#endif // HLMDLVIEWER_HL1_STUDIOMODEL_SKINNING_H_
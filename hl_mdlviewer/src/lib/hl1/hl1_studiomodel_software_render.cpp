@@ -0,0 +1,250 @@
+/**
+* \file hl1_studiomodel_software_render.cpp
+* \brief Implementation for the HL1 Studio model software render class.
+*/
+
+#include "pch.h"
+#include "hl1_studiomodel_software_render.h"
+#include <chrono>
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+StudioModelSoftwareRender::StudioModelSoftwareRender(ThreadPool* thread_pool) :
+    rasterizer_(thread_pool),
+    lighting_(),
+    clear_color_(0.0f, 0.0f, 0.0f, 1.0f),
+    view_projection_(1.0f),
+    model_(1.0f),
+    scene_transform_(1.0f),
+    world_matrices_(),
+    bone_offset_matrices_(),
+    chrome_right_(),
+    chrome_up_(),
+    vertices_(),
+    vertex_mesh_stamps_(),
+    mesh_stamp_(0),
+    indices_(),
+    statistics_()
+{
+}
+
+void StudioModelSoftwareRender::resize(unsigned int width, unsigned int height)
+{
+    rasterizer_.resize(width, height);
+}
+
+void StudioModelSoftwareRender::set_matrices(const glm::mat4& projection,
+    const glm::mat4& view,
+    const glm::mat4& model,
+    const glm::mat4& scene_transform)
+{
+    view_projection_ = projection * view;
+    model_ = model;
+    scene_transform_ = scene_transform;
+}
+
+void StudioModelSoftwareRender::reset_statistics()
+{
+    statistics_ = SoftwareRenderStatistics();
+}
+
+void StudioModelSoftwareRender::render(const StudioModel& studio_model,
+    const StudioModelBuffer& buffer,
+    const StudioModelRenderData& render_data,
+    const ModelRenderSettings& settings,
+    const std::vector<glm::mat4>& bones_transform)
+{
+    if (buffer.vertices.empty() && !buffer.meshes.empty())
+        throw std::runtime_error("The model buffer has no CPU copy of its vertices");
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    rasterizer_.clear(clear_color_);
+
+    setup_bones(studio_model, bones_transform);
+
+    if (vertices_.size() != buffer.vertices.size())
+    {
+        vertices_.resize(buffer.vertices.size());
+        vertex_mesh_stamps_.assign(buffer.vertices.size(), 0);
+        mesh_stamp_ = 0;
+    }
+
+    const bool textured = settings.render_mode == RenderMode::TEXTURED;
+
+    // Same mesh selection and opaque/additive split as StudioModelRender.
+    std::vector<const Mesh*> opaque_meshes;
+    std::vector<const Mesh*> additive_meshes;
+
+    for (size_t i = 0; i < studio_model.bodyparts.size(); ++i)
+    {
+        const Bodypart& bodypart = studio_model.bodyparts[i];
+
+        if (i >= render_data.model.size() ||
+            render_data.model[i] < 0 ||
+            render_data.model[i] >= static_cast<int>(bodypart.models.size()))
+            continue;
+
+        for (const Mesh* mesh : bodypart.models[render_data.model[i]]->meshes)
+        {
+            const Texture* texture = mesh->texture;
+            if (render_data.skin > 0 && texture->skin_textures.size())
+                texture = texture->skin_textures[render_data.skin - 1];
+
+            if (textured && texture->blend_mode == aiBlendMode::aiBlendMode_Additive)
+                additive_meshes.push_back(mesh);
+            else
+                opaque_meshes.push_back(mesh);
+        }
+    }
+
+    opaque_meshes.insert(opaque_meshes.end(), additive_meshes.begin(), additive_meshes.end());
+
+    for (const Mesh* mesh : opaque_meshes)
+    {
+        const Texture* texture = mesh->texture;
+        if (render_data.skin > 0 && texture->skin_textures.size())
+            texture = texture->skin_textures[render_data.skin - 1];
+
+        const bool flat_shade = settings.lighting_enabled && mesh->texture->shading_mode == aiShadingMode_Flat;
+        const bool chrome = textured && settings.render_chrome_effects && mesh->texture->type == Texture::Type::Chrome;
+
+        RasterMaterial material;
+        material.lighting = settings.lighting_enabled;
+        material.light_color = lighting_.light_color;
+
+        if (textured)
+        {
+            if (texture->index < 0 || texture->index >= static_cast<int>(buffer.images.size()))
+                throw std::runtime_error("The model buffer has no CPU copy of texture " + std::to_string(texture->index));
+
+            material.texture = &buffer.images[texture->index];
+            material.masked = (mesh->texture->flags & aiTextureFlags::aiTextureFlags_UseAlpha) != 0;
+            material.mask_color = texture->mask_color;
+            material.additive = texture->blend_mode == aiBlendMode::aiBlendMode_Additive;
+        }
+        else
+        {
+            material.color = settings.smooth_color;
+        }
+
+        get_mesh_indices(buffer, buffer.meshes[mesh->index], indices_);
+        transform_vertices(buffer, indices_, chrome, flat_shade, settings.lighting_enabled);
+
+        rasterizer_.draw_triangles(vertices_.data(), indices_.data(), indices_.size(), material);
+    }
+
+    rasterizer_.flush();
+
+    const RasterStatistics& raster_statistics = rasterizer_.statistics();
+    ++statistics_.num_models;
+    statistics_.num_triangles += raster_statistics.num_rasterized_triangles;
+    statistics_.num_fragments += raster_statistics.num_shaded_fragments;
+    statistics_.render_time += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start_time).count();
+}
+
+void StudioModelSoftwareRender::setup_bones(const StudioModel& studio_model,
+    const std::vector<glm::mat4>& bones_transform)
+{
+    const size_t num_bones = std::min(studio_model.bones.size(), bones_transform.size());
+
+    world_matrices_.resize(num_bones);
+    bone_offset_matrices_.resize(num_bones);
+    chrome_right_.resize(num_bones);
+    chrome_up_.resize(num_bones);
+
+    const glm::mat4 model_scene = model_ * scene_transform_;
+    const glm::vec3 right = glm::mat3(model_) * glm::vec3(1.0f, 0.0f, 0.0f);
+
+    for (size_t i = 0; i < num_bones; ++i)
+    {
+        const glm::mat4 bone_transform = model_scene * bones_transform[i];
+
+        world_matrices_[i] = bone_transform * studio_model.bones[i].offset_matrix;
+        bone_offset_matrices_[i] = glm::mat3(studio_model.bones[i].offset_matrix);
+
+        // As the chrome part of textured.vs, once per bone.
+        const glm::vec3 bone_position = glm::normalize(glm::vec3(bone_transform[3]));
+        const glm::vec3 chrome_up = glm::normalize(glm::cross(bone_position, right));
+        const glm::vec3 chrome_right = glm::normalize(glm::cross(bone_position, chrome_up));
+        const glm::mat3 bone_transform_transpose = glm::transpose(glm::mat3(bone_transform));
+
+        chrome_right_[i] = bone_transform_transpose * chrome_right;
+        chrome_up_[i] = bone_transform_transpose * chrome_up;
+    }
+}
+
+void StudioModelSoftwareRender::transform_vertices(const StudioModelBuffer& buffer,
+    const std::vector<unsigned int>& indices,
+    bool chrome, bool flat_shade, bool lighting)
+{
+    if (++mesh_stamp_ == 0)
+    {
+        std::fill(vertex_mesh_stamps_.begin(), vertex_mesh_stamps_.end(), 0);
+        mesh_stamp_ = 1;
+    }
+
+    const glm::vec3 light_direction = glm::mat3(model_) * lighting_.light_direction;
+    const int num_bones = static_cast<int>(world_matrices_.size());
+
+    for (unsigned int index : indices)
+    {
+        if (index >= vertices_.size())
+            throw std::runtime_error("Vertex index " + std::to_string(index) + " is out of range");
+
+        if (vertex_mesh_stamps_[index] == mesh_stamp_)
+            continue;
+        vertex_mesh_stamps_[index] = mesh_stamp_;
+
+        const glvertex& vertex = buffer.vertices[index];
+        RasterVertex& output = vertices_[index];
+
+        const int bone = num_bones ? clamp(vertex.boneid, 0, num_bones - 1) : -1;
+        const glm::mat4 world = bone >= 0 ? world_matrices_[bone] : model_ * scene_transform_;
+
+        output.position = view_projection_ * world * glm::vec4(vertex.position, 1.0f);
+        output.uv = vertex.uv;
+        output.intensity = 1.0f;
+
+        if (chrome && bone >= 0)
+        {
+            const glm::vec3 normal = bone_offset_matrices_[bone] * vertex.normal;
+            output.uv.x = (glm::dot(normal, chrome_right_[bone]) + 1.0f) * 0.5f;
+            output.uv.y = (glm::dot(normal, chrome_up_[bone]) + 1.0f) * 0.5f;
+        }
+
+        if (lighting)
+        {
+            output.intensity = calculate_lighting_intensity(lighting_,
+                light_direction, glm::mat3(world) * vertex.normal, flat_shade);
+        }
+    }
+}
+
+void StudioModelSoftwareRender::get_mesh_indices(const StudioModelBuffer& buffer,
+    const MeshBufferStride& stride,
+    std::vector<unsigned int>& indices)
+{
+    indices.resize(stride.num_indices);
+
+    if (stride.index_size == sizeof(unsigned short))
+    {
+        const unsigned short* source = reinterpret_cast<const unsigned short*>(
+            reinterpret_cast<const uint8_t*>(buffer.indices.data()) + stride.index_offset);
+
+        for (int i = 0; i < stride.num_indices; ++i)
+            indices[i] = source[i] + stride.base_vertex;
+    }
+    else
+    {
+        const unsigned int* source = buffer.indices.data() + stride.index_offset / sizeof(unsigned int);
+
+        for (int i = 0; i < stride.num_indices; ++i)
+            indices[i] = source[i] + stride.base_vertex;
+    }
+}
+
+}
+}
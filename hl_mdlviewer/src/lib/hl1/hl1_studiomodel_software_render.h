@@ -0,0 +1,133 @@
+/**
+* \file hl1_studiomodel_software_render.h
+* \brief Declaration for the HL1 Studio model software render class.
+*/
+
+#ifndef HLMDLVIEWER_HL1_STUDIOMODEL_SOFTWARE_RENDER_H_
+#define HLMDLVIEWER_HL1_STUDIOMODEL_SOFTWARE_RENDER_H_
+
+#include "hl1_studiomodel.h"
+#include "hl1_studiomodel_buffer.h"
+#include "hl1_studiomodel_lighting.h"
+#include "hl1_studiomodel_render_data.h"
+#include "hl1_model_render_settings.h"
+#include "software_rasterizer.h"
+
+namespace hl_mdlviewer {
+namespace hl1 {
+
+/** \brief Counters accumulated over the rendered models. */
+struct SoftwareRenderStatistics
+{
+    size_t num_models;
+    size_t num_triangles;
+    size_t num_fragments;
+
+    /** \brief The time spent rendering, in seconds. */
+    double render_time;
+
+    inline double models_per_second() const {
+        return render_time > 0.0 ? num_models / render_time : 0.0;
+    }
+};
+
+/** \brief Renders HL1 models on the CPU, without an OpenGL context.
+*
+* This follows \ref StudioModelRender: the same meshes, skins, bone
+* palette, lighting and texture flags, opaque meshes first and additive
+* meshes last. Only the model is drawn, none of the overlays. The model
+* buffer must have been set up with CPU copies of its data.
+*/
+class StudioModelSoftwareRender
+{
+public:
+    /** \param[in] thread_pool The pool to rasterize on, or null. */
+    explicit StudioModelSoftwareRender(ThreadPool* thread_pool = nullptr);
+    StudioModelSoftwareRender(const StudioModelSoftwareRender&) = delete;
+
+    void resize(unsigned int width, unsigned int height);
+
+    /** \brief Set the camera and model transforms.
+    * \param[in] projection The projection matrix.
+    * \param[in] view The view matrix.
+    * \param[in] model The model matrix, i.e. the model angles.
+    * \param[in] scene_transform The scene transform of the model.
+    */
+    void set_matrices(const glm::mat4& projection,
+        const glm::mat4& view,
+        const glm::mat4& model,
+        const glm::mat4& scene_transform);
+
+    inline void set_lighting(const StudioModelLighting& lighting) { lighting_ = lighting; }
+
+    inline void set_clear_color(const glm::vec4& color) { clear_color_ = color; }
+
+    /** \brief Clear and render a model.
+    * \param[in] studio_model The model.
+    * \param[in] buffer The model buffer, with CPU copies of its data.
+    * \param[in] render_data The skin and models to render.
+    * \param[in] settings The render mode, lighting and chrome settings.
+    * \param[in] bones_transform The bone transforms.
+    */
+    void render(const StudioModel& studio_model,
+        const StudioModelBuffer& buffer,
+        const StudioModelRenderData& render_data,
+        const ModelRenderSettings& settings,
+        const std::vector<glm::mat4>& bones_transform);
+
+    inline const Image& color_buffer() const { return rasterizer_.color_buffer(); }
+    inline const std::vector<float>& depth_buffer() const { return rasterizer_.depth_buffer(); }
+
+    inline const SoftwareRenderStatistics& statistics() const { return statistics_; }
+    void reset_statistics();
+
+private:
+
+    void setup_bones(const StudioModel& studio_model, const std::vector<glm::mat4>& bones_transform);
+
+    /** \brief Transform the vertices referenced by \p indices, once per mesh.
+    * \param[in] buffer The model buffer.
+    * \param[in] indices The absolute vertex indices of the mesh.
+    * \param[in] chrome Whether or not to generate chrome texture coordinates.
+    * \param[in] flat_shade Whether or not the mesh is flat shaded.
+    * \param[in] lighting Whether or not to compute the lighting.
+    */
+    void transform_vertices(const StudioModelBuffer& buffer,
+        const std::vector<unsigned int>& indices,
+        bool chrome, bool flat_shade, bool lighting);
+
+    /** \brief Decode the "indices" of a mesh stride to absolute indices. */
+    static void get_mesh_indices(const StudioModelBuffer& buffer,
+        const MeshBufferStride& stride,
+        std::vector<unsigned int>& indices);
+
+    SoftwareRasterizer rasterizer_;
+    StudioModelLighting lighting_;
+    glm::vec4 clear_color_;
+
+    glm::mat4 view_projection_;
+    glm::mat4 model_;
+    glm::mat4 scene_transform_;
+
+    /** \brief The vertex transforms, from model space to world space. */
+    std::vector<glm::mat4> world_matrices_;
+    std::vector<glm::mat3> bone_offset_matrices_;
+    std::vector<glm::vec3> chrome_right_;
+    std::vector<glm::vec3> chrome_up_;
+
+    std::vector<RasterVertex> vertices_;
+
+    /** \brief The mesh that last transformed each vertex, as vertices
+    * may be shared by meshes with different features. */
+    std::vector<unsigned int> vertex_mesh_stamps_;
+    unsigned int mesh_stamp_;
+
+    std::vector<unsigned int> indices_;
+
+    SoftwareRenderStatistics statistics_;
+};
+
+}
+}
+
+#endif // HLMDLVIEWER_HL1_STUDIOMODEL_SOFTWARE_RENDER_H_
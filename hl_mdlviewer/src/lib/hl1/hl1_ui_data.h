@@ -45,6 +45,21 @@ struct UIBlendController
     float rest_value;
 };
 
+/** \brief How much a level of detail simplifies the meshes, and from
+*          which distance it is drawn. */
+struct UIMeshLOD
+{
+    int level;
+    size_t num_triangles;
+    size_t num_full_triangles;
+
+    /** The largest simplification error, in model units. */
+    float max_error;
+
+    /** The distance from which the error is small enough on screen. */
+    float min_distance;
+};
+
 /** \brief A structure used to keep loose coupling between 
 *          the Studiomodel and the view. */
 struct UIData
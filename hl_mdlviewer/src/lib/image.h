@@ -0,0 +1,70 @@
+/**
+* \file image.h
+* \brief Declaration for the image structures.
+*/
+
+#ifndef HLMDLVIEWER_IMAGE_H_
+#define HLMDLVIEWER_IMAGE_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace hl_mdlviewer {
+
+/** \brief An 8 bit per channel RGBA image, stored row by row from the
+* top row. */
+struct Image
+{
+    Image() :
+        width(0),
+        height(0),
+        pixels()
+    {
+    }
+
+    Image(unsigned int width, unsigned int height) :
+        width(width),
+        height(height),
+        pixels(static_cast<size_t>(width) * height * 4, 0)
+    {
+    }
+
+    inline uint8_t* pixel(unsigned int x, unsigned int y) {
+        return &pixels[(static_cast<size_t>(y) * width + x) * 4];
+    }
+
+    inline const uint8_t* pixel(unsigned int x, unsigned int y) const {
+        return &pixels[(static_cast<size_t>(y) * width + x) * 4];
+    }
+
+    unsigned int width;
+    unsigned int height;
+    std::vector<uint8_t> pixels;
+};
+
+/** \brief One mip level of a texture, its texels in the format of the
+* texture: 1 or 4 bytes per texel, or compressed blocks. */
+struct MipLevel
+{
+    MipLevel() :
+        width(0),
+        height(0),
+        pixels()
+    {
+    }
+
+    MipLevel(unsigned int width, unsigned int height, size_t size) :
+        width(width),
+        height(height),
+        pixels(size, 0)
+    {
+    }
+
+    unsigned int width;
+    unsigned int height;
+    std::vector<uint8_t> pixels;
+};
+
+}
+
+#endif // HLMDLVIEWER_IMAGE_H_
@@ -0,0 +1,66 @@
+/**
+* \file image_palette.cpp
+* \brief Implementation for the palettized image functions.
+*/
+
+#include "pch.h"
+#include "image_palette.h"
+#include <cstring>
+#include <unordered_map>
+
+namespace hl_mdlviewer {
+
+bool palettize_image(const uint8_t* pixels,
+    unsigned int width, unsigned int height,
+    const uint8_t* mask_color,
+    PalettizedImage& result)
+{
+    const size_t num_pixels = static_cast<size_t>(width) * height;
+
+    result.width = width;
+    result.height = height;
+    result.indices.resize(num_pixels);
+    result.palette.assign(PALETTE_SIZE * 4, 0);
+
+    // The mask index is kept for the transparent color.
+    const unsigned int num_colors = mask_color ? PALETTE_SIZE - 1 : PALETTE_SIZE;
+    if (mask_color)
+    {
+        std::memcpy(&result.palette[MASK_PALETTE_INDEX * 4], mask_color, 3);
+        result.palette[MASK_PALETTE_INDEX * 4 + 3] = 255;
+    }
+
+    std::unordered_map<uint32_t, uint8_t> color_indices;
+    unsigned int next_index = 0;
+
+    for (size_t i = 0; i < num_pixels; ++i)
+    {
+        const uint8_t* pixel = &pixels[i * 4];
+
+        if (mask_color && std::memcmp(pixel, mask_color, 3) == 0)
+        {
+            result.indices[i] = MASK_PALETTE_INDEX;
+            continue;
+        }
+
+        uint32_t color;
+        std::memcpy(&color, pixel, 4);
+
+        auto it = color_indices.find(color);
+        if (it == color_indices.end())
+        {
+            if (next_index == num_colors)
+                return false;
+
+            const uint8_t index = static_cast<uint8_t>(next_index++);
+            std::memcpy(&result.palette[index * 4], pixel, 4);
+            it = color_indices.emplace(color, index).first;
+        }
+
+        result.indices[i] = it->second;
+    }
+
+    return true;
+}
+
+}
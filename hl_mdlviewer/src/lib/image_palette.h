@@ -0,0 +1,62 @@
+/**
+* \file image_palette.h
+* \brief Declaration for the palettized image structure and functions.
+*/
+
+#ifndef HLMDLVIEWER_IMAGE_PALETTE_H_
+#define HLMDLVIEWER_IMAGE_PALETTE_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace hl_mdlviewer {
+
+/** \brief The number of colors of a palette. */
+const unsigned int PALETTE_SIZE = 256;
+
+/** \brief The palette index of the transparent color of masked textures,
+*          as in the MDL format. */
+const uint8_t MASK_PALETTE_INDEX = 255;
+
+/** \brief An image of 8 bit palette indices, stored row by row, and its
+* palette of \ref PALETTE_SIZE colors of 4 bytes. */
+struct PalettizedImage
+{
+    PalettizedImage() :
+        width(0),
+        height(0),
+        indices(),
+        palette()
+    {
+    }
+
+    unsigned int width;
+    unsigned int height;
+    std::vector<uint8_t> indices;
+
+    /** \brief The colors, in the channel order of the source pixels.
+    *          The unused entries are black. */
+    std::vector<uint8_t> palette;
+};
+
+/** \brief Convert an image of 4 byte pixels back to palette indices.
+*
+* The palette is built in the order the colors first appear, so images
+* that only differ by their colors, like the skin families of a model,
+* get the same indices.
+* \param[in] pixels The pixels, 4 bytes each, in any channel order.
+* \param[in] width The image width.
+* \param[in] height The image height.
+* \param[in] mask_color The first 3 bytes of the transparent pixels, or
+*            nullptr. These pixels get the index \ref MASK_PALETTE_INDEX.
+* \param[out] result The indices and the palette.
+* \return false if the image has too many colors for a palette.
+*/
+bool palettize_image(const uint8_t* pixels,
+    unsigned int width, unsigned int height,
+    const uint8_t* mask_color,
+    PalettizedImage& result);
+
+}
+
+#endif // HLMDLVIEWER_IMAGE_PALETTE_H_
@@ -0,0 +1,104 @@
+/**
+* \file mapped_file.cpp
+* \brief Implementation for the memory-mapped file class.
+*/
+
+#include "pch.h"
+#include "mapped_file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hl_mdlviewer {
+
+MappedFile::MappedFile(const std::string& file_path) :
+    file_path_(file_path),
+    data_(nullptr),
+    size_(0)
+#ifdef _WIN32
+    , file_(INVALID_HANDLE_VALUE),
+    mapping_(nullptr)
+#endif
+{
+#ifdef _WIN32
+    file_ = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Failed to open file " + file_path + ".");
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_, &file_size))
+    {
+        CloseHandle(file_);
+        throw std::runtime_error("Failed to get the size of file " + file_path + ".");
+    }
+
+    size_ = static_cast<size_t>(file_size.QuadPart);
+
+    // Empty files cannot be mapped, and have nothing to read anyway.
+    if (size_ == 0)
+        return;
+
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_)
+        data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+
+    if (!data_)
+    {
+        if (mapping_)
+            CloseHandle(mapping_);
+        CloseHandle(file_);
+        throw std::runtime_error("Failed to map file " + file_path + ".");
+    }
+#else
+    const int file = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+        throw std::runtime_error("Failed to open file " + file_path + ".");
+
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0)
+    {
+        close(file);
+        throw std::runtime_error("Failed to get the size of file " + file_path + ".");
+    }
+
+    size_ = static_cast<size_t>(file_stat.st_size);
+
+    // Empty files cannot be mapped, and have nothing to read anyway.
+    if (size_ == 0)
+    {
+        close(file);
+        return;
+    }
+
+    // The mapping keeps the file open.
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if (data == MAP_FAILED)
+        throw std::runtime_error("Failed to map file " + file_path + ".");
+
+    data_ = static_cast<const uint8_t*>(data);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mapping_)
+        CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE)
+        CloseHandle(file_);
+#else
+    if (data_)
+        munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+}
+
+}
@@ -0,0 +1,46 @@
+/**
+* \file mapped_file.h
+* \brief Declaration for the memory-mapped file class.
+*/
+
+#ifndef HLMDLVIEWER_MAPPED_FILE_H_
+#define HLMDLVIEWER_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace hl_mdlviewer {
+
+/** \brief A file mapped read-only in memory, for its whole lifetime.
+*
+* Pages are only read from disk once touched, so mapping a large archive
+* to read a few entries is cheap.
+*/
+class MappedFile
+{
+public:
+    /** \brief Map a file. Throws if it cannot be opened or mapped. */
+    explicit MappedFile(const std::string& file_path);
+    MappedFile(const MappedFile&) = delete;
+    ~MappedFile();
+
+    inline const uint8_t* data() const { return data_; }
+    inline size_t size() const { return size_; }
+
+    inline const std::string& file_path() const { return file_path_; }
+
+private:
+    std::string file_path_;
+    const uint8_t* data_;
+    size_t size_;
+
+#ifdef _WIN32
+    void* file_;
+    void* mapping_;
+#endif
+};
+
+}
+
+#endif // HLMDLVIEWER_MAPPED_FILE_H_
@@ -25,6 +25,14 @@ void MeshBuffer::initialize(
     buffer_.initialize(vertices, indices, usage);
 }
 
+void MeshBuffer::initialize(
+    const std::vector<glvertex_packed>& vertices,
+    const std::vector<unsigned int>& indices,
+    GLenum usage)
+{
+    buffer_.initialize(vertices, indices, usage);
+}
+
 void MeshBuffer::delete_buffer()
 {
     buffer_.delete_buffer();
@@ -42,10 +50,12 @@ void MeshBuffer::draw_arrays_unbinded(const GLenum mode, const MeshBufferStride&
 
 void MeshBuffer::draw_indexed_unbinded(const GLenum mode, const MeshBufferStride& stride)
 {
-    buffer_.draw_indexed_range_unbinded(
+    buffer_.draw_elements_unbinded(
         mode,
-        stride.indice_start_index,
-        stride.num_indices);
+        stride.num_indices,
+        index_type(stride),
+        stride.index_offset,
+        stride.base_vertex);
 }
 
 void MeshBuffer::draw_indexed_unbinded(const GLenum mode)
@@ -53,6 +63,17 @@ void MeshBuffer::draw_indexed_unbinded(const GLenum mode)
     buffer_.draw_indexed_unbinded(mode);
 }
 
+void MeshBuffer::draw_indexed_instanced_unbinded(const GLenum mode, const MeshBufferStride& stride, int instance_count)
+{
+    buffer_.draw_elements_instanced_unbinded(
+        mode,
+        stride.num_indices,
+        index_type(stride),
+        stride.index_offset,
+        stride.base_vertex,
+        instance_count);
+}
+
 void MeshBuffer::set_vertices(const MeshBufferStride& stride, const std::vector<glvertex>& vertices)
 {
     buffer_.set_vertices(vertices, stride.vertex_start_index);
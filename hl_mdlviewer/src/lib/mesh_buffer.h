@@ -24,13 +24,21 @@ public:
         const std::vector<unsigned int>& indices,
         GLenum usage = GL_STATIC_DRAW);
 
+    void initialize(
+        const std::vector<glvertex_packed>& vertices,
+        const std::vector<unsigned int>& indices,
+        GLenum usage = GL_STATIC_DRAW);
+
     void delete_buffer();
 
+    inline const GLuint vertex_array_id() const { return buffer_.vertex_array_id(); }
+
     void draw_arrays_unbinded(const GLenum mode);
     void draw_arrays_unbinded(const GLenum mode, const MeshBufferStride& stride);
 
     void draw_indexed_unbinded(const GLenum mode, const MeshBufferStride& stride);
     void draw_indexed_unbinded(const GLenum mode);
+    void draw_indexed_instanced_unbinded(const GLenum mode, const MeshBufferStride& stride, int instance_count);
 
     inline void bind() {
         buffer_.bind();
@@ -43,6 +51,10 @@ public:
     void set_vertices(const MeshBufferStride& stride, const std::vector<glvertex>& vertices);
 
 private:
+    static inline GLenum index_type(const MeshBufferStride& stride) {
+        return stride.index_size == sizeof(unsigned short) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
     glbuffer buffer_;
 };
 
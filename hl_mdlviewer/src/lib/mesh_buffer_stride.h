@@ -5,6 +5,8 @@
 #ifndef HLMDLVIEWER_MESH_BUFFER_STRIDE_H_
 #define HLMDLVIEWER_MESH_BUFFER_STRIDE_H_
 
+#include <cstddef>
+
 namespace hl_mdlviewer {
 
 /** \brief A structure that contains the stride of a single mesh. */
@@ -14,7 +16,10 @@ struct MeshBufferStride
         vertex_start_index(-1),
         indice_start_index(-1),
         num_vertices(0),
-        num_indices(0)
+        num_indices(0),
+        index_size(sizeof(unsigned int)),
+        index_offset(0),
+        base_vertex(0)
     {
     }
 
@@ -24,6 +29,9 @@ struct MeshBufferStride
         indice_start_index = -1;
         num_vertices = 0;
         num_indices = 0;
+        index_size = sizeof(unsigned int);
+        index_offset = 0;
+        base_vertex = 0;
     }
 
     /** The index for the first vertex of the mesh. */
@@ -37,6 +45,16 @@ struct MeshBufferStride
 
     /** The mesh "indice" count. */
     int num_indices;
+
+    /** The size of a single "indice", either 2 or 4 bytes. */
+    int index_size;
+
+    /** The offset of the first "indice" in the index buffer, in bytes. */
+    size_t index_offset;
+
+    /** The value added to each "indice" when drawing. 16-bit "indices"
+    * are relative to the first vertex of the mesh. */
+    int base_vertex;
 };
 
 }
@@ -0,0 +1,312 @@
+/**
+* \file mesh_simplifier.cpp
+* \brief Implementation for the mesh simplification functions.
+*/
+
+#include "pch.h"
+#include "mesh_simplifier.h"
+#include <map>
+#include <queue>
+#include <tuple>
+
+namespace hl_mdlviewer {
+
+namespace {
+
+/** \brief The sum of the squared distances to a set of planes. */
+struct Quadric
+{
+    Quadric() :
+        a00(0), a01(0), a02(0), a11(0), a12(0), a22(0),
+        b0(0), b1(0), b2(0), c(0)
+    {
+    }
+
+    /** \brief Make the quadric of the plane n.p + d = 0. */
+    static Quadric from_plane(const glm::dvec3& n, double d)
+    {
+        Quadric q;
+        q.a00 = n.x * n.x; q.a01 = n.x * n.y; q.a02 = n.x * n.z;
+        q.a11 = n.y * n.y; q.a12 = n.y * n.z;
+        q.a22 = n.z * n.z;
+        q.b0 = n.x * d; q.b1 = n.y * d; q.b2 = n.z * d;
+        q.c = d * d;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02;
+        a11 += q.a11; a12 += q.a12;
+        a22 += q.a22;
+        b0 += q.b0; b1 += q.b1; b2 += q.b2;
+        c += q.c;
+        return *this;
+    }
+
+    double evaluate(const glm::vec3& p) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z
+            + a11 * y * y + 2 * a12 * y * z
+            + a22 * z * z
+            + 2 * (b0 * x + b1 * y + b2 * z)
+            + c;
+    }
+
+    double a00, a01, a02, a11, a12, a22;
+    double b0, b1, b2;
+    double c;
+};
+
+/** \brief A candidate collapse of the vertex \p from onto \p to. */
+struct Collapse
+{
+    double cost;
+    unsigned int from;
+    unsigned int to;
+
+    /** \brief The vertex versions the cost was computed with. */
+    unsigned int from_version;
+    unsigned int to_version;
+
+    bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+bool same_attributes(const glvertex& a, const glvertex& b)
+{
+    return a.normal == b.normal && a.uv == b.uv && a.boneid == b.boneid;
+}
+
+}
+
+float simplify_mesh(const std::vector<glvertex>& vertices,
+    const std::vector<unsigned int>& indices,
+    size_t target_num_indices,
+    std::vector<unsigned int>& result)
+{
+    const size_t num_vertices = vertices.size();
+
+    // Weld the exact duplicates, and lock the vertices sharing a position
+    // with a vertex of other attributes: those are on seams or hard edges.
+    std::vector<unsigned int> remap(num_vertices);
+    std::vector<bool> locked(num_vertices, false);
+    {
+        std::map<std::tuple<float, float, float>, std::vector<unsigned int>> positions;
+        for (unsigned int i = 0; i < num_vertices; ++i)
+        {
+            const glm::vec3& p = vertices[i].position;
+            std::vector<unsigned int>& same_position = positions[std::make_tuple(p.x, p.y, p.z)];
+
+            remap[i] = i;
+            for (unsigned int other : same_position)
+            {
+                if (same_attributes(vertices[other], vertices[i]))
+                {
+                    remap[i] = other;
+                    break;
+                }
+
+                locked[other] = true;
+                locked[i] = true;
+            }
+
+            if (remap[i] == i)
+                same_position.push_back(i);
+        }
+    }
+
+    std::vector<unsigned int> triangles;
+    triangles.reserve(indices.size());
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const unsigned int a = remap[indices[i]];
+        const unsigned int b = remap[indices[i + 1]];
+        const unsigned int c = remap[indices[i + 2]];
+
+        if (a != b && b != c && c != a)
+        {
+            triangles.push_back(a);
+            triangles.push_back(b);
+            triangles.push_back(c);
+        }
+    }
+
+    const size_t num_triangles = triangles.size() / 3;
+    std::vector<bool> live_triangles(num_triangles, true);
+    size_t num_live_triangles = num_triangles;
+
+    std::vector<std::vector<unsigned int>> vertex_triangles(num_vertices);
+    std::vector<Quadric> quadrics(num_vertices);
+
+    // Lock the vertices of the border edges, used by a single triangle.
+    std::map<std::pair<unsigned int, unsigned int>, int> edges;
+
+    for (unsigned int t = 0; t < num_triangles; ++t)
+    {
+        const unsigned int* tri = &triangles[t * 3];
+        const glm::dvec3 p0(vertices[tri[0]].position);
+        const glm::dvec3 p1(vertices[tri[1]].position);
+        const glm::dvec3 p2(vertices[tri[2]].position);
+
+        glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+        const double length = glm::length(n);
+        if (length > 0.0)
+            n /= length;
+
+        const Quadric q = Quadric::from_plane(n, -glm::dot(n, p0));
+
+        for (int k = 0; k < 3; ++k)
+        {
+            vertex_triangles[tri[k]].push_back(t);
+            quadrics[tri[k]] += q;
+
+            const unsigned int a = tri[k];
+            const unsigned int b = tri[(k + 1) % 3];
+            ++edges[std::make_pair(std::min(a, b), std::max(a, b))];
+        }
+    }
+
+    for (const auto& edge : edges)
+    {
+        if (edge.second == 1)
+        {
+            locked[edge.first.first] = true;
+            locked[edge.first.second] = true;
+        }
+    }
+
+    std::vector<unsigned int> versions(num_vertices, 0);
+    std::vector<bool> removed(num_vertices, false);
+
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapses;
+
+    auto push_collapse = [&](unsigned int from, unsigned int to) {
+        if (locked[from] || vertices[from].boneid != vertices[to].boneid)
+            return;
+
+        Quadric q = quadrics[from];
+        q += quadrics[to];
+
+        Collapse collapse;
+        collapse.cost = std::max(q.evaluate(vertices[to].position), 0.0);
+        collapse.from = from;
+        collapse.to = to;
+        collapse.from_version = versions[from];
+        collapse.to_version = versions[to];
+        collapses.push(collapse);
+    };
+
+    for (size_t i = 0; i < triangles.size(); i += 3)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const unsigned int a = triangles[i + k];
+            const unsigned int b = triangles[i + (k + 1) % 3];
+            push_collapse(a, b);
+            push_collapse(b, a);
+        }
+    }
+
+    const size_t target_num_triangles = target_num_indices / 3;
+    double max_cost = 0.0;
+
+    while (num_live_triangles > target_num_triangles && !collapses.empty())
+    {
+        const Collapse collapse = collapses.top();
+        collapses.pop();
+
+        // The cost is outdated once either vertex changed.
+        if (removed[collapse.from] || removed[collapse.to] ||
+            versions[collapse.from] != collapse.from_version ||
+            versions[collapse.to] != collapse.to_version)
+            continue;
+
+        // Reject the collapse if it flips a remaining triangle.
+        bool flips = false;
+        for (unsigned int t : vertex_triangles[collapse.from])
+        {
+            if (!live_triangles[t])
+                continue;
+
+            const unsigned int* tri = &triangles[t * 3];
+            if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+                continue;
+
+            glm::vec3 p[3], q[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                p[k] = vertices[tri[k]].position;
+                q[k] = tri[k] == collapse.from ? vertices[collapse.to].position : p[k];
+            }
+
+            const glm::vec3 n0 = glm::cross(p[1] - p[0], p[2] - p[0]);
+            const glm::vec3 n1 = glm::cross(q[1] - q[0], q[2] - q[0]);
+            if (glm::dot(n0, n1) <= 0.0f)
+            {
+                flips = true;
+                break;
+            }
+        }
+
+        if (flips)
+            continue;
+
+        // Move the triangles of the removed vertex over, and drop the
+        // triangles of the collapsed edge.
+        for (unsigned int t : vertex_triangles[collapse.from])
+        {
+            if (!live_triangles[t])
+                continue;
+
+            unsigned int* tri = &triangles[t * 3];
+            if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+            {
+                live_triangles[t] = false;
+                --num_live_triangles;
+                continue;
+            }
+
+            for (int k = 0; k < 3; ++k)
+            {
+                if (tri[k] == collapse.from)
+                    tri[k] = collapse.to;
+            }
+
+            vertex_triangles[collapse.to].push_back(t);
+        }
+
+        removed[collapse.from] = true;
+        quadrics[collapse.to] += quadrics[collapse.from];
+        ++versions[collapse.to];
+        max_cost = std::max(max_cost, collapse.cost);
+
+        for (unsigned int t : vertex_triangles[collapse.to])
+        {
+            if (!live_triangles[t])
+                continue;
+
+            const unsigned int* tri = &triangles[t * 3];
+            for (int k = 0; k < 3; ++k)
+            {
+                if (tri[k] != collapse.to)
+                {
+                    push_collapse(collapse.to, tri[k]);
+                    push_collapse(tri[k], collapse.to);
+                }
+            }
+        }
+    }
+
+    result.clear();
+    result.reserve(num_live_triangles * 3);
+    for (size_t t = 0; t < num_triangles; ++t)
+    {
+        if (live_triangles[t])
+            result.insert(result.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+    }
+
+    return static_cast<float>(std::sqrt(max_cost));
+}
+
+}
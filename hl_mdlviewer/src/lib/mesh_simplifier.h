@@ -0,0 +1,35 @@
+/**
+* \file mesh_simplifier.h
+* \brief Declaration for the mesh simplification functions.
+*/
+
+#ifndef HLMDLVIEWER_MESH_SIMPLIFIER_H_
+#define HLMDLVIEWER_MESH_SIMPLIFIER_H_
+
+#include <vector>
+#include "glvertex.h"
+
+namespace hl_mdlviewer {
+
+/** \brief Simplify a triangle list by collapsing edges, in the order of
+*          the least quadric error.
+*
+* A vertex is only collapsed onto another vertex of the mesh, so the result
+* uses the same vertices as \p indices. Vertices are never collapsed onto a
+* vertex of another bone, and vertices on a UV seam, a hard edge or a border
+* are never moved, so that skinning and texturing are left intact.
+* \param[in] vertices The vertices.
+* \param[in] indices A triangle list.
+* \param[in] target_num_indices The number of "indices" to reduce to.
+*            The result may be larger if the mesh cannot be simplified further.
+* \param[out] result The simplified triangle list.
+* \return The largest error of a collapse, as a distance.
+*/
+float simplify_mesh(const std::vector<glvertex>& vertices,
+    const std::vector<unsigned int>& indices,
+    size_t target_num_indices,
+    std::vector<unsigned int>& result);
+
+}
+
+#endif // HLMDLVIEWER_MESH_SIMPLIFIER_H_
@@ -8,6 +8,7 @@
 #include "hl1_mdlviewer_presenter.h"
 #include "hl1_model_stats.h"
 #include <nanogui/messagedialog.h>
+#include <iomanip>
 
 namespace hl_mdlviewer {
 namespace hl1 {
@@ -18,6 +19,8 @@ HL1NanoGUIView::HL1NanoGUIView() :
     bodypart_(nullptr),
     model_(nullptr),
     skin_(nullptr),
+    crowd_size_(nullptr),
+    max_frame_rate_(nullptr),
     sequence_button_(nullptr),
     sequence_panel_(nullptr),
     rendermode_(nullptr),
@@ -29,11 +32,15 @@ HL1NanoGUIView::HL1NanoGUIView() :
     wireframe_(nullptr),
     enable_lighting_(nullptr),
     enable_chrome_effects_(nullptr),
+    compress_textures_(nullptr),
     playback_rate_(nullptr),
     bone_controller_panel_(nullptr),
     blend_panel_(nullptr),
+    mesh_lod_panel_(nullptr),
+    benchmark_panel_(nullptr),
     bone_controllers_(),
-    blenders_()
+    blenders_(),
+    frame_pacer_()
 {
 }
 
@@ -111,6 +118,11 @@ void HL1NanoGUIView::initialize()
         }
     });
 
+    b = new Button(p, "Refresh files");
+    b->setCallback([&]() {
+        presenter_->refresh_files();
+    });
+
     tab_ = w->add<TabWidget>();
     tab_->setFixedWidth(300);
     tab_->setEnabled(false);
@@ -163,6 +175,62 @@ void HL1NanoGUIView::initialize()
         enable_chrome_effects_->setCallback([&](bool checked) {
             presenter_->set_draw_chrome_effects(checked);
         });
+
+        compress_textures_ = new CheckBox(p);
+        compress_textures_->setCaption("Compress textures (on load)");
+        compress_textures_->setCallback([&](bool checked) {
+            TextureSetupSettings settings = presenter_->texture_settings();
+            settings.compress = checked;
+            presenter_->set_texture_settings(settings);
+        });
+
+        p = new Widget(layer);
+        layout = new GridLayout(Orientation::Horizontal, 2,
+                Alignment::Fill, 15, 6);
+        layout->setColAlignment({ Alignment::Minimum, Alignment::Fill });
+        p->setLayout(layout);
+
+        new Label(p, "Crowd size", "sans-bold");
+        crowd_size_ = new IntBox<int>(p);
+        crowd_size_->setWidth(screen_->width());
+        crowd_size_->setEditable(true);
+        crowd_size_->setSpinnable(true);
+        crowd_size_->setValue(0);
+        crowd_size_->setMinMaxValues(0, 1000);
+        crowd_size_->setCallback([&](int value) {
+            presenter_->set_crowd_size(value);
+        });
+
+        new Label(p, "Max frame rate", "sans-bold");
+        max_frame_rate_ = new IntBox<int>(p);
+        max_frame_rate_->setWidth(screen_->width());
+        max_frame_rate_->setEditable(true);
+        max_frame_rate_->setSpinnable(true);
+        max_frame_rate_->setValue(static_cast<int>(frame_pacer_.max_frame_rate()));
+        max_frame_rate_->setMinMaxValues(0, 500);
+        max_frame_rate_->setCallback([&](int value) {
+            frame_pacer_.set_max_frame_rate(static_cast<float>(value));
+        });
+
+        p = new Widget(layer);
+        p->setLayout(new GroupLayout());
+
+        Button* benchmark = new Button(p, "Benchmark instancing");
+        benchmark->setCallback([&]() {
+            presenter_->start_instancing_benchmark();
+        });
+
+        benchmark_panel_ = new Widget(layer);
+        layout = new GridLayout(Orientation::Horizontal, 4,
+            Alignment::Fill, 15, 6);
+        layout->setColAlignment({ Alignment::Minimum, Alignment::Maximum, Alignment::Maximum, Alignment::Maximum });
+        benchmark_panel_->setLayout(layout);
+
+        mesh_lod_panel_ = new Widget(layer);
+        layout = new GridLayout(Orientation::Horizontal, 2,
+            Alignment::Fill, 15, 6);
+        layout->setColAlignment({ Alignment::Minimum, Alignment::Fill });
+        mesh_lod_panel_->setLayout(layout);
     }
 
     {
@@ -301,7 +369,34 @@ void HL1NanoGUIView::initialize()
 
 void HL1NanoGUIView::run()
 {
-    nanogui::mainloop();
+    GLFWwindow* window = screen_->glfwWindow();
+
+    screen_->drawAll();
+    frame_pacer_.end_frame(glfwGetTime());
+
+    // Draw continuously only while the model animates, otherwise sleep
+    // until an event comes in.
+    while (!glfwWindowShouldClose(window))
+    {
+        const bool animating = presenter_->is_animating();
+        const bool dirty = presenter_->needs_redraw();
+        frame_pacer_.begin_wait(glfwGetTime(), !animating && !dirty);
+
+        const double wait_time = frame_pacer_.get_wait_time(glfwGetTime(), animating, dirty);
+        if (wait_time < 0.0)
+            glfwWaitEvents();
+        else if (wait_time > 0.0)
+            glfwWaitEventsTimeout(wait_time);
+        else
+            glfwPollEvents();
+
+        // Input received while animating is drawn with the next frame.
+        if (animating && !frame_pacer_.frame_due(glfwGetTime()))
+            continue;
+
+        screen_->drawAll();
+        frame_pacer_.end_frame(glfwGetTime());
+    }
 }
 
 void HL1NanoGUIView::dispose()
@@ -314,6 +409,61 @@ void HL1NanoGUIView::invalidate()
     screen_->performLayout();
 }
 
+void HL1NanoGUIView::set_mesh_lods(const std::vector<UIMeshLOD>& mesh_lods)
+{
+    using namespace nanogui;
+
+    while (mesh_lod_panel_->childCount() > 0)
+        mesh_lod_panel_->removeChild(0);
+
+    for (const UIMeshLOD& lod : mesh_lods)
+    {
+        const size_t percent = lod.num_full_triangles > 0 ?
+            lod.num_triangles * 100 / lod.num_full_triangles : 100;
+
+        std::stringstream ss;
+        ss << lod.num_triangles << " triangles (" << percent << "%)";
+        if (lod.level > 0)
+        {
+            ss << ", error " << std::fixed << std::setprecision(2) << lod.max_error
+                << ", from " << std::setprecision(0) << lod.min_distance << " units";
+        }
+
+        new Label(mesh_lod_panel_, std::string("Mesh LOD ") + std::to_string(lod.level), "sans-bold");
+        new Label(mesh_lod_panel_, ss.str());
+    }
+}
+
+void HL1NanoGUIView::set_instancing_benchmark_results(const std::vector<InstancingBenchmarkResult>& results)
+{
+    using namespace nanogui;
+
+    while (benchmark_panel_->childCount() > 0)
+        benchmark_panel_->removeChild(0);
+
+    if (results.empty())
+        return;
+
+    new Label(benchmark_panel_, "Instances", "sans-bold");
+    new Label(benchmark_panel_, "Frame (ms)", "sans-bold");
+    new Label(benchmark_panel_, "CPU (ms)", "sans-bold");
+    new Label(benchmark_panel_, "GPU (ms)", "sans-bold");
+
+    auto format = [](double milliseconds) {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(3) << milliseconds;
+        return ss.str();
+    };
+
+    for (const InstancingBenchmarkResult& result : results)
+    {
+        new Label(benchmark_panel_, std::to_string(result.instance_count));
+        new Label(benchmark_panel_, format(result.frame_time_ms));
+        new Label(benchmark_panel_, format(result.cpu_time_ms));
+        new Label(benchmark_panel_, format(result.gpu_time_ms));
+    }
+}
+
 void HL1NanoGUIView::on_model_loading_success()
 {
 }
@@ -377,6 +527,8 @@ void HL1NanoGUIView::setup_ui(const UIData& ui_data)
     skin_->setEditable(skin_->enabled());
     skin_->setSpinnable(skin_->enabled());
 
+    crowd_size_->setValue(0);
+
     // Clear sequence list.
     while (sequence_panel_->childCount() > 0)
         sequence_panel_->removeChild(0);
@@ -8,6 +8,7 @@
 
 #include "hl1_mdlviewer_view.h"
 #include "hl1_nanogui_view_glcanvas.h"
+#include "frame_pacer.h"
 
 #include <nanogui/nanogui.h>
 
@@ -113,6 +114,11 @@ public:
     virtual void disable_model_interaction();
 
     virtual void setup_ui(const UIData& ui_data);
+    virtual void set_mesh_lods(const std::vector<UIMeshLOD>& mesh_lods);
+    virtual void set_instancing_benchmark_results(const std::vector<InstancingBenchmarkResult>& results);
+
+    /** \brief Get how much CPU time the main loop spent while idle. */
+    const IdleStatistics& idle_statistics() const { return frame_pacer_.idle_statistics(); }
 
 private:
 
@@ -124,10 +130,14 @@ private:
     nanogui::IntBox<int>* bodypart_;
     nanogui::IntBox<int>* model_;
     nanogui::IntBox<int>* skin_;
+    nanogui::IntBox<int>* crowd_size_;
+    nanogui::IntBox<int>* max_frame_rate_;
     nanogui::PopupButton* sequence_button_;
     nanogui::Widget* sequence_panel_;
     nanogui::Widget* bone_controller_panel_;
     nanogui::Widget* blend_panel_;
+    nanogui::Widget* mesh_lod_panel_;
+    nanogui::Widget* benchmark_panel_;
     nanogui::ComboBox* rendermode_;
     nanogui::CheckBox* show_normals_;
     nanogui::CheckBox* show_bones_;
@@ -138,10 +148,14 @@ private:
     nanogui::CheckBox* wireframe_;
     nanogui::CheckBox* enable_lighting_;
     nanogui::CheckBox* enable_chrome_effects_;
+    nanogui::CheckBox* compress_textures_;
     nanogui::Slider* playback_rate_;
     std::vector<IndexedSlider*> bone_controllers_;
     std::vector<IndexedSlider*> blenders_;
     nanogui::TabWidget* tab_;
+
+    /** \brief Decides when the main loop draws, and measures the idle time. */
+    FramePacer frame_pacer_;
 };
 
 }
@@ -0,0 +1,473 @@
+/**
+* \file opengl_render_backend.cpp
+* \brief Implementation for the OpenGL render backend class.
+*/
+
+#include "pch.h"
+#include "opengl_render_backend.h"
+#include "glcapabilities.h"
+
+namespace hl_mdlviewer
+{
+
+namespace {
+
+/** \brief GL_COMPLETION_STATUS_KHR, that glad was not generated with. */
+const GLenum COMPLETION_STATUS = 0x91B1;
+
+/** \brief Read an info log, i.e. with glGetShaderInfoLog. */
+template<typename GetLength, typename GetLog>
+std::string read_info_log(GLuint id, GetLength get_length, GetLog get_log)
+{
+    GLint log_length = 0;
+    get_length(id, GL_INFO_LOG_LENGTH, &log_length);
+
+    std::string info_log;
+    info_log.resize(log_length);
+
+    if (log_length > 0)
+    {
+        GLsizei num_read_characters = 0;
+        get_log(id, log_length, &num_read_characters, &info_log[0]);
+        info_log.resize(num_read_characters);
+    }
+
+    return info_log;
+}
+
+}
+
+OpenGLRenderBackend::OpenGLRenderBackend() :
+    parallel_shader_compile_(-1)
+{
+}
+
+OpenGLRenderBackend::~OpenGLRenderBackend()
+{
+}
+
+GLuint OpenGLRenderBackend::create_buffer()
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    return buffer;
+}
+
+void OpenGLRenderBackend::delete_buffer(GLuint buffer)
+{
+    glDeleteBuffers(1, &buffer);
+}
+
+GLuint OpenGLRenderBackend::create_vertex_array()
+{
+    GLuint vertex_array = 0;
+    glGenVertexArrays(1, &vertex_array);
+    return vertex_array;
+}
+
+void OpenGLRenderBackend::delete_vertex_array(GLuint vertex_array)
+{
+    glDeleteVertexArrays(1, &vertex_array);
+}
+
+GLuint OpenGLRenderBackend::create_texture()
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    return texture;
+}
+
+void OpenGLRenderBackend::delete_texture(GLuint texture)
+{
+    glDeleteTextures(1, &texture);
+}
+
+GLuint OpenGLRenderBackend::create_shader(GLenum type)
+{
+    return glCreateShader(type);
+}
+
+void OpenGLRenderBackend::delete_shader(GLuint shader)
+{
+    glDeleteShader(shader);
+}
+
+GLuint OpenGLRenderBackend::create_program()
+{
+    return glCreateProgram();
+}
+
+void OpenGLRenderBackend::delete_program(GLuint program)
+{
+    glDeleteProgram(program);
+}
+
+void OpenGLRenderBackend::bind_buffer(GLenum target, GLuint buffer)
+{
+    glBindBuffer(target, buffer);
+}
+
+void OpenGLRenderBackend::bind_buffer_range(GLenum target, GLuint index, GLuint buffer,
+    GLintptr offset, GLsizeiptr size)
+{
+    glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void OpenGLRenderBackend::buffer_data(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    glBufferData(target, size, data, usage);
+}
+
+void OpenGLRenderBackend::buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    glBufferSubData(target, offset, size, data);
+}
+
+void OpenGLRenderBackend::buffer_storage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+{
+    glBufferStorage(target, size, data, flags);
+}
+
+void* OpenGLRenderBackend::map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    return glMapBufferRange(target, offset, length, access);
+}
+
+void OpenGLRenderBackend::unmap_buffer(GLenum target)
+{
+    glUnmapBuffer(target);
+}
+
+void OpenGLRenderBackend::bind_vertex_array(GLuint vertex_array)
+{
+    glBindVertexArray(vertex_array);
+}
+
+void OpenGLRenderBackend::enable_vertex_attrib_array(GLuint index)
+{
+    glEnableVertexAttribArray(index);
+}
+
+void OpenGLRenderBackend::vertex_attrib_pointer(GLuint index, GLint size, GLenum type,
+    GLboolean normalized, GLsizei stride, size_t offset)
+{
+    glVertexAttribPointer(index, size, type, normalized, stride, (void*)offset);
+}
+
+void OpenGLRenderBackend::vertex_attrib_ipointer(GLuint index, GLint size, GLenum type,
+    GLsizei stride, size_t offset)
+{
+    glVertexAttribIPointer(index, size, type, stride, (void*)offset);
+}
+
+void OpenGLRenderBackend::active_texture(GLuint unit)
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void OpenGLRenderBackend::bind_texture(GLenum target, GLuint texture)
+{
+    glBindTexture(target, texture);
+}
+
+void OpenGLRenderBackend::tex_parameter(GLenum target, GLenum name, GLint value)
+{
+    glTexParameteri(target, name, value);
+}
+
+void OpenGLRenderBackend::tex_image_2d(GLenum target, GLint level, GLint internal_format,
+    GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+    glTexImage2D(target, level, internal_format, width, height, 0, format, type, pixels);
+}
+
+void OpenGLRenderBackend::compressed_tex_image_2d(GLenum target, GLint level, GLenum internal_format,
+    GLsizei width, GLsizei height, GLsizei size, const void* data)
+{
+    glCompressedTexImage2D(target, level, internal_format, width, height, 0, size, data);
+}
+
+void OpenGLRenderBackend::tex_buffer(GLenum target, GLenum internal_format, GLuint buffer)
+{
+    glTexBuffer(target, internal_format, buffer);
+}
+
+void OpenGLRenderBackend::pixel_store(GLenum name, GLint value)
+{
+    glPixelStorei(name, value);
+}
+
+void OpenGLRenderBackend::compile_shader(GLuint shader, const std::string& source)
+{
+    const GLchar* const shader_source = source.c_str();
+    glShaderSource(shader, 1, &shader_source, nullptr);
+
+    glCompileShader(shader);
+}
+
+bool OpenGLRenderBackend::get_compile_status(GLuint shader, std::string& info_log)
+{
+    GLint status;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+    if (status == GL_FALSE)
+    {
+        info_log = read_info_log(shader, glGetShaderiv, glGetShaderInfoLog);
+        return false;
+    }
+
+    return true;
+}
+
+void OpenGLRenderBackend::attach_shader(GLuint program, GLuint shader)
+{
+    glAttachShader(program, shader);
+}
+
+void OpenGLRenderBackend::bind_attrib_location(GLuint program, GLuint index, const char* name)
+{
+    glBindAttribLocation(program, index, name);
+}
+
+void OpenGLRenderBackend::program_parameter(GLuint program, GLenum name, GLint value)
+{
+    // Needs GL 4.1 or GL_ARB_get_program_binary.
+    if (glProgramParameteri)
+        glProgramParameteri(program, name, value);
+}
+
+void OpenGLRenderBackend::link_program(GLuint program)
+{
+    glLinkProgram(program);
+}
+
+bool OpenGLRenderBackend::get_link_status(GLuint program, std::string& info_log)
+{
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+    if (status == GL_FALSE)
+    {
+        info_log = read_info_log(program, glGetProgramiv, glGetProgramInfoLog);
+        return false;
+    }
+
+    return true;
+}
+
+bool OpenGLRenderBackend::has_parallel_shader_compile()
+{
+    // Queried on first use, the backend is created before the context.
+    if (parallel_shader_compile_ < 0)
+    {
+        parallel_shader_compile_ = has_gl_extension("GL_KHR_parallel_shader_compile") ||
+            has_gl_extension("GL_ARB_parallel_shader_compile");
+    }
+
+    return parallel_shader_compile_ != 0;
+}
+
+bool OpenGLRenderBackend::is_program_completed(GLuint program)
+{
+    if (!has_parallel_shader_compile())
+        return true;
+
+    GLint status = GL_TRUE;
+    glGetProgramiv(program, COMPLETION_STATUS, &status);
+    return status != GL_FALSE;
+}
+
+bool OpenGLRenderBackend::get_program_binary(GLuint program, GLenum& format, std::vector<uint8_t>& binary)
+{
+    if (!glGetProgramBinary)
+        return false;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return false;
+
+    binary.resize(static_cast<size_t>(length));
+
+    GLsizei num_written_bytes = 0;
+    glGetProgramBinary(program, length, &num_written_bytes, &format, binary.data());
+    binary.resize(static_cast<size_t>(num_written_bytes));
+    return num_written_bytes > 0;
+}
+
+bool OpenGLRenderBackend::program_binary(GLuint program, GLenum format, const void* binary, GLsizei size)
+{
+    if (!glProgramBinary)
+        return false;
+
+    glProgramBinary(program, format, binary, size);
+
+    // A format the driver does not know is an error, not only a failed link.
+    if (glGetError() == GL_INVALID_ENUM)
+        return false;
+
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    return status != GL_FALSE;
+}
+
+bool OpenGLRenderBackend::validate_program(GLuint program, std::string& info_log)
+{
+    glValidateProgram(program);
+
+    GLint status;
+    glGetProgramiv(program, GL_VALIDATE_STATUS, &status);
+
+    if (status == GL_FALSE)
+    {
+        info_log = read_info_log(program, glGetProgramiv, glGetProgramInfoLog);
+        return false;
+    }
+
+    return true;
+}
+
+void OpenGLRenderBackend::use_program(GLuint program)
+{
+    glUseProgram(program);
+}
+
+GLint OpenGLRenderBackend::get_attrib_location(GLuint program, const char* name)
+{
+    return glGetAttribLocation(program, name);
+}
+
+GLint OpenGLRenderBackend::get_uniform_location(GLuint program, const char* name)
+{
+    return glGetUniformLocation(program, name);
+}
+
+GLuint OpenGLRenderBackend::get_uniform_block_index(GLuint program, const char* name)
+{
+    return glGetUniformBlockIndex(program, name);
+}
+
+void OpenGLRenderBackend::uniform_block_binding(GLuint program, GLuint block_index, GLuint binding)
+{
+    glUniformBlockBinding(program, block_index, binding);
+}
+
+void OpenGLRenderBackend::uniform_1i(GLint location, GLint value)
+{
+    glUniform1i(location, value);
+}
+
+void OpenGLRenderBackend::uniform_1ui(GLint location, GLuint value)
+{
+    glUniform1ui(location, value);
+}
+
+void OpenGLRenderBackend::uniform_1f(GLint location, GLfloat value)
+{
+    glUniform1f(location, value);
+}
+
+void OpenGLRenderBackend::uniform_2fv(GLint location, const GLfloat* value)
+{
+    glUniform2fv(location, 1, value);
+}
+
+void OpenGLRenderBackend::uniform_3fv(GLint location, const GLfloat* value)
+{
+    glUniform3fv(location, 1, value);
+}
+
+void OpenGLRenderBackend::uniform_4fv(GLint location, const GLfloat* value)
+{
+    glUniform4fv(location, 1, value);
+}
+
+void OpenGLRenderBackend::uniform_matrix_4fv(GLint location, GLboolean transpose, const GLfloat* value)
+{
+    glUniformMatrix4fv(location, 1, transpose, value);
+}
+
+void OpenGLRenderBackend::enable(GLenum capability)
+{
+    glEnable(capability);
+}
+
+void OpenGLRenderBackend::disable(GLenum capability)
+{
+    glDisable(capability);
+}
+
+void OpenGLRenderBackend::blend_func(GLenum source_factor, GLenum destination_factor)
+{
+    glBlendFunc(source_factor, destination_factor);
+}
+
+void OpenGLRenderBackend::depth_func(GLenum func)
+{
+    glDepthFunc(func);
+}
+
+void OpenGLRenderBackend::cull_face(GLenum mode)
+{
+    glCullFace(mode);
+}
+
+void OpenGLRenderBackend::polygon_mode(GLenum face, GLenum mode)
+{
+    glPolygonMode(face, mode);
+}
+
+void OpenGLRenderBackend::primitive_restart_index(GLuint index)
+{
+    glPrimitiveRestartIndex(index);
+}
+
+void OpenGLRenderBackend::draw_arrays(GLenum mode, GLint first, GLsizei count)
+{
+    glDrawArrays(mode, first, count);
+}
+
+void OpenGLRenderBackend::draw_elements(GLenum mode, GLsizei count, GLenum type,
+    size_t offset, GLint base_vertex)
+{
+    if (base_vertex == 0)
+        glDrawElements(mode, count, type, (void*)offset);
+    else
+        glDrawElementsBaseVertex(mode, count, type, (void*)offset, base_vertex);
+}
+
+void OpenGLRenderBackend::draw_elements_instanced(GLenum mode, GLsizei count, GLenum type,
+    size_t offset, GLint base_vertex, GLsizei instance_count)
+{
+    glDrawElementsInstancedBaseVertex(mode, count, type, (void*)offset, instance_count, base_vertex);
+}
+
+GLsync OpenGLRenderBackend::fence_sync()
+{
+    return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLenum OpenGLRenderBackend::client_wait_sync(GLsync sync, GLbitfield flags, GLuint64 timeout_ns)
+{
+    return glClientWaitSync(sync, flags, timeout_ns);
+}
+
+void OpenGLRenderBackend::delete_sync(GLsync sync)
+{
+    glDeleteSync(sync);
+}
+
+GLint OpenGLRenderBackend::get_integer(GLenum name)
+{
+    GLint value = 0;
+    glGetIntegerv(name, &value);
+    return value;
+}
+
+std::string OpenGLRenderBackend::get_string(GLenum name)
+{
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : std::string();
+}
+
+}
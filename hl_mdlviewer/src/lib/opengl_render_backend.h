@@ -0,0 +1,105 @@
+/**
+* \file opengl_render_backend.h
+* \brief Declaration for the OpenGL render backend class.
+*/
+
+#ifndef HLMDLVIEWER_OPENGL_RENDER_BACKEND_H_
+#define HLMDLVIEWER_OPENGL_RENDER_BACKEND_H_
+
+#include "render_backend.h"
+
+namespace hl_mdlviewer {
+
+/** \brief A render backend that forwards every command to the current
+* OpenGL context. */
+class OpenGLRenderBackend : public RenderBackend
+{
+public:
+    OpenGLRenderBackend();
+    ~OpenGLRenderBackend();
+
+    GLuint create_buffer() override;
+    void delete_buffer(GLuint buffer) override;
+    GLuint create_vertex_array() override;
+    void delete_vertex_array(GLuint vertex_array) override;
+    GLuint create_texture() override;
+    void delete_texture(GLuint texture) override;
+    GLuint create_shader(GLenum type) override;
+    void delete_shader(GLuint shader) override;
+    GLuint create_program() override;
+    void delete_program(GLuint program) override;
+    void bind_buffer(GLenum target, GLuint buffer) override;
+    void bind_buffer_range(GLenum target, GLuint index, GLuint buffer,
+        GLintptr offset, GLsizeiptr size) override;
+    void buffer_data(GLenum target, GLsizeiptr size, const void* data, GLenum usage) override;
+    void buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) override;
+    void buffer_storage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) override;
+    void* map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) override;
+    void unmap_buffer(GLenum target) override;
+    void bind_vertex_array(GLuint vertex_array) override;
+    void enable_vertex_attrib_array(GLuint index) override;
+    void vertex_attrib_pointer(GLuint index, GLint size, GLenum type,
+        GLboolean normalized, GLsizei stride, size_t offset) override;
+    void vertex_attrib_ipointer(GLuint index, GLint size, GLenum type,
+        GLsizei stride, size_t offset) override;
+    void active_texture(GLuint unit) override;
+    void bind_texture(GLenum target, GLuint texture) override;
+    void tex_parameter(GLenum target, GLenum name, GLint value) override;
+    void tex_image_2d(GLenum target, GLint level, GLint internal_format,
+        GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) override;
+    void compressed_tex_image_2d(GLenum target, GLint level, GLenum internal_format,
+        GLsizei width, GLsizei height, GLsizei size, const void* data) override;
+    void tex_buffer(GLenum target, GLenum internal_format, GLuint buffer) override;
+    void pixel_store(GLenum name, GLint value) override;
+    void compile_shader(GLuint shader, const std::string& source) override;
+    bool get_compile_status(GLuint shader, std::string& info_log) override;
+    void attach_shader(GLuint program, GLuint shader) override;
+    void bind_attrib_location(GLuint program, GLuint index, const char* name) override;
+    void program_parameter(GLuint program, GLenum name, GLint value) override;
+    void link_program(GLuint program) override;
+    bool get_link_status(GLuint program, std::string& info_log) override;
+    bool has_parallel_shader_compile() override;
+    bool is_program_completed(GLuint program) override;
+    bool get_program_binary(GLuint program, GLenum& format, std::vector<uint8_t>& binary) override;
+    bool program_binary(GLuint program, GLenum format, const void* binary, GLsizei size) override;
+    bool validate_program(GLuint program, std::string& info_log) override;
+    void use_program(GLuint program) override;
+    GLint get_attrib_location(GLuint program, const char* name) override;
+    GLint get_uniform_location(GLuint program, const char* name) override;
+    GLuint get_uniform_block_index(GLuint program, const char* name) override;
+    void uniform_block_binding(GLuint program, GLuint block_index, GLuint binding) override;
+    void uniform_1i(GLint location, GLint value) override;
+    void uniform_1ui(GLint location, GLuint value) override;
+    void uniform_1f(GLint location, GLfloat value) override;
+    void uniform_2fv(GLint location, const GLfloat* value) override;
+    void uniform_3fv(GLint location, const GLfloat* value) override;
+    void uniform_4fv(GLint location, const GLfloat* value) override;
+    void uniform_matrix_4fv(GLint location, GLboolean transpose, const GLfloat* value) override;
+    void enable(GLenum capability) override;
+    void disable(GLenum capability) override;
+    void blend_func(GLenum source_factor, GLenum destination_factor) override;
+    void depth_func(GLenum func) override;
+    void cull_face(GLenum mode) override;
+    void polygon_mode(GLenum face, GLenum mode) override;
+    void primitive_restart_index(GLuint index) override;
+    void draw_arrays(GLenum mode, GLint first, GLsizei count) override;
+    void draw_elements(GLenum mode, GLsizei count, GLenum type,
+        size_t offset, GLint base_vertex) override;
+    void draw_elements_instanced(GLenum mode, GLsizei count, GLenum type,
+        size_t offset, GLint base_vertex, GLsizei instance_count) override;
+    GLsync fence_sync() override;
+    GLenum client_wait_sync(GLsync sync, GLbitfield flags, GLuint64 timeout_ns) override;
+    void delete_sync(GLsync sync) override;
+    GLint get_integer(GLenum name) override;
+    std::string get_string(GLenum name) override;
+
+private:
+
+    /** \brief Whether GL_KHR_parallel_shader_compile is supported, -1
+    * until the extensions are first queried. */
+    int parallel_shader_compile_;
+};
+
+}
+
+#endif // HLMDLVIEWER_OPENGL_RENDER_BACKEND_H_
@@ -0,0 +1,391 @@
+/**
+* \file png_writer.cpp
+* \brief Implementation for the PNG writer functions.
+*/
+
+#include "pch.h"
+#include "png_writer.h"
+#include <fstream>
+
+namespace hl_mdlviewer {
+
+namespace {
+
+const int BYTES_PER_PIXEL = 4;
+
+const int DEFLATE_WINDOW_SIZE = 32768;
+const int DEFLATE_MIN_MATCH = 3;
+const int DEFLATE_MAX_MATCH = 258;
+const int DEFLATE_HASH_BITS = 15;
+
+/** \brief The longest hash chain walked per position, trading speed for ratio. */
+const int DEFLATE_MAX_CHAIN = 32;
+
+const int LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const int LENGTH_EXTRA_BITS[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const int DISTANCE_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const int DISTANCE_EXTRA_BITS[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+/** \brief Writes a deflate bit stream, least significant bit first. */
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uint8_t>& output) :
+        output_(output),
+        bits_(0),
+        num_bits_(0)
+    {
+    }
+
+    void write_bits(uint32_t value, int count)
+    {
+        bits_ |= static_cast<uint64_t>(value) << num_bits_;
+        num_bits_ += count;
+
+        while (num_bits_ >= 8)
+        {
+            output_.push_back(static_cast<uint8_t>(bits_));
+            bits_ >>= 8;
+            num_bits_ -= 8;
+        }
+    }
+
+    /** \brief Write a Huffman code, which is stored most significant bit first. */
+    void write_code(uint32_t code, int length)
+    {
+        uint32_t reversed = 0;
+
+        for (int i = 0; i < length; ++i)
+            reversed |= ((code >> i) & 1) << (length - 1 - i);
+
+        write_bits(reversed, length);
+    }
+
+    void flush()
+    {
+        if (num_bits_ > 0)
+            output_.push_back(static_cast<uint8_t>(bits_));
+
+        bits_ = 0;
+        num_bits_ = 0;
+    }
+
+private:
+    std::vector<uint8_t>& output_;
+    uint64_t bits_;
+    int num_bits_;
+};
+
+/** \brief Write a literal/length symbol with the fixed Huffman code. */
+void write_symbol(BitWriter& writer, int symbol)
+{
+    if (symbol < 144)
+        writer.write_code(0x30 + symbol, 8);
+    else if (symbol < 256)
+        writer.write_code(0x190 + symbol - 144, 9);
+    else if (symbol < 280)
+        writer.write_code(symbol - 256, 7);
+    else
+        writer.write_code(0xC0 + symbol - 280, 8);
+}
+
+void write_match(BitWriter& writer, int length, int distance)
+{
+    int length_code = 0;
+    while (length_code < 28 && LENGTH_BASE[length_code + 1] <= length)
+        ++length_code;
+
+    write_symbol(writer, 257 + length_code);
+    writer.write_bits(length - LENGTH_BASE[length_code], LENGTH_EXTRA_BITS[length_code]);
+
+    int distance_code = 0;
+    while (distance_code < 29 && DISTANCE_BASE[distance_code + 1] <= distance)
+        ++distance_code;
+
+    writer.write_code(distance_code, 5);
+    writer.write_bits(distance - DISTANCE_BASE[distance_code], DISTANCE_EXTRA_BITS[distance_code]);
+}
+
+uint32_t adler32(const uint8_t* data, size_t size)
+{
+    uint32_t a = 1;
+    uint32_t b = 0;
+
+    while (size > 0)
+    {
+        // The largest block that cannot overflow before the modulo.
+        const size_t block_size = std::min(size, static_cast<size_t>(5552));
+
+        for (size_t i = 0; i < block_size; ++i)
+        {
+            a += data[i];
+            b += a;
+        }
+
+        a %= 65521;
+        b %= 65521;
+        data += block_size;
+        size -= block_size;
+    }
+
+    return (b << 16) | a;
+}
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> result(256);
+
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            result[i] = c;
+        }
+
+        return result;
+    }();
+
+    crc = ~crc;
+
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+/** \brief Compress \p data as a zlib stream with a single fixed Huffman block. */
+void zlib_compress(const uint8_t* data, size_t size, std::vector<uint8_t>& output)
+{
+    // Deflate, 32K window, no dictionary, fastest compression level.
+    output.push_back(0x78);
+    output.push_back(0x01);
+
+    BitWriter writer(output);
+    writer.write_bits(1, 1);   // Final block.
+    writer.write_bits(1, 2);   // Fixed Huffman codes.
+
+    std::vector<int32_t> head(size_t(1) << DEFLATE_HASH_BITS, -1);
+    std::vector<int32_t> previous(DEFLATE_WINDOW_SIZE, -1);
+
+    auto hash = [data](size_t position) {
+        const uint32_t value = (data[position] << 16) | (data[position + 1] << 8) | data[position + 2];
+        return (value * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+    };
+
+    auto insert = [&](size_t position) {
+        if (position + DEFLATE_MIN_MATCH > size)
+            return;
+
+        const uint32_t h = hash(position);
+        previous[position & (DEFLATE_WINDOW_SIZE - 1)] = head[h];
+        head[h] = static_cast<int32_t>(position);
+    };
+
+    size_t position = 0;
+
+    while (position < size)
+    {
+        int best_length = 0;
+        int best_distance = 0;
+
+        if (position + DEFLATE_MIN_MATCH <= size)
+        {
+            const int max_length = static_cast<int>(std::min(size - position, static_cast<size_t>(DEFLATE_MAX_MATCH)));
+            int32_t candidate = head[hash(position)];
+
+            for (int chain = 0;
+                candidate >= 0 && position - candidate <= DEFLATE_WINDOW_SIZE && chain < DEFLATE_MAX_CHAIN;
+                ++chain)
+            {
+                const uint8_t* a = data + candidate;
+                const uint8_t* b = data + position;
+                int length = 0;
+
+                while (length < max_length && a[length] == b[length])
+                    ++length;
+
+                if (length > best_length)
+                {
+                    best_length = length;
+                    best_distance = static_cast<int>(position - candidate);
+
+                    if (length == max_length)
+                        break;
+                }
+
+                candidate = previous[candidate & (DEFLATE_WINDOW_SIZE - 1)];
+            }
+        }
+
+        if (best_length >= DEFLATE_MIN_MATCH)
+        {
+            write_match(writer, best_length, best_distance);
+
+            for (int i = 0; i < best_length; ++i)
+                insert(position + i);
+
+            position += best_length;
+        }
+        else
+        {
+            write_symbol(writer, data[position]);
+            insert(position);
+            ++position;
+        }
+    }
+
+    write_symbol(writer, 256);
+    writer.flush();
+
+    const uint32_t checksum = adler32(data, size);
+    output.push_back(static_cast<uint8_t>(checksum >> 24));
+    output.push_back(static_cast<uint8_t>(checksum >> 16));
+    output.push_back(static_cast<uint8_t>(checksum >> 8));
+    output.push_back(static_cast<uint8_t>(checksum));
+}
+
+inline uint8_t paeth_predictor(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+
+    if (pa <= pb && pa <= pc)
+        return static_cast<uint8_t>(a);
+    if (pb <= pc)
+        return static_cast<uint8_t>(b);
+    return static_cast<uint8_t>(c);
+}
+
+/** \brief Filter a row with each PNG filter and keep the one with the
+* smallest sum of absolute values.
+* \param[in] row The row.
+* \param[in] previous_row The row above, or null for the first row.
+* \param[in] row_size The row size, in bytes.
+* \param[out] output The filter type followed by the filtered row.
+*/
+void filter_row(const uint8_t* row, const uint8_t* previous_row, size_t row_size, uint8_t* output)
+{
+    std::vector<uint8_t> filtered(row_size);
+    uint64_t best_cost = UINT64_MAX;
+
+    for (uint8_t filter = 0; filter < 5; ++filter)
+    {
+        uint64_t cost = 0;
+
+        for (size_t i = 0; i < row_size; ++i)
+        {
+            const int a = i >= BYTES_PER_PIXEL ? row[i - BYTES_PER_PIXEL] : 0;
+            const int b = previous_row ? previous_row[i] : 0;
+            const int c = previous_row && i >= BYTES_PER_PIXEL ? previous_row[i - BYTES_PER_PIXEL] : 0;
+
+            uint8_t prediction = 0;
+            switch (filter)
+            {
+            case 1: prediction = static_cast<uint8_t>(a); break;
+            case 2: prediction = static_cast<uint8_t>(b); break;
+            case 3: prediction = static_cast<uint8_t>((a + b) / 2); break;
+            case 4: prediction = paeth_predictor(a, b, c); break;
+            }
+
+            filtered[i] = static_cast<uint8_t>(row[i] - prediction);
+            cost += std::abs(static_cast<int8_t>(filtered[i]));
+        }
+
+        if (cost < best_cost)
+        {
+            best_cost = cost;
+            output[0] = filter;
+            std::copy(filtered.begin(), filtered.end(), output + 1);
+        }
+    }
+}
+
+void append_uint32(std::vector<uint8_t>& output, uint32_t value)
+{
+    output.push_back(static_cast<uint8_t>(value >> 24));
+    output.push_back(static_cast<uint8_t>(value >> 16));
+    output.push_back(static_cast<uint8_t>(value >> 8));
+    output.push_back(static_cast<uint8_t>(value));
+}
+
+void append_chunk(std::vector<uint8_t>& output, const char* type, const std::vector<uint8_t>& data)
+{
+    append_uint32(output, static_cast<uint32_t>(data.size()));
+
+    const size_t type_offset = output.size();
+    output.insert(output.end(), type, type + 4);
+    output.insert(output.end(), data.begin(), data.end());
+
+    append_uint32(output, crc32(&output[type_offset], output.size() - type_offset));
+}
+
+}
+
+void encode_png(const Image& image, std::vector<uint8_t>& png)
+{
+    if (image.width == 0 || image.height == 0)
+        throw std::runtime_error("Cannot encode an empty image");
+
+    const size_t row_size = static_cast<size_t>(image.width) * BYTES_PER_PIXEL;
+
+    std::vector<uint8_t> filtered(image.height * (row_size + 1));
+
+    for (unsigned int y = 0; y < image.height; ++y)
+    {
+        filter_row(image.pixel(0, y),
+            y > 0 ? image.pixel(0, y - 1) : nullptr,
+            row_size,
+            &filtered[y * (row_size + 1)]);
+    }
+
+    png.clear();
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png.insert(png.end(), signature, signature + 8);
+
+    std::vector<uint8_t> header;
+    append_uint32(header, image.width);
+    append_uint32(header, image.height);
+    header.push_back(8);    // Bit depth.
+    header.push_back(6);    // RGBA.
+    header.push_back(0);    // Deflate.
+    header.push_back(0);    // Adaptive filtering.
+    header.push_back(0);    // No interlace.
+    append_chunk(png, "IHDR", header);
+
+    std::vector<uint8_t> compressed;
+    compressed.reserve(filtered.size() / 2);
+    zlib_compress(filtered.data(), filtered.size(), compressed);
+    append_chunk(png, "IDAT", compressed);
+
+    append_chunk(png, "IEND", std::vector<uint8_t>());
+}
+
+void write_png(const std::string& file_path, const Image& image)
+{
+    std::vector<uint8_t> png;
+    encode_png(image, png);
+
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        throw std::runtime_error("Failed to open \"" + file_path + "\" for writing");
+
+    file.write(reinterpret_cast<const char*>(png.data()), png.size());
+
+    if (!file)
+        throw std::runtime_error("Failed to write \"" + file_path + "\"");
+}
+
+}
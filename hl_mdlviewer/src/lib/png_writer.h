@@ -0,0 +1,34 @@
+/**
+* \file png_writer.h
+* \brief Declaration for the PNG writer functions.
+*/
+
+#ifndef HLMDLVIEWER_PNG_WRITER_H_
+#define HLMDLVIEWER_PNG_WRITER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "image.h"
+
+namespace hl_mdlviewer {
+
+/** \brief Encode an image as an 8 bit RGBA PNG.
+*
+* Rows are filtered with the PNG filter that minimizes the sum of absolute
+* differences, and compressed with fixed Huffman codes and a hash chain
+* match finder, which is enough for rendered images with flat backgrounds.
+* \param[in] image The image.
+* \param[out] png The PNG file data.
+*/
+void encode_png(const Image& image, std::vector<uint8_t>& png);
+
+/** \brief Encode an image as PNG and write it to a file.
+* \param[in] file_path The output file.
+* \param[in] image The image.
+*/
+void write_png(const std::string& file_path, const Image& image);
+
+}
+
+#endif // HLMDLVIEWER_PNG_WRITER_H_
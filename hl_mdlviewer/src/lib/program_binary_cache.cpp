@@ -0,0 +1,148 @@
+/**
+* \file program_binary_cache.cpp
+* \brief Implementation for the program binary cache class.
+*/
+
+#include "pch.h"
+#include "program_binary_cache.h"
+#include "content_hash.h"
+#include "render_backend.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace hl_mdlviewer {
+
+namespace {
+
+const char CACHE_FILE_MAGIC[4] = { 'H', 'L', 'P', 'B' };
+const uint32_t CACHE_FILE_VERSION = 1;
+
+/** Binaries are a few hundred KiB at most, anything larger is corrupt. */
+const uint64_t MAX_BINARY_SIZE = 64 * 1024 * 1024;
+
+template<typename T>
+bool read_value(std::istream& stream, T& value)
+{
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template<typename T>
+void write_value(std::ostream& stream, const T& value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}
+
+ProgramBinaryCache::ProgramBinaryCache() :
+    directory_(),
+    driver_hash_valid_(false),
+    driver_hash_(0),
+    num_loaded_(0),
+    num_stored_(0),
+    num_rejected_(0)
+{
+}
+
+uint64_t ProgramBinaryCache::get_driver_hash()
+{
+    if (!driver_hash_valid_)
+    {
+        RenderBackend& backend = render_backend();
+
+        uint64_t hash = FNV1A_64_OFFSET_BASIS;
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            // The separator keeps "ab" + "c" apart from "a" + "bc".
+            hash = hash_string_64(backend.get_string(name), hash);
+            hash = hash_bytes_64("", 1, hash);
+        }
+
+        driver_hash_ = hash;
+        driver_hash_valid_ = true;
+    }
+
+    return driver_hash_;
+}
+
+bool ProgramBinaryCache::load(uint64_t key, GLenum& format, std::vector<uint8_t>& binary)
+{
+    if (!enabled())
+        return false;
+
+    std::ifstream file(get_file_path(key), std::ios::binary);
+    if (!file)
+        return false;
+
+    char magic[4];
+    uint32_t version, file_format;
+    uint64_t size;
+    if (!file.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, CACHE_FILE_MAGIC, sizeof(magic)) != 0 ||
+        !read_value(file, version) || version != CACHE_FILE_VERSION ||
+        !read_value(file, file_format) ||
+        !read_value(file, size) || size == 0 || size > MAX_BINARY_SIZE)
+        return false;
+
+    std::vector<uint8_t> result(static_cast<size_t>(size));
+    if (!file.read(reinterpret_cast<char*>(result.data()), static_cast<std::streamsize>(size)))
+        return false;
+
+    format = static_cast<GLenum>(file_format);
+    binary = std::move(result);
+    ++num_loaded_;
+    return true;
+}
+
+bool ProgramBinaryCache::store(uint64_t key, GLenum format, const std::vector<uint8_t>& binary)
+{
+    if (!enabled() || binary.empty())
+        return false;
+
+    std::error_code error;
+    fs::create_directories(directory_, error);
+    if (error)
+        return false;
+
+    const std::string file_path = get_file_path(key);
+    const std::string temporary_path = file_path + ".tmp";
+
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        file.write(CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+        write_value(file, CACHE_FILE_VERSION);
+        write_value(file, static_cast<uint32_t>(format));
+        write_value(file, static_cast<uint64_t>(binary.size()));
+        file.write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(binary.size()));
+
+        if (!file)
+        {
+            file.close();
+            fs::remove(temporary_path, error);
+            return false;
+        }
+    }
+
+    fs::rename(temporary_path, file_path, error);
+    if (error)
+    {
+        fs::remove(temporary_path, error);
+        return false;
+    }
+
+    ++num_stored_;
+    return true;
+}
+
+std::string ProgramBinaryCache::get_file_path(uint64_t key) const
+{
+    return (fs::path(directory_) / (hash_to_string(key) + ".bin")).string();
+}
+
+}
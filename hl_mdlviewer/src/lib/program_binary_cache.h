@@ -0,0 +1,77 @@
+/**
+* \file program_binary_cache.h
+* \brief Declaration for the program binary cache class.
+*/
+
+#ifndef HLMDLVIEWER_PROGRAM_BINARY_CACHE_H_
+#define HLMDLVIEWER_PROGRAM_BINARY_CACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "glad.h"
+
+namespace hl_mdlviewer {
+
+/** \brief Keeps linked program binaries on disk, so that programs are not
+* compiled again on the next launch.
+*
+* Binaries only load on the driver that made them, so the keys cover the
+* vendor, renderer and version strings of the driver on top of the sources.
+* Like \ref TextureCache, entries are never invalidated.
+*/
+class ProgramBinaryCache
+{
+public:
+    ProgramBinaryCache();
+    ProgramBinaryCache(const ProgramBinaryCache&) = delete;
+
+    /** \brief Set the directory of the cache, created when first stored
+    *          to. An empty directory disables the cache. */
+    inline void set_directory(const std::string& directory) { directory_ = directory; }
+    inline const std::string& directory() const { return directory_; }
+
+    inline bool enabled() const { return !directory_.empty(); }
+
+    /** \brief Get the hash to start the key of a program with: the driver
+    *          identity. Queried from the render backend on first use. */
+    uint64_t get_driver_hash();
+
+    /** \brief Read a program binary.
+    * \param[in] key The hash of the driver and of the program sources.
+    * \param[out] format The format of the binary.
+    * \param[out] binary The binary.
+    * \return false if the program is not cached, or its file is invalid.
+    */
+    bool load(uint64_t key, GLenum& format, std::vector<uint8_t>& binary);
+
+    /** \brief Write a program binary, aside and renamed like
+    *          \ref TextureCache::store.
+    * \return false if the file could not be written.
+    */
+    bool store(uint64_t key, GLenum format, const std::vector<uint8_t>& binary);
+
+    /** \brief Count a binary rejected by the driver after being loaded. */
+    inline void on_binary_rejected() { ++num_rejected_; --num_loaded_; }
+
+    inline size_t num_loaded() const { return num_loaded_; }
+    inline size_t num_stored() const { return num_stored_; }
+    inline size_t num_rejected() const { return num_rejected_; }
+
+private:
+
+    std::string get_file_path(uint64_t key) const;
+
+    std::string directory_;
+
+    bool driver_hash_valid_;
+    uint64_t driver_hash_;
+
+    size_t num_loaded_;
+    size_t num_stored_;
+    size_t num_rejected_;
+};
+
+}
+
+#endif // HLMDLVIEWER_PROGRAM_BINARY_CACHE_H_
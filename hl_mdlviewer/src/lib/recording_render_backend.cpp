@@ -0,0 +1,647 @@
+/**
+* \file recording_render_backend.cpp
+* \brief Implementation for the recording render backend class.
+*/
+
+#include "pch.h"
+#include "recording_render_backend.h"
+#include <cstring>
+#include <sstream>
+
+namespace hl_mdlviewer
+{
+
+namespace {
+
+const char* const COMMAND_NAMES[RecordingRenderBackend::NUM_COMMANDS] = {
+    "create_buffer",
+    "delete_buffer",
+    "create_vertex_array",
+    "delete_vertex_array",
+    "create_texture",
+    "delete_texture",
+    "create_shader",
+    "delete_shader",
+    "create_program",
+    "delete_program",
+    "bind_buffer",
+    "bind_buffer_range",
+    "buffer_data",
+    "buffer_sub_data",
+    "buffer_storage",
+    "map_buffer_range",
+    "unmap_buffer",
+    "bind_vertex_array",
+    "enable_vertex_attrib_array",
+    "vertex_attrib_pointer",
+    "vertex_attrib_ipointer",
+    "active_texture",
+    "bind_texture",
+    "tex_parameter",
+    "tex_image_2d",
+    "compressed_tex_image_2d",
+    "tex_buffer",
+    "pixel_store",
+    "compile_shader",
+    "attach_shader",
+    "bind_attrib_location",
+    "program_parameter",
+    "link_program",
+    "program_binary",
+    "validate_program",
+    "use_program",
+    "uniform_block_binding",
+    "uniform_1i",
+    "uniform_1ui",
+    "uniform_1f",
+    "uniform_2fv",
+    "uniform_3fv",
+    "uniform_4fv",
+    "uniform_matrix_4fv",
+    "enable",
+    "disable",
+    "blend_func",
+    "depth_func",
+    "cull_face",
+    "polygon_mode",
+    "primitive_restart_index",
+    "draw_arrays",
+    "draw_elements",
+    "draw_elements_instanced",
+    "fence_sync",
+    "client_wait_sync",
+    "delete_sync"
+};
+
+/** \brief FNV-1a hash of \p size bytes. */
+uint32_t hash_bytes(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+inline uint32_t float_bits(GLfloat value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline uint32_t word(size_t value)
+{
+    return static_cast<uint32_t>(value);
+}
+
+}
+
+RecordingRenderBackend::RecordingRenderBackend() :
+    commands_(),
+    statistics_(),
+    last_name_(0),
+    bound_buffers_(),
+    buffer_stores_(),
+    uniform_locations_(),
+    uniform_block_indices_(),
+    attrib_locations_(),
+    shader_hashes_(),
+    attached_shaders_(),
+    integers_()
+{
+    // Typical limits of a desktop GL 3.3 implementation.
+    integers_[GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT] = 256;
+    integers_[GL_MAX_TEXTURE_BUFFER_SIZE] = 134217728;
+    integers_[GL_MAX_UNIFORM_BLOCK_SIZE] = 65536;
+    integers_[GL_MAX_TEXTURE_SIZE] = 16384;
+}
+
+RecordingRenderBackend::~RecordingRenderBackend()
+{
+}
+
+void RecordingRenderBackend::clear()
+{
+    commands_.clear();
+    statistics_ = RenderBackendStatistics();
+}
+
+std::string RecordingRenderBackend::to_string() const
+{
+    std::ostringstream stream;
+
+    size_t i = 0;
+    while (i < commands_.size())
+    {
+        const uint32_t header = commands_[i++];
+        const size_t num_arguments = header >> 8;
+
+        stream << command_name(static_cast<Command>(header & 0xFF));
+        for (size_t j = 0; j < num_arguments; ++j)
+            stream << ' ' << commands_[i++];
+        stream << '\n';
+    }
+
+    return stream.str();
+}
+
+const char* RecordingRenderBackend::command_name(Command command)
+{
+    return command < NUM_COMMANDS ? COMMAND_NAMES[command] : "unknown";
+}
+
+void RecordingRenderBackend::set_integer(GLenum name, GLint value)
+{
+    integers_[name] = value;
+}
+
+void RecordingRenderBackend::record(Command command, std::initializer_list<uint32_t> arguments)
+{
+    commands_.push_back(static_cast<uint32_t>(command) | word(arguments.size() << 8));
+    commands_.insert(commands_.end(), arguments.begin(), arguments.end());
+    ++statistics_.num_commands;
+}
+
+void RecordingRenderBackend::record_upload(Command command, std::initializer_list<uint32_t> arguments,
+    const void* data, size_t size)
+{
+    commands_.push_back(static_cast<uint32_t>(command) | word((arguments.size() + 2) << 8));
+    commands_.insert(commands_.end(), arguments.begin(), arguments.end());
+    commands_.push_back(word(size));
+    commands_.push_back(data ? hash_bytes(data, size) : 0);
+    ++statistics_.num_commands;
+
+    if (data)
+        statistics_.num_uploaded_bytes += size;
+}
+
+std::vector<unsigned char>& RecordingRenderBackend::bound_store(GLenum target)
+{
+    auto it = buffer_stores_.find(bound_buffers_[target]);
+    if (it == buffer_stores_.end())
+        throw std::runtime_error("No buffer bound to the target.");
+    return it->second;
+}
+
+GLuint RecordingRenderBackend::next_name()
+{
+    return ++last_name_;
+}
+
+GLuint RecordingRenderBackend::create_buffer()
+{
+    const GLuint buffer = next_name();
+    buffer_stores_[buffer];
+    record(CREATE_BUFFER, { buffer });
+    return buffer;
+}
+
+void RecordingRenderBackend::delete_buffer(GLuint buffer)
+{
+    buffer_stores_.erase(buffer);
+    record(DELETE_BUFFER, { buffer });
+}
+
+GLuint RecordingRenderBackend::create_vertex_array()
+{
+    const GLuint vertex_array = next_name();
+    record(CREATE_VERTEX_ARRAY, { vertex_array });
+    return vertex_array;
+}
+
+void RecordingRenderBackend::delete_vertex_array(GLuint vertex_array)
+{
+    record(DELETE_VERTEX_ARRAY, { vertex_array });
+}
+
+GLuint RecordingRenderBackend::create_texture()
+{
+    const GLuint texture = next_name();
+    record(CREATE_TEXTURE, { texture });
+    return texture;
+}
+
+void RecordingRenderBackend::delete_texture(GLuint texture)
+{
+    record(DELETE_TEXTURE, { texture });
+}
+
+GLuint RecordingRenderBackend::create_shader(GLenum type)
+{
+    const GLuint shader = next_name();
+    record(CREATE_SHADER, { shader, type });
+    return shader;
+}
+
+void RecordingRenderBackend::delete_shader(GLuint shader)
+{
+    shader_hashes_.erase(shader);
+    record(DELETE_SHADER, { shader });
+}
+
+GLuint RecordingRenderBackend::create_program()
+{
+    const GLuint program = next_name();
+    record(CREATE_PROGRAM, { program });
+    return program;
+}
+
+void RecordingRenderBackend::delete_program(GLuint program)
+{
+    uniform_locations_.erase(program);
+    uniform_block_indices_.erase(program);
+    attrib_locations_.erase(program);
+    attached_shaders_.erase(program);
+    record(DELETE_PROGRAM, { program });
+}
+
+void RecordingRenderBackend::bind_buffer(GLenum target, GLuint buffer)
+{
+    bound_buffers_[target] = buffer;
+    record(BIND_BUFFER, { target, buffer });
+    ++statistics_.num_bind_calls;
+}
+
+void RecordingRenderBackend::bind_buffer_range(GLenum target, GLuint index, GLuint buffer,
+    GLintptr offset, GLsizeiptr size)
+{
+    bound_buffers_[target] = buffer;
+    record(BIND_BUFFER_RANGE, { target, index, buffer, word(offset), word(size) });
+    ++statistics_.num_bind_calls;
+}
+
+void RecordingRenderBackend::buffer_data(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    std::vector<unsigned char>& store = bound_store(target);
+    store.assign(static_cast<size_t>(size), 0);
+    if (data)
+        std::memcpy(store.data(), data, static_cast<size_t>(size));
+
+    record_upload(BUFFER_DATA, { target, usage }, data, static_cast<size_t>(size));
+}
+
+void RecordingRenderBackend::buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    std::vector<unsigned char>& store = bound_store(target);
+    if (static_cast<size_t>(offset + size) > store.size())
+        throw std::runtime_error("Buffer sub data out of range.");
+    std::memcpy(store.data() + offset, data, static_cast<size_t>(size));
+
+    record_upload(BUFFER_SUB_DATA, { target, word(offset) }, data, static_cast<size_t>(size));
+}
+
+void RecordingRenderBackend::buffer_storage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+{
+    std::vector<unsigned char>& store = bound_store(target);
+    store.assign(static_cast<size_t>(size), 0);
+    if (data)
+        std::memcpy(store.data(), data, static_cast<size_t>(size));
+
+    record_upload(BUFFER_STORAGE, { target, flags }, data, static_cast<size_t>(size));
+}
+
+void* RecordingRenderBackend::map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    std::vector<unsigned char>& store = bound_store(target);
+    if (static_cast<size_t>(offset + length) > store.size())
+        return nullptr;
+
+    record(MAP_BUFFER_RANGE, { target, word(offset), word(length), access });
+    return store.data() + offset;
+}
+
+void RecordingRenderBackend::unmap_buffer(GLenum target)
+{
+    record(UNMAP_BUFFER, { target });
+}
+
+void RecordingRenderBackend::bind_vertex_array(GLuint vertex_array)
+{
+    record(BIND_VERTEX_ARRAY, { vertex_array });
+    ++statistics_.num_bind_calls;
+}
+
+void RecordingRenderBackend::enable_vertex_attrib_array(GLuint index)
+{
+    record(ENABLE_VERTEX_ATTRIB_ARRAY, { index });
+}
+
+void RecordingRenderBackend::vertex_attrib_pointer(GLuint index, GLint size, GLenum type,
+    GLboolean normalized, GLsizei stride, size_t offset)
+{
+    record(VERTEX_ATTRIB_POINTER, { index, word(size), type, normalized, word(stride), word(offset) });
+}
+
+void RecordingRenderBackend::vertex_attrib_ipointer(GLuint index, GLint size, GLenum type,
+    GLsizei stride, size_t offset)
+{
+    record(VERTEX_ATTRIB_IPOINTER, { index, word(size), type, word(stride), word(offset) });
+}
+
+void RecordingRenderBackend::active_texture(GLuint unit)
+{
+    record(ACTIVE_TEXTURE, { unit });
+    ++statistics_.num_bind_calls;
+}
+
+void RecordingRenderBackend::bind_texture(GLenum target, GLuint texture)
+{
+    record(BIND_TEXTURE, { target, texture });
+    ++statistics_.num_bind_calls;
+}
+
+void RecordingRenderBackend::tex_parameter(GLenum target, GLenum name, GLint value)
+{
+    record(TEX_PARAMETER, { target, name, word(value) });
+}
+
+void RecordingRenderBackend::tex_image_2d(GLenum target, GLint level, GLint internal_format,
+    GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+    // Only 8 bit components are uploaded by the viewer.
+    size_t components = 4;
+    switch (format)
+    {
+    case GL_RED: components = 1; break;
+    case GL_RG: components = 2; break;
+    case GL_RGB: components = 3; break;
+    default: break;
+    }
+
+    const size_t size = static_cast<size_t>(width) * height * components *
+        (type == GL_UNSIGNED_BYTE ? 1 : 4);
+
+    record_upload(TEX_IMAGE_2D,
+        { target, word(level), word(internal_format), word(width), word(height), format, type },
+        pixels, size);
+}
+
+void RecordingRenderBackend::compressed_tex_image_2d(GLenum target, GLint level, GLenum internal_format,
+    GLsizei width, GLsizei height, GLsizei size, const void* data)
+{
+    record_upload(COMPRESSED_TEX_IMAGE_2D,
+        { target, word(level), internal_format, word(width), word(height) },
+        data, static_cast<size_t>(size));
+}
+
+void RecordingRenderBackend::tex_buffer(GLenum target, GLenum internal_format, GLuint buffer)
+{
+    record(TEX_BUFFER, { target, internal_format, buffer });
+}
+
+void RecordingRenderBackend::pixel_store(GLenum name, GLint value)
+{
+    record(PIXEL_STORE, { name, word(value) });
+}
+
+void RecordingRenderBackend::compile_shader(GLuint shader, const std::string& source)
+{
+    shader_hashes_[shader] = hash_bytes(source.data(), source.size());
+    record_upload(COMPILE_SHADER, { shader }, source.data(), source.size());
+}
+
+bool RecordingRenderBackend::get_compile_status(GLuint shader, std::string& info_log)
+{
+    return true;
+}
+
+void RecordingRenderBackend::attach_shader(GLuint program, GLuint shader)
+{
+    attached_shaders_[program].push_back(shader);
+    record(ATTACH_SHADER, { program, shader });
+}
+
+void RecordingRenderBackend::bind_attrib_location(GLuint program, GLuint index, const char* name)
+{
+    attrib_locations_[program][name] = static_cast<GLint>(index);
+    record(BIND_ATTRIB_LOCATION, { program, index });
+}
+
+void RecordingRenderBackend::program_parameter(GLuint program, GLenum name, GLint value)
+{
+    record(PROGRAM_PARAMETER, { program, name, word(value) });
+}
+
+void RecordingRenderBackend::link_program(GLuint program)
+{
+    record(LINK_PROGRAM, { program });
+}
+
+bool RecordingRenderBackend::get_link_status(GLuint program, std::string& info_log)
+{
+    return true;
+}
+
+bool RecordingRenderBackend::has_parallel_shader_compile()
+{
+    return false;
+}
+
+bool RecordingRenderBackend::is_program_completed(GLuint program)
+{
+    return true;
+}
+
+bool RecordingRenderBackend::get_program_binary(GLuint program, GLenum& format, std::vector<uint8_t>& binary)
+{
+    std::vector<uint32_t> hashes;
+    for (GLuint shader : attached_shaders_[program])
+        hashes.push_back(shader_hashes_[shader]);
+
+    format = PROGRAM_BINARY_FORMAT;
+    binary.resize(hashes.size() * sizeof(uint32_t));
+    std::memcpy(binary.data(), hashes.data(), binary.size());
+    return !binary.empty();
+}
+
+bool RecordingRenderBackend::program_binary(GLuint program, GLenum format, const void* binary, GLsizei size)
+{
+    record_upload(PROGRAM_BINARY, { program, format }, binary, static_cast<size_t>(size));
+    return format == PROGRAM_BINARY_FORMAT && size > 0 && size % sizeof(uint32_t) == 0;
+}
+
+bool RecordingRenderBackend::validate_program(GLuint program, std::string& info_log)
+{
+    record(VALIDATE_PROGRAM, { program });
+    return true;
+}
+
+void RecordingRenderBackend::use_program(GLuint program)
+{
+    record(USE_PROGRAM, { program });
+    ++statistics_.num_bind_calls;
+}
+
+GLint RecordingRenderBackend::get_attrib_location(GLuint program, const char* name)
+{
+    const auto& locations = attrib_locations_[program];
+    auto it = locations.find(name);
+    return it != locations.end() ? it->second : -1;
+}
+
+GLint RecordingRenderBackend::get_uniform_location(GLuint program, const char* name)
+{
+    auto& locations = uniform_locations_[program];
+    return locations.emplace(name, static_cast<GLint>(locations.size())).first->second;
+}
+
+GLuint RecordingRenderBackend::get_uniform_block_index(GLuint program, const char* name)
+{
+    auto& indices = uniform_block_indices_[program];
+    return indices.emplace(name, static_cast<GLuint>(indices.size())).first->second;
+}
+
+void RecordingRenderBackend::uniform_block_binding(GLuint program, GLuint block_index, GLuint binding)
+{
+    record(UNIFORM_BLOCK_BINDING, { program, block_index, binding });
+}
+
+void RecordingRenderBackend::uniform_1i(GLint location, GLint value)
+{
+    record(UNIFORM_1I, { word(location), word(value) });
+    ++statistics_.num_uniform_calls;
+}
+
+void RecordingRenderBackend::uniform_1ui(GLint location, GLuint value)
+{
+    record(UNIFORM_1UI, { word(location), value });
+    ++statistics_.num_uniform_calls;
+}
+
+void RecordingRenderBackend::uniform_1f(GLint location, GLfloat value)
+{
+    record(UNIFORM_1F, { word(location), float_bits(value) });
+    ++statistics_.num_uniform_calls;
+}
+
+void RecordingRenderBackend::uniform_2fv(GLint location, const GLfloat* value)
+{
+    record(UNIFORM_2FV, { word(location), float_bits(value[0]), float_bits(value[1]) });
+    ++statistics_.num_uniform_calls;
+}
+
+void RecordingRenderBackend::uniform_3fv(GLint location, const GLfloat* value)
+{
+    record(UNIFORM_3FV, { word(location),
+        float_bits(value[0]), float_bits(value[1]), float_bits(value[2]) });
+    ++statistics_.num_uniform_calls;
+}
+
+void RecordingRenderBackend::uniform_4fv(GLint location, const GLfloat* value)
+{
+    record(UNIFORM_4FV, { word(location),
+        float_bits(value[0]), float_bits(value[1]), float_bits(value[2]), float_bits(value[3]) });
+    ++statistics_.num_uniform_calls;
+}
+
+void RecordingRenderBackend::uniform_matrix_4fv(GLint location, GLboolean transpose, const GLfloat* value)
+{
+    record_upload(UNIFORM_MATRIX_4FV, { word(location), transpose }, value, 16 * sizeof(GLfloat));
+    ++statistics_.num_uniform_calls;
+}
+
+void RecordingRenderBackend::enable(GLenum capability)
+{
+    record(ENABLE, { capability });
+    ++statistics_.num_state_calls;
+}
+
+void RecordingRenderBackend::disable(GLenum capability)
+{
+    record(DISABLE, { capability });
+    ++statistics_.num_state_calls;
+}
+
+void RecordingRenderBackend::blend_func(GLenum source_factor, GLenum destination_factor)
+{
+    record(BLEND_FUNC, { source_factor, destination_factor });
+    ++statistics_.num_state_calls;
+}
+
+void RecordingRenderBackend::depth_func(GLenum func)
+{
+    record(DEPTH_FUNC, { func });
+    ++statistics_.num_state_calls;
+}
+
+void RecordingRenderBackend::cull_face(GLenum mode)
+{
+    record(CULL_FACE, { mode });
+    ++statistics_.num_state_calls;
+}
+
+void RecordingRenderBackend::polygon_mode(GLenum face, GLenum mode)
+{
+    record(POLYGON_MODE, { face, mode });
+    ++statistics_.num_state_calls;
+}
+
+void RecordingRenderBackend::primitive_restart_index(GLuint index)
+{
+    record(PRIMITIVE_RESTART_INDEX, { index });
+    ++statistics_.num_state_calls;
+}
+
+void RecordingRenderBackend::draw_arrays(GLenum mode, GLint first, GLsizei count)
+{
+    record(DRAW_ARRAYS, { mode, word(first), word(count) });
+    ++statistics_.num_draw_calls;
+    ++statistics_.num_instances;
+    statistics_.num_indices += count;
+}
+
+void RecordingRenderBackend::draw_elements(GLenum mode, GLsizei count, GLenum type,
+    size_t offset, GLint base_vertex)
+{
+    record(DRAW_ELEMENTS, { mode, word(count), type, word(offset), word(base_vertex) });
+    ++statistics_.num_draw_calls;
+    ++statistics_.num_instances;
+    statistics_.num_indices += count;
+}
+
+void RecordingRenderBackend::draw_elements_instanced(GLenum mode, GLsizei count, GLenum type,
+    size_t offset, GLint base_vertex, GLsizei instance_count)
+{
+    record(DRAW_ELEMENTS_INSTANCED,
+        { mode, word(count), type, word(offset), word(base_vertex), word(instance_count) });
+    ++statistics_.num_draw_calls;
+    statistics_.num_instances += instance_count;
+    statistics_.num_indices += static_cast<size_t>(count) * instance_count;
+}
+
+GLsync RecordingRenderBackend::fence_sync()
+{
+    const GLuint fence = next_name();
+    record(FENCE_SYNC, { fence });
+    return reinterpret_cast<GLsync>(static_cast<uintptr_t>(fence));
+}
+
+GLenum RecordingRenderBackend::client_wait_sync(GLsync sync, GLbitfield flags, GLuint64 timeout_ns)
+{
+    // Nothing is ever pending.
+    record(CLIENT_WAIT_SYNC, { word(reinterpret_cast<uintptr_t>(sync)), flags });
+    return GL_ALREADY_SIGNALED;
+}
+
+void RecordingRenderBackend::delete_sync(GLsync sync)
+{
+    record(DELETE_SYNC, { word(reinterpret_cast<uintptr_t>(sync)) });
+}
+
+GLint RecordingRenderBackend::get_integer(GLenum name)
+{
+    auto it = integers_.find(name);
+    return it != integers_.end() ? it->second : 0;
+}
+
+std::string RecordingRenderBackend::get_string(GLenum name)
+{
+    return "Recording";
+}
+
+}
@@ -0,0 +1,243 @@
+/**
+* \file recording_render_backend.h
+* \brief Declaration for the recording render backend class.
+*/
+
+#ifndef HLMDLVIEWER_RECORDING_RENDER_BACKEND_H_
+#define HLMDLVIEWER_RECORDING_RENDER_BACKEND_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "render_backend.h"
+
+namespace hl_mdlviewer {
+
+/** \brief Counters of a recorded command stream. */
+struct RenderBackendStatistics
+{
+    size_t num_commands;
+    size_t num_draw_calls;
+    size_t num_instances;
+    size_t num_indices;
+    size_t num_bind_calls;
+    size_t num_state_calls;
+    size_t num_uniform_calls;
+
+    /** \brief The bytes passed to buffer and texture uploads. */
+    size_t num_uploaded_bytes;
+};
+
+/** \brief A render backend that needs no GPU and logs the commands it
+* receives.
+*
+* Each command is stored as one header word, holding the command and its
+* number of arguments, followed by its arguments. Uploaded data is stored
+* as its size and a hash of its content, so a stream only depends on what
+* was submitted and can be compared against a golden stream.
+*
+* Buffers have a CPU store, so that mapping them works. Programs always
+* compile, link and validate, and their uniforms are given locations in
+* the order they are first looked up. The binary of a program is the hashes
+* of its shader sources, and only such binaries are accepted back.
+*/
+class RecordingRenderBackend : public RenderBackend
+{
+public:
+    /** \brief The recorded commands. Queries are not recorded. */
+    enum Command
+    {
+        CREATE_BUFFER,
+        DELETE_BUFFER,
+        CREATE_VERTEX_ARRAY,
+        DELETE_VERTEX_ARRAY,
+        CREATE_TEXTURE,
+        DELETE_TEXTURE,
+        CREATE_SHADER,
+        DELETE_SHADER,
+        CREATE_PROGRAM,
+        DELETE_PROGRAM,
+        BIND_BUFFER,
+        BIND_BUFFER_RANGE,
+        BUFFER_DATA,
+        BUFFER_SUB_DATA,
+        BUFFER_STORAGE,
+        MAP_BUFFER_RANGE,
+        UNMAP_BUFFER,
+        BIND_VERTEX_ARRAY,
+        ENABLE_VERTEX_ATTRIB_ARRAY,
+        VERTEX_ATTRIB_POINTER,
+        VERTEX_ATTRIB_IPOINTER,
+        ACTIVE_TEXTURE,
+        BIND_TEXTURE,
+        TEX_PARAMETER,
+        TEX_IMAGE_2D,
+        COMPRESSED_TEX_IMAGE_2D,
+        TEX_BUFFER,
+        PIXEL_STORE,
+        COMPILE_SHADER,
+        ATTACH_SHADER,
+        BIND_ATTRIB_LOCATION,
+        PROGRAM_PARAMETER,
+        LINK_PROGRAM,
+        PROGRAM_BINARY,
+        VALIDATE_PROGRAM,
+        USE_PROGRAM,
+        UNIFORM_BLOCK_BINDING,
+        UNIFORM_1I,
+        UNIFORM_1UI,
+        UNIFORM_1F,
+        UNIFORM_2FV,
+        UNIFORM_3FV,
+        UNIFORM_4FV,
+        UNIFORM_MATRIX_4FV,
+        ENABLE,
+        DISABLE,
+        BLEND_FUNC,
+        DEPTH_FUNC,
+        CULL_FACE,
+        POLYGON_MODE,
+        PRIMITIVE_RESTART_INDEX,
+        DRAW_ARRAYS,
+        DRAW_ELEMENTS,
+        DRAW_ELEMENTS_INSTANCED,
+        FENCE_SYNC,
+        CLIENT_WAIT_SYNC,
+        DELETE_SYNC,
+        NUM_COMMANDS // Must be last.
+    };
+
+    /** \brief The format of the program binaries. */
+    static const GLenum PROGRAM_BINARY_FORMAT = 1;
+
+    RecordingRenderBackend();
+    ~RecordingRenderBackend();
+
+    inline const std::vector<uint32_t>& commands() const { return commands_; }
+    inline const RenderBackendStatistics& statistics() const { return statistics_; }
+
+    /** \brief Clear the recorded commands and statistics. Objects are kept. */
+    void clear();
+
+    /** \brief Get the recorded commands as text, one command per line. */
+    std::string to_string() const;
+
+    static const char* command_name(Command command);
+
+    /** \brief Set the value returned by \ref get_integer for \p name. */
+    void set_integer(GLenum name, GLint value);
+
+    GLuint create_buffer() override;
+    void delete_buffer(GLuint buffer) override;
+    GLuint create_vertex_array() override;
+    void delete_vertex_array(GLuint vertex_array) override;
+    GLuint create_texture() override;
+    void delete_texture(GLuint texture) override;
+    GLuint create_shader(GLenum type) override;
+    void delete_shader(GLuint shader) override;
+    GLuint create_program() override;
+    void delete_program(GLuint program) override;
+    void bind_buffer(GLenum target, GLuint buffer) override;
+    void bind_buffer_range(GLenum target, GLuint index, GLuint buffer, 
+        GLintptr offset, GLsizeiptr size) override;
+    void buffer_data(GLenum target, GLsizeiptr size, const void* data, GLenum usage) override;
+    void buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) override;
+    void buffer_storage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) override;
+    void* map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) override;
+    void unmap_buffer(GLenum target) override;
+    void bind_vertex_array(GLuint vertex_array) override;
+    void enable_vertex_attrib_array(GLuint index) override;
+    void vertex_attrib_pointer(GLuint index, GLint size, GLenum type,
+        GLboolean normalized, GLsizei stride, size_t offset) override;
+    void vertex_attrib_ipointer(GLuint index, GLint size, GLenum type,
+        GLsizei stride, size_t offset) override;
+    void active_texture(GLuint unit) override;
+    void bind_texture(GLenum target, GLuint texture) override;
+    void tex_parameter(GLenum target, GLenum name, GLint value) override;
+    void tex_image_2d(GLenum target, GLint level, GLint internal_format,
+        GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) override;
+    void compressed_tex_image_2d(GLenum target, GLint level, GLenum internal_format,
+        GLsizei width, GLsizei height, GLsizei size, const void* data) override;
+    void tex_buffer(GLenum target, GLenum internal_format, GLuint buffer) override;
+    void pixel_store(GLenum name, GLint value) override;
+    void compile_shader(GLuint shader, const std::string& source) override;
+    bool get_compile_status(GLuint shader, std::string& info_log) override;
+    void attach_shader(GLuint program, GLuint shader) override;
+    void bind_attrib_location(GLuint program, GLuint index, const char* name) override;
+    void program_parameter(GLuint program, GLenum name, GLint value) override;
+    void link_program(GLuint program) override;
+    bool get_link_status(GLuint program, std::string& info_log) override;
+    bool has_parallel_shader_compile() override;
+    bool is_program_completed(GLuint program) override;
+    bool get_program_binary(GLuint program, GLenum& format, std::vector<uint8_t>& binary) override;
+    bool program_binary(GLuint program, GLenum format, const void* binary, GLsizei size) override;
+    bool validate_program(GLuint program, std::string& info_log) override;
+    void use_program(GLuint program) override;
+    GLint get_attrib_location(GLuint program, const char* name) override;
+    GLint get_uniform_location(GLuint program, const char* name) override;
+    GLuint get_uniform_block_index(GLuint program, const char* name) override;
+    void uniform_block_binding(GLuint program, GLuint block_index, GLuint binding) override;
+    void uniform_1i(GLint location, GLint value) override;
+    void uniform_1ui(GLint location, GLuint value) override;
+    void uniform_1f(GLint location, GLfloat value) override;
+    void uniform_2fv(GLint location, const GLfloat* value) override;
+    void uniform_3fv(GLint location, const GLfloat* value) override;
+    void uniform_4fv(GLint location, const GLfloat* value) override;
+    void uniform_matrix_4fv(GLint location, GLboolean transpose, const GLfloat* value) override;
+    void enable(GLenum capability) override;
+    void disable(GLenum capability) override;
+    void blend_func(GLenum source_factor, GLenum destination_factor) override;
+    void depth_func(GLenum func) override;
+    void cull_face(GLenum mode) override;
+    void polygon_mode(GLenum face, GLenum mode) override;
+    void primitive_restart_index(GLuint index) override;
+    void draw_arrays(GLenum mode, GLint first, GLsizei count) override;
+    void draw_elements(GLenum mode, GLsizei count, GLenum type,
+        size_t offset, GLint base_vertex) override;
+    void draw_elements_instanced(GLenum mode, GLsizei count, GLenum type,
+        size_t offset, GLint base_vertex, GLsizei instance_count) override;
+    GLsync fence_sync() override;
+    GLenum client_wait_sync(GLsync sync, GLbitfield flags, GLuint64 timeout_ns) override;
+    void delete_sync(GLsync sync) override;
+    GLint get_integer(GLenum name) override;
+    std::string get_string(GLenum name) override;
+
+private:
+
+    void record(Command command, std::initializer_list<uint32_t> arguments);
+
+    /** \brief Record a command followed by the size and hash of \p data. */
+    void record_upload(Command command, std::initializer_list<uint32_t> arguments,
+        const void* data, size_t size);
+
+    std::vector<unsigned char>& bound_store(GLenum target);
+
+    GLuint next_name();
+
+    std::vector<uint32_t> commands_;
+    RenderBackendStatistics statistics_;
+
+    GLuint last_name_;
+
+    std::map<GLenum, GLuint> bound_buffers_;
+
+    /** \brief The CPU store of each buffer, by name. */
+    std::map<GLuint, std::vector<unsigned char>> buffer_stores_;
+
+    /** \brief The uniform locations of each program, by name. */
+    std::map<GLuint, std::map<std::string, GLint>> uniform_locations_;
+    std::map<GLuint, std::map<std::string, GLuint>> uniform_block_indices_;
+    std::map<GLuint, std::map<std::string, GLint>> attrib_locations_;
+
+    /** \brief The hash of the source of each shader, and the shaders
+    * attached to each program, for program binaries. */
+    std::map<GLuint, uint32_t> shader_hashes_;
+    std::map<GLuint, std::vector<GLuint>> attached_shaders_;
+
+    std::map<GLenum, GLint> integers_;
+};
+
+}
+
+#endif // HLMDLVIEWER_RECORDING_RENDER_BACKEND_H_
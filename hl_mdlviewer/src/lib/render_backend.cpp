@@ -0,0 +1,30 @@
+/**
+* \file render_backend.cpp
+* \brief Implementation for the render backend accessors.
+*/
+
+#include "pch.h"
+#include "render_backend.h"
+#include "opengl_render_backend.h"
+
+namespace hl_mdlviewer
+{
+
+namespace {
+
+OpenGLRenderBackend opengl_render_backend;
+RenderBackend* current_render_backend = &opengl_render_backend;
+
+}
+
+RenderBackend& render_backend()
+{
+    return *current_render_backend;
+}
+
+void set_render_backend(RenderBackend* backend)
+{
+    current_render_backend = backend ? backend : &opengl_render_backend;
+}
+
+}
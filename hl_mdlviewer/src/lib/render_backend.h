@@ -0,0 +1,185 @@
+/**
+* \file render_backend.h
+* \brief Declaration for the render backend interface.
+*/
+
+#ifndef HLMDLVIEWER_RENDER_BACKEND_H_
+#define HLMDLVIEWER_RENDER_BACKEND_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "glad.h"
+
+namespace hl_mdlviewer {
+
+/** \brief The commands the OpenGL wrappers submit.
+*
+* The interface mirrors the subset of OpenGL the wrappers use, so that
+* frame submission can run against something other than a GL context,
+* i.e. \ref RecordingRenderBackend. Object names, enums and offsets keep
+* their OpenGL meaning.
+*/
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() {}
+
+    virtual GLuint create_buffer() = 0;
+    virtual void delete_buffer(GLuint buffer) = 0;
+    virtual GLuint create_vertex_array() = 0;
+    virtual void delete_vertex_array(GLuint vertex_array) = 0;
+    virtual GLuint create_texture() = 0;
+    virtual void delete_texture(GLuint texture) = 0;
+    virtual GLuint create_shader(GLenum type) = 0;
+    virtual void delete_shader(GLuint shader) = 0;
+    virtual GLuint create_program() = 0;
+    virtual void delete_program(GLuint program) = 0;
+
+    virtual void bind_buffer(GLenum target, GLuint buffer) = 0;
+    virtual void bind_buffer_range(GLenum target, GLuint index, GLuint buffer,
+        GLintptr offset, GLsizeiptr size) = 0;
+    virtual void buffer_data(GLenum target, GLsizeiptr size, const void* data, GLenum usage) = 0;
+    virtual void buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) = 0;
+    virtual void buffer_storage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags) = 0;
+    virtual void* map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) = 0;
+    virtual void unmap_buffer(GLenum target) = 0;
+
+    virtual void bind_vertex_array(GLuint vertex_array) = 0;
+    virtual void enable_vertex_attrib_array(GLuint index) = 0;
+    virtual void vertex_attrib_pointer(GLuint index, GLint size, GLenum type,
+        GLboolean normalized, GLsizei stride, size_t offset) = 0;
+    virtual void vertex_attrib_ipointer(GLuint index, GLint size, GLenum type,
+        GLsizei stride, size_t offset) = 0;
+
+    virtual void active_texture(GLuint unit) = 0;
+    virtual void bind_texture(GLenum target, GLuint texture) = 0;
+    virtual void tex_parameter(GLenum target, GLenum name, GLint value) = 0;
+    virtual void tex_image_2d(GLenum target, GLint level, GLint internal_format,
+        GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) = 0;
+    virtual void compressed_tex_image_2d(GLenum target, GLint level, GLenum internal_format,
+        GLsizei width, GLsizei height, GLsizei size, const void* data) = 0;
+    virtual void tex_buffer(GLenum target, GLenum internal_format, GLuint buffer) = 0;
+    virtual void pixel_store(GLenum name, GLint value) = 0;
+
+    /** \brief Submit a shader for compilation. With
+    *          GL_KHR_parallel_shader_compile, the driver compiles it in the
+    *          background until its status is queried.
+    * \param[in] shader The shader.
+    * \param[in] source The shader source.
+    */
+    virtual void compile_shader(GLuint shader, const std::string& source) = 0;
+
+    /** \brief Wait for a shader to compile.
+    * \param[in] shader The shader.
+    * \param[out] info_log The compiler log, on failure.
+    * \return true if the shader compiled; false otherwise.
+    */
+    virtual bool get_compile_status(GLuint shader, std::string& info_log) = 0;
+    virtual void attach_shader(GLuint program, GLuint shader) = 0;
+    virtual void bind_attrib_location(GLuint program, GLuint index, const char* name) = 0;
+    virtual void program_parameter(GLuint program, GLenum name, GLint value) = 0;
+
+    /** \brief Submit a program for linking.
+    * \see compile_shader
+    */
+    virtual void link_program(GLuint program) = 0;
+
+    /** \brief Wait for a program to link.
+    * \see get_compile_status
+    */
+    virtual bool get_link_status(GLuint program, std::string& info_log) = 0;
+
+    /** \brief Whether shaders compile and programs link in the background,
+    *          with GL_KHR_parallel_shader_compile. Otherwise the driver may
+    *          compile them when their status is first queried.
+    */
+    virtual bool has_parallel_shader_compile() = 0;
+
+    /** \brief Check, without waiting, whether a program submitted with
+    *          \ref link_program finished linking.
+    * \return true if it did, or if \ref has_parallel_shader_compile is
+    *         false; false otherwise.
+    */
+    virtual bool is_program_completed(GLuint program) = 0;
+
+    /** \brief Get the binary of a linked program.
+    * \param[in] program The program.
+    * \param[out] format The driver specific format of the binary.
+    * \param[out] binary The binary.
+    * \return false if the driver cannot give program binaries.
+    */
+    virtual bool get_program_binary(GLuint program, GLenum& format, std::vector<uint8_t>& binary) = 0;
+
+    /** \brief Load a program from a binary given by \ref get_program_binary.
+    * \return false if the binary was rejected, i.e. by another driver.
+    *         The program must then be linked from its shaders.
+    */
+    virtual bool program_binary(GLuint program, GLenum format, const void* binary, GLsizei size) = 0;
+
+    /** \brief Validate a program against the current state.
+    * \see get_compile_status
+    */
+    virtual bool validate_program(GLuint program, std::string& info_log) = 0;
+    virtual void use_program(GLuint program) = 0;
+
+    virtual GLint get_attrib_location(GLuint program, const char* name) = 0;
+    virtual GLint get_uniform_location(GLuint program, const char* name) = 0;
+    virtual GLuint get_uniform_block_index(GLuint program, const char* name) = 0;
+    virtual void uniform_block_binding(GLuint program, GLuint block_index, GLuint binding) = 0;
+
+    virtual void uniform_1i(GLint location, GLint value) = 0;
+    virtual void uniform_1ui(GLint location, GLuint value) = 0;
+    virtual void uniform_1f(GLint location, GLfloat value) = 0;
+    virtual void uniform_2fv(GLint location, const GLfloat* value) = 0;
+    virtual void uniform_3fv(GLint location, const GLfloat* value) = 0;
+    virtual void uniform_4fv(GLint location, const GLfloat* value) = 0;
+    virtual void uniform_matrix_4fv(GLint location, GLboolean transpose, const GLfloat* value) = 0;
+
+    virtual void enable(GLenum capability) = 0;
+    virtual void disable(GLenum capability) = 0;
+    virtual void blend_func(GLenum source_factor, GLenum destination_factor) = 0;
+    virtual void depth_func(GLenum func) = 0;
+    virtual void cull_face(GLenum mode) = 0;
+    virtual void polygon_mode(GLenum face, GLenum mode) = 0;
+    virtual void primitive_restart_index(GLuint index) = 0;
+
+    virtual void draw_arrays(GLenum mode, GLint first, GLsizei count) = 0;
+
+    /** \brief Draw indexed primitives.
+    * \param[in] mode The primitive mode.
+    * \param[in] count The number of indices.
+    * \param[in] type The index type.
+    * \param[in] offset The offset of the first index, in bytes.
+    * \param[in] base_vertex The value added to each index.
+    */
+    virtual void draw_elements(GLenum mode, GLsizei count, GLenum type,
+        size_t offset, GLint base_vertex) = 0;
+    virtual void draw_elements_instanced(GLenum mode, GLsizei count, GLenum type,
+        size_t offset, GLint base_vertex, GLsizei instance_count) = 0;
+
+    virtual GLsync fence_sync() = 0;
+    virtual GLenum client_wait_sync(GLsync sync, GLbitfield flags, GLuint64 timeout_ns) = 0;
+    virtual void delete_sync(GLsync sync) = 0;
+
+    virtual GLint get_integer(GLenum name) = 0;
+
+    /** \brief Get a string of the implementation, i.e. GL_RENDERER. */
+    virtual std::string get_string(GLenum name) = 0;
+};
+
+/** \brief Get the backend the OpenGL wrappers submit to.
+* \return The current backend, \ref OpenGLRenderBackend by default.
+*/
+RenderBackend& render_backend();
+
+/** \brief Set the backend the OpenGL wrappers submit to.
+*
+* Objects must be created, used and deleted with the same backend.
+* \param[in] backend The backend, or nullptr for OpenGL.
+*/
+void set_render_backend(RenderBackend* backend);
+
+}
+
+#endif // HLMDLVIEWER_RENDER_BACKEND_H_
@@ -51,6 +51,44 @@ struct RenderViewSettings
     float zoom_step_sensitivity;
 };
 
+/** \brief Get the projection matrix of a viewport.
+* \param[in] settings The view settings.
+* \param[in] width The viewport width.
+* \param[in] height The viewport height.
+*/
+inline glm::mat4 get_projection_matrix(const RenderViewSettings& settings, int width, int height)
+{
+    return glm::perspectiveFov(
+        static_cast<float>(settings.fov_radians),
+        static_cast<float>(width),
+        static_cast<float>(height),
+        settings.znear,
+        settings.zfar);
+}
+
+/** \brief Get the view matrix, looking at the origin down the -Z axis.
+* \param[in] settings The view settings.
+* \param[in] pan The camera pan translation.
+*/
+inline glm::mat4 get_view_matrix(const RenderViewSettings& settings, const glm::vec2& pan)
+{
+    glm::mat4 v = glm::lookAt(
+        glm::vec3(0, 0, settings.zdistance),
+        glm::vec3(0, 0, 0),
+        glm::vec3(0, 1, 0));
+
+    // Apply pan to view matrix.
+    glm::mat4 p = glm::translate(glm::mat4(1.0f), glm::vec3(pan.x, pan.y, 0));
+
+    return p * v;
+}
+
+/** \brief Get the model matrix from the model angles, in radians. */
+inline glm::mat4 get_model_matrix(const glm::vec3& angles)
+{
+    return glm::eulerAngleXYZ(angles.x, angles.y, angles.z);
+}
+
 }
 
 #endif // HLMDLVIEWER_RENDER_VIEW_SETTINGS_H_
@@ -5,36 +5,126 @@
 
 #include "pch.h"
 #include "shader_parser.h"
-#include <iostream>
-#include <fstream>
+#include "content_hash.h"
+#include "mapped_file.h"
+#include <chrono>
 #include <filesystem>
 
 namespace fs = std::filesystem;
 
 namespace hl_mdlviewer {
 
+namespace {
+
+double get_elapsed_milliseconds(std::chrono::steady_clock::time_point start_time)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+}
+
 ShaderParser::ShaderParser(FileSystem* file_system) :
-    file_system_(file_system)
+    file_system_(file_system),
+    files_(),
+    sources_(),
+    statistics_()
+{
+}
+
+void ShaderParser::parse(
+    const std::string& file_path,
+    std::string& parsed_shader_string)
 {
+    expand(file_path, 0, parsed_shader_string);
 }
 
 void ShaderParser::parse(
     const std::string& file_path,
+    const Defines& defines,
     std::string& parsed_shader_string)
 {
+    // Room for the defines, so that injecting them does not reallocate.
+    size_t defines_size = 0;
+    for (const auto& define : defines)
+        defines_size += define.length() + 9;
+
+    expand(file_path, defines_size, parsed_shader_string);
+    inject_defines(defines, parsed_shader_string);
+}
+
+void ShaderParser::clear_cache()
+{
+    files_.clear();
+    sources_.clear();
+}
+
+void ShaderParser::expand(const std::string& file_path, size_t extra_size, std::string& parsed_shader_string)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
     std::set<std::string> files_already_included;
+    std::vector<Fragment> fragments;
+    uint64_t graph_hash = FNV1A_64_OFFSET_BASIS;
     parse_recursively(file_path,
-        files_already_included, 
-        parsed_shader_string);
+        files_already_included,
+        fragments,
+        graph_hash);
+
+    auto source = sources_.find(graph_hash);
+    if (source != sources_.end())
+    {
+        ++statistics_.num_sources_cached;
+    }
+    else
+    {
+        size_t size = 0;
+        for (const Fragment& fragment : fragments)
+            size += fragment.end - fragment.begin;
+
+        std::string expanded_source;
+        expanded_source.reserve(size);
+        for (const Fragment& fragment : fragments)
+            expanded_source.append(fragment.file->text, fragment.begin, fragment.end - fragment.begin);
+
+        source = sources_.emplace(graph_hash, std::move(expanded_source)).first;
+    }
+
+    parsed_shader_string.reserve(parsed_shader_string.length() + source->second.length() + extra_size);
+    parsed_shader_string += source->second;
+
+    ++statistics_.num_parses;
+    statistics_.parse_time += get_elapsed_milliseconds(start_time);
+}
+
+void ShaderParser::inject_defines(const Defines& defines, std::string& parsed_shader_string)
+{
+    if (defines.empty())
+        return;
+
+    std::string define_lines;
+    for (const auto& define : defines)
+        define_lines += "#define " + define + '\n';
+
+    // The #version directive must come first.
+    size_t pos = 0;
+    const size_t version_pos = parsed_shader_string.find("#version");
+    if (version_pos != std::string::npos)
+    {
+        pos = parsed_shader_string.find('\n', version_pos);
+        pos = pos != std::string::npos ? pos + 1 : parsed_shader_string.length();
+    }
+
+    parsed_shader_string.insert(pos, define_lines);
 }
 
 void ShaderParser::parse_recursively(
     const std::string& file_path,
     std::set<std::string>& files_already_included,
-    std::string& parsed_shader_string)
+    std::vector<Fragment>& fragments,
+    uint64_t& graph_hash)
 {
-    std::string file_path2;
-    if (!file_system_->find_file(file_path.c_str(), file_path2, FileSystem::SearchFlags::Recursive))
+    std::string full_file_path;
+    if (!file_system_->find_file(file_path.c_str(), full_file_path, FileSystem::SearchFlags::Recursive))
         throw std::runtime_error(("Failed to load shader file " + file_path + ". No such file exists.").c_str());
 
     if (files_already_included.count(file_path))
@@ -42,60 +132,103 @@ void ShaderParser::parse_recursively(
 
     files_already_included.insert(file_path);
 
-    std::ifstream ifs;
-    try
+    const std::shared_ptr<const ShaderFile> file = get_file(full_file_path, graph_hash);
+
+    // Includes are relative to the including file.
+    size_t position = 0;
+    for (const Include& include : file->includes)
+    {
+        if (include.position > position)
+            fragments.push_back({ file, position, include.position });
+        position = include.position;
+
+        parse_recursively(
+            fs::path(file_path)
+                .parent_path()
+                .append(include.file_name).string(),
+            files_already_included,
+            fragments,
+            graph_hash);
+    }
+
+    if (position < file->text.length())
+        fragments.push_back({ file, position, file->text.length() });
+}
+
+std::shared_ptr<const ShaderParser::ShaderFile> ShaderParser::get_file(const std::string& full_file_path, uint64_t& graph_hash)
+{
+    std::error_code error;
+    fs::path canonical_path = fs::weakly_canonical(full_file_path, error);
+    if (error)
+        canonical_path = full_file_path;
+
+    const fs::file_time_type write_time = fs::last_write_time(canonical_path, error);
+
+    // The expanded source depends on which files were included, and on
+    // their contents, as of their modification time.
+    const std::string key = canonical_path.string();
+    const auto write_time_count = write_time.time_since_epoch().count();
+    graph_hash = hash_string_64(key, graph_hash);
+    graph_hash = hash_bytes_64(&write_time_count, sizeof(write_time_count), graph_hash);
+
+    auto it = files_.find(key);
+    if (it != files_.end() && !error && it->second->write_time == write_time)
+        return it->second;
+
+    auto file = std::make_shared<ShaderFile>();
+    file->write_time = write_time;
+    read_file(full_file_path, *file);
+
+    files_[key] = file;
+    return file;
+}
+
+void ShaderParser::read_file(const std::string& full_file_path, ShaderFile& file)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const MappedFile mapped_file(full_file_path);
+    const char* data = reinterpret_cast<const char*>(mapped_file.data());
+    const size_t size = mapped_file.size();
+
+    file.text.reserve(size);
+
+    const std::string INCLUDE_STRING = "#include";
+
+    for (size_t begin = 0; begin < size; )
     {
-        ifs.open(fs::path(file_path2).string(), std::ios::in);
+        const char* line_end = std::find(data + begin, data + size, '\n');
+        const std::string line(data + begin, line_end);
+        begin = static_cast<size_t>(line_end - data) + 1;
+
+        // Skip the blank lines.
+        if (line.find_first_not_of(' ') == std::string::npos)
+            continue;
 
-        std::string line;
-        while (std::getline(ifs, line))
+        // Check for include files.
+        size_t pos = line.find(INCLUDE_STRING);
+        if (pos == std::string::npos)
         {
-            bool append_content = true;
-
-            if (line.find_first_not_of(' ') != std::string::npos)
-            {
-                // Check for include files.
-                const std::string INCLUDE_STRING = "#include";
-                size_t pos = line.find(INCLUDE_STRING);
-                if (pos != std::string::npos)
-                {
-                    append_content = false;
-
-                    pos = line.find_first_not_of(' ', pos + INCLUDE_STRING.length());
-                    if (pos != std::string::npos)
-                    {
-                        std::string token = line.substr(pos, line.length() - pos);
-                        std::string file_name = "";
-                        strip_quotes(token, file_name);
-
-                        parse_recursively(
-                            fs::path(file_path)
-                                .parent_path()
-                                .append(file_name).string(),
-                            files_already_included,
-                            parsed_shader_string);
-                    }
-                }
-            }
-            else
-            {
-                append_content = false;
-            }
-
-            if (append_content)
-            {
-                parsed_shader_string += line + '\n';
-            }
+            file.text += line;
+            file.text += '\n';
+            continue;
         }
 
-        ifs.close();
-    }
-    catch (const std::exception& e)
-    {
-        std::cerr << e.what() << std::endl;
-        ifs.close();
-        throw e;
+        pos = line.find_first_not_of(' ', pos + INCLUDE_STRING.length());
+        if (pos != std::string::npos)
+        {
+            std::string token = line.substr(pos, line.length() - pos);
+            std::string file_name = "";
+            strip_quotes(token, file_name);
+
+            file.includes.push_back({ file.text.length(), file_name });
+        }
     }
+
+    file.text.shrink_to_fit();
+
+    ++statistics_.num_files_read;
+    statistics_.read_time += get_elapsed_milliseconds(start_time);
 }
 
 void ShaderParser::strip_quotes(const std::string& token, std::string& result)
@@ -7,30 +7,139 @@
 #define HLMDLVIEWER_SHADER_PARSER_H_
 
 #include "file_system.h"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
 #include <string>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 namespace hl_mdlviewer {
 
+/** \brief The work done by a shader parser, to see what the shaders cost
+* at startup. Times are in milliseconds. */
+struct ShaderParserStatistics
+{
+    ShaderParserStatistics() :
+        num_parses(0),
+        num_files_read(0),
+        num_sources_cached(0),
+        read_time(0.0),
+        parse_time(0.0)
+    {
+    }
+
+    size_t num_parses;
+    size_t num_files_read;
+
+    /** The parses whose expanded source was cached. */
+    size_t num_sources_cached;
+
+    double read_time;
+
+    /** The total time of the parses, reads included. */
+    double parse_time;
+};
+
+/** \brief Expands the includes of shaders.
+*
+* Each file is read once, and kept split at its include directives. A file
+* is read again once its modification time changes. The expanded sources
+* are kept as well, by a hash of the files they were made of, so parsing
+* the same shader with other defines is only a copy.
+*/
 class ShaderParser
 {
 public:
     ShaderParser(FileSystem* file_system);
+    ShaderParser(const ShaderParser&) = delete;
 
+    using Defines = std::vector<std::string>;
+
+    void parse(
+        const std::string& file_path,
+        std::string& parsed_shader_string);
+
+    /** \brief Parse a shader and inject preprocessor definitions.
+    * \param[in] file_path The shader file path.
+    * \param[in] defines The names to define, right after the #version
+    *            directive, or at the top of the shader if it has none.
+    * \param[out] parsed_shader_string The parsed shader.
+    */
     void parse(
         const std::string& file_path,
+        const Defines& defines,
         std::string& parsed_shader_string);
 
+    /** \brief Forget the files read and the expanded sources. */
+    void clear_cache();
+
+    inline const ShaderParserStatistics& statistics() const { return statistics_; }
+
 protected:
+
+    struct Include
+    {
+        /** Where the included file goes in the text. */
+        size_t position;
+
+        /** The included file, relative to the including file. */
+        std::string file_name;
+    };
+
+    struct ShaderFile
+    {
+        std::filesystem::file_time_type write_time;
+
+        /** The lines of the file, without the include directives and the
+        * blank lines. */
+        std::string text;
+
+        std::vector<Include> includes;
+    };
+
+    /** \brief A part of the expanded source: a range of a file text. */
+    struct Fragment
+    {
+        std::shared_ptr<const ShaderFile> file;
+        size_t begin;
+        size_t end;
+    };
+
+    /** \brief Gather the fragments of a file and of its includes, in order. */
     void parse_recursively(
         const std::string& file_path,
         std::set<std::string>& files_already_included,
-        std::string& parsed_shader_string);
+        std::vector<Fragment>& fragments,
+        uint64_t& graph_hash);
 
     void strip_quotes(const std::string& token, std::string& result);
 
+    void inject_defines(const Defines& defines, std::string& parsed_shader_string);
+
 private:
+
+    /** \brief Expand a shader, reserving room for \p extra_size more bytes. */
+    void expand(const std::string& file_path, size_t extra_size, std::string& parsed_shader_string);
+
+    /** \brief Get a file from the cache, reading it if needed.
+    * \param[in] full_file_path The file on disk.
+    * \param[in, out] graph_hash The hash to continue with the file identity.
+    */
+    std::shared_ptr<const ShaderFile> get_file(const std::string& full_file_path, uint64_t& graph_hash);
+
+    void read_file(const std::string& full_file_path, ShaderFile& file);
+
     FileSystem* file_system_;
+
+    /** \brief The files read, by canonical path. */
+    std::unordered_map<std::string, std::shared_ptr<const ShaderFile>> files_;
+
+    /** \brief The expanded sources, by the hash of their include graph. */
+    std::unordered_map<uint64_t, std::string> sources_;
+
+    ShaderParserStatistics statistics_;
 };
 
 }
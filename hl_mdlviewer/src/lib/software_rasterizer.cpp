@@ -0,0 +1,656 @@
+/**
+* \file software_rasterizer.cpp
+* \brief Implementation for the software rasterizer class.
+*/
+
+#include "pch.h"
+#include "software_rasterizer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HLMDLVIEWER_RASTERIZER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace hl_mdlviewer {
+
+namespace {
+
+const int SUBPIXEL_SCALE = 16;
+
+/** \brief The guard band, in multiples of the viewport half size.
+* Triangles are only clipped in x and y when they leave it, which keeps
+* the fixed point coordinates well within 32 bits. */
+const float GUARD_BAND = 3.0f;
+
+const int NUM_CLIP_PLANES = 6;
+
+/** \brief The largest polygon clipping a triangle can produce. */
+const size_t MAX_CLIPPED_VERTICES = 3 + NUM_CLIP_PLANES;
+
+/** \brief Get the signed distance of a clip space position to a clip
+* plane, positive inside. */
+inline float clip_distance(const glm::vec4& p, int plane)
+{
+    switch (plane)
+    {
+    case 0: return p.w + p.z;
+    case 1: return p.w - p.z;
+    case 2: return GUARD_BAND * p.w + p.x;
+    case 3: return GUARD_BAND * p.w - p.x;
+    case 4: return GUARD_BAND * p.w + p.y;
+    default: return GUARD_BAND * p.w - p.y;
+    }
+}
+
+inline bool is_inside(const RasterVertex& vertex)
+{
+    for (int plane = 0; plane < NUM_CLIP_PLANES; ++plane)
+    {
+        if (clip_distance(vertex.position, plane) < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+inline RasterVertex lerp_vertex(const RasterVertex& a, const RasterVertex& b, float t)
+{
+    RasterVertex result;
+    result.position = a.position + (b.position - a.position) * t;
+    result.uv = a.uv + (b.uv - a.uv) * t;
+    result.intensity = a.intensity + (b.intensity - a.intensity) * t;
+    return result;
+}
+
+/** \brief Clip a convex polygon against a plane, Sutherland-Hodgman style.
+* \return The number of vertices written to \p output.
+*/
+size_t clip_polygon(const RasterVertex* input, size_t num_vertices, RasterVertex* output, int plane)
+{
+    size_t num_output = 0;
+
+    for (size_t i = 0; i < num_vertices; ++i)
+    {
+        const RasterVertex& current = input[i];
+        const RasterVertex& next = input[(i + 1) % num_vertices];
+
+        const float current_distance = clip_distance(current.position, plane);
+        const float next_distance = clip_distance(next.position, plane);
+
+        if (current_distance >= 0.0f)
+            output[num_output++] = current;
+
+        if ((current_distance >= 0.0f) != (next_distance >= 0.0f))
+        {
+            const float t = current_distance / (current_distance - next_distance);
+            output[num_output++] = lerp_vertex(current, next, t);
+        }
+    }
+
+    return num_output;
+}
+
+inline int64_t floor_div(int64_t a, int64_t b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+inline uint8_t to_unorm8(float value)
+{
+    return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 255.0f) + 0.5f);
+}
+
+/** \brief Sample a texture with clamp to edge addressing.
+* \param[out] texel The RGBA texel, in [0, 255].
+*/
+void sample_texture(const Image& texture, float u, float v, bool bilinear, float* texel)
+{
+    const int width = static_cast<int>(texture.width);
+    const int height = static_cast<int>(texture.height);
+
+    if (!bilinear)
+    {
+        const int x = clamp(static_cast<int>(std::floor(u * width)), 0, width - 1);
+        const int y = clamp(static_cast<int>(std::floor(v * height)), 0, height - 1);
+        const uint8_t* p = texture.pixel(x, y);
+
+        for (int i = 0; i < 4; ++i)
+            texel[i] = p[i];
+
+        return;
+    }
+
+    const float tx = u * width - 0.5f;
+    const float ty = v * height - 0.5f;
+    const float fx = std::floor(tx);
+    const float fy = std::floor(ty);
+    const float wx = tx - fx;
+    const float wy = ty - fy;
+
+    const int x0 = clamp(static_cast<int>(fx), 0, width - 1);
+    const int y0 = clamp(static_cast<int>(fy), 0, height - 1);
+    const int x1 = clamp(static_cast<int>(fx) + 1, 0, width - 1);
+    const int y1 = clamp(static_cast<int>(fy) + 1, 0, height - 1);
+
+    const uint8_t* p00 = texture.pixel(x0, y0);
+    const uint8_t* p10 = texture.pixel(x1, y0);
+    const uint8_t* p01 = texture.pixel(x0, y1);
+    const uint8_t* p11 = texture.pixel(x1, y1);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        const float top = p00[i] + (p10[i] - p00[i]) * wx;
+        const float bottom = p01[i] + (p11[i] - p01[i]) * wx;
+        texel[i] = top + (bottom - top) * wy;
+    }
+}
+
+}
+
+SoftwareRasterizer::SoftwareRasterizer(ThreadPool* thread_pool) :
+    thread_pool_(thread_pool),
+    color_buffer_(),
+    depth_buffer_(),
+    num_tiles_x_(0),
+    num_tiles_y_(0),
+    triangles_(),
+    materials_(),
+    bins_(),
+    tile_fragments_(),
+    statistics_()
+{
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+}
+
+void SoftwareRasterizer::resize(unsigned int width, unsigned int height)
+{
+    if (width == 0 || height == 0 || width > MAX_SIZE || height > MAX_SIZE)
+        throw std::runtime_error("Invalid software rasterizer size " +
+            std::to_string(width) + "x" + std::to_string(height));
+
+    color_buffer_ = Image(width, height);
+    depth_buffer_.assign(static_cast<size_t>(width) * height, 1.0f);
+
+    num_tiles_x_ = (width + TILE_SIZE - 1) / TILE_SIZE;
+    num_tiles_y_ = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    triangles_.clear();
+    materials_.clear();
+    bins_.assign(num_tiles_x_ * num_tiles_y_, std::vector<uint32_t>());
+    tile_fragments_.assign(bins_.size(), 0);
+}
+
+void SoftwareRasterizer::clear(const glm::vec4& color, float depth)
+{
+    const uint8_t rgba[4] = {
+        to_unorm8(color.x * 255.0f),
+        to_unorm8(color.y * 255.0f),
+        to_unorm8(color.z * 255.0f),
+        to_unorm8(color.w * 255.0f) };
+
+    for (size_t i = 0; i < color_buffer_.pixels.size(); i += 4)
+        std::copy(rgba, rgba + 4, &color_buffer_.pixels[i]);
+
+    std::fill(depth_buffer_.begin(), depth_buffer_.end(), depth);
+
+    statistics_ = RasterStatistics();
+}
+
+void SoftwareRasterizer::draw_triangles(const RasterVertex* vertices,
+    const unsigned int* indices,
+    size_t num_indices,
+    const RasterMaterial& material)
+{
+    if (color_buffer_.pixels.empty())
+        throw std::runtime_error("The software rasterizer must be resized before drawing");
+
+    const uint32_t material_index = static_cast<uint32_t>(materials_.size());
+    materials_.push_back(material);
+
+    RasterVertex polygon[MAX_CLIPPED_VERTICES];
+    RasterVertex clipped[MAX_CLIPPED_VERTICES];
+
+    for (size_t i = 0; i + 2 < num_indices; i += 3)
+    {
+        ++statistics_.num_submitted_triangles;
+
+        const RasterVertex& v0 = vertices[indices[i]];
+        const RasterVertex& v1 = vertices[indices[i + 1]];
+        const RasterVertex& v2 = vertices[indices[i + 2]];
+
+        if (is_inside(v0) && is_inside(v1) && is_inside(v2))
+        {
+            setup_triangle(v0, v1, v2, material, material_index);
+            continue;
+        }
+
+        polygon[0] = v0;
+        polygon[1] = v1;
+        polygon[2] = v2;
+        size_t num_vertices = 3;
+
+        for (int plane = 0; plane < NUM_CLIP_PLANES && num_vertices >= 3; ++plane)
+        {
+            num_vertices = clip_polygon(polygon, num_vertices, clipped, plane);
+            std::copy(clipped, clipped + num_vertices, polygon);
+        }
+
+        // Fan triangulation keeps the winding of the source triangle.
+        for (size_t j = 1; j + 1 < num_vertices; ++j)
+            setup_triangle(polygon[0], polygon[j], polygon[j + 1], material, material_index);
+    }
+}
+
+void SoftwareRasterizer::setup_triangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2,
+    const RasterMaterial& material, uint32_t material_index)
+{
+    const RasterVertex* vertices[3] = { &v0, &v1, &v2 };
+
+    const float width = static_cast<float>(color_buffer_.width);
+    const float height = static_cast<float>(color_buffer_.height);
+
+    // Window coordinates, with y pointing down, in sub-pixel units.
+    int64_t x[3], y[3];
+    float inv_w[3], depth[3];
+
+    for (int i = 0; i < 3; ++i)
+    {
+        const glm::vec4& p = vertices[i]->position;
+
+        if (p.w <= 0.0f)
+            return;
+
+        inv_w[i] = 1.0f / p.w;
+
+        const float window_x = (p.x * inv_w[i] * 0.5f + 0.5f) * width;
+        const float window_y = (0.5f - p.y * inv_w[i] * 0.5f) * height;
+
+        x[i] = static_cast<int64_t>(std::floor(window_x * SUBPIXEL_SCALE + 0.5f));
+        y[i] = static_cast<int64_t>(std::floor(window_y * SUBPIXEL_SCALE + 0.5f));
+        depth[i] = clamp(p.z * inv_w[i] * 0.5f + 0.5f, 0.0f, 1.0f);
+    }
+
+    int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+
+    if (area == 0)
+        return;
+
+    // As y points down, counter-clockwise front faces have a negative area.
+    if ((material.cull_mode == RasterCullMode::FRONT && area < 0) ||
+        (material.cull_mode == RasterCullMode::BACK && area > 0))
+        return;
+
+    if (area < 0)
+    {
+        std::swap(vertices[1], vertices[2]);
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(inv_w[1], inv_w[2]);
+        std::swap(depth[1], depth[2]);
+        area = -area;
+    }
+
+    Triangle triangle;
+
+    // The pixels whose centers are within the sub-pixel bounding box.
+    const int64_t min_x = std::min(x[0], std::min(x[1], x[2]));
+    const int64_t max_x = std::max(x[0], std::max(x[1], x[2]));
+    const int64_t min_y = std::min(y[0], std::min(y[1], y[2]));
+    const int64_t max_y = std::max(y[0], std::max(y[1], y[2]));
+
+    triangle.min_x = static_cast<int>(std::max<int64_t>(
+        floor_div(min_x - SUBPIXEL_SCALE / 2 + SUBPIXEL_SCALE - 1, SUBPIXEL_SCALE), 0));
+    triangle.min_y = static_cast<int>(std::max<int64_t>(
+        floor_div(min_y - SUBPIXEL_SCALE / 2 + SUBPIXEL_SCALE - 1, SUBPIXEL_SCALE), 0));
+    triangle.max_x = static_cast<int>(std::min<int64_t>(
+        floor_div(max_x - SUBPIXEL_SCALE / 2, SUBPIXEL_SCALE), color_buffer_.width - 1));
+    triangle.max_y = static_cast<int>(std::min<int64_t>(
+        floor_div(max_y - SUBPIXEL_SCALE / 2, SUBPIXEL_SCALE), color_buffer_.height - 1));
+
+    if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y)
+        return;
+
+    // Edge i goes from vertex i to vertex i + 1, and is positive inside.
+    for (int i = 0; i < 3; ++i)
+    {
+        const int j = (i + 1) % 3;
+        Edge& edge = triangle.edges[i];
+
+        edge.a = y[i] - y[j];
+        edge.b = x[j] - x[i];
+        edge.c = (y[j] - y[i]) * x[i] - (x[j] - x[i]) * y[i];
+
+        // Top-left fill rule: pixel centers exactly on other edges are
+        // left to the adjacent triangle.
+        const bool top_left = edge.a > 0 || (edge.a == 0 && edge.b > 0);
+
+        if (!top_left)
+            edge.c -= 1;
+    }
+
+    // The barycentric weight of vertex i is the edge opposite to it, over
+    // the area, evaluated at pixel centers relative to the bounding box.
+    double weight_dx[3], weight_dy[3], weight_c[3];
+    const double origin_x = static_cast<double>(triangle.min_x) * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2;
+    const double origin_y = static_cast<double>(triangle.min_y) * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        const int a = (i + 1) % 3;
+        const int b = (i + 2) % 3;
+        const double edge_a = static_cast<double>(y[a] - y[b]);
+        const double edge_b = static_cast<double>(x[b] - x[a]);
+        const double edge_c = static_cast<double>((y[b] - y[a]) * x[a] - (x[b] - x[a]) * y[a]);
+
+        weight_dx[i] = edge_a * SUBPIXEL_SCALE / area;
+        weight_dy[i] = edge_b * SUBPIXEL_SCALE / area;
+        weight_c[i] = (edge_a * origin_x + edge_b * origin_y + edge_c) / area;
+    }
+
+    auto make_plane = [&](float f0, float f1, float f2) {
+        const float f[3] = { f0, f1, f2 };
+        Plane plane = { 0.0f, 0.0f, 0.0f };
+        double dx = 0.0, dy = 0.0, c = 0.0;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            dx += weight_dx[i] * f[i];
+            dy += weight_dy[i] * f[i];
+            c += weight_c[i] * f[i];
+        }
+
+        plane.dx = static_cast<float>(dx);
+        plane.dy = static_cast<float>(dy);
+        plane.c = static_cast<float>(c);
+        return plane;
+    };
+
+    triangle.depth = make_plane(depth[0], depth[1], depth[2]);
+    triangle.inv_w = make_plane(inv_w[0], inv_w[1], inv_w[2]);
+    triangle.u_over_w = make_plane(
+        vertices[0]->uv.x * inv_w[0], vertices[1]->uv.x * inv_w[1], vertices[2]->uv.x * inv_w[2]);
+    triangle.v_over_w = make_plane(
+        vertices[0]->uv.y * inv_w[0], vertices[1]->uv.y * inv_w[1], vertices[2]->uv.y * inv_w[2]);
+    triangle.intensity_over_w = make_plane(
+        vertices[0]->intensity * inv_w[0], vertices[1]->intensity * inv_w[1], vertices[2]->intensity * inv_w[2]);
+
+    triangle.material = material_index;
+    triangle.magnified = false;
+
+    if (material.texture)
+    {
+        // The filter is chosen per triangle, from the texels covered by a
+        // pixel on average: GL_LINEAR when magnified, GL_NEAREST otherwise.
+        const glm::vec2 duv1 = vertices[1]->uv - vertices[0]->uv;
+        const glm::vec2 duv2 = vertices[2]->uv - vertices[0]->uv;
+        const double texel_area = std::abs(static_cast<double>(duv1.x) * duv2.y - static_cast<double>(duv1.y) * duv2.x) *
+            material.texture->width * material.texture->height;
+        const double pixel_area = static_cast<double>(area) / (SUBPIXEL_SCALE * SUBPIXEL_SCALE);
+
+        triangle.magnified = texel_area < pixel_area;
+    }
+
+    const uint32_t triangle_index = static_cast<uint32_t>(triangles_.size());
+    triangles_.push_back(triangle);
+    ++statistics_.num_rasterized_triangles;
+
+    bin_triangle(triangles_.back(), triangle_index);
+}
+
+void SoftwareRasterizer::bin_triangle(const Triangle& triangle, uint32_t triangle_index)
+{
+    const int first_tile_x = triangle.min_x / TILE_SIZE;
+    const int last_tile_x = triangle.max_x / TILE_SIZE;
+    const int first_tile_y = triangle.min_y / TILE_SIZE;
+    const int last_tile_y = triangle.max_y / TILE_SIZE;
+
+    for (int tile_y = first_tile_y; tile_y <= last_tile_y; ++tile_y)
+    {
+        for (int tile_x = first_tile_x; tile_x <= last_tile_x; ++tile_x)
+        {
+            bins_[tile_y * num_tiles_x_ + tile_x].push_back(triangle_index);
+            ++statistics_.num_binned_triangles;
+        }
+    }
+}
+
+void SoftwareRasterizer::flush()
+{
+    if (thread_pool_ && bins_.size() > 1)
+    {
+        thread_pool_->parallel_for(bins_.size(), [this](size_t index, size_t) {
+            rasterize_tile(index);
+        });
+    }
+    else
+    {
+        for (size_t i = 0; i < bins_.size(); ++i)
+            rasterize_tile(i);
+    }
+
+    for (size_t i = 0; i < bins_.size(); ++i)
+    {
+        statistics_.num_shaded_fragments += tile_fragments_[i];
+        tile_fragments_[i] = 0;
+        bins_[i].clear();
+    }
+
+    triangles_.clear();
+    materials_.clear();
+}
+
+void SoftwareRasterizer::rasterize_tile(size_t tile_index)
+{
+    const int tile_x = static_cast<int>(tile_index % num_tiles_x_) * TILE_SIZE;
+    const int tile_y = static_cast<int>(tile_index / num_tiles_x_) * TILE_SIZE;
+    const int tile_max_x = std::min(tile_x + TILE_SIZE, static_cast<int>(color_buffer_.width)) - 1;
+    const int tile_max_y = std::min(tile_y + TILE_SIZE, static_cast<int>(color_buffer_.height)) - 1;
+
+    size_t num_fragments = 0;
+
+    for (uint32_t triangle_index : bins_[tile_index])
+    {
+        const Triangle& triangle = triangles_[triangle_index];
+        const RasterMaterial& material = materials_[triangle.material];
+
+        const int x0 = std::max(tile_x, triangle.min_x);
+        const int y0 = std::max(tile_y, triangle.min_y);
+        const int x1 = std::min(tile_max_x, triangle.max_x);
+        const int y1 = std::min(tile_max_y, triangle.max_y);
+
+        // Classify the edges against the pixel centers of the rectangle:
+        // edges that contain all of them need not be evaluated.
+        const int64_t corner_x[2] = {
+            static_cast<int64_t>(x0) * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2,
+            static_cast<int64_t>(x1) * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2 };
+        const int64_t corner_y[2] = {
+            static_cast<int64_t>(y0) * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2,
+            static_cast<int64_t>(y1) * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2 };
+
+        int32_t row_value[3];
+        int32_t step_x[3];
+        int32_t step_y[3];
+        int num_active_edges = 0;
+        bool rejected = false;
+
+        for (const Edge& edge : triangle.edges)
+        {
+            int64_t min_value = INT64_MAX;
+            int64_t max_value = INT64_MIN;
+
+            for (int64_t cy : corner_y)
+            {
+                for (int64_t cx : corner_x)
+                {
+                    const int64_t value = edge.at(cx, cy);
+                    min_value = std::min(min_value, value);
+                    max_value = std::max(max_value, value);
+                }
+            }
+
+            if (max_value < 0)
+            {
+                rejected = true;
+                break;
+            }
+
+            if (min_value >= 0)
+                continue;
+
+            // The guard band bounds the values to 32 bits within a tile.
+            row_value[num_active_edges] = static_cast<int32_t>(edge.at(corner_x[0], corner_y[0]));
+            step_x[num_active_edges] = static_cast<int32_t>(edge.a * SUBPIXEL_SCALE);
+            step_y[num_active_edges] = static_cast<int32_t>(edge.b * SUBPIXEL_SCALE);
+            ++num_active_edges;
+        }
+
+        if (rejected)
+            continue;
+
+        if (num_active_edges == 0)
+        {
+            for (int y = y0; y <= y1; ++y)
+            {
+                for (int x = x0; x <= x1; ++x)
+                    shade_fragment(triangle, material, x, y);
+            }
+
+            num_fragments += static_cast<size_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+            continue;
+        }
+
+        for (int y = y0; y <= y1; ++y)
+        {
+#ifdef HLMDLVIEWER_RASTERIZER_SSE2
+            __m128i values[3];
+            __m128i steps[3];
+
+            for (int i = 0; i < num_active_edges; ++i)
+            {
+                values[i] = _mm_add_epi32(_mm_set1_epi32(row_value[i]),
+                    _mm_setr_epi32(0, step_x[i], step_x[i] * 2, step_x[i] * 3));
+                steps[i] = _mm_set1_epi32(step_x[i] * 4);
+            }
+
+            for (int x = x0; x <= x1; x += 4)
+            {
+                // A lane is outside when any of its edge values is negative.
+                __m128i outside = values[0];
+
+                for (int i = 1; i < num_active_edges; ++i)
+                    outside = _mm_or_si128(outside, values[i]);
+
+                unsigned int covered = ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xf;
+
+                if (x1 - x < 3)
+                    covered &= (1u << (x1 - x + 1)) - 1;
+
+                while (covered)
+                {
+                    const int lane = covered & 1 ? 0 : covered & 2 ? 1 : covered & 4 ? 2 : 3;
+                    covered &= covered - 1;
+                    shade_fragment(triangle, material, x + lane, y);
+                    ++num_fragments;
+                }
+
+                for (int i = 0; i < num_active_edges; ++i)
+                    values[i] = _mm_add_epi32(values[i], steps[i]);
+            }
+#else
+            int32_t values[3];
+            std::copy(row_value, row_value + num_active_edges, values);
+
+            for (int x = x0; x <= x1; ++x)
+            {
+                int32_t outside = values[0];
+
+                for (int i = 1; i < num_active_edges; ++i)
+                    outside |= values[i];
+
+                if (outside >= 0)
+                {
+                    shade_fragment(triangle, material, x, y);
+                    ++num_fragments;
+                }
+
+                for (int i = 0; i < num_active_edges; ++i)
+                    values[i] += step_x[i];
+            }
+#endif
+
+            for (int i = 0; i < num_active_edges; ++i)
+                row_value[i] += step_y[i];
+        }
+    }
+
+    tile_fragments_[tile_index] = num_fragments;
+}
+
+void SoftwareRasterizer::shade_fragment(const Triangle& triangle, const RasterMaterial& material, int x, int y)
+{
+    const float fx = static_cast<float>(x - triangle.min_x);
+    const float fy = static_cast<float>(y - triangle.min_y);
+    const size_t index = static_cast<size_t>(y) * color_buffer_.width + x;
+
+    const float depth = triangle.depth.at(fx, fy);
+
+    if (!material.additive && depth > depth_buffer_[index])
+        return;
+
+    const float w = 1.0f / triangle.inv_w.at(fx, fy);
+
+    float color[4];
+
+    if (material.texture)
+    {
+        const float u = triangle.u_over_w.at(fx, fy) * w;
+        const float v = triangle.v_over_w.at(fx, fy) * w;
+
+        sample_texture(*material.texture, u, v, triangle.magnified, color);
+
+        if (material.masked &&
+            to_unorm8(color[0]) == to_unorm8(material.mask_color.x * 255.0f) &&
+            to_unorm8(color[1]) == to_unorm8(material.mask_color.y * 255.0f) &&
+            to_unorm8(color[2]) == to_unorm8(material.mask_color.z * 255.0f))
+            return;
+
+        if (material.lighting)
+            color[3] = 255.0f;
+    }
+    else
+    {
+        for (int i = 0; i < 4; ++i)
+            color[i] = material.color[i] * 255.0f;
+    }
+
+    if (material.lighting)
+    {
+        const float intensity = triangle.intensity_over_w.at(fx, fy) * w;
+
+        for (int i = 0; i < 3; ++i)
+            color[i] *= intensity * material.light_color[i];
+    }
+
+    uint8_t* destination = &color_buffer_.pixels[index * 4];
+
+    if (material.additive)
+    {
+        const float source_alpha = color[3] / 255.0f;
+        const float destination_alpha = destination[3] / 255.0f;
+
+        for (int i = 0; i < 4; ++i)
+            destination[i] = to_unorm8(color[i] * source_alpha + destination[i] * destination_alpha);
+    }
+    else
+    {
+        for (int i = 0; i < 4; ++i)
+            destination[i] = to_unorm8(color[i]);
+
+        depth_buffer_[index] = depth;
+    }
+}
+
+}
@@ -0,0 +1,208 @@
+/**
+* \file software_rasterizer.h
+* \brief Declaration for the software rasterizer class.
+*/
+
+#ifndef HLMDLVIEWER_SOFTWARE_RASTERIZER_H_
+#define HLMDLVIEWER_SOFTWARE_RASTERIZER_H_
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "image.h"
+#include "thread_pool.h"
+
+namespace hl_mdlviewer {
+
+/** \brief A vertex as output by the vertex stage. */
+struct RasterVertex
+{
+    /** \brief The clip space position. */
+    glm::vec4 position;
+    glm::vec2 uv;
+
+    /** \brief The lighting intensity, in [0, 1]. */
+    float intensity;
+};
+
+/** \brief The faces to discard, as with glCullFace. */
+enum class RasterCullMode
+{
+    NONE,
+    FRONT,
+    BACK
+};
+
+/** \brief The state and fragment shading of a draw.
+*
+* The shading follows the smooth and textured fragment shaders: the
+* texture, or the color if there is none, is multiplied by the intensity
+* and the light color when lighting is enabled.
+*/
+struct RasterMaterial
+{
+    RasterMaterial() :
+        texture(nullptr),
+        color(1.0f),
+        lighting(false),
+        light_color(1.0f),
+        masked(false),
+        mask_color(0.0f),
+        additive(false),
+        cull_mode(RasterCullMode::FRONT)
+    {
+    }
+
+    /** \brief The texture, or null to use \ref color. Must stay valid
+    * until \ref SoftwareRasterizer::flush. */
+    const Image* texture;
+    glm::vec4 color;
+
+    bool lighting;
+    glm::vec3 light_color;
+
+    /** \brief Discard texels matching \ref mask_color. */
+    bool masked;
+    glm::vec3 mask_color;
+
+    /** \brief Blend with (GL_SRC_ALPHA, GL_DST_ALPHA) and no depth test,
+    * instead of writing with a GL_LEQUAL depth test. */
+    bool additive;
+
+    RasterCullMode cull_mode;
+};
+
+/** \brief Counters since the last \ref SoftwareRasterizer::clear. */
+struct RasterStatistics
+{
+    size_t num_submitted_triangles;
+
+    /** \brief The triangles left after clipping and culling. */
+    size_t num_rasterized_triangles;
+
+    /** \brief The sum of the bin sizes, a triangle is counted once for
+    * each tile it overlaps. */
+    size_t num_binned_triangles;
+    size_t num_shaded_fragments;
+};
+
+/** \brief A tiled triangle rasterizer that renders into an RGBA8 color
+* buffer and a float depth buffer.
+*
+* Triangles are set up and sorted into bins of \ref TILE_SIZE pixels when
+* submitted. \ref flush then rasterizes the tiles in parallel, each tile
+* processing its triangles in submission order, so the result does not
+* depend on the number of threads. Coverage uses fixed point edge
+* functions with 4 bits of sub-pixel precision and the top-left fill rule,
+* evaluated 4 pixels at a time with SSE2 when available.
+*/
+class SoftwareRasterizer
+{
+public:
+    static const int TILE_SIZE = 32;
+
+    /** \brief The largest supported width or height. */
+    static const unsigned int MAX_SIZE = 4096;
+
+    /** \param[in] thread_pool The pool to rasterize tiles on, or null
+    *             to rasterize on the calling thread. */
+    explicit SoftwareRasterizer(ThreadPool* thread_pool = nullptr);
+    ~SoftwareRasterizer();
+
+    void resize(unsigned int width, unsigned int height);
+
+    inline unsigned int width() const { return color_buffer_.width; }
+    inline unsigned int height() const { return color_buffer_.height; }
+
+    void clear(const glm::vec4& color, float depth = 1.0f);
+
+    /** \brief Submit indexed triangles.
+    * \param[in] vertices The vertices.
+    * \param[in] indices The triangle list, relative to \p vertices.
+    * \param[in] num_indices The number of indices.
+    * \param[in] material The draw state.
+    */
+    void draw_triangles(const RasterVertex* vertices,
+        const unsigned int* indices,
+        size_t num_indices,
+        const RasterMaterial& material);
+
+    /** \brief Rasterize the submitted triangles. */
+    void flush();
+
+    inline const Image& color_buffer() const { return color_buffer_; }
+    inline const std::vector<float>& depth_buffer() const { return depth_buffer_; }
+    inline const RasterStatistics& statistics() const { return statistics_; }
+
+private:
+
+    /** \brief An affine function of the pixel position, relative to
+    * the top left corner of the triangle bounding box. */
+    struct Plane
+    {
+        float dx, dy, c;
+
+        inline float at(float x, float y) const { return dx * x + dy * y + c; }
+    };
+
+    /** \brief A fixed point edge function, E = a * x + b * y + c, in
+    * sub-pixel units. A pixel center is covered when E >= 0 for all
+    * edges, the fill rule is folded into c. */
+    struct Edge
+    {
+        int64_t a, b, c;
+
+        inline int64_t at(int64_t x, int64_t y) const { return a * x + b * y + c; }
+    };
+
+    struct Triangle
+    {
+        Edge edges[3];
+
+        /** \brief The pixel bounding box, inclusive. */
+        int min_x, min_y, max_x, max_y;
+
+        Plane depth;
+        Plane inv_w;
+        Plane u_over_w;
+        Plane v_over_w;
+        Plane intensity_over_w;
+
+        uint32_t material;
+
+        /** \brief Whether the texture is magnified, and thus filtered. */
+        bool magnified;
+    };
+
+    void setup_triangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2,
+        const RasterMaterial& material, uint32_t material_index);
+
+    void bin_triangle(const Triangle& triangle, uint32_t triangle_index);
+
+    void rasterize_tile(size_t tile_index);
+
+    void shade_fragment(const Triangle& triangle, const RasterMaterial& material, int x, int y);
+
+    ThreadPool* thread_pool_;
+
+    Image color_buffer_;
+    std::vector<float> depth_buffer_;
+
+    int num_tiles_x_;
+    int num_tiles_y_;
+
+    std::vector<Triangle> triangles_;
+    std::vector<RasterMaterial> materials_;
+
+    /** \brief The triangles overlapping each tile, in submission order. */
+    std::vector<std::vector<uint32_t>> bins_;
+
+    /** \brief The shaded fragments of each tile. */
+    std::vector<size_t> tile_fragments_;
+
+    RasterStatistics statistics_;
+};
+
+}
+
+#endif // HLMDLVIEWER_SOFTWARE_RASTERIZER_H_
@@ -0,0 +1,88 @@
+/**
+* \file sound_device.cpp
+* \brief Implementation for the sound output device classes.
+*/
+
+#include "pch.h"
+#include "sound_device.h"
+#include "wav_file.h"
+#include <iostream>
+#include <thread>
+#ifdef _WIN32
+#include "sound_device_windows.h"
+#endif
+
+namespace hl_mdlviewer {
+
+NullSoundDevice::NullSoundDevice(uint32_t sample_rate) :
+    sample_rate_(sample_rate),
+    next_write_time_(std::chrono::steady_clock::now())
+{
+}
+
+void NullSoundDevice::write(const int16_t* frames, size_t num_frames)
+{
+    wait(num_frames);
+}
+
+void NullSoundDevice::wait(size_t num_frames)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    // After a stall, start over instead of catching up.
+    if (next_write_time_ < now)
+        next_write_time_ = now;
+
+    std::this_thread::sleep_until(next_write_time_);
+
+    next_write_time_ += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(num_frames) / sample_rate_));
+}
+
+WavFileSoundDevice::WavFileSoundDevice(const std::string& file_path, uint32_t sample_rate, bool paced) :
+    NullSoundDevice(sample_rate),
+    file_(file_path, std::ios::binary | std::ios::trunc),
+    paced_(paced),
+    num_frames_written_(0)
+{
+    if (!file_)
+        throw std::runtime_error("Could not create " + file_path);
+
+    write_wav_header(file_, sample_rate, 2, 0);
+}
+
+WavFileSoundDevice::~WavFileSoundDevice()
+{
+    file_.seekp(0);
+    write_wav_header(file_, sample_rate(), 2,
+        static_cast<uint32_t>(num_frames_written_ * 2 * sizeof(int16_t)));
+}
+
+void WavFileSoundDevice::write(const int16_t* frames, size_t num_frames)
+{
+    // The samples are little-endian, like the machines this runs on.
+    file_.write(reinterpret_cast<const char*>(frames),
+        static_cast<std::streamsize>(num_frames * 2 * sizeof(int16_t)));
+    num_frames_written_ += num_frames;
+
+    if (paced_)
+        wait(num_frames);
+}
+
+std::unique_ptr<SoundDevice> create_default_sound_device(uint32_t sample_rate, size_t period_frames)
+{
+#ifdef _WIN32
+    try
+    {
+        return std::unique_ptr<SoundDevice>(new WaveOutSoundDevice(sample_rate, period_frames));
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << ", sounds are muted" << std::endl;
+    }
+#endif
+
+    return std::unique_ptr<SoundDevice>(new NullSoundDevice(sample_rate));
+}
+
+}
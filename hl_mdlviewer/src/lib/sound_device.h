@@ -0,0 +1,86 @@
+/**
+* \file sound_device.h
+* \brief Declaration for the sound output device classes.
+*/
+
+#ifndef HLMDLVIEWER_SOUND_DEVICE_H_
+#define HLMDLVIEWER_SOUND_DEVICE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace hl_mdlviewer {
+
+/** \brief Where the mixed sound goes: 16-bit stereo frames, written by
+* the mixing thread at the pace the device plays them. */
+class SoundDevice
+{
+public:
+    virtual ~SoundDevice() {}
+
+    virtual uint32_t sample_rate() const = 0;
+
+    /** \brief Play frames, blocking while the device has enough queued.
+    * \param[in] frames The frames, left and right samples interleaved.
+    * \param[in] num_frames The number of frames.
+    */
+    virtual void write(const int16_t* frames, size_t num_frames) = 0;
+};
+
+/** \brief Discards the frames, at the pace of a real device. For
+* machines without sound, i.e. headless test runs. */
+class NullSoundDevice : public SoundDevice
+{
+public:
+    explicit NullSoundDevice(uint32_t sample_rate);
+
+    uint32_t sample_rate() const override { return sample_rate_; }
+    void write(const int16_t* frames, size_t num_frames) override;
+
+protected:
+
+    /** \brief Sleep until the frames written so far would have played. */
+    void wait(size_t num_frames);
+
+private:
+    uint32_t sample_rate_;
+    std::chrono::steady_clock::time_point next_write_time_;
+};
+
+/** \brief Writes the frames to a WAV file, to hear or check what was
+* mixed without a sound card.
+*
+* The sizes in the header are written when the device is destroyed.
+*/
+class WavFileSoundDevice : public NullSoundDevice
+{
+public:
+    /** \brief Create the file. Throws if it cannot be created.
+    * \param[in] file_path The file.
+    * \param[in] sample_rate The rate of the frames.
+    * \param[in] paced Whether writes wait as if the frames were played.
+    *            Without, the mixing thread writes as fast as it mixes.
+    */
+    WavFileSoundDevice(const std::string& file_path, uint32_t sample_rate, bool paced = true);
+    ~WavFileSoundDevice();
+
+    void write(const int16_t* frames, size_t num_frames) override;
+
+    inline size_t num_frames_written() const { return num_frames_written_; }
+
+private:
+    std::ofstream file_;
+    bool paced_;
+    size_t num_frames_written_;
+};
+
+/** \brief Open the sound card of the platform, or a \ref NullSoundDevice
+*          if there is none. */
+std::unique_ptr<SoundDevice> create_default_sound_device(uint32_t sample_rate, size_t period_frames);
+
+}
+
+#endif // HLMDLVIEWER_SOUND_DEVICE_H_
@@ -0,0 +1,89 @@
+/**
+* \file sound_device_windows.cpp
+* \brief Implementation for the Windows sound output device class.
+*/
+
+#include "pch.h"
+#ifdef _WIN32
+#include "sound_device_windows.h"
+
+namespace hl_mdlviewer {
+
+WaveOutSoundDevice::WaveOutSoundDevice(uint32_t sample_rate, size_t period_frames, size_t num_buffers) :
+    sample_rate_(sample_rate),
+    period_frames_(period_frames),
+    wave_out_(NULL),
+    buffer_done_event_(NULL),
+    buffers_(num_buffers),
+    next_buffer_(0)
+{
+    buffer_done_event_ = CreateEventA(NULL, FALSE, FALSE, NULL);
+    if (!buffer_done_event_)
+        throw std::runtime_error("Could not create the sound event");
+
+    WAVEFORMATEX format = {};
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = 2;
+    format.nSamplesPerSec = sample_rate;
+    format.wBitsPerSample = 16;
+    format.nBlockAlign = format.nChannels * format.wBitsPerSample / 8;
+    format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+
+    if (waveOutOpen(&wave_out_, WAVE_MAPPER, &format,
+        reinterpret_cast<DWORD_PTR>(buffer_done_event_), 0, CALLBACK_EVENT) != MMSYSERR_NOERROR)
+    {
+        CloseHandle(buffer_done_event_);
+        throw std::runtime_error("Could not open the sound card");
+    }
+
+    for (Buffer& buffer : buffers_)
+    {
+        buffer.frames.resize(period_frames * 2);
+        buffer.header = {};
+        buffer.header.lpData = reinterpret_cast<LPSTR>(buffer.frames.data());
+        buffer.header.dwBufferLength = static_cast<DWORD>(buffer.frames.size() * sizeof(int16_t));
+        waveOutPrepareHeader(wave_out_, &buffer.header, sizeof(WAVEHDR));
+
+        // Free until first written.
+        buffer.header.dwFlags |= WHDR_DONE;
+    }
+}
+
+WaveOutSoundDevice::~WaveOutSoundDevice()
+{
+    // Returns the queued buffers at once.
+    waveOutReset(wave_out_);
+
+    for (Buffer& buffer : buffers_)
+        waveOutUnprepareHeader(wave_out_, &buffer.header, sizeof(WAVEHDR));
+
+    waveOutClose(wave_out_);
+    CloseHandle(buffer_done_event_);
+}
+
+void WaveOutSoundDevice::write(const int16_t* frames, size_t num_frames)
+{
+    while (num_frames > 0)
+    {
+        Buffer& buffer = buffers_[next_buffer_];
+
+        // The event is shared by the buffers, so check the one needed.
+        while (!(buffer.header.dwFlags & WHDR_DONE))
+            WaitForSingleObject(buffer_done_event_, INFINITE);
+
+        const size_t buffer_frames = std::min(num_frames, period_frames_);
+        std::copy(frames, frames + buffer_frames * 2, buffer.frames.begin());
+
+        buffer.header.dwBufferLength = static_cast<DWORD>(buffer_frames * 2 * sizeof(int16_t));
+        buffer.header.dwFlags &= ~WHDR_DONE;
+        waveOutWrite(wave_out_, &buffer.header, sizeof(WAVEHDR));
+
+        next_buffer_ = (next_buffer_ + 1) % buffers_.size();
+        frames += buffer_frames * 2;
+        num_frames -= buffer_frames;
+    }
+}
+
+}
+
+#endif
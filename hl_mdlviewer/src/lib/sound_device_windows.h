@@ -0,0 +1,55 @@
+/**
+* \file sound_device_windows.h
+* \brief Declaration for the Windows sound output device class.
+*/
+
+#ifndef HLMDLVIEWER_SOUND_DEVICE_WINDOWS_H_
+#define HLMDLVIEWER_SOUND_DEVICE_WINDOWS_H_
+
+#include "sound_device.h"
+#include <vector>
+#include <mmsystem.h>
+
+namespace hl_mdlviewer {
+
+/** \brief Plays the frames with the waveOut API, through a ring of
+* buffers of one period each. */
+class WaveOutSoundDevice : public SoundDevice
+{
+public:
+    /** \brief Open the default sound card. Throws if it cannot be opened.
+    * \param[in] sample_rate The rate of the frames.
+    * \param[in] period_frames The frames of each buffer.
+    * \param[in] num_buffers The buffers queued to the card. The latency
+    *            is up to this many periods.
+    */
+    WaveOutSoundDevice(uint32_t sample_rate, size_t period_frames, size_t num_buffers = 4);
+    WaveOutSoundDevice(const WaveOutSoundDevice&) = delete;
+    ~WaveOutSoundDevice();
+
+    uint32_t sample_rate() const override { return sample_rate_; }
+    void write(const int16_t* frames, size_t num_frames) override;
+
+private:
+
+    struct Buffer
+    {
+        WAVEHDR header;
+        std::vector<int16_t> frames;
+    };
+
+    uint32_t sample_rate_;
+    size_t period_frames_;
+
+    HWAVEOUT wave_out_;
+
+    /** \brief Signaled by the driver each time a buffer is done. */
+    HANDLE buffer_done_event_;
+
+    std::vector<Buffer> buffers_;
+    size_t next_buffer_;
+};
+
+}
+
+#endif // HLMDLVIEWER_SOUND_DEVICE_WINDOWS_H_
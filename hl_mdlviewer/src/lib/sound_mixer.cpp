@@ -0,0 +1,176 @@
+/**
+* \file sound_mixer.cpp
+* \brief Implementation for the sound mixer class.
+*/
+
+#include "pch.h"
+#include "sound_mixer.h"
+
+namespace hl_mdlviewer {
+
+namespace {
+
+/** The frames mixed at once, bounding the accumulator. */
+const size_t MIX_CHUNK_FRAMES = 256;
+
+const int32_t UNIT_GAIN = 256;
+
+}
+
+SoundMixer::SoundMixer(size_t num_voices, uint32_t sample_rate, size_t queue_capacity) :
+    commands_(queue_capacity),
+    voices_(num_voices),
+    accumulator_(MIX_CHUNK_FRAMES * 2),
+    sample_rate_(sample_rate),
+    num_started_(0),
+    num_dropped_(0),
+    num_playing_(0),
+    num_stolen_(0)
+{
+    if (num_voices == 0 || sample_rate == 0)
+        throw std::runtime_error("A sound mixer needs voices and a sample rate");
+}
+
+bool SoundMixer::play(std::shared_ptr<const PcmSound> sound, float volume)
+{
+    if (!sound || sound->num_frames() == 0)
+        return false;
+
+    const float clamped_volume = std::min(std::max(volume, 0.0f), 1.0f);
+    return push_command({ Command::Type::Play, std::move(sound),
+        static_cast<int32_t>(clamped_volume * UNIT_GAIN + 0.5f) });
+}
+
+bool SoundMixer::stop_all()
+{
+    return push_command({ Command::Type::StopAll, nullptr, 0 });
+}
+
+bool SoundMixer::push_command(Command&& command)
+{
+    if (commands_.try_push(std::move(command)))
+        return true;
+
+    ++num_dropped_;
+    return false;
+}
+
+void SoundMixer::mix(int16_t* output, size_t num_frames)
+{
+    process_commands();
+
+    while (num_frames > 0)
+    {
+        const size_t chunk_frames = std::min(num_frames, MIX_CHUNK_FRAMES);
+        int32_t* accumulator = accumulator_.data();
+        std::fill(accumulator, accumulator + chunk_frames * 2, 0);
+
+        for (Voice& voice : voices_)
+        {
+            if (voice.sound)
+                mix_voice(voice, accumulator, chunk_frames);
+        }
+
+        for (size_t i = 0; i < chunk_frames * 2; ++i)
+            output[i] = static_cast<int16_t>(std::min(std::max(accumulator[i], -32768), 32767));
+
+        output += chunk_frames * 2;
+        num_frames -= chunk_frames;
+    }
+
+    size_t num_playing = 0;
+    for (const Voice& voice : voices_)
+    {
+        if (voice.sound)
+            ++num_playing;
+    }
+
+    num_playing_.store(num_playing, std::memory_order_relaxed);
+}
+
+void SoundMixer::process_commands()
+{
+    Command command;
+    while (commands_.try_pop(command))
+    {
+        switch (command.type)
+        {
+        case Command::Type::Play:
+            start_voice(std::move(command.sound), command.gain);
+            break;
+
+        case Command::Type::StopAll:
+            for (Voice& voice : voices_)
+                voice.sound.reset();
+            break;
+        }
+
+        // The slot holds no reference once popped.
+        command.sound.reset();
+    }
+}
+
+void SoundMixer::start_voice(std::shared_ptr<const PcmSound>&& sound, int32_t gain)
+{
+    Voice* target = nullptr;
+    for (Voice& voice : voices_)
+    {
+        if (!voice.sound)
+        {
+            target = &voice;
+            break;
+        }
+
+        if (!target || voice.start_order < target->start_order)
+            target = &voice;
+    }
+
+    if (target->sound)
+        num_stolen_.fetch_add(1, std::memory_order_relaxed);
+
+    target->step = (static_cast<uint64_t>(sound->sample_rate) << 32) / sample_rate_;
+    target->sound = std::move(sound);
+    target->position = 0;
+    target->gain = gain;
+    target->start_order = num_started_++;
+}
+
+void SoundMixer::mix_voice(Voice& voice, int32_t* accumulator, size_t num_frames)
+{
+    const PcmSound& sound = *voice.sound;
+    const int16_t* samples = sound.samples.data();
+    const size_t sound_frames = sound.num_frames();
+    const size_t num_channels = sound.num_channels;
+
+    // Mono sounds go to both channels.
+    const size_t right_channel = num_channels > 1 ? 1 : 0;
+
+    for (size_t i = 0; i < num_frames; ++i)
+    {
+        const size_t frame = static_cast<size_t>(voice.position >> 32);
+        if (frame >= sound_frames)
+        {
+            voice.sound.reset();
+            return;
+        }
+
+        const size_t next_frame = std::min(frame + 1, sound_frames - 1);
+        // A 15-bit fraction keeps the product of a full-scale step, up to
+        // 65535, within 32 bits.
+        const int32_t fraction = static_cast<int32_t>((voice.position >> 17) & 0x7fff);
+
+        const int16_t* current = samples + frame * num_channels;
+        const int16_t* next = samples + next_frame * num_channels;
+
+        const int32_t left = current[0] + (((next[0] - current[0]) * fraction) >> 15);
+        const int32_t right = current[right_channel] +
+            (((next[right_channel] - current[right_channel]) * fraction) >> 15);
+
+        accumulator[i * 2] += (left * voice.gain) >> 8;
+        accumulator[i * 2 + 1] += (right * voice.gain) >> 8;
+
+        voice.position += voice.step;
+    }
+}
+
+}
@@ -0,0 +1,126 @@
+/**
+* \file sound_mixer.h
+* \brief Declaration for the sound mixer class.
+*/
+
+#ifndef HLMDLVIEWER_SOUND_MIXER_H_
+#define HLMDLVIEWER_SOUND_MIXER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "spsc_queue.h"
+#include "wav_file.h"
+
+namespace hl_mdlviewer {
+
+/** \brief Mixes decoded sounds into a stereo stream, with a fixed number
+* of voices.
+*
+* Sounds are started from one thread with \ref play, and mixed on another
+* with \ref mix: the two only share a lock-free command queue, so the
+* mixing thread never waits. When all voices are busy, a new sound takes
+* the voice of the oldest one. Sounds of any rate are resampled linearly
+* to the rate of the mixer.
+*/
+class SoundMixer
+{
+public:
+    /** \brief Create a mixer.
+    * \param[in] num_voices The number of sounds played at once.
+    * \param[in] sample_rate The rate of the mixed stream.
+    * \param[in] queue_capacity The number of commands that can wait for
+    *            the next \ref mix.
+    */
+    SoundMixer(size_t num_voices, uint32_t sample_rate, size_t queue_capacity = 64);
+    SoundMixer(const SoundMixer&) = delete;
+
+    inline uint32_t sample_rate() const { return sample_rate_; }
+    inline size_t num_voices() const { return voices_.size(); }
+
+    /** \brief Start a sound, from the producer thread. The sound must not
+    *          change while it plays.
+    * \param[in] sound The sound.
+    * \param[in] volume The volume, from 0 to 1.
+    * \return false if the command queue is full, the sound is dropped.
+    */
+    bool play(std::shared_ptr<const PcmSound> sound, float volume = 1.0f);
+
+    /** \brief Stop all sounds, from the producer thread. */
+    bool stop_all();
+
+    /** \brief Mix the next frames, from the consumer thread.
+    * \param[out] output The frames, left and right samples interleaved.
+    * \param[in] num_frames The number of frames to mix.
+    */
+    void mix(int16_t* output, size_t num_frames);
+
+    /** \brief The number of voices playing after the last \ref mix. */
+    inline size_t num_playing() const { return num_playing_.load(std::memory_order_relaxed); }
+
+    /** \brief The number of sounds cut short to free a voice. */
+    inline size_t num_stolen() const { return num_stolen_.load(std::memory_order_relaxed); }
+
+    /** \brief The number of commands dropped because the queue was full.
+    *          Counted on the producer thread. */
+    inline size_t num_dropped() const { return num_dropped_; }
+
+private:
+
+    struct Command
+    {
+        enum class Type
+        {
+            Play,
+            StopAll
+        };
+
+        Type type;
+        std::shared_ptr<const PcmSound> sound;
+        int32_t gain;
+    };
+
+    struct Voice
+    {
+        std::shared_ptr<const PcmSound> sound;
+
+        /** The position in the sound, in frames, as 32.32 fixed point. */
+        uint64_t position;
+
+        /** The frames of the sound per mixed frame, as 32.32 fixed point. */
+        uint64_t step;
+
+        /** The volume, as 8.8 fixed point. */
+        int32_t gain;
+
+        /** When the voice started, to find the oldest one. */
+        uint64_t start_order;
+    };
+
+    bool push_command(Command&& command);
+    void process_commands();
+    void start_voice(std::shared_ptr<const PcmSound>&& sound, int32_t gain);
+
+    /** \brief Add the frames of a voice to the accumulator, and stop the
+    *          voice at the end of its sound. */
+    void mix_voice(Voice& voice, int32_t* accumulator, size_t num_frames);
+
+    SpscQueue<Command> commands_;
+
+    std::vector<Voice> voices_;
+
+    /** \brief The sum of the voices, before clamping, two values per frame. */
+    std::vector<int32_t> accumulator_;
+
+    uint32_t sample_rate_;
+    uint64_t num_started_;
+
+    size_t num_dropped_;
+    std::atomic<size_t> num_playing_;
+    std::atomic<size_t> num_stolen_;
+};
+
+}
+
+#endif // HLMDLVIEWER_SOUND_MIXER_H_
@@ -5,9 +5,7 @@
 
 #include "pch.h"
 #include "sound_system.h"
-#ifdef _WIN32
-#include "sound_system_windows.h"
-#endif
+#include "sound_system_mixer.h"
 
 namespace hl_mdlviewer {
 
@@ -15,9 +13,15 @@ SoundSystem::SoundSystem(FileSystem* file_system) :
     file_system_(file_system),
     impl_(nullptr)
 {
-#ifdef _WIN32
-    impl_.reset(new SoundSystemImplWindows());
-#endif
+    impl_.reset(new SoundSystemImplMixer(
+        create_default_sound_device(SOUND_MIXER_SAMPLE_RATE, SOUND_MIXER_PERIOD_FRAMES)));
+}
+
+SoundSystem::SoundSystem(FileSystem* file_system, std::unique_ptr<SoundDevice> device) :
+    file_system_(file_system),
+    impl_(nullptr)
+{
+    impl_.reset(new SoundSystemImplMixer(std::move(device)));
 }
 
 SoundSystem::~SoundSystem()
@@ -26,9 +30,21 @@ SoundSystem::~SoundSystem()
         impl_.reset(nullptr);
 }
 
+SoundHandle SoundSystem::precache_sound(const char* file_path)
+{
+    return impl_->precache_sound(file_path, file_system_);
+}
+
+void SoundSystem::play_sound(SoundHandle handle)
+{
+    impl_->play_sound(handle);
+}
+
 void SoundSystem::play_sound(const char* file_path)
 {
-    impl_->play_sound(file_path, file_system_);
+    const SoundHandle handle = impl_->precache_sound(file_path, file_system_);
+    impl_->wait_for_precache();
+    impl_->play_sound(handle);
 }
 
 }
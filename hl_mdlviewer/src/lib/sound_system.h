@@ -8,17 +8,32 @@
 
 #include "disposable.h"
 #include "file_system.h"
+#include "sound_device.h"
 #include "sound_system_impl.h"
 
 namespace hl_mdlviewer {
 
+/** \brief Plays the sounds of animation events. */
 class SoundSystem
 {
 public:
+    /** \brief Play sounds on the sound card of the platform. */
     SoundSystem(FileSystem* file_system);
+
+    /** \brief Play sounds on a given device, i.e. a \ref WavFileSoundDevice. */
+    SoundSystem(FileSystem* file_system, std::unique_ptr<SoundDevice> device);
     SoundSystem(const SoundSystem&) = delete;
     ~SoundSystem();
 
+    /** \brief Load a sound on a background thread, so that playing it
+    *          later costs no file access. See \ref SoundSystemImpl. */
+    SoundHandle precache_sound(const char* file_path);
+
+    /** \brief Play a precached sound. */
+    void play_sound(SoundHandle handle);
+
+    /** \brief Play a sound, loading it first if needed. Blocks while the
+    *          sounds precached before are loading; prefer handles. */
     void play_sound(const char* file_path);
 private:
     FileSystem* file_system_;
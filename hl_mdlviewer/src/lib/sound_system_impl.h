@@ -10,10 +10,27 @@
 
 namespace hl_mdlviewer {
 
+/** \brief Names a precached sound. */
+using SoundHandle = int;
+
+const SoundHandle INVALID_SOUND_HANDLE = -1;
+
 class SoundSystemImpl {
 public:
-    virtual void play_sound(const char* file_path, 
+    virtual ~SoundSystemImpl() {}
+
+    /** \brief Start loading a sound in the background.
+    * \return The handle to play the sound with. The same file always
+    *         gives the same handle.
+    */
+    virtual SoundHandle precache_sound(const char* file_path,
         FileSystem* const file_system) = 0;
+
+    /** \brief Wait for the sounds precached so far to be loaded. */
+    virtual void wait_for_precache() = 0;
+
+    /** \brief Play a precached sound. Sounds still loading are skipped. */
+    virtual void play_sound(SoundHandle handle) = 0;
 };
 
 }
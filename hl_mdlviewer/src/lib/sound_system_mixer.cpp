@@ -0,0 +1,184 @@
+/**
+* \file sound_system_mixer.cpp
+* \brief Implementation for the mixing sound system implementation class.
+*/
+
+#include "pch.h"
+#include "sound_system_mixer.h"
+#include <cctype>
+#include <iostream>
+
+namespace hl_mdlviewer {
+
+SoundSystemImplMixer::SoundSystemImplMixer(std::unique_ptr<SoundDevice> device, size_t num_voices) :
+    device_(std::move(device)),
+    mixer_(num_voices, device_->sample_rate()),
+    slots_(),
+    handles_(),
+    num_skipped_plays_(0),
+    loader_mutex_(),
+    load_pending_(),
+    loads_done_(),
+    pending_loads_(),
+    loading_(false),
+    loader_stopping_(false),
+    loader_thread_(),
+    stopping_(false),
+    thread_()
+{
+    loader_thread_ = std::thread(&SoundSystemImplMixer::loader_main, this);
+    thread_ = std::thread(&SoundSystemImplMixer::mixer_main, this);
+}
+
+SoundSystemImplMixer::~SoundSystemImplMixer()
+{
+    {
+        std::lock_guard<std::mutex> lock(loader_mutex_);
+        loader_stopping_ = true;
+        pending_loads_.clear();
+    }
+
+    load_pending_.notify_one();
+    loader_thread_.join();
+
+    stopping_.store(true, std::memory_order_relaxed);
+    thread_.join();
+}
+
+SoundHandle SoundSystemImplMixer::precache_sound(const char* file_path, FileSystem* const file_system)
+{
+    // Named like the file system matches them.
+    std::string name(file_path);
+    for (char& c : name)
+        c = c == '\\' ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+    auto it = handles_.find(name);
+    if (it != handles_.end())
+    {
+        // A sound that could not be read may have been added since, it
+        // keeps its handle. The loader may still use the previous slot.
+        std::shared_ptr<SoundSlot>& slot = slots_[it->second];
+        if (slot->loaded.load(std::memory_order_acquire) && !slot->sound)
+        {
+            slot = std::make_shared<SoundSlot>();
+            queue_load(slot, file_path, file_system);
+        }
+
+        return it->second;
+    }
+
+    const SoundHandle handle = static_cast<SoundHandle>(slots_.size());
+    slots_.push_back(std::make_shared<SoundSlot>());
+    handles_.emplace(name, handle);
+
+    queue_load(slots_.back(), file_path, file_system);
+    return handle;
+}
+
+void SoundSystemImplMixer::queue_load(const std::shared_ptr<SoundSlot>& slot, const char* file_path,
+    FileSystem* file_system)
+{
+    {
+        std::lock_guard<std::mutex> lock(loader_mutex_);
+        pending_loads_.push_back({ slot, file_path, file_system });
+    }
+
+    load_pending_.notify_one();
+}
+
+void SoundSystemImplMixer::wait_for_precache()
+{
+    std::unique_lock<std::mutex> lock(loader_mutex_);
+    loads_done_.wait(lock, [this] { return pending_loads_.empty() && !loading_; });
+}
+
+void SoundSystemImplMixer::play_sound(SoundHandle handle)
+{
+    if (handle < 0 || handle >= static_cast<SoundHandle>(slots_.size()))
+        return;
+
+    const SoundSlot& slot = *slots_[handle];
+    if (!slot.loaded.load(std::memory_order_acquire))
+    {
+        ++num_skipped_plays_;
+        return;
+    }
+
+    if (slot.sound)
+        mixer_.play(slot.sound);
+}
+
+bool SoundSystemImplMixer::has_sound(SoundHandle handle) const
+{
+    if (handle < 0 || handle >= static_cast<SoundHandle>(slots_.size()))
+        return false;
+
+    const SoundSlot& slot = *slots_[handle];
+    return slot.loaded.load(std::memory_order_acquire) && slot.sound;
+}
+
+std::shared_ptr<const PcmSound> SoundSystemImplMixer::load_sound(const std::string& file_path, FileSystem* file_system)
+{
+    std::shared_ptr<PcmSound> sound(new PcmSound());
+
+    FileView file;
+    try
+    {
+        if (!file_system->open_file(file_path.c_str(), file) || !decode_wav(file.data(), file.size(), *sound))
+            sound.reset();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        sound.reset();
+    }
+
+    if (!sound)
+        std::cerr << "Could not load sound " << file_path << std::endl;
+
+    return sound;
+}
+
+void SoundSystemImplMixer::loader_main()
+{
+    std::unique_lock<std::mutex> lock(loader_mutex_);
+
+    for (;;)
+    {
+        load_pending_.wait(lock, [this] { return !pending_loads_.empty() || loader_stopping_; });
+
+        if (loader_stopping_)
+            break;
+
+        PendingLoad pending_load = std::move(pending_loads_.front());
+        pending_loads_.pop_front();
+        loading_ = true;
+
+        lock.unlock();
+
+        pending_load.slot->sound = load_sound(pending_load.file_path, pending_load.file_system);
+        pending_load.slot->loaded.store(true, std::memory_order_release);
+
+        lock.lock();
+        loading_ = false;
+
+        if (pending_loads_.empty())
+            loads_done_.notify_all();
+    }
+
+    // Nobody waits for the dropped loads.
+    loads_done_.notify_all();
+}
+
+void SoundSystemImplMixer::mixer_main()
+{
+    std::vector<int16_t> frames(SOUND_MIXER_PERIOD_FRAMES * 2);
+
+    while (!stopping_.load(std::memory_order_relaxed))
+    {
+        mixer_.mix(frames.data(), SOUND_MIXER_PERIOD_FRAMES);
+        device_->write(frames.data(), SOUND_MIXER_PERIOD_FRAMES);
+    }
+}
+
+}
@@ -0,0 +1,131 @@
+/**
+* \file sound_system_mixer.h
+* \brief Declaration for the mixing sound system implementation class.
+*/
+
+#ifndef HLMDLVIEWER_SOUND_SYSTEM_MIXER_H_
+#define HLMDLVIEWER_SOUND_SYSTEM_MIXER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "sound_device.h"
+#include "sound_mixer.h"
+#include "sound_system_impl.h"
+
+namespace hl_mdlviewer {
+
+/** \brief The rate sounds are mixed at, the rate of most game sounds. */
+const uint32_t SOUND_MIXER_SAMPLE_RATE = 22050;
+
+/** \brief The frames mixed at once, about 23 ms at the mixer rate. */
+const size_t SOUND_MIXER_PERIOD_FRAMES = 512;
+
+/** \brief Plays sounds on any platform, through a \ref SoundMixer fed to a
+* \ref SoundDevice by a thread of its own.
+*
+* Each sound is read and decoded once, by a loader thread, when it is
+* precached, then kept decoded. Sounds that cannot be read are read again
+* when precached again, e.g. once the file system was refreshed. Playing a
+* sound is then only a push to the mixer queue. Sounds overlap, up to the
+* number of voices of the mixer.
+*
+* Sounds are precached and played from one thread only.
+*/
+class SoundSystemImplMixer : public SoundSystemImpl
+{
+public:
+    /** \brief Start the mixing thread.
+    * \param[in] device The output, at the rate of the mixer.
+    * \param[in] num_voices The number of sounds played at once.
+    */
+    explicit SoundSystemImplMixer(std::unique_ptr<SoundDevice> device, size_t num_voices = 16);
+    SoundSystemImplMixer(const SoundSystemImplMixer&) = delete;
+
+    /** \brief Stop the loader thread, then the mixing thread after the
+    *          current period. */
+    ~SoundSystemImplMixer();
+
+    SoundHandle precache_sound(const char* file_path, FileSystem* const file_system) override;
+    void wait_for_precache() override;
+    void play_sound(SoundHandle handle) override;
+
+    inline const SoundMixer& mixer() const { return mixer_; }
+
+    /** \brief The number of sounds precached, including those that
+    *          cannot be read. */
+    inline size_t num_cached_sounds() const { return slots_.size(); }
+
+    /** \brief The number of plays skipped because the sound was still
+    *          loading. */
+    inline size_t num_skipped_plays() const { return num_skipped_plays_; }
+
+    /** \brief Whether a precached sound was read, false while it loads
+    *          or if it cannot be read. */
+    bool has_sound(SoundHandle handle) const;
+
+private:
+
+    /** \brief A precached sound, shared with the loader thread. */
+    struct SoundSlot
+    {
+        SoundSlot() : loaded(false), sound() {}
+
+        /** Set by the loader once \ref sound is. */
+        std::atomic<bool> loaded;
+
+        /** The decoded sound, or null if it cannot be read. */
+        std::shared_ptr<const PcmSound> sound;
+    };
+
+    struct PendingLoad
+    {
+        std::shared_ptr<SoundSlot> slot;
+        std::string file_path;
+        FileSystem* file_system;
+    };
+
+    /** \brief Read and decode a sound.
+    * \return The sound, or null if it cannot be read.
+    */
+    static std::shared_ptr<const PcmSound> load_sound(const std::string& file_path, FileSystem* file_system);
+
+    /** \brief Queue the load of a sound for the loader thread. */
+    void queue_load(const std::shared_ptr<SoundSlot>& slot, const char* file_path, FileSystem* file_system);
+
+    void loader_main();
+    void mixer_main();
+
+    std::unique_ptr<SoundDevice> device_;
+    SoundMixer mixer_;
+
+    /** \brief The precached sounds, by handle. Holding the sounds here
+    * also means the mixing thread never frees one. */
+    std::vector<std::shared_ptr<SoundSlot>> slots_;
+
+    /** \brief The handles, by normalized file name. */
+    std::unordered_map<std::string, SoundHandle> handles_;
+
+    size_t num_skipped_plays_;
+
+    std::mutex loader_mutex_;
+    std::condition_variable load_pending_;
+    std::condition_variable loads_done_;
+    std::deque<PendingLoad> pending_loads_;
+    bool loading_;
+    bool loader_stopping_;
+    std::thread loader_thread_;
+
+    std::atomic<bool> stopping_;
+    std::thread thread_;
+};
+
+}
+
+#endif // HLMDLVIEWER_SOUND_SYSTEM_MIXER_H_
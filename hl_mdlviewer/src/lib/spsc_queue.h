@@ -0,0 +1,90 @@
+/**
+* \file spsc_queue.h
+* \brief Declaration for the single producer, single consumer queue class.
+*/
+
+#ifndef HLMDLVIEWER_SPSC_QUEUE_H_
+#define HLMDLVIEWER_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace hl_mdlviewer {
+
+/** \brief A bounded queue between exactly one producer thread and one
+* consumer thread, without locks.
+*
+* Neither side ever waits for the other, so a real-time thread, i.e. an
+* audio mixer, can consume from it. The slots are allocated up front.
+*/
+template<typename T>
+class SpscQueue
+{
+public:
+    /** \brief Create the queue.
+    * \param[in] capacity The number of items the queue holds, rounded up
+    *            to a power of two.
+    */
+    explicit SpscQueue(size_t capacity) :
+        slots_(round_up_to_power_of_two(capacity)),
+        mask_(slots_.size() - 1),
+        head_(0),
+        tail_(0)
+    {
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+
+    inline size_t capacity() const { return slots_.size(); }
+
+    /** \brief Add an item, from the producer thread.
+    * \return false if the queue is full; \p value is then left as is.
+    */
+    bool try_push(T&& value)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+            return false;
+
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** \brief Remove the oldest item, from the consumer thread.
+    * \return false if the queue is empty.
+    */
+    bool try_pop(T& value)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+            return false;
+
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+
+    static size_t round_up_to_power_of_two(size_t value)
+    {
+        size_t result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    std::vector<T> slots_;
+    const size_t mask_;
+
+    /** \brief The positions only grow, the slot is the position modulo the
+    * capacity. Kept on their own cache lines, written by one side each. */
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+};
+
+}
+
+#endif // HLMDLVIEWER_SPSC_QUEUE_H_
@@ -0,0 +1,135 @@
+/**
+* \file texture_atlas.cpp
+* \brief Implementation for the texture atlas packing functions.
+*/
+
+#include "pch.h"
+#include "texture_atlas.h"
+#include <cstring>
+
+namespace hl_mdlviewer {
+
+namespace {
+
+inline unsigned int align_up(unsigned int value, unsigned int alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/** \brief Place the images in rows of \p width texels.
+* \return The atlas height. */
+unsigned int pack_rows(std::vector<AtlasRect>& rects,
+    const std::vector<size_t>& order,
+    unsigned int padding,
+    unsigned int alignment,
+    unsigned int width)
+{
+    unsigned int x = 0;
+    unsigned int y = 0;
+    unsigned int row_height = 0;
+
+    for (size_t index : order)
+    {
+        AtlasRect& rect = rects[index];
+        const unsigned int padded_width = align_up(rect.width + padding * 2, alignment);
+        const unsigned int padded_height = align_up(rect.height + padding * 2, alignment);
+
+        if (x + padded_width > width)
+        {
+            x = 0;
+            y += row_height;
+            row_height = 0;
+        }
+
+        rect.x = x + padding;
+        rect.y = y + padding;
+
+        x += padded_width;
+        row_height = std::max(row_height, padded_height);
+    }
+
+    return align_up(y + row_height, alignment);
+}
+
+}
+
+bool pack_atlas(std::vector<AtlasRect>& rects,
+    unsigned int padding,
+    unsigned int max_size,
+    unsigned int& atlas_width,
+    unsigned int& atlas_height,
+    unsigned int alignment)
+{
+    atlas_width = 0;
+    atlas_height = 0;
+
+    if (rects.empty())
+        return true;
+
+    // The tallest images first keep the rows full.
+    std::vector<size_t> order(rects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&rects](size_t a, size_t b) {
+        return rects[a].height > rects[b].height;
+    });
+
+    size_t area = 0;
+    unsigned int widest = 0;
+    for (const AtlasRect& rect : rects)
+    {
+        const size_t padded_width = align_up(rect.width + padding * 2, alignment);
+        area += padded_width * align_up(rect.height + padding * 2, alignment);
+        widest = std::max(widest, static_cast<unsigned int>(padded_width));
+    }
+
+    // Start from a square of the total area, and widen until the height fits.
+    unsigned int width = alignment;
+    while (width < widest || static_cast<size_t>(width) * width < area)
+        width *= 2;
+
+    for (; width <= max_size; width *= 2)
+    {
+        const unsigned int height = pack_rows(rects, order, padding, alignment, width);
+        if (height <= max_size)
+        {
+            atlas_width = width;
+            atlas_height = height;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void copy_to_atlas(const uint8_t* pixels,
+    unsigned int bytes_per_texel,
+    const AtlasRect& rect,
+    unsigned int padding,
+    uint8_t* atlas,
+    unsigned int atlas_width)
+{
+    if (rect.width == 0 || rect.height == 0)
+        return;
+
+    const size_t row_size = static_cast<size_t>(rect.width) * bytes_per_texel;
+    const int p = static_cast<int>(padding);
+
+    for (int y = -p; y < static_cast<int>(rect.height) + p; ++y)
+    {
+        const int source_y = std::min(std::max(y, 0), static_cast<int>(rect.height) - 1);
+        const uint8_t* source_row = pixels + source_y * row_size;
+        uint8_t* row = atlas + (static_cast<size_t>(rect.y + y) * atlas_width + rect.x) * bytes_per_texel;
+
+        std::memcpy(row, source_row, row_size);
+
+        // Repeat the first and last texels of the row.
+        for (int x = 1; x <= p; ++x)
+        {
+            std::memcpy(row - x * bytes_per_texel, source_row, bytes_per_texel);
+            std::memcpy(row + row_size + (x - 1) * bytes_per_texel,
+                source_row + row_size - bytes_per_texel, bytes_per_texel);
+        }
+    }
+}
+
+}
@@ -0,0 +1,82 @@
+/**
+* \file texture_atlas.h
+* \brief Declaration for the texture atlas packing functions.
+*/
+
+#ifndef HLMDLVIEWER_TEXTURE_ATLAS_H_
+#define HLMDLVIEWER_TEXTURE_ATLAS_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace hl_mdlviewer {
+
+/** \brief The place of an image in an atlas, in texels, without its padding. */
+struct AtlasRect
+{
+    AtlasRect() :
+        x(0),
+        y(0),
+        width(0),
+        height(0)
+    {
+    }
+
+    AtlasRect(unsigned int width, unsigned int height) :
+        x(0),
+        y(0),
+        width(width),
+        height(height)
+    {
+    }
+
+    unsigned int x;
+    unsigned int y;
+    unsigned int width;
+    unsigned int height;
+};
+
+/** \brief Pack images into rows of an atlas, the tallest images first.
+*
+* The atlas width is the smallest power of two that fits the images
+* within \p max_size, the height is as small as the rows allow.
+*
+* With an \p alignment, the padded images and the atlas height are
+* rounded up to its multiples, so that mip levels down to a size divided
+* by \p alignment keep the images in place.
+* \param[in,out] rects The image sizes, in which the positions are set.
+* \param[in] padding The texels kept free around each image.
+* \param[in] max_size The largest width and height of the atlas.
+* \param[out] atlas_width The atlas width.
+* \param[out] atlas_height The atlas height.
+* \param[in] alignment A power of two the padded images are aligned to.
+* \return false if the images do not fit.
+*/
+bool pack_atlas(std::vector<AtlasRect>& rects,
+    unsigned int padding,
+    unsigned int max_size,
+    unsigned int& atlas_width,
+    unsigned int& atlas_height,
+    unsigned int alignment = 1);
+
+/** \brief Copy an image into its place in an atlas, and repeat its edge
+*          texels in the padding around it.
+*
+* Filtering near an edge then reads the edge, like GL_CLAMP_TO_EDGE.
+* \param[in] pixels The image texels.
+* \param[in] bytes_per_texel The size of a texel, in the image and the atlas.
+* \param[in] rect The place of the image.
+* \param[in] padding The padding the atlas was packed with.
+* \param[in,out] atlas The atlas texels.
+* \param[in] atlas_width The atlas width.
+*/
+void copy_to_atlas(const uint8_t* pixels,
+    unsigned int bytes_per_texel,
+    const AtlasRect& rect,
+    unsigned int padding,
+    uint8_t* atlas,
+    unsigned int atlas_width);
+
+}
+
+#endif // HLMDLVIEWER_TEXTURE_ATLAS_H_
@@ -0,0 +1,133 @@
+/**
+* \file texture_cache.cpp
+* \brief Implementation for the texture cache class.
+*/
+
+#include "pch.h"
+#include "texture_cache.h"
+#include "content_hash.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace hl_mdlviewer {
+
+namespace {
+
+const char CACHE_FILE_MAGIC[4] = { 'H', 'L', 'T', 'C' };
+const uint32_t CACHE_FILE_VERSION = 1;
+const uint32_t MAX_CACHED_LEVELS = 32;
+
+template<typename T>
+bool read_value(std::istream& stream, T& value)
+{
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template<typename T>
+void write_value(std::ostream& stream, const T& value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}
+
+TextureCache::TextureCache() :
+    directory_()
+{
+}
+
+bool TextureCache::load(uint64_t key, std::vector<MipLevel>& levels) const
+{
+    if (!enabled())
+        return false;
+
+    std::ifstream file(get_file_path(key), std::ios::binary);
+    if (!file)
+        return false;
+
+    char magic[4];
+    uint32_t version, num_levels;
+    if (!file.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, CACHE_FILE_MAGIC, sizeof(magic)) != 0 ||
+        !read_value(file, version) || version != CACHE_FILE_VERSION ||
+        !read_value(file, num_levels) || num_levels == 0 || num_levels > MAX_CACHED_LEVELS)
+        return false;
+
+    std::vector<MipLevel> result(num_levels);
+    for (MipLevel& level : result)
+    {
+        uint64_t size;
+        if (!read_value(file, level.width) || !read_value(file, level.height) || !read_value(file, size))
+            return false;
+
+        // The texels are at most 4 bytes each, anything else is corrupt.
+        if (size > static_cast<uint64_t>(level.width) * level.height * 4)
+            return false;
+
+        level.pixels.resize(static_cast<size_t>(size));
+        if (!file.read(reinterpret_cast<char*>(level.pixels.data()), static_cast<std::streamsize>(size)))
+            return false;
+    }
+
+    levels = std::move(result);
+    return true;
+}
+
+bool TextureCache::store(uint64_t key, const std::vector<MipLevel>& levels) const
+{
+    if (!enabled() || levels.empty() || levels.size() > MAX_CACHED_LEVELS)
+        return false;
+
+    std::error_code error;
+    fs::create_directories(directory_, error);
+    if (error)
+        return false;
+
+    const std::string file_path = get_file_path(key);
+    const std::string temporary_path = file_path + ".tmp";
+
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        file.write(CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+        write_value(file, CACHE_FILE_VERSION);
+        write_value(file, static_cast<uint32_t>(levels.size()));
+
+        for (const MipLevel& level : levels)
+        {
+            write_value(file, level.width);
+            write_value(file, level.height);
+            write_value(file, static_cast<uint64_t>(level.pixels.size()));
+            file.write(reinterpret_cast<const char*>(level.pixels.data()),
+                static_cast<std::streamsize>(level.pixels.size()));
+        }
+
+        if (!file)
+        {
+            file.close();
+            fs::remove(temporary_path, error);
+            return false;
+        }
+    }
+
+    fs::rename(temporary_path, file_path, error);
+    if (error)
+    {
+        fs::remove(temporary_path, error);
+        return false;
+    }
+
+    return true;
+}
+
+std::string TextureCache::get_file_path(uint64_t key) const
+{
+    return (fs::path(directory_) / (hash_to_string(key) + ".tex")).string();
+}
+
+}
@@ -0,0 +1,57 @@
+/**
+* \file texture_cache.h
+* \brief Declaration for the texture cache class.
+*/
+
+#ifndef HLMDLVIEWER_TEXTURE_CACHE_H_
+#define HLMDLVIEWER_TEXTURE_CACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "image.h"
+
+namespace hl_mdlviewer {
+
+/** \brief Keeps processed textures on disk, one file per texture named
+* after a hash of everything the processing depends on.
+*
+* Since the key covers the inputs, entries are never invalidated: a change
+* of the inputs is a new key. Stale files are left for the user to delete.
+*/
+class TextureCache
+{
+public:
+    TextureCache();
+    TextureCache(const TextureCache&) = delete;
+
+    /** \brief Set the directory of the cache, created when first stored
+    *          to. An empty directory disables the cache. */
+    inline void set_directory(const std::string& directory) { directory_ = directory; }
+    inline const std::string& directory() const { return directory_; }
+
+    inline bool enabled() const { return !directory_.empty(); }
+
+    /** \brief Read the levels of a texture.
+    * \param[in] key The hash of the texture inputs.
+    * \param[out] levels The levels, as stored.
+    * \return false if the texture is not cached, or its file is invalid.
+    */
+    bool load(uint64_t key, std::vector<MipLevel>& levels) const;
+
+    /** \brief Write the levels of a texture. The file is written aside and
+    *          renamed, so that readers never see a partial file.
+    * \return false if the file could not be written.
+    */
+    bool store(uint64_t key, const std::vector<MipLevel>& levels) const;
+
+private:
+
+    std::string get_file_path(uint64_t key) const;
+
+    std::string directory_;
+};
+
+}
+
+#endif // HLMDLVIEWER_TEXTURE_CACHE_H_
@@ -0,0 +1,295 @@
+/**
+* \file texture_compression.cpp
+* \brief Implementation for the BC1 and BC3 texture compression functions.
+*/
+
+#include "pch.h"
+#include "texture_compression.h"
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace hl_mdlviewer {
+
+namespace {
+
+const unsigned int BLOCK_TEXELS = 16;
+
+/** \brief Pack a BGRA color to 5:6:5 bits, red in the high bits. */
+uint16_t to_rgb565(const float* color)
+{
+    const auto quantize = [](float value, int max_value) {
+        return static_cast<int>(std::min(std::max(value, 0.0f), 255.0f) * max_value / 255.0f + 0.5f);
+    };
+
+    return static_cast<uint16_t>(
+        (quantize(color[2], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[0], 31));
+}
+
+/** \brief Expand 5:6:5 bits to a BGR color. */
+void from_rgb565(uint16_t value, int* color)
+{
+    const int r = (value >> 11) & 31;
+    const int g = (value >> 5) & 63;
+    const int b = value & 31;
+    color[0] = (b << 3) | (b >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (r << 3) | (r >> 2);
+}
+
+/** \brief Encode the colors of a block, ignoring the texels not in \p used.
+*
+* The end points are the extremes of the texels along their principal
+* axis, and every texel picks the closest of the four colors.
+*/
+void encode_color_block(const uint8_t* texels, const bool* used, uint8_t* block)
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    unsigned int num_used = 0;
+    for (unsigned int i = 0; i < BLOCK_TEXELS; ++i)
+    {
+        if (!used[i])
+            continue;
+
+        for (int c = 0; c < 3; ++c)
+            mean[c] += texels[i * 4 + c];
+        ++num_used;
+    }
+
+    for (int c = 0; c < 3; ++c)
+        mean[c] /= num_used;
+
+    float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (unsigned int i = 0; i < BLOCK_TEXELS; ++i)
+    {
+        if (!used[i])
+            continue;
+
+        const float d0 = texels[i * 4] - mean[0];
+        const float d1 = texels[i * 4 + 1] - mean[1];
+        const float d2 = texels[i * 4 + 2] - mean[2];
+        covariance[0] += d0 * d0;
+        covariance[1] += d0 * d1;
+        covariance[2] += d0 * d2;
+        covariance[3] += d1 * d1;
+        covariance[4] += d1 * d2;
+        covariance[5] += d2 * d2;
+    }
+
+    // The principal axis, by power iteration.
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+        const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+        const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+        const float length = std::max(std::max(std::abs(x), std::abs(y)), std::abs(z));
+        if (length < 1e-6f)
+            break;
+
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    float min_projection = FLT_MAX, max_projection = -FLT_MAX;
+    float min_color[3] = { 0.0f, 0.0f, 0.0f }, max_color[3] = { 0.0f, 0.0f, 0.0f };
+    for (unsigned int i = 0; i < BLOCK_TEXELS; ++i)
+    {
+        if (!used[i])
+            continue;
+
+        const uint8_t* texel = &texels[i * 4];
+        const float projection = texel[0] * axis[0] + texel[1] * axis[1] + texel[2] * axis[2];
+        if (projection < min_projection)
+        {
+            min_projection = projection;
+            for (int c = 0; c < 3; ++c)
+                min_color[c] = texel[c];
+        }
+        if (projection > max_projection)
+        {
+            max_projection = projection;
+            for (int c = 0; c < 3; ++c)
+                max_color[c] = texel[c];
+        }
+    }
+
+    uint16_t color0 = to_rgb565(max_color);
+    uint16_t color1 = to_rgb565(min_color);
+
+    // The first color is the larger one for the four color mode.
+    if (color0 < color1)
+        std::swap(color0, color1);
+
+    uint32_t indices = 0;
+    if (color0 != color1)
+    {
+        int palette[4][3];
+        from_rgb565(color0, palette[0]);
+        from_rgb565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (unsigned int i = 0; i < BLOCK_TEXELS; ++i)
+        {
+            const uint8_t* texel = &texels[i * 4];
+
+            uint32_t best_index = 0;
+            int best_distance = INT_MAX;
+            for (uint32_t j = 0; j < 4; ++j)
+            {
+                const int d0 = texel[0] - palette[j][0];
+                const int d1 = texel[1] - palette[j][1];
+                const int d2 = texel[2] - palette[j][2];
+                const int distance = d0 * d0 + d1 * d1 + d2 * d2;
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    best_index = j;
+                }
+            }
+
+            indices |= best_index << (i * 2);
+        }
+    }
+
+    block[0] = static_cast<uint8_t>(color0);
+    block[1] = static_cast<uint8_t>(color0 >> 8);
+    block[2] = static_cast<uint8_t>(color1);
+    block[3] = static_cast<uint8_t>(color1 >> 8);
+    for (int i = 0; i < 4; ++i)
+        block[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+}
+
+/** \brief Encode the alpha of a block, with 8 levels between the extremes. */
+void encode_alpha_block(const uint8_t* texels, uint8_t* block)
+{
+    int alpha0 = 0, alpha1 = 255;
+    for (unsigned int i = 0; i < BLOCK_TEXELS; ++i)
+    {
+        alpha0 = std::max(alpha0, static_cast<int>(texels[i * 4 + 3]));
+        alpha1 = std::min(alpha1, static_cast<int>(texels[i * 4 + 3]));
+    }
+
+    uint64_t indices = 0;
+    if (alpha0 != alpha1)
+    {
+        int values[8] = { alpha0, alpha1 };
+        for (int j = 2; j < 8; ++j)
+            values[j] = ((8 - j) * alpha0 + (j - 1) * alpha1) / 7;
+
+        for (unsigned int i = 0; i < BLOCK_TEXELS; ++i)
+        {
+            const int alpha = texels[i * 4 + 3];
+
+            uint64_t best_index = 0;
+            int best_distance = INT_MAX;
+            for (uint64_t j = 0; j < 8; ++j)
+            {
+                const int distance = std::abs(alpha - values[j]);
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    best_index = j;
+                }
+            }
+
+            indices |= best_index << (i * 3);
+        }
+    }
+
+    block[0] = static_cast<uint8_t>(alpha0);
+    block[1] = static_cast<uint8_t>(alpha1);
+    for (int i = 0; i < 6; ++i)
+        block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+}
+
+}
+
+size_t get_compressed_size(unsigned int width, unsigned int height, TextureCompression compression)
+{
+    const size_t num_blocks = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+    switch (compression)
+    {
+    case TextureCompression::BC1: return num_blocks * 8;
+    case TextureCompression::BC3: return num_blocks * 16;
+    default: return static_cast<size_t>(width) * height * 4;
+    }
+}
+
+void encode_bc1_block(const uint8_t* texels, uint8_t* block)
+{
+    bool used[BLOCK_TEXELS];
+    std::fill(used, used + BLOCK_TEXELS, true);
+    encode_color_block(texels, used, block);
+}
+
+void encode_bc3_block(const uint8_t* texels, uint8_t* block)
+{
+    encode_alpha_block(texels, block);
+
+    // The transparent texels are discarded, their colors do not matter.
+    bool used[BLOCK_TEXELS];
+    bool any_used = false;
+    for (unsigned int i = 0; i < BLOCK_TEXELS; ++i)
+    {
+        used[i] = texels[i * 4 + 3] != 0;
+        any_used = any_used || used[i];
+    }
+
+    if (!any_used)
+        std::fill(used, used + BLOCK_TEXELS, true);
+
+    encode_color_block(texels, used, block + 8);
+}
+
+void compress_image(const uint8_t* pixels,
+    unsigned int width, unsigned int height,
+    TextureCompression compression,
+    uint8_t* blocks,
+    ThreadPool* thread_pool)
+{
+    const unsigned int blocks_x = (width + 3) / 4;
+    const unsigned int blocks_y = (height + 3) / 4;
+    const size_t block_size = compression == TextureCompression::BC1 ? 8 : 16;
+
+    const auto compress_row = [&](size_t block_y, size_t) {
+        uint8_t texels[BLOCK_TEXELS * 4];
+
+        for (unsigned int block_x = 0; block_x < blocks_x; ++block_x)
+        {
+            for (unsigned int y = 0; y < 4; ++y)
+            {
+                const unsigned int source_y = std::min(static_cast<unsigned int>(block_y) * 4 + y, height - 1);
+                for (unsigned int x = 0; x < 4; ++x)
+                {
+                    const unsigned int source_x = std::min(block_x * 4 + x, width - 1);
+                    std::memcpy(&texels[(y * 4 + x) * 4],
+                        &pixels[(static_cast<size_t>(source_y) * width + source_x) * 4], 4);
+                }
+            }
+
+            uint8_t* block = &blocks[(block_y * blocks_x + block_x) * block_size];
+            if (compression == TextureCompression::BC1)
+                encode_bc1_block(texels, block);
+            else
+                encode_bc3_block(texels, block);
+        }
+    };
+
+    if (thread_pool && thread_pool->num_threads() > 1 && blocks_y > 1)
+    {
+        thread_pool->parallel_for(blocks_y, compress_row);
+        return;
+    }
+
+    for (size_t block_y = 0; block_y < blocks_y; ++block_y)
+        compress_row(block_y, 0);
+}
+
+}
@@ -0,0 +1,65 @@
+/**
+* \file texture_compression.h
+* \brief Declaration for the BC1 and BC3 texture compression functions.
+*/
+
+#ifndef HLMDLVIEWER_TEXTURE_COMPRESSION_H_
+#define HLMDLVIEWER_TEXTURE_COMPRESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "thread_pool.h"
+
+// From GL_EXT_texture_compression_s3tc, which glad does not load.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace hl_mdlviewer {
+
+enum class TextureCompression
+{
+    NONE,
+    BC1,    // Opaque colors, 8 bytes per 4x4 block.
+    BC3     // Colors and alpha, 16 bytes per 4x4 block.
+};
+
+/** \brief Get the size of an image once compressed, in bytes. */
+size_t get_compressed_size(unsigned int width, unsigned int height, TextureCompression compression);
+
+/** \brief Encode 4x4 BGRA texels as a BC1 block.
+* \param[in] texels The texels, row by row.
+* \param[out] block The 8 bytes of the block.
+*/
+void encode_bc1_block(const uint8_t* texels, uint8_t* block);
+
+/** \brief Encode 4x4 BGRA texels as a BC3 block.
+*
+* The colors of the texels with an alpha of 0 are ignored.
+* \param[in] texels The texels, row by row.
+* \param[out] block The 16 bytes of the block.
+*/
+void encode_bc3_block(const uint8_t* texels, uint8_t* block);
+
+/** \brief Compress a BGRA image.
+*
+* The blocks over the edges of the image repeat its last row and column.
+* \param[in] pixels The BGRA texels.
+* \param[in] width The image width.
+* \param[in] height The image height.
+* \param[in] compression The block format, not \ref TextureCompression::NONE.
+* \param[out] blocks The blocks, \ref get_compressed_size bytes.
+* \param[in] thread_pool The pool to encode rows of blocks on, or null.
+*/
+void compress_image(const uint8_t* pixels,
+    unsigned int width, unsigned int height,
+    TextureCompression compression,
+    uint8_t* blocks,
+    ThreadPool* thread_pool = nullptr);
+
+}
+
+#endif // HLMDLVIEWER_TEXTURE_COMPRESSION_H_
@@ -0,0 +1,221 @@
+/**
+* \file texture_mipmaps.cpp
+* \brief Implementation for the mip level generation functions.
+*/
+
+#include "pch.h"
+#include "texture_mipmaps.h"
+#include <climits>
+#include <cstring>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HLMDLVIEWER_MIPMAPS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace hl_mdlviewer {
+
+namespace {
+
+bool is_opaque(const MipLevel& level)
+{
+    for (size_t i = 3; i < level.pixels.size(); i += 4)
+    {
+        if (level.pixels[i] != 255)
+            return false;
+    }
+
+    return true;
+}
+
+/** \brief Average 2x2 texels, their colors weighted by their alpha. */
+void filter_texel(const uint8_t* t00, const uint8_t* t10,
+    const uint8_t* t01, const uint8_t* t11,
+    uint8_t* output)
+{
+    const unsigned int a00 = t00[3], a10 = t10[3], a01 = t01[3], a11 = t11[3];
+    const unsigned int alpha = a00 + a10 + a01 + a11;
+
+    for (int c = 0; c < 3; ++c)
+    {
+        if (alpha == 0)
+        {
+            output[c] = static_cast<uint8_t>((t00[c] + t10[c] + t01[c] + t11[c] + 2) / 4);
+            continue;
+        }
+
+        const unsigned int sum = t00[c] * a00 + t10[c] * a10 + t01[c] * a01 + t11[c] * a11;
+        output[c] = static_cast<uint8_t>((sum + alpha / 2) / alpha);
+    }
+
+    output[3] = static_cast<uint8_t>((alpha + 2) / 4);
+}
+
+#ifdef HLMDLVIEWER_MIPMAPS_SSE2
+/** \brief Average 2x2 opaque texels, two output texels at a time.
+*
+* With an alpha of 255 everywhere, the weighted average of \ref filter_texel
+* is the plain average.
+* \param[in] count The number of output texels whose 2x2 texels are all
+*            in the rows.
+* \return The number of output texels done.
+*/
+unsigned int filter_opaque_row(const uint8_t* row0, const uint8_t* row1,
+    uint8_t* output, unsigned int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+
+    unsigned int x = 0;
+    for (; x + 2 <= count; x += 2)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+
+        // The sums of the two rows, texels 0 and 1, then 2 and 3.
+        const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+        // Texels 0 + 1, and 2 + 3.
+        const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+        const __m128i average = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + x * 4), _mm_packus_epi16(average, zero));
+    }
+
+    return x;
+}
+#endif
+
+void downsample(const MipLevel& source, MipLevel& target)
+{
+    const bool opaque = is_opaque(source);
+    const size_t source_row_size = static_cast<size_t>(source.width) * 4;
+
+    for (unsigned int y = 0; y < target.height; ++y)
+    {
+        const unsigned int y0 = y * 2;
+        const unsigned int y1 = std::min(y0 + 1, source.height - 1);
+        const uint8_t* row0 = source.pixels.data() + y0 * source_row_size;
+        const uint8_t* row1 = source.pixels.data() + y1 * source_row_size;
+        uint8_t* output = target.pixels.data() + static_cast<size_t>(y) * target.width * 4;
+
+        unsigned int x = 0;
+#ifdef HLMDLVIEWER_MIPMAPS_SSE2
+        if (opaque)
+            x = filter_opaque_row(row0, row1, output, source.width / 2);
+#else
+        (void)opaque;
+#endif
+
+        for (; x < target.width; ++x)
+        {
+            const unsigned int x0 = x * 2;
+            const unsigned int x1 = std::min(x0 + 1, source.width - 1);
+            filter_texel(row0 + x0 * 4, row0 + x1 * 4, row1 + x0 * 4, row1 + x1 * 4, output + x * 4);
+        }
+    }
+}
+
+}
+
+void generate_mipmaps(const uint8_t* pixels,
+    unsigned int width, unsigned int height,
+    unsigned int num_levels,
+    std::vector<MipLevel>& levels)
+{
+    levels.assign(std::max(num_levels, 1u), MipLevel());
+
+    levels[0] = MipLevel(width, height, static_cast<size_t>(width) * height * 4);
+    std::memcpy(levels[0].pixels.data(), pixels, levels[0].pixels.size());
+
+    for (size_t i = 1; i < levels.size(); ++i)
+    {
+        const MipLevel& source = levels[i - 1];
+        const unsigned int level_width = mip_level_size(source.width, 1);
+        const unsigned int level_height = mip_level_size(source.height, 1);
+
+        levels[i] = MipLevel(level_width, level_height, static_cast<size_t>(level_width) * level_height * 4);
+        downsample(source, levels[i]);
+    }
+}
+
+void generate_palettized_mipmaps(const uint8_t* indices,
+    unsigned int width, unsigned int height,
+    const uint8_t* palette,
+    int mask_index,
+    unsigned int num_levels,
+    std::vector<MipLevel>& levels)
+{
+    const size_t num_texels = static_cast<size_t>(width) * height;
+
+    // Filter the colors, only the colors used by the image can be picked.
+    bool used[256] = {};
+    std::vector<uint8_t> colors(num_texels * 4);
+    for (size_t i = 0; i < num_texels; ++i)
+    {
+        const uint8_t index = indices[i];
+        std::memcpy(&colors[i * 4], &palette[index * 4], 3);
+        colors[i * 4 + 3] = index == mask_index ? 0 : 255;
+        used[index] = index != mask_index;
+    }
+
+    std::vector<MipLevel> color_levels;
+    generate_mipmaps(colors.data(), width, height, num_levels, color_levels);
+
+    levels.assign(color_levels.size(), MipLevel());
+    levels[0] = MipLevel(width, height, num_texels);
+    std::memcpy(levels[0].pixels.data(), indices, num_texels);
+
+    std::unordered_map<uint32_t, uint8_t> closest_indices;
+
+    for (size_t i = 1; i < levels.size(); ++i)
+    {
+        const MipLevel& color_level = color_levels[i];
+        MipLevel& level = levels[i];
+        level = MipLevel(color_level.width, color_level.height,
+            static_cast<size_t>(color_level.width) * color_level.height);
+
+        for (size_t j = 0; j < level.pixels.size(); ++j)
+        {
+            const uint8_t* color = &color_level.pixels[j * 4];
+
+            // Mostly transparent texels stay transparent.
+            if (mask_index >= 0 && color[3] < 128)
+            {
+                level.pixels[j] = static_cast<uint8_t>(mask_index);
+                continue;
+            }
+
+            const uint32_t key = color[0] | (color[1] << 8) | (color[2] << 16);
+            auto it = closest_indices.find(key);
+            if (it == closest_indices.end())
+            {
+                int best_index = 0;
+                int best_distance = INT_MAX;
+                for (int k = 0; k < 256; ++k)
+                {
+                    if (!used[k])
+                        continue;
+
+                    const int d0 = color[0] - palette[k * 4];
+                    const int d1 = color[1] - palette[k * 4 + 1];
+                    const int d2 = color[2] - palette[k * 4 + 2];
+                    const int distance = d0 * d0 + d1 * d1 + d2 * d2;
+                    if (distance < best_distance)
+                    {
+                        best_distance = distance;
+                        best_index = k;
+                    }
+                }
+
+                it = closest_indices.emplace(key, static_cast<uint8_t>(best_index)).first;
+            }
+
+            level.pixels[j] = it->second;
+        }
+    }
+}
+
+}
@@ -0,0 +1,59 @@
+/**
+* \file texture_mipmaps.h
+* \brief Declaration for the mip level generation functions.
+*/
+
+#ifndef HLMDLVIEWER_TEXTURE_MIPMAPS_H_
+#define HLMDLVIEWER_TEXTURE_MIPMAPS_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "image.h"
+
+namespace hl_mdlviewer {
+
+/** \brief Get the size of a mip level: halved per level, rounded up,
+*          down to 1 texel. */
+inline unsigned int mip_level_size(unsigned int size, unsigned int level) {
+    return std::max((size + (1u << level) - 1) >> level, 1u);
+}
+
+/** \brief Generate the mip levels of a BGRA image with a 2x2 box filter.
+*
+* The colors are weighted by their alpha, so that the colors of masked
+* texels, with an alpha of 0, do not bleed into the smaller levels.
+* Odd sizes repeat the last row and column.
+* \param[in] pixels The BGRA texels of the image.
+* \param[in] width The image width.
+* \param[in] height The image height.
+* \param[in] num_levels The number of levels, including the image.
+* \param[out] levels The levels, from the image.
+*/
+void generate_mipmaps(const uint8_t* pixels,
+    unsigned int width, unsigned int height,
+    unsigned int num_levels,
+    std::vector<MipLevel>& levels);
+
+/** \brief Generate the mip levels of an image of palette indices.
+*
+* The colors are filtered as \ref generate_mipmaps does, then mapped back
+* to the closest color of the palette.
+* \param[in] indices The palette indices of the image.
+* \param[in] width The image width.
+* \param[in] height The image height.
+* \param[in] palette The 256 BGRA colors of the palette.
+* \param[in] mask_index The index of the transparent color, or -1.
+* \param[in] num_levels The number of levels, including the image.
+* \param[out] levels The levels, from the image.
+*/
+void generate_palettized_mipmaps(const uint8_t* indices,
+    unsigned int width, unsigned int height,
+    const uint8_t* palette,
+    int mask_index,
+    unsigned int num_levels,
+    std::vector<MipLevel>& levels);
+
+}
+
+#endif // HLMDLVIEWER_TEXTURE_MIPMAPS_H_
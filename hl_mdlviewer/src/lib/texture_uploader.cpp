@@ -0,0 +1,320 @@
+/**
+* \file texture_uploader.cpp
+* \brief Implementation for the texture uploader class.
+*/
+
+#include "pch.h"
+#include "texture_uploader.h"
+#include "render_backend.h"
+#include <cstring>
+
+namespace hl_mdlviewer {
+
+TextureUploader::TextureUploader(size_t num_threads, size_t frame_budget) :
+    frame_budget_(frame_budget),
+    uploads_(),
+    mutex_(),
+    work_available_(),
+    work_done_(),
+    work_(),
+    stopping_(false),
+    workers_()
+{
+    num_threads = std::max(num_threads, static_cast<size_t>(1));
+    for (size_t i = 0; i < num_threads; ++i)
+        workers_.emplace_back(&TextureUploader::worker_main, this);
+}
+
+TextureUploader::~TextureUploader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+
+    work_available_.notify_all();
+    for (std::thread& worker : workers_)
+        worker.join();
+}
+
+void TextureUploader::upload(gltexture& texture,
+    unsigned int width, unsigned int height,
+    GLint internal_format, GLint format,
+    std::vector<uint8_t> pixels)
+{
+    std::vector<MipLevel> levels(1);
+    levels[0].width = width;
+    levels[0].height = height;
+    levels[0].pixels = std::move(pixels);
+
+    upload(texture, internal_format, format, std::move(levels));
+}
+
+void TextureUploader::upload(gltexture& texture,
+    GLint internal_format, GLint format,
+    std::vector<MipLevel> levels)
+{
+    // The storage is allocated now, so that the texture can be bound.
+    texture.create_from_levels(levels, internal_format, format, false);
+
+    std::unique_ptr<Upload> upload(new Upload());
+    upload->texture = texture.id();
+    upload->internal_format = internal_format;
+    upload->format = format;
+    upload->size = 0;
+    for (const MipLevel& level : levels)
+    {
+        upload->level_sizes.push_back(level.pixels.size());
+        upload->size += level.pixels.size();
+    }
+    upload->levels = std::move(levels);
+    upload->state = UploadState::QUEUED;
+    upload->cancelled = false;
+    upload->pixel_buffer = 0;
+    upload->mapped_pixels = nullptr;
+    upload->fence = nullptr;
+    upload->filled = false;
+
+    uploads_.push_back(std::move(upload));
+}
+
+void TextureUploader::update()
+{
+    RenderBackend& backend = render_backend();
+    size_t specified_bytes = 0;
+
+    for (auto& upload : uploads_)
+    {
+        if (upload->cancelled)
+            continue;
+
+        if (upload->state == UploadState::QUEUED)
+            begin_fill(*upload);
+
+        if (upload->state == UploadState::FILLING && upload->filled)
+            upload->state = UploadState::FILLED;
+
+        // The uploads are specified in order, within the budget.
+        if (upload->state == UploadState::FILLED &&
+            (specified_bytes == 0 || specified_bytes + upload->size <= frame_budget_))
+        {
+            specified_bytes += upload->size;
+            specify(*upload);
+        }
+        else if (upload->state == UploadState::SPECIFIED)
+        {
+            const GLenum status = backend.client_wait_sync(upload->fence, 0, 0);
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+            {
+                release(*upload);
+                upload->state = UploadState::DONE;
+            }
+        }
+    }
+
+    // Cancelled uploads are only dropped once their worker is done.
+    for (auto& upload : uploads_)
+    {
+        if (upload->cancelled && (upload->state != UploadState::FILLING || upload->filled))
+        {
+            release(*upload);
+            upload->state = UploadState::DONE;
+        }
+    }
+
+    uploads_.erase(std::remove_if(uploads_.begin(), uploads_.end(),
+        [](const std::unique_ptr<Upload>& upload) { return upload->state == UploadState::DONE; }),
+        uploads_.end());
+}
+
+bool TextureUploader::is_ready(const gltexture& texture) const
+{
+    for (const auto& upload : uploads_)
+    {
+        if (upload->texture == texture.id() && !upload->cancelled)
+            return false;
+    }
+
+    return true;
+}
+
+void TextureUploader::cancel(const gltexture& texture)
+{
+    for (auto& upload : uploads_)
+    {
+        if (upload->texture == texture.id())
+            upload->cancelled = true;
+    }
+}
+
+void TextureUploader::flush()
+{
+    RenderBackend& backend = render_backend();
+
+    for (auto& upload : uploads_)
+    {
+        if (upload->cancelled)
+            continue;
+
+        if (upload->state == UploadState::QUEUED)
+            begin_fill(*upload);
+
+        if (upload->state == UploadState::FILLING)
+        {
+            wait_filled(*upload);
+            upload->state = UploadState::FILLED;
+        }
+
+        if (upload->state == UploadState::FILLED)
+            specify(*upload);
+
+        backend.client_wait_sync(upload->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        release(*upload);
+        upload->state = UploadState::DONE;
+    }
+
+    dispose();
+}
+
+void TextureUploader::dispose()
+{
+    for (auto& upload : uploads_)
+        release(*upload);
+
+    uploads_.clear();
+}
+
+void TextureUploader::begin_fill(Upload& upload)
+{
+    RenderBackend& backend = render_backend();
+    const GLsizeiptr size = static_cast<GLsizeiptr>(upload.size);
+
+    upload.pixel_buffer = backend.create_buffer();
+    backend.bind_buffer(GL_PIXEL_UNPACK_BUFFER, upload.pixel_buffer);
+    backend.buffer_data(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    upload.mapped_pixels = backend.map_buffer_range(GL_PIXEL_UNPACK_BUFFER, 0, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    backend.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!upload.mapped_pixels)
+    {
+        // Without a mapping, the texels are specified from memory.
+        upload.filled = true;
+        upload.state = UploadState::FILLED;
+        return;
+    }
+
+    upload.state = UploadState::FILLING;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        work_.push_back(&upload);
+    }
+
+    work_available_.notify_one();
+}
+
+void TextureUploader::specify(Upload& upload)
+{
+    RenderBackend& backend = render_backend();
+
+    const bool from_buffer = upload.mapped_pixels != nullptr;
+    if (from_buffer)
+    {
+        backend.bind_buffer(GL_PIXEL_UNPACK_BUFFER, upload.pixel_buffer);
+        backend.unmap_buffer(GL_PIXEL_UNPACK_BUFFER);
+        upload.mapped_pixels = nullptr;
+    }
+
+    backend.bind_texture(GL_TEXTURE_2D, upload.texture);
+
+    // The levels follow each other in the buffer.
+    size_t offset = 0;
+    for (size_t i = 0; i < upload.levels.size(); ++i)
+    {
+        const MipLevel& level = upload.levels[i];
+        const void* pixels = from_buffer ?
+            reinterpret_cast<const void*>(offset) : level.pixels.data();
+
+        specify_texture_level(static_cast<GLint>(i), level.width, level.height,
+            upload.internal_format, upload.format,
+            pixels, upload.level_sizes[i]);
+
+        offset += upload.level_sizes[i];
+    }
+
+    backend.bind_texture(GL_TEXTURE_2D, 0);
+    backend.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    upload.fence = backend.fence_sync();
+    upload.state = UploadState::SPECIFIED;
+
+    for (MipLevel& level : upload.levels)
+        std::vector<uint8_t>().swap(level.pixels);
+}
+
+void TextureUploader::release(Upload& upload)
+{
+    RenderBackend& backend = render_backend();
+
+    if (upload.state == UploadState::FILLING)
+        wait_filled(upload);
+
+    if (upload.mapped_pixels)
+    {
+        backend.bind_buffer(GL_PIXEL_UNPACK_BUFFER, upload.pixel_buffer);
+        backend.unmap_buffer(GL_PIXEL_UNPACK_BUFFER);
+        backend.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        upload.mapped_pixels = nullptr;
+    }
+
+    if (upload.fence)
+    {
+        backend.delete_sync(upload.fence);
+        upload.fence = nullptr;
+    }
+
+    if (upload.pixel_buffer)
+    {
+        backend.delete_buffer(upload.pixel_buffer);
+        upload.pixel_buffer = 0;
+    }
+}
+
+void TextureUploader::wait_filled(Upload& upload)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [&upload] { return upload.filled.load(); });
+}
+
+void TextureUploader::worker_main()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    for (;;)
+    {
+        work_available_.wait(lock, [this] { return !work_.empty() || stopping_; });
+
+        if (work_.empty())
+            break;
+
+        Upload* upload = work_.front();
+        work_.pop_front();
+
+        lock.unlock();
+
+        uint8_t* destination = static_cast<uint8_t*>(upload->mapped_pixels);
+        for (MipLevel& level : upload->levels)
+        {
+            std::memcpy(destination, level.pixels.data(), level.pixels.size());
+            destination += level.pixels.size();
+            std::vector<uint8_t>().swap(level.pixels);
+        }
+
+        lock.lock();
+        upload->filled = true;
+        work_done_.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,160 @@
+/**
+* \file texture_uploader.h
+* \brief Declaration for the texture uploader class.
+*/
+
+#ifndef HLMDLVIEWER_TEXTURE_UPLOADER_H_
+#define HLMDLVIEWER_TEXTURE_UPLOADER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "glad.h"
+#include "gltexture.h"
+
+namespace hl_mdlviewer {
+
+/** \brief Uploads textures over several frames through pixel unpack
+* buffers, so that loading does not stall the frame.
+*
+* Each upload goes through these steps:
+* (1) A pixel unpack buffer is mapped, and a worker thread copies the
+*     texels in.
+* (2) Once copied, the buffer is unmapped and the texture is specified
+*     from it. No more than the frame budget is specified per frame.
+* (3) Once the fence after the upload signals, the buffer is deleted and
+*     the texture is ready.
+* Until then, the texture exists but its texels are undefined.
+*
+* All functions but the worker threads run on the OpenGL thread.
+*/
+class TextureUploader
+{
+public:
+    /** \brief Start the workers.
+    * \param[in] num_threads The number of worker threads.
+    * \param[in] frame_budget The bytes specified per frame.
+    */
+    explicit TextureUploader(size_t num_threads = 1, size_t frame_budget = 4 * 1024 * 1024);
+
+    /** \brief Stop the workers. The OpenGL objects must have been
+    *          released with \ref dispose. */
+    ~TextureUploader();
+
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+
+    /** \brief Set the bytes specified per frame. At least one texture is
+    *          specified per frame, whatever its size. */
+    inline void set_frame_budget(size_t bytes) { frame_budget_ = bytes; }
+    inline size_t frame_budget() const { return frame_budget_; }
+
+    /** \brief Create a texture, and queue the upload of its texels.
+    * \param[out] texture The texture, created right away.
+    * \param[in] width The texture width.
+    * \param[in] height The texture height.
+    * \param[in] internal_format The texture format.
+    * \param[in] format The format of the texels, in unsigned bytes.
+    * \param[in] pixels The texels, tightly packed.
+    */
+    void upload(gltexture& texture,
+        unsigned int width, unsigned int height,
+        GLint internal_format, GLint format,
+        std::vector<uint8_t> pixels);
+
+    /** \brief Create a texture with mip levels, and queue the upload of
+    *          its levels.
+    * \param[out] texture The texture, created right away.
+    * \param[in] internal_format The texture format.
+    * \param[in] format The format of the texels, or 0 for compressed blocks.
+    * \param[in] levels The levels, from the largest.
+    */
+    void upload(gltexture& texture,
+        GLint internal_format, GLint format,
+        std::vector<MipLevel> levels);
+
+    /** \brief Advance the uploads. Call once per frame. */
+    void update();
+
+    /** \brief Whether the texels of a texture are uploaded, or it was
+    *          not uploaded by this uploader. */
+    bool is_ready(const gltexture& texture) const;
+
+    /** \brief Drop the upload of a texture, i.e. before deleting it. */
+    void cancel(const gltexture& texture);
+
+    /** \brief Complete all the uploads now. */
+    void flush();
+
+    /** \brief Drop all the uploads and delete their buffers. */
+    void dispose();
+
+    inline bool has_pending_uploads() const { return !uploads_.empty(); }
+
+private:
+
+    enum class UploadState
+    {
+        QUEUED,     // Waiting for a buffer.
+        FILLING,    // Mapped, a worker copies the texels.
+        FILLED,     // Waiting for the frame budget.
+        SPECIFIED,  // Waiting for the fence.
+        DONE
+    };
+
+    struct Upload
+    {
+        GLuint texture;
+        GLint internal_format;
+        GLint format;
+
+        /** \brief The levels, whose texels are freed once copied. */
+        std::vector<MipLevel> levels;
+        std::vector<size_t> level_sizes;
+        size_t size;
+
+        UploadState state;
+        bool cancelled;
+
+        GLuint pixel_buffer;
+        void* mapped_pixels;
+        GLsync fence;
+
+        /** \brief Set by the worker once the texels are copied. */
+        std::atomic<bool> filled;
+    };
+
+    void worker_main();
+
+    /** \brief Map a buffer for the upload and hand it to a worker. */
+    void begin_fill(Upload& upload);
+
+    /** \brief Specify the texture from its filled buffer. */
+    void specify(Upload& upload);
+
+    /** \brief Delete the OpenGL objects of an upload. Waits for the worker
+    *          if the buffer is being filled. */
+    void release(Upload& upload);
+
+    void wait_filled(Upload& upload);
+
+    size_t frame_budget_;
+
+    std::deque<std::unique_ptr<Upload>> uploads_;
+
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable work_done_;
+    std::deque<Upload*> work_;
+    bool stopping_;
+
+    std::vector<std::thread> workers_;
+};
+
+}
+
+#endif // HLMDLVIEWER_TEXTURE_UPLOADER_H_
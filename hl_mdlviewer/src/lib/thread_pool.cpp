@@ -0,0 +1,104 @@
+/**
+* \file thread_pool.cpp
+* \brief Implementation for the thread pool class.
+*/
+
+#include "pch.h"
+#include "thread_pool.h"
+
+namespace hl_mdlviewer
+{
+
+ThreadPool::ThreadPool(size_t num_threads) :
+    workers_(),
+    mutex_(),
+    work_available_(),
+    work_done_(),
+    task_(nullptr),
+    count_(0),
+    next_index_(0),
+    generation_(0),
+    num_busy_workers_(0),
+    stopping_(false)
+{
+    if (num_threads == 0)
+        num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (size_t i = 1; i < num_threads; ++i)
+        workers_.emplace_back(&ThreadPool::worker_main, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+void ThreadPool::parallel_for(size_t count, const Task& task)
+{
+    if (count == 0)
+        return;
+
+    if (workers_.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            task(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        count_ = count;
+        next_index_ = 0;
+        num_busy_workers_ = workers_.size();
+        ++generation_;
+    }
+    work_available_.notify_all();
+
+    run_items(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [this] { return num_busy_workers_ == 0; });
+    task_ = nullptr;
+}
+
+void ThreadPool::worker_main(size_t thread_index)
+{
+    size_t generation = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_available_.wait(lock, [&] { return stopping_ || generation_ != generation; });
+
+            if (stopping_)
+                return;
+
+            generation = generation_;
+        }
+
+        run_items(thread_index);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --num_busy_workers_;
+        }
+        work_done_.notify_one();
+    }
+}
+
+void ThreadPool::run_items(size_t thread_index)
+{
+    for (size_t i = next_index_++; i < count_; i = next_index_++)
+        (*task_)(i, thread_index);
+}
+
+}
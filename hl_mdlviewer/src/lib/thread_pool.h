@@ -0,0 +1,74 @@
+/**
+* \file thread_pool.h
+* \brief Declaration for the thread pool class.
+*/
+
+#ifndef HLMDLVIEWER_THREAD_POOL_H_
+#define HLMDLVIEWER_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hl_mdlviewer {
+
+/** \brief A fixed set of worker threads that run parallel loops. */
+class ThreadPool
+{
+public:
+    /** \brief The loop body, called with the item index and the index
+    * of the calling thread, in [0, num_threads()). */
+    using Task = std::function<void(size_t index, size_t thread_index)>;
+
+    /** \brief Start the workers.
+    * \param[in] num_threads The number of threads running loops,
+    *            including the caller. 0 uses the hardware concurrency.
+    */
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    inline size_t num_threads() const { return workers_.size() + 1; }
+
+    /** \brief Call \p task for every index in [0, \p count) and wait for
+    *          all calls to return. The caller takes part in the loop.
+    *
+    * Items are handed out one at a time, so the cost of an item may vary.
+    * Loops must not be nested.
+    */
+    void parallel_for(size_t count, const Task& task);
+
+private:
+
+    void worker_main(size_t thread_index);
+
+    /** \brief Run items of the current loop until there are none left. */
+    void run_items(size_t thread_index);
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable work_done_;
+
+    const Task* task_;
+    size_t count_;
+    std::atomic<size_t> next_index_;
+
+    /** \brief Incremented for each loop, so workers join a loop once. */
+    size_t generation_;
+
+    /** \brief The number of workers still in the current loop. */
+    size_t num_busy_workers_;
+
+    bool stopping_;
+};
+
+}
+
+#endif // HLMDLVIEWER_THREAD_POOL_H_
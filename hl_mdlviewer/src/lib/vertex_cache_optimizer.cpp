@@ -0,0 +1,266 @@
+/**
+* \file vertex_cache_optimizer.cpp
+* \brief Implementation for the vertex cache optimization functions.
+*/
+
+#include "pch.h"
+#include "vertex_cache_optimizer.h"
+#include <deque>
+
+namespace hl_mdlviewer {
+
+namespace {
+
+const int MAX_CACHE_SIZE = 32;
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+struct VertexData
+{
+    VertexData() :
+        cache_position(-1),
+        score(0),
+        num_remaining_triangles(0),
+        first_triangle(0)
+    {
+    }
+
+    int cache_position;
+    float score;
+    int num_remaining_triangles;
+
+    /** \brief Offset into the vertex to triangle adjacency list. */
+    size_t first_triangle;
+};
+
+float compute_vertex_score(const VertexData& vertex)
+{
+    if (vertex.num_remaining_triangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+
+    if (vertex.cache_position >= 0)
+    {
+        // The vertices of the last triangle get a fixed score, so that
+        // the next triangle does not simply reuse the same edge.
+        if (vertex.cache_position < 3)
+        {
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else
+        {
+            const float scaler = 1.0f / (MAX_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (vertex.cache_position - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Favor vertices with few remaining triangles, to finish them off
+    // before they get evicted.
+    score += VALENCE_BOOST_SCALE *
+        std::pow(static_cast<float>(vertex.num_remaining_triangles), -VALENCE_BOOST_POWER);
+
+    return score;
+}
+
+}
+
+void optimize_vertex_cache(std::vector<unsigned int>& indices, size_t num_vertices)
+{
+    const size_t num_triangles = indices.size() / 3;
+    if (num_triangles == 0)
+        return;
+
+    std::vector<VertexData> vertices(num_vertices);
+
+    // Build the vertex to triangle adjacency.
+    for (unsigned int index : indices)
+        ++vertices[index].num_remaining_triangles;
+
+    size_t offset = 0;
+    for (auto& vertex : vertices)
+    {
+        vertex.first_triangle = offset;
+        offset += vertex.num_remaining_triangles;
+    }
+
+    std::vector<unsigned int> adjacency(offset);
+    std::vector<int> num_adjacent(num_vertices, 0);
+    for (size_t t = 0; t < num_triangles; ++t)
+    {
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const unsigned int v = indices[t * 3 + k];
+            adjacency[vertices[v].first_triangle + num_adjacent[v]++] = static_cast<unsigned int>(t);
+        }
+    }
+
+    for (auto& vertex : vertices)
+        vertex.score = compute_vertex_score(vertex);
+
+    std::vector<float> triangle_scores(num_triangles);
+    std::vector<bool> triangle_added(num_triangles, false);
+    for (size_t t = 0; t < num_triangles; ++t)
+    {
+        triangle_scores[t] =
+            vertices[indices[t * 3]].score +
+            vertices[indices[t * 3 + 1]].score +
+            vertices[indices[t * 3 + 2]].score;
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    // The simulated LRU cache, with room for the 3 vertices of the
+    // triangle being added.
+    std::vector<int> cache;
+    cache.reserve(MAX_CACHE_SIZE + 3);
+
+    size_t best_triangle = 0;
+    for (size_t t = 1; t < num_triangles; ++t)
+    {
+        if (triangle_scores[t] > triangle_scores[best_triangle])
+            best_triangle = t;
+    }
+
+    size_t scan_position = 0;
+
+    for (size_t num_added = 0; num_added < num_triangles; ++num_added)
+    {
+        triangle_added[best_triangle] = true;
+
+        std::vector<int> new_cache;
+        new_cache.reserve(MAX_CACHE_SIZE + 3);
+
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const unsigned int v = indices[best_triangle * 3 + k];
+            output.push_back(v);
+            new_cache.push_back(static_cast<int>(v));
+
+            // Remove the triangle from the vertex adjacency.
+            VertexData& vertex = vertices[v];
+            unsigned int* triangles = &adjacency[vertex.first_triangle];
+            for (int i = 0; i < vertex.num_remaining_triangles; ++i)
+            {
+                if (triangles[i] == best_triangle)
+                {
+                    std::swap(triangles[i], triangles[vertex.num_remaining_triangles - 1]);
+                    break;
+                }
+            }
+            --vertex.num_remaining_triangles;
+        }
+
+        for (int v : cache)
+        {
+            if (std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end())
+                new_cache.push_back(v);
+        }
+
+        // Evicted vertices are no longer in the cache.
+        for (size_t i = MAX_CACHE_SIZE; i < new_cache.size(); ++i)
+        {
+            vertices[new_cache[i]].cache_position = -1;
+            vertices[new_cache[i]].score = compute_vertex_score(vertices[new_cache[i]]);
+        }
+
+        if (new_cache.size() > static_cast<size_t>(MAX_CACHE_SIZE))
+            new_cache.resize(MAX_CACHE_SIZE);
+
+        cache.swap(new_cache);
+
+        // Update the scores of the cached vertices and their triangles,
+        // and pick the best one among them.
+        float best_score = -1.0f;
+        bool found = false;
+
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            VertexData& vertex = vertices[cache[i]];
+            vertex.cache_position = static_cast<int>(i);
+            vertex.score = compute_vertex_score(vertex);
+        }
+
+        for (int v : cache)
+        {
+            const VertexData& vertex = vertices[v];
+            for (int i = 0; i < vertex.num_remaining_triangles; ++i)
+            {
+                const unsigned int t = adjacency[vertex.first_triangle + i];
+                triangle_scores[t] =
+                    vertices[indices[t * 3]].score +
+                    vertices[indices[t * 3 + 1]].score +
+                    vertices[indices[t * 3 + 2]].score;
+
+                if (triangle_scores[t] > best_score)
+                {
+                    best_score = triangle_scores[t];
+                    best_triangle = t;
+                    found = true;
+                }
+            }
+        }
+
+        if (!found && num_added + 1 < num_triangles)
+        {
+            // Nothing left around the cache, restart from the next
+            // triangle that was not added yet.
+            while (triangle_added[scan_position])
+                ++scan_position;
+            best_triangle = scan_position;
+        }
+    }
+
+    indices.swap(output);
+}
+
+void optimize_vertex_fetch(std::vector<glvertex>& vertices, std::vector<unsigned int>& indices)
+{
+    const unsigned int unused = UINT_MAX;
+
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    unsigned int next_vertex = 0;
+
+    for (auto& index : indices)
+    {
+        if (remap[index] == unused)
+            remap[index] = next_vertex++;
+        index = remap[index];
+    }
+
+    for (auto& index : remap)
+    {
+        if (index == unused)
+            index = next_vertex++;
+    }
+
+    std::vector<glvertex> reordered(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        reordered[remap[i]] = vertices[i];
+
+    vertices.swap(reordered);
+}
+
+size_t count_vertex_cache_misses(const std::vector<unsigned int>& indices, size_t cache_size)
+{
+    std::deque<unsigned int> cache;
+    size_t num_misses = 0;
+
+    for (unsigned int index : indices)
+    {
+        if (std::find(cache.begin(), cache.end(), index) != cache.end())
+            continue;
+
+        ++num_misses;
+        cache.push_back(index);
+        if (cache.size() > cache_size)
+            cache.pop_front();
+    }
+
+    return num_misses;
+}
+
+}
@@ -0,0 +1,39 @@
+/**
+* \file vertex_cache_optimizer.h
+* \brief Declaration for the vertex cache optimization functions.
+*/
+
+#ifndef HLMDLVIEWER_VERTEX_CACHE_OPTIMIZER_H_
+#define HLMDLVIEWER_VERTEX_CACHE_OPTIMIZER_H_
+
+#include <vector>
+#include "glvertex.h"
+
+namespace hl_mdlviewer {
+
+/** \brief Reorder triangles to improve post-transform cache hits,
+*          using Tom Forsyth's linear-speed algorithm.
+* \param[in, out] indices A triangle list.
+* \param[in] num_vertices The number of vertices referenced by \p indices.
+*/
+void optimize_vertex_cache(std::vector<unsigned int>& indices, size_t num_vertices);
+
+/** \brief Reorder vertices in the order they are first referenced,
+*          so that vertex fetch reads memory sequentially.
+*          Unreferenced vertices are moved to the end.
+* \param[in, out] vertices The vertices.
+* \param[in, out] indices A triangle list, remapped to the new order.
+*/
+void optimize_vertex_fetch(std::vector<glvertex>& vertices, std::vector<unsigned int>& indices);
+
+/** \brief Count the vertex cache misses of a triangle list with a
+*          simulated FIFO cache.
+* \param[in] indices A triangle list.
+* \param[in] cache_size The number of entries in the simulated cache.
+* \return The number of cache misses.
+*/
+size_t count_vertex_cache_misses(const std::vector<unsigned int>& indices, size_t cache_size = 16);
+
+}
+
+#endif // HLMDLVIEWER_VERTEX_CACHE_OPTIMIZER_H_
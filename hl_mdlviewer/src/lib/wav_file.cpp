@@ -0,0 +1,123 @@
+/**
+* \file wav_file.cpp
+* \brief Implementation for the WAV file functions.
+*/
+
+#include "pch.h"
+#include "wav_file.h"
+#include <cstring>
+
+namespace hl_mdlviewer {
+
+namespace {
+
+const uint16_t WAVE_FORMAT_PCM = 1;
+
+inline uint16_t read_uint16(const uint8_t* data)
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+inline uint32_t read_uint32(const uint8_t* data)
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+        (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+void write_uint16(std::ostream& stream, uint16_t value)
+{
+    const char bytes[2] = { static_cast<char>(value & 0xff), static_cast<char>(value >> 8) };
+    stream.write(bytes, sizeof(bytes));
+}
+
+void write_uint32(std::ostream& stream, uint32_t value)
+{
+    write_uint16(stream, static_cast<uint16_t>(value & 0xffff));
+    write_uint16(stream, static_cast<uint16_t>(value >> 16));
+}
+
+}
+
+bool decode_wav(const uint8_t* data, size_t size, PcmSound& sound)
+{
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+        return false;
+
+    uint16_t format = 0, num_channels = 0, bits_per_sample = 0;
+    uint32_t sample_rate = 0;
+    const uint8_t* samples = nullptr;
+    size_t samples_size = 0;
+
+    // The RIFF size is not trusted, some tools write it wrong.
+    size_t offset = 12;
+    while (offset + 8 <= size)
+    {
+        const uint8_t* chunk = data + offset;
+        const size_t chunk_size = std::min<size_t>(read_uint32(chunk + 4), size - offset - 8);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16)
+        {
+            format = read_uint16(chunk + 8);
+            num_channels = read_uint16(chunk + 10);
+            sample_rate = read_uint32(chunk + 12);
+            bits_per_sample = read_uint16(chunk + 22);
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0)
+        {
+            samples = chunk + 8;
+            samples_size = chunk_size;
+        }
+
+        // Chunks are padded to an even size.
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+
+    if (format != WAVE_FORMAT_PCM || !samples || sample_rate == 0 ||
+        (num_channels != 1 && num_channels != 2) ||
+        (bits_per_sample != 8 && bits_per_sample != 16))
+        return false;
+
+    const size_t frame_size = num_channels * (bits_per_sample / 8);
+    const size_t num_samples = (samples_size / frame_size) * num_channels;
+
+    std::vector<int16_t> result(num_samples);
+    if (bits_per_sample == 8)
+    {
+        // 8-bit samples are unsigned.
+        for (size_t i = 0; i < num_samples; ++i)
+            result[i] = static_cast<int16_t>((samples[i] - 128) * 256);
+    }
+    else
+    {
+        for (size_t i = 0; i < num_samples; ++i)
+            result[i] = static_cast<int16_t>(read_uint16(samples + i * 2));
+    }
+
+    sound.sample_rate = sample_rate;
+    sound.num_channels = num_channels;
+    sound.samples = std::move(result);
+    return true;
+}
+
+void write_wav_header(std::ostream& stream, uint32_t sample_rate, uint16_t num_channels, uint32_t data_size)
+{
+    const uint16_t block_align = num_channels * sizeof(int16_t);
+
+    stream.write("RIFF", 4);
+    write_uint32(stream, static_cast<uint32_t>(WAV_HEADER_SIZE - 8) + data_size);
+    stream.write("WAVE", 4);
+
+    stream.write("fmt ", 4);
+    write_uint32(stream, 16);
+    write_uint16(stream, WAVE_FORMAT_PCM);
+    write_uint16(stream, num_channels);
+    write_uint32(stream, sample_rate);
+    write_uint32(stream, sample_rate * block_align);
+    write_uint16(stream, block_align);
+    write_uint16(stream, 16);
+
+    stream.write("data", 4);
+    write_uint32(stream, data_size);
+}
+
+}
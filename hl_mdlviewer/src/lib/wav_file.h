@@ -0,0 +1,55 @@
+/**
+* \file wav_file.h
+* \brief Declaration for the WAV file functions.
+*/
+
+#ifndef HLMDLVIEWER_WAV_FILE_H_
+#define HLMDLVIEWER_WAV_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace hl_mdlviewer {
+
+/** \brief A decoded sound: signed 16-bit samples, interleaved by channel. */
+struct PcmSound
+{
+    PcmSound() :
+        sample_rate(0),
+        num_channels(0),
+        samples()
+    {
+    }
+
+    inline size_t num_frames() const { return num_channels ? samples.size() / num_channels : 0; }
+
+    uint32_t sample_rate;
+    uint16_t num_channels;
+    std::vector<int16_t> samples;
+};
+
+/** \brief Decode a WAV file held in memory.
+*
+* Only uncompressed 8-bit and 16-bit PCM, mono or stereo, is supported,
+* which covers the sounds of the game. Cue and other chunks are skipped.
+* \param[in] data The contents of the file.
+* \param[in] size The size of the file, in bytes.
+* \param[out] sound The decoded sound.
+* \return false if the file is not a supported WAV file.
+*/
+bool decode_wav(const uint8_t* data, size_t size, PcmSound& sound);
+
+/** \brief Write the header of a 16-bit PCM WAV file, the samples
+*          following it.
+* \param[in] data_size The size of the samples, in bytes.
+*/
+void write_wav_header(std::ostream& stream, uint32_t sample_rate, uint16_t num_channels, uint32_t data_size);
+
+/** \brief The size of the header written by \ref write_wav_header. */
+const size_t WAV_HEADER_SIZE = 44;
+
+}
+
+#endif // HLMDLVIEWER_WAV_FILE_H_
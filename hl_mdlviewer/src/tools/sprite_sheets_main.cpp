@@ -0,0 +1,221 @@
+/**
+* \file sprite_sheets_main.cpp
+* \brief Command line tool rendering sprite sheets of HL1 models.
+*/
+
+#include "pch.h"
+#include "hl1_sprite_sheet_renderer.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void print_usage()
+{
+    std::cout <<
+        "Usage: hl_mdlviewer_sprite_sheets [options] <output directory> <model.mdl | directory | @list.txt>...\n"
+        "\n"
+        "Renders a PNG sprite sheet per model. Models whose content and settings\n"
+        "did not change since the last run are skipped.\n"
+        "\n"
+        "Options:\n"
+        "  --cell <width>x<height>   The cell size (default 128x128).\n"
+        "  --columns <n>             The cells per row (default: the frames per sequence).\n"
+        "  --frames <n>              The frames sampled per sequence (default 4).\n"
+        "  --sequences <i,j,...>     The sequences (default: all).\n"
+        "  --skins <i,j,...>         The skins (default 0).\n"
+        "  --bodies <i,j,...>        The body values (default 0).\n"
+        "  --cameras <name,...>      front, side, back, three_quarter, top (default front).\n"
+        "  --smooth                  Render flat colors instead of textures.\n"
+        "  --no-lighting             Disable lighting.\n"
+        "  --chrome                  Render chrome effects.\n"
+        "  --threads <n>             The number of threads (default: all cores).\n"
+        "  --force                   Render up to date models too.\n";
+}
+
+std::vector<std::string> split(const std::string& value, char separator)
+{
+    std::vector<std::string> result;
+    std::istringstream stream(value);
+    std::string item;
+
+    while (std::getline(stream, item, separator))
+    {
+        if (!item.empty())
+            result.push_back(item);
+    }
+
+    return result;
+}
+
+std::vector<int> parse_int_list(const std::string& value)
+{
+    std::vector<int> result;
+
+    for (const std::string& item : split(value, ','))
+        result.push_back(std::stoi(item));
+
+    return result;
+}
+
+/** \brief Whether a file is the texture or sequence group file of another model. */
+bool is_companion_file(const fs::path& path)
+{
+    const std::string stem = path.stem().string();
+
+    if (stem.size() > 1 && (stem.back() == 'T' || stem.back() == 't'))
+        return fs::exists(path.parent_path() / (stem.substr(0, stem.size() - 1) + path.extension().string()));
+
+    if (stem.size() > 2 && isdigit(stem[stem.size() - 1]) && isdigit(stem[stem.size() - 2]))
+        return fs::exists(path.parent_path() / (stem.substr(0, stem.size() - 2) + path.extension().string()));
+
+    return false;
+}
+
+void add_models(const std::string& argument, std::vector<std::string>& model_paths)
+{
+    if (!argument.empty() && argument[0] == '@')
+    {
+        std::ifstream list(argument.substr(1));
+        if (!list.is_open())
+            throw std::runtime_error("Failed to open \"" + argument.substr(1) + "\"");
+
+        std::string line;
+        while (std::getline(list, line))
+        {
+            if (!line.empty())
+                add_models(line, model_paths);
+        }
+    }
+    else if (fs::is_directory(argument))
+    {
+        std::vector<std::string> directory_models;
+
+        for (const auto& entry : fs::recursive_directory_iterator(argument))
+        {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+            if (entry.is_regular_file() && extension == ".mdl" && !is_companion_file(entry.path()))
+                directory_models.push_back(entry.path().string());
+        }
+
+        // The iteration order is unspecified, the output names must not be.
+        std::sort(directory_models.begin(), directory_models.end());
+        model_paths.insert(model_paths.end(), directory_models.begin(), directory_models.end());
+    }
+    else
+    {
+        model_paths.push_back(argument);
+    }
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace hl_mdlviewer::hl1;
+
+    try
+    {
+        SpriteSheetSettings settings;
+        size_t num_threads = 0;
+        bool force = false;
+        std::vector<std::string> arguments;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string option = argv[i];
+
+            auto next_value = [&]() -> std::string {
+                if (i + 1 >= argc)
+                    throw std::runtime_error("Missing value for " + option);
+                return argv[++i];
+            };
+
+            if (option == "--help" || option == "-h")
+            {
+                print_usage();
+                return EXIT_SUCCESS;
+            }
+            else if (option == "--cell")
+            {
+                const std::string value = next_value();
+                const std::vector<std::string> parts = split(value, 'x');
+                if (parts.size() != 2)
+                    throw std::runtime_error("Invalid cell size \"" + value + "\"");
+
+                settings.cell_width = std::stoi(parts[0]);
+                settings.cell_height = std::stoi(parts[1]);
+            }
+            else if (option == "--columns")
+                settings.columns = std::stoi(next_value());
+            else if (option == "--frames")
+                settings.frames_per_sequence = std::stoi(next_value());
+            else if (option == "--sequences")
+                settings.sequences = parse_int_list(next_value());
+            else if (option == "--skins")
+                settings.skins = parse_int_list(next_value());
+            else if (option == "--bodies")
+                settings.bodies = parse_int_list(next_value());
+            else if (option == "--cameras")
+            {
+                for (const std::string& name : split(next_value(), ','))
+                {
+                    const CameraPreset* camera = find_camera_preset(name);
+                    if (!camera)
+                        throw std::runtime_error("Unknown camera \"" + name + "\"");
+
+                    settings.cameras.push_back(*camera);
+                }
+            }
+            else if (option == "--smooth")
+                settings.render_settings.render_mode = RenderMode::SMOOTH;
+            else if (option == "--no-lighting")
+                settings.render_settings.lighting_enabled = false;
+            else if (option == "--chrome")
+                settings.render_settings.render_chrome_effects = true;
+            else if (option == "--threads")
+                num_threads = std::stoul(next_value());
+            else if (option == "--force")
+                force = true;
+            else if (option.size() > 1 && option[0] == '-' && option[1] == '-')
+                throw std::runtime_error("Unknown option \"" + option + "\"");
+            else
+                arguments.push_back(option);
+        }
+
+        if (arguments.size() < 2)
+        {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+
+        std::vector<std::string> model_paths;
+        for (size_t i = 1; i < arguments.size(); ++i)
+            add_models(arguments[i], model_paths);
+
+        SpriteSheetRenderer renderer(settings, num_threads);
+        const SpriteSheetBatchResult result = renderer.render_batch(model_paths, arguments[0], force);
+
+        for (const std::string& error : result.errors)
+            std::cerr << error << std::endl;
+
+        std::cout << result.num_rendered << " rendered, "
+            << result.num_skipped << " up to date, "
+            << result.num_failed << " failed, "
+            << result.num_cells << " cells in " << result.elapsed_time << " s ("
+            << result.models_per_second() << " models/s)" << std::endl;
+
+        return result.num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,159 @@
+/** \file animation_lod_scheduler.cpp
+* \brief Includes tests for the HL1 animation level of detail scheduler class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "hl1_animation_lod_scheduler.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestAnimationLODScheduler)
+    {
+    public:
+
+        TEST_METHOD(LeavesAreDroppedFirst)
+        {
+            // A spine with an arm down to a finger tip, and a head.
+            const int parents[] = { -1, 0, 1, 2, 3, 1 };
+
+            hl_mdlviewer::hl1::StudioModel studio_model;
+            studio_model.bones.resize(6);
+            for (int i = 0; i < 6; ++i)
+            {
+                studio_model.bones[i].index = i;
+                studio_model.bones[i].parent_index = parents[i];
+                studio_model.bones[i].parent = parents[i] >= 0 ? &studio_model.bones[parents[i]] : nullptr;
+                if (parents[i] >= 0)
+                    studio_model.bones[parents[i]].children.push_back(&studio_model.bones[i]);
+            }
+
+            // The head is a leaf, but is hit.
+            studio_model.hitboxes.resize(1);
+            studio_model.hitboxes[0].bone = &studio_model.bones[5];
+
+            std::vector<uint8_t> bone_masks[hl_mdlviewer::hl1::NUM_ANIMATION_BONE_LEVELS];
+            hl_mdlviewer::hl1::AnimationLODScheduler::compute_bone_masks(studio_model, bone_masks);
+
+            const uint8_t expected[][6] = {
+                { 1, 1, 1, 1, 1, 1 },
+                { 1, 1, 1, 1, 0, 1 },
+                { 1, 1, 1, 0, 0, 1 }
+            };
+
+            for (int level = 0; level < hl_mdlviewer::hl1::NUM_ANIMATION_BONE_LEVELS; ++level)
+            {
+                Assert::AreEqual(static_cast<size_t>(6), bone_masks[level].size());
+                for (int i = 0; i < 6; ++i)
+                    Assert::AreEqual(expected[level][i], bone_masks[level][i]);
+            }
+        }
+
+        TEST_METHOD(DistantInstancesAreUpdatedLessOften)
+        {
+            hl_mdlviewer::hl1::StudioModel studio_model;
+            studio_model.sequences.resize(1);
+            studio_model.sequences[0].bbmin = glm::vec3(-1.0f);
+            studio_model.sequences[0].bbmax = glm::vec3(1.0f);
+
+            hl_mdlviewer::hl1::StudioModelScene scene;
+            scene.set_bounds_source(hl_mdlviewer::hl1::SceneBoundsSource::SEQUENCE);
+            scene.add_model(&studio_model, nullptr, nullptr, glm::mat4(1.0f));
+
+            // One instance close to the camera, one far away.
+            hl_mdlviewer::hl1::StudioModelInstance instance;
+            instance.transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 5.0f));
+            scene.add_instance(0, instance);
+            instance.transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -500.0f));
+            scene.add_instance(0, instance);
+
+            const glm::mat4 view_projection =
+                glm::perspective(glm::radians(65.0f), 1.0f, 1.0f, 1000.0f) *
+                glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+            scene.cull(view_projection);
+            Assert::AreEqual(static_cast<size_t>(2), scene.visible_instances().size());
+
+            hl_mdlviewer::hl1::AnimationLODScheduler scheduler;
+            scheduler.schedule(scene, view_projection, 600);
+
+            Assert::AreEqual(1, scheduler.get_update_interval(0));
+            Assert::AreEqual(0, scheduler.get_bone_level(0));
+
+            Assert::AreEqual(scheduler.settings().max_update_interval, scheduler.get_update_interval(1));
+            Assert::AreEqual(2, scheduler.get_bone_level(1));
+
+            // Without LOD, every instance is updated every frame.
+            hl_mdlviewer::hl1::AnimationLODSettings settings;
+            settings.enabled = false;
+            scheduler.set_settings(settings);
+            scheduler.schedule(scene, view_projection, 600);
+
+            Assert::AreEqual(1, scheduler.get_update_interval(1));
+            Assert::AreEqual(0, scheduler.get_bone_level(1));
+        }
+
+        TEST_METHOD(InterpolatedBonesStayRigid)
+        {
+            hl_mdlviewer::hl1::StudioModel studio_model;
+            studio_model.sequences.resize(1);
+            studio_model.sequences[0].bbmin = glm::vec3(-1.0f);
+            studio_model.sequences[0].bbmax = glm::vec3(1.0f);
+
+            // Without an animation, the instance stands in the bind pose,
+            // which is turned between the updates.
+            studio_model.bones.resize(1);
+            studio_model.bones[0].index = 0;
+            studio_model.bones[0].parent_index = -1;
+            studio_model.bones[0].parent = nullptr;
+            studio_model.bones[0].local_quat = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+            studio_model.bones[0].local_position = glm::vec3(0.0f);
+
+            hl_mdlviewer::hl1::StudioModelScene scene;
+            scene.set_bounds_source(hl_mdlviewer::hl1::SceneBoundsSource::SEQUENCE);
+            scene.add_model(&studio_model, nullptr, nullptr, glm::mat4(1.0f));
+
+            hl_mdlviewer::hl1::StudioModelInstance instance;
+            instance.transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -500.0f));
+            scene.add_instance(0, instance);
+
+            const glm::mat4 view_projection =
+                glm::perspective(glm::radians(65.0f), 1.0f, 1.0f, 1000.0f) *
+                glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            scene.cull(view_projection);
+
+            hl_mdlviewer::hl1::AnimationLODSettings settings;
+            settings.max_update_interval = 2;
+
+            hl_mdlviewer::hl1::AnimationLODScheduler scheduler;
+            scheduler.set_settings(settings);
+
+            std::vector<glm::mat4> bones_transform;
+            for (int frame = 0; frame < 3; ++frame)
+            {
+                // A quarter turn around z, and a step along x.
+                if (frame == 1)
+                {
+                    studio_model.bones[0].local_quat = glm::quat(std::sqrt(0.5f), 0.0f, 0.0f, std::sqrt(0.5f));
+                    studio_model.bones[0].local_position = glm::vec3(2.0f, 0.0f, 0.0f);
+                }
+
+                scheduler.schedule(scene, view_projection, 600);
+                Assert::AreEqual(2, scheduler.get_update_interval(0));
+                scheduler.compute_bone_transforms(scene, 0, bones_transform);
+            }
+
+            // The second pose was computed on the third frame, the bone is
+            // halfway: an eighth turn, not a shrunk matrix.
+            Assert::AreEqual(static_cast<size_t>(1), scheduler.statistics().num_updated);
+            Assert::AreEqual(std::sqrt(0.5f), bones_transform[0][0].x, 1e-5f);
+            Assert::AreEqual(std::sqrt(0.5f), bones_transform[0][0].y, 1e-5f);
+            Assert::AreEqual(1.0f, glm::length(glm::vec3(bones_transform[0][1])), 1e-5f);
+            Assert::AreEqual(1.0f, bones_transform[0][3].x, 1e-5f);
+            Assert::AreEqual(1.0f, bones_transform[0][3].w, 1e-5f);
+        }
+    };
+}
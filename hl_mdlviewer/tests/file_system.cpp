@@ -0,0 +1,237 @@
+/** \file file_system.cpp
+* \brief Includes tests for the file system class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <filesystem>
+#include <cstring>
+#include <fstream>
+#include "file_system.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace fs = std::filesystem;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestFileSystem)
+    {
+        fs::path directory_;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(CreateFiles)
+        {
+            directory_ = fs::temp_directory_path() / "hl_mdlviewer_file_system_test";
+            fs::remove_all(directory_);
+            fs::create_directories(directory_ / "Sound" / "Common");
+            fs::create_directories(directory_ / "Shaders");
+
+            std::ofstream(directory_ / "Sound" / "Common" / "Null.WAV") << "wav";
+            std::ofstream(directory_ / "Shaders" / "locations.in") << "in";
+        }
+
+        TEST_METHOD_CLEANUP(RemoveFiles)
+        {
+            fs::remove_all(directory_);
+        }
+
+        TEST_METHOD(NamesAreMatchedWithoutCase)
+        {
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_search_path(directory_.string().c_str());
+
+            std::string path;
+            Assert::IsTrue(file_system.find_file("sound/common/null.wav", path));
+            Assert::IsTrue(fs::equivalent(directory_ / "Sound" / "Common" / "Null.WAV", path));
+
+            Assert::IsTrue(file_system.find_file("SOUND\\Common\\.\\NULL.wav", path));
+            Assert::IsTrue(file_system.find_file("shaders/../sound/common/null.wav", path));
+            Assert::IsFalse(file_system.find_file("sound/null.wav", path));
+        }
+
+        TEST_METHOD(RecursiveSearchLooksInSubFolders)
+        {
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_search_path(directory_.string().c_str());
+
+            std::string path;
+            Assert::IsFalse(file_system.find_file("null.wav", path));
+            Assert::IsTrue(file_system.find_file("null.wav", path, hl_mdlviewer::FileSystem::SearchFlags::Recursive));
+            Assert::IsTrue(file_system.find_file("common/null.wav", path, hl_mdlviewer::FileSystem::SearchFlags::Recursive));
+            Assert::IsTrue(file_system.find_file("locations.in", path, hl_mdlviewer::FileSystem::SearchFlags::Recursive));
+            Assert::IsFalse(file_system.find_file("uniform_blocks.in", path, hl_mdlviewer::FileSystem::SearchFlags::Recursive));
+        }
+
+        TEST_METHOD(NewFilesAreFoundOnceInvalidated)
+        {
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_search_path(directory_.string().c_str());
+
+            std::string path;
+            Assert::IsFalse(file_system.find_file("shaders/skinning.in", path));
+
+            std::ofstream(directory_ / "Shaders" / "skinning.in") << "in";
+            Assert::IsFalse(file_system.find_file("shaders/skinning.in", path));
+
+            file_system.invalidate();
+            Assert::IsTrue(file_system.find_file("shaders/skinning.in", path));
+        }
+
+        TEST_METHOD(CurrentDirectoryMissesAreForgottenOnceInvalidated)
+        {
+            hl_mdlviewer::FileSystem file_system;
+            const std::string file_name = "hl_mdlviewer_file_system_test.wav";
+            const fs::path file_path = fs::current_path() / file_name;
+            fs::remove(file_path);
+
+            std::string path;
+            Assert::IsFalse(file_system.find_file(file_name.c_str(), path));
+
+            std::ofstream(file_path) << "wav";
+            Assert::IsFalse(file_system.find_file(file_name.c_str(), path));
+
+            file_system.invalidate();
+            const bool found = file_system.find_file(file_name.c_str(), path);
+            fs::remove(file_path);
+            Assert::IsTrue(found);
+        }
+
+        TEST_METHOD(ArchiveEntriesAreViewedInPlace)
+        {
+            write_pak(directory_ / "pak0.pak", { { "sound/common/null.wav", "packed" },
+                { "sound/Debris/Wood1.wav", "wood" }, { "models/null.mdl", "mdl" } });
+
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_archive((directory_ / "pak0.pak").string().c_str(), 0, "sound");
+
+            hl_mdlviewer::FileView view;
+            Assert::IsTrue(file_system.open_file("debris/wood1.wav", view));
+            Assert::AreEqual(std::string("wood"), std::string(reinterpret_cast<const char*>(view.data()), view.size()));
+
+            // Outside of the root.
+            Assert::IsFalse(file_system.open_file("models/null.mdl", view));
+
+            // Not a file on disk.
+            std::string path;
+            Assert::IsFalse(file_system.find_file("debris/wood1.wav", path));
+        }
+
+        TEST_METHOD(MountsAreLayeredByPriority)
+        {
+            write_pak(directory_ / "pak0.pak", { { "common/null.wav", "pak0" } });
+            write_pak(directory_ / "pak1.pak", { { "common/null.wav", "pak1" } });
+
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_archive((directory_ / "pak0.pak").string().c_str(), -1);
+            file_system.add_search_path((directory_ / "Sound").string().c_str());
+
+            hl_mdlviewer::FileView view;
+            Assert::IsTrue(file_system.open_file("common/null.wav", view));
+            Assert::AreEqual(std::string("wav"), std::string(reinterpret_cast<const char*>(view.data()), view.size()));
+
+            file_system.add_archive((directory_ / "pak1.pak").string().c_str(), 1);
+            Assert::IsTrue(file_system.open_file("common/null.wav", view));
+            Assert::AreEqual(std::string("pak1"), std::string(reinterpret_cast<const char*>(view.data()), view.size()));
+        }
+
+        TEST_METHOD(WadLumpsAreMounted)
+        {
+            // A header, one lump, and its directory entry.
+            std::string wad("WAD3", 4);
+            append_int32(wad, 1);
+            append_int32(wad, 16);
+            wad += "TEXL";
+            append_int32(wad, 12);
+            append_int32(wad, 4);
+            append_int32(wad, 4);
+            wad += std::string("\x43\0\0\0", 4);
+            wad += std::string("{Fence\0\0\0\0\0\0\0\0\0\0", 16);
+            std::ofstream(directory_ / "textures.wad", std::ios::binary) << wad;
+
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_archive((directory_ / "textures.wad").string().c_str());
+
+            hl_mdlviewer::FileView view;
+            Assert::IsTrue(file_system.open_file("{FENCE", view));
+            Assert::AreEqual(std::string("TEXL"), std::string(reinterpret_cast<const char*>(view.data()), view.size()));
+        }
+
+        TEST_METHOD(InvalidArchivesAreRejected)
+        {
+            // The directory is past the end of the file.
+            std::string pak("PACK", 4);
+            append_int32(pak, 0x7fffffff);
+            append_int32(pak, 64);
+            std::ofstream(directory_ / "invalid.pak", std::ios::binary) << pak;
+
+            hl_mdlviewer::FileSystem file_system;
+            Assert::ExpectException<std::runtime_error>([&] {
+                file_system.add_archive((directory_ / "invalid.pak").string().c_str()); });
+            Assert::ExpectException<std::runtime_error>([&] {
+                file_system.add_archive((directory_ / "Shaders" / "locations.in").string().c_str()); });
+        }
+
+        TEST_METHOD(ChangesAreFoundWatchedOrInvalidated)
+        {
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_search_path(directory_.string().c_str());
+
+            // Changes are watched with inotify or change notifications,
+            // other platforms invalidate explicitly.
+            const bool watching = file_system.set_watch_changes(true);
+#if defined __linux__ || defined _WIN32
+            Assert::IsTrue(watching);
+#else
+            Assert::IsFalse(watching);
+#endif
+
+            std::string path;
+            Assert::IsTrue(file_system.find_file("sound/common/null.wav", path));
+
+            fs::create_directories(directory_ / "Sound" / "Debris");
+            std::ofstream(directory_ / "Sound" / "Debris" / "Wood1.wav") << "wav";
+            fs::remove(directory_ / "Sound" / "Common" / "Null.WAV");
+            if (!watching)
+                file_system.invalidate();
+
+            Assert::IsTrue(file_system.find_file("sound/debris/wood1.wav", path));
+            Assert::IsFalse(file_system.find_file("sound/common/null.wav", path));
+
+            // Files of the new folder are found as well.
+            std::ofstream(directory_ / "Sound" / "Debris" / "Wood2.wav") << "wav";
+            if (!watching)
+                file_system.invalidate();
+
+            Assert::IsTrue(file_system.find_file("sound/debris/wood2.wav", path));
+        }
+
+    private:
+
+        static void append_int32(std::string& data, int32_t value)
+        {
+            data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        static void write_pak(const fs::path& path, const std::vector<std::pair<std::string, std::string>>& files)
+        {
+            std::string contents;
+            std::string directory;
+            for (const auto& file : files)
+            {
+                char name[56] = {};
+                std::strncpy(name, file.first.c_str(), sizeof(name) - 1);
+                directory.append(name, sizeof(name));
+                append_int32(directory, static_cast<int32_t>(12 + contents.size()));
+                append_int32(directory, static_cast<int32_t>(file.second.size()));
+                contents += file.second;
+            }
+
+            std::string pak("PACK", 4);
+            append_int32(pak, static_cast<int32_t>(12 + contents.size()));
+            append_int32(pak, static_cast<int32_t>(directory.size()));
+            std::ofstream(path, std::ios::binary) << pak << contents << directory;
+        }
+    };
+}
@@ -0,0 +1,59 @@
+/** \file frame_pacer.cpp
+* \brief Includes tests for the frame pacer class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "frame_pacer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestFramePacer)
+    {
+    public:
+
+        TEST_METHOD(WaitsForEventsWhenIdle)
+        {
+            hl_mdlviewer::FramePacer pacer;
+            pacer.end_frame(1.0);
+
+            Assert::IsTrue(pacer.get_wait_time(1.5, false, false) < 0.0);
+            Assert::AreEqual(0.0, pacer.get_wait_time(1.5, false, true));
+        }
+
+        TEST_METHOD(CapsTheFrameRateWhileAnimating)
+        {
+            hl_mdlviewer::FramePacer pacer;
+            pacer.set_max_frame_rate(50.0f);
+            pacer.end_frame(1.0);
+
+            Assert::AreEqual(0.015, pacer.get_wait_time(1.005, true, false), 1e-9);
+            Assert::IsFalse(pacer.frame_due(1.005));
+            Assert::IsTrue(pacer.frame_due(1.02));
+            Assert::AreEqual(0.0, pacer.get_wait_time(1.5, true, false));
+
+            pacer.set_max_frame_rate(0.0f);
+            Assert::AreEqual(0.0, pacer.get_wait_time(1.005, true, false));
+            Assert::IsTrue(pacer.frame_due(1.005));
+        }
+
+        TEST_METHOD(MeasuresIdleWaitsOnly)
+        {
+            hl_mdlviewer::FramePacer pacer;
+
+            pacer.begin_wait(1.0, false);
+            pacer.end_frame(1.5);
+            Assert::AreEqual(0.0, pacer.idle_statistics().idle_time);
+
+            // A wake up that does not draw keeps the wait going.
+            pacer.begin_wait(2.0, true);
+            pacer.begin_wait(3.0, true);
+            pacer.end_frame(4.0);
+            Assert::AreEqual(2.0, pacer.idle_statistics().idle_time);
+            Assert::AreEqual(static_cast<size_t>(1), pacer.idle_statistics().num_wakeups);
+            Assert::IsTrue(pacer.idle_statistics().cpu_time >= 0.0);
+        }
+    };
+}
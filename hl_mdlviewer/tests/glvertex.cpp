@@ -0,0 +1,98 @@
+/** \file glvertex.cpp
+* \brief Includes tests for the packed vertex layout.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "buffer_builder.h"
+#include "glvertex.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestPackedVertex)
+    {
+    public:
+
+        static hl_mdlviewer::glvertex make_vertex(const glm::vec3& normal, const glm::vec2& uv, int boneid)
+        {
+            hl_mdlviewer::glvertex vertex;
+            vertex.position = glm::vec3(1.0f, -2.0f, 3.5f);
+            vertex.normal = normal;
+            vertex.uv = uv;
+            vertex.boneid = boneid;
+            return vertex;
+        }
+
+        TEST_METHOD(VerticesRoundTripAtTheEdgesOfTheRange)
+        {
+            const float uvs[] = { 0.0f, 1.0f / 65535.0f, 0.5f, 1.0f - 1.0f / 65535.0f, 1.0f };
+            const glm::vec3 normals[] = {
+                glm::vec3(1.0f, 0.0f, 0.0f),
+                glm::vec3(0.0f, -1.0f, 0.0f),
+                glm::vec3(0.0f, 0.0f, 1.0f),
+                glm::normalize(glm::vec3(-1.0f, 1.0f, -1.0f))
+            };
+            const int boneids[] = { 0, 1, hl_mdlviewer::PACKED_VERTEX_MAX_BONE_INDEX };
+
+            for (float u : uvs)
+            {
+                for (const glm::vec3& normal : normals)
+                {
+                    for (int boneid : boneids)
+                    {
+                        const hl_mdlviewer::glvertex vertex = make_vertex(normal, glm::vec2(u, 1.0f - u), boneid);
+                        Assert::IsTrue(hl_mdlviewer::can_pack_vertex(vertex));
+
+                        const hl_mdlviewer::glvertex unpacked = hl_mdlviewer::unpack_vertex(hl_mdlviewer::pack_vertex(vertex));
+
+                        Assert::IsTrue(unpacked.position == vertex.position);
+                        Assert::AreEqual(vertex.uv.x, unpacked.uv.x, 0.5f / 65535.0f);
+                        Assert::AreEqual(vertex.uv.y, unpacked.uv.y, 0.5f / 65535.0f);
+                        Assert::AreEqual(vertex.normal.x, unpacked.normal.x, 0.5f / 511.0f);
+                        Assert::AreEqual(vertex.normal.y, unpacked.normal.y, 0.5f / 511.0f);
+                        Assert::AreEqual(vertex.normal.z, unpacked.normal.z, 0.5f / 511.0f);
+                        Assert::AreEqual(vertex.boneid, unpacked.boneid);
+                    }
+                }
+            }
+
+            // The ends of the range are exact.
+            const hl_mdlviewer::glvertex vertex = make_vertex(glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(0.0f, 1.0f), 0);
+            const hl_mdlviewer::glvertex unpacked = hl_mdlviewer::unpack_vertex(hl_mdlviewer::pack_vertex(vertex));
+            Assert::AreEqual(0.0f, unpacked.uv.x);
+            Assert::AreEqual(1.0f, unpacked.uv.y);
+            Assert::AreEqual(-1.0f, unpacked.normal.z);
+        }
+
+        TEST_METHOD(VerticesOutOfTheRangeAreNotPacked)
+        {
+            const glm::vec3 normal(0.0f, 0.0f, 1.0f);
+
+            Assert::IsFalse(hl_mdlviewer::can_pack_vertex(make_vertex(normal, glm::vec2(-0.001f, 0.5f), 0)));
+            Assert::IsFalse(hl_mdlviewer::can_pack_vertex(make_vertex(normal, glm::vec2(0.5f, 1.001f), 0)));
+            Assert::IsFalse(hl_mdlviewer::can_pack_vertex(make_vertex(normal, glm::vec2(2.0f, 0.5f), 0)));
+            Assert::IsFalse(hl_mdlviewer::can_pack_vertex(make_vertex(normal, glm::vec2(0.5f), -1)));
+            Assert::IsFalse(hl_mdlviewer::can_pack_vertex(
+                make_vertex(normal, glm::vec2(0.5f), hl_mdlviewer::PACKED_VERTEX_MAX_BONE_INDEX + 1)));
+
+            // A single tiled UV keeps the whole buffer unpacked.
+            std::vector<hl_mdlviewer::glvertex> vertices = {
+                make_vertex(normal, glm::vec2(0.0f, 0.0f), 0),
+                make_vertex(normal, glm::vec2(1.0f, 0.0f), 0),
+                make_vertex(normal, glm::vec2(1.0f, 1.0f), 0)
+            };
+            const std::vector<unsigned int> indices = { 0, 1, 2 };
+
+            hl_mdlviewer::BufferBuilder buffer_builder;
+            hl_mdlviewer::MeshBufferStride stride;
+            buffer_builder.append_triangles(vertices, indices, stride);
+            Assert::IsTrue(buffer_builder.can_pack_vertices());
+
+            vertices[2].uv.x = 1.5f;
+            buffer_builder.append_triangles(vertices, indices, stride);
+            Assert::IsFalse(buffer_builder.can_pack_vertices());
+        }
+    };
+}
@@ -0,0 +1,74 @@
+/** \file image_palette.cpp
+* \brief Includes tests for the palettized image functions.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "image_palette.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestImagePalette)
+    {
+    public:
+
+        TEST_METHOD(MaskColorGetsTheMaskIndex)
+        {
+            const uint8_t pixels[] = {
+                10, 20, 30, 255,    0, 0, 255, 255,
+                0, 0, 255, 255,     40, 50, 60, 255
+            };
+            const uint8_t mask_color[] = { 0, 0, 255 };
+
+            hl_mdlviewer::PalettizedImage image;
+            Assert::IsTrue(hl_mdlviewer::palettize_image(pixels, 2, 2, mask_color, image));
+
+            const uint8_t expected[] = { 0, hl_mdlviewer::MASK_PALETTE_INDEX, hl_mdlviewer::MASK_PALETTE_INDEX, 1 };
+            for (int i = 0; i < 4; ++i)
+                Assert::AreEqual(expected[i], image.indices[i]);
+
+            Assert::AreEqual(static_cast<size_t>(hl_mdlviewer::PALETTE_SIZE * 4), image.palette.size());
+            Assert::AreEqual(static_cast<uint8_t>(40), image.palette[4]);
+            Assert::AreEqual(static_cast<uint8_t>(255), image.palette[hl_mdlviewer::MASK_PALETTE_INDEX * 4 + 2]);
+        }
+
+        TEST_METHOD(RecoloredImagesShareIndices)
+        {
+            const uint8_t first[] = {
+                1, 1, 1, 255,   2, 2, 2, 255,
+                1, 1, 1, 255,   3, 3, 3, 255
+            };
+            const uint8_t second[] = {
+                9, 9, 9, 255,   8, 8, 8, 255,
+                9, 9, 9, 255,   7, 7, 7, 255
+            };
+
+            hl_mdlviewer::PalettizedImage a, b;
+            Assert::IsTrue(hl_mdlviewer::palettize_image(first, 2, 2, nullptr, a));
+            Assert::IsTrue(hl_mdlviewer::palettize_image(second, 2, 2, nullptr, b));
+
+            Assert::IsTrue(a.indices == b.indices);
+            Assert::IsFalse(a.palette == b.palette);
+        }
+
+        TEST_METHOD(TooManyColorsFail)
+        {
+            std::vector<uint8_t> pixels(257 * 4, 255);
+            for (int i = 0; i < 257; ++i)
+            {
+                pixels[i * 4] = static_cast<uint8_t>(i);
+                pixels[i * 4 + 1] = static_cast<uint8_t>(i >> 8);
+            }
+
+            hl_mdlviewer::PalettizedImage image;
+            Assert::IsTrue(hl_mdlviewer::palettize_image(pixels.data(), 256, 1, nullptr, image));
+            Assert::IsFalse(hl_mdlviewer::palettize_image(pixels.data(), 257, 1, nullptr, image));
+
+            // The mask index is reserved for the transparent color.
+            const uint8_t mask_color[] = { 1, 2, 3 };
+            Assert::IsFalse(hl_mdlviewer::palettize_image(pixels.data(), 256, 1, mask_color, image));
+        }
+    };
+}
@@ -0,0 +1,122 @@
+/** \file mesh_simplifier.cpp
+* \brief Includes tests for the mesh simplification functions.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "mesh_simplifier.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestMeshSimplifier)
+    {
+    public:
+
+        /** \brief Make a flat grid of \p size by \p size vertices. */
+        static void make_grid(int size,
+            std::vector<hl_mdlviewer::glvertex>& vertices,
+            std::vector<unsigned int>& indices)
+        {
+            vertices.resize(size * size);
+            for (int y = 0; y < size; ++y)
+            {
+                for (int x = 0; x < size; ++x)
+                {
+                    hl_mdlviewer::glvertex& vertex = vertices[y * size + x];
+                    vertex.position = glm::vec3(static_cast<float>(x), static_cast<float>(y), 0.0f);
+                    vertex.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                    vertex.uv = glm::vec2(x / (size - 1.0f), y / (size - 1.0f));
+                    vertex.boneid = 0;
+                }
+            }
+
+            indices.clear();
+            for (int y = 0; y + 1 < size; ++y)
+            {
+                for (int x = 0; x + 1 < size; ++x)
+                {
+                    const unsigned int i = y * size + x;
+                    const unsigned int quad[] = { i, i + 1, i + size + 1, i, i + size + 1, i + size };
+                    indices.insert(indices.end(), quad, quad + 6);
+                }
+            }
+        }
+
+        TEST_METHOD(SimplifiesInsideTheBorders)
+        {
+            std::vector<hl_mdlviewer::glvertex> vertices;
+            std::vector<unsigned int> indices;
+            make_grid(7, vertices, indices);
+
+            std::vector<unsigned int> result;
+            const float error = hl_mdlviewer::simplify_mesh(vertices, indices, indices.size() / 2, result);
+
+            // A flat grid loses its inner vertices without any error.
+            Assert::IsTrue(result.size() <= indices.size() / 2);
+            Assert::IsTrue(result.size() % 3 == 0);
+            Assert::AreEqual(0.0f, error, 1e-5f);
+
+            // The border vertices are never moved.
+            std::vector<bool> used(vertices.size(), false);
+            for (unsigned int index : result)
+                used[index] = true;
+
+            for (size_t i = 0; i < vertices.size(); ++i)
+            {
+                const glm::vec3& p = vertices[i].position;
+                if (p.x == 0.0f || p.y == 0.0f || p.x == 6.0f || p.y == 6.0f)
+                    Assert::IsTrue(used[i]);
+            }
+        }
+
+        TEST_METHOD(KeepsVerticesOfOtherBones)
+        {
+            std::vector<hl_mdlviewer::glvertex> vertices;
+            std::vector<unsigned int> indices;
+            make_grid(5, vertices, indices);
+
+            // No vertex can be collapsed onto a vertex of the same bone.
+            for (size_t i = 0; i < vertices.size(); ++i)
+                vertices[i].boneid = static_cast<int>(i);
+
+            std::vector<unsigned int> result;
+            hl_mdlviewer::simplify_mesh(vertices, indices, 0, result);
+            Assert::AreEqual(indices.size(), result.size());
+
+            // A UV seam through the middle column locks it.
+            make_grid(5, vertices, indices);
+            for (int y = 0; y < 5; ++y)
+            {
+                hl_mdlviewer::glvertex seam_vertex = vertices[y * 5 + 2];
+                seam_vertex.uv.x += 0.5f;
+                vertices.push_back(seam_vertex);
+            }
+
+            // The right half uses the other side of the seam.
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                const bool right = vertices[indices[i]].position.x + vertices[indices[i + 1]].position.x +
+                    vertices[indices[i + 2]].position.x > 6.0f;
+                for (size_t k = i; right && k < i + 3; ++k)
+                {
+                    if (indices[k] % 5 == 2)
+                        indices[k] = 25 + indices[k] / 5;
+                }
+            }
+
+            hl_mdlviewer::simplify_mesh(vertices, indices, 0, result);
+
+            std::vector<bool> used(vertices.size(), false);
+            for (unsigned int index : result)
+                used[index] = true;
+
+            for (int y = 0; y < 5; ++y)
+            {
+                Assert::IsTrue(used[y * 5 + 2]);
+                Assert::IsTrue(used[25 + y]);
+            }
+        }
+    };
+}
@@ -0,0 +1,324 @@
+/** \file png_writer.cpp
+* \brief Includes tests for the PNG writer functions.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include "png_writer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestPngWriter)
+    {
+    public:
+
+        /** \brief A chunk of a PNG file, its data and CRC as read. */
+        struct Chunk
+        {
+            std::string type;
+            std::vector<uint8_t> data;
+            uint32_t crc;
+            uint32_t expected_crc;
+        };
+
+        static uint32_t read_uint32(const uint8_t* data)
+        {
+            return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+                (static_cast<uint32_t>(data[2]) << 8) | data[3];
+        }
+
+        /** \brief A bitwise CRC-32, independent of the table of the writer. */
+        static uint32_t reference_crc32(const uint8_t* data, size_t size)
+        {
+            uint32_t crc = 0xFFFFFFFF;
+            for (size_t i = 0; i < size; ++i)
+            {
+                crc ^= data[i];
+                for (int bit = 0; bit < 8; ++bit)
+                    crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+            }
+            return ~crc;
+        }
+
+        static uint32_t reference_adler32(const std::vector<uint8_t>& data)
+        {
+            uint32_t a = 1, b = 0;
+            for (uint8_t value : data)
+            {
+                a = (a + value) % 65521;
+                b = (b + a) % 65521;
+            }
+            return (b << 16) | a;
+        }
+
+        static void read_chunks(const std::vector<uint8_t>& png, std::vector<Chunk>& chunks)
+        {
+            static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+            Assert::IsTrue(png.size() >= 8 && std::memcmp(png.data(), signature, 8) == 0);
+
+            size_t offset = 8;
+            while (offset + 12 <= png.size())
+            {
+                const uint32_t size = read_uint32(&png[offset]);
+                Assert::IsTrue(offset + 12 + size <= png.size());
+
+                Chunk chunk;
+                chunk.type.assign(reinterpret_cast<const char*>(&png[offset + 4]), 4);
+                chunk.data.assign(png.begin() + offset + 8, png.begin() + offset + 8 + size);
+                chunk.crc = read_uint32(&png[offset + 8 + size]);
+                chunk.expected_crc = reference_crc32(&png[offset + 4], size + 4);
+                chunks.push_back(std::move(chunk));
+
+                offset += 12 + size;
+            }
+
+            Assert::AreEqual(png.size(), offset);
+        }
+
+        /** \brief Reads the bits of a deflate stream, least significant first. */
+        struct BitReader
+        {
+            const std::vector<uint8_t>& data;
+            size_t position;
+
+            int read_bit()
+            {
+                if (position / 8 >= data.size())
+                    throw std::runtime_error("Truncated deflate stream");
+                const int bit = (data[position / 8] >> (position % 8)) & 1;
+                ++position;
+                return bit;
+            }
+
+            int read_bits(int count)
+            {
+                int value = 0;
+                for (int i = 0; i < count; ++i)
+                    value |= read_bit() << i;
+                return value;
+            }
+
+            /** \brief Read a Huffman code, most significant bit first. */
+            int read_code(int count)
+            {
+                int value = 0;
+                for (int i = 0; i < count; ++i)
+                    value = (value << 1) | read_bit();
+                return value;
+            }
+        };
+
+        static int read_fixed_symbol(BitReader& reader)
+        {
+            int code = reader.read_code(7);
+            if (code <= 0x17)
+                return 256 + code;
+
+            code = (code << 1) | reader.read_bit();
+            if (code >= 0x30 && code <= 0xBF)
+                return code - 0x30;
+            if (code >= 0xC0 && code <= 0xC7)
+                return 280 + code - 0xC0;
+
+            code = (code << 1) | reader.read_bit();
+            return 144 + code - 0x190;
+        }
+
+        /** \brief Decompress the fixed Huffman and stored blocks of a deflate stream. */
+        static void inflate(const std::vector<uint8_t>& data, size_t start, std::vector<uint8_t>& output)
+        {
+            BitReader reader = { data, start * 8 };
+
+            bool final_block = false;
+            while (!final_block)
+            {
+                final_block = reader.read_bits(1) != 0;
+                const int type = reader.read_bits(2);
+
+                if (type == 0)
+                {
+                    reader.position = (reader.position + 7) & ~size_t(7);
+                    const int size = reader.read_bits(16);
+                    Assert::AreEqual(size ^ 0xFFFF, reader.read_bits(16));
+                    for (int i = 0; i < size; ++i)
+                        output.push_back(static_cast<uint8_t>(reader.read_bits(8)));
+                    continue;
+                }
+
+                Assert::AreEqual(1, type);
+
+                for (;;)
+                {
+                    const int symbol = read_fixed_symbol(reader);
+                    if (symbol < 256)
+                    {
+                        output.push_back(static_cast<uint8_t>(symbol));
+                        continue;
+                    }
+                    if (symbol == 256)
+                        break;
+
+                    const int length_code = symbol - 257;
+                    Assert::IsTrue(length_code < 29);
+
+                    int length = 3;
+                    for (int i = 0; i < length_code; ++i)
+                        length += 1 << (i < 8 ? 0 : i / 4 - 1);
+                    if (length_code == 28)
+                        length = 258;
+                    else
+                        length += reader.read_bits(length_code < 8 ? 0 : length_code / 4 - 1);
+
+                    const int distance_code = reader.read_code(5);
+                    Assert::IsTrue(distance_code < 30);
+
+                    int distance = 1;
+                    for (int i = 0; i < distance_code; ++i)
+                        distance += 1 << (i < 4 ? 0 : i / 2 - 1);
+                    distance += reader.read_bits(distance_code < 4 ? 0 : distance_code / 2 - 1);
+
+                    Assert::IsTrue(static_cast<size_t>(distance) <= output.size());
+                    for (int i = 0; i < length; ++i)
+                        output.push_back(output[output.size() - distance]);
+                }
+            }
+        }
+
+        static uint8_t paeth(int a, int b, int c)
+        {
+            const int p = a + b - c;
+            const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+            if (pa <= pb && pa <= pc)
+                return static_cast<uint8_t>(a);
+            return static_cast<uint8_t>(pb <= pc ? b : c);
+        }
+
+        /** \brief Undo the filters of the rows of an RGBA image. */
+        static void unfilter(const std::vector<uint8_t>& filtered, unsigned int width, unsigned int height,
+            std::vector<uint8_t>& pixels)
+        {
+            const size_t row_size = static_cast<size_t>(width) * 4;
+            Assert::AreEqual(height * (row_size + 1), filtered.size());
+
+            pixels.assign(height * row_size, 0);
+            for (unsigned int y = 0; y < height; ++y)
+            {
+                const uint8_t filter = filtered[y * (row_size + 1)];
+                const uint8_t* input = &filtered[y * (row_size + 1) + 1];
+                uint8_t* row = &pixels[y * row_size];
+                const uint8_t* previous = y > 0 ? row - row_size : nullptr;
+
+                Assert::IsTrue(filter <= 4);
+                for (size_t i = 0; i < row_size; ++i)
+                {
+                    const int a = i >= 4 ? row[i - 4] : 0;
+                    const int b = previous ? previous[i] : 0;
+                    const int c = i >= 4 && previous ? previous[i - 4] : 0;
+
+                    int predictor = 0;
+                    switch (filter)
+                    {
+                    case 1: predictor = a; break;
+                    case 2: predictor = b; break;
+                    case 3: predictor = (a + b) / 2; break;
+                    case 4: predictor = paeth(a, b, c); break;
+                    }
+                    row[i] = static_cast<uint8_t>(input[i] + predictor);
+                }
+            }
+        }
+
+        /** \brief An image with flat areas, gradients and noise, so that all
+        * filters and matches are worth using. */
+        static hl_mdlviewer::Image make_image(unsigned int width, unsigned int height)
+        {
+            hl_mdlviewer::Image image(width, height);
+            uint32_t noise = 12345;
+            for (unsigned int y = 0; y < height; ++y)
+            {
+                for (unsigned int x = 0; x < width; ++x)
+                {
+                    noise = noise * 1103515245 + 12345;
+                    uint8_t* pixel = image.pixel(x, y);
+                    pixel[0] = static_cast<uint8_t>(x * 3);
+                    pixel[1] = static_cast<uint8_t>(y * 7);
+                    pixel[2] = ((x / 8 + y / 8) & 1) ? 200 : 0;
+                    pixel[3] = y < height / 2 ? 255 : static_cast<uint8_t>(noise >> 24);
+                }
+            }
+            return image;
+        }
+
+        TEST_METHOD(ChunksHaveValidChecksums)
+        {
+            std::vector<uint8_t> png;
+            hl_mdlviewer::encode_png(make_image(37, 21), png);
+
+            std::vector<Chunk> chunks;
+            read_chunks(png, chunks);
+
+            Assert::AreEqual(size_t(3), chunks.size());
+            Assert::AreEqual(std::string("IHDR"), chunks[0].type);
+            Assert::AreEqual(std::string("IDAT"), chunks[1].type);
+            Assert::AreEqual(std::string("IEND"), chunks[2].type);
+
+            for (const Chunk& chunk : chunks)
+                Assert::AreEqual(chunk.expected_crc, chunk.crc);
+
+            // The IEND CRC is the same in every PNG file.
+            Assert::AreEqual(0xAE426082u, chunks[2].crc);
+
+            const std::vector<uint8_t>& header = chunks[0].data;
+            Assert::AreEqual(size_t(13), header.size());
+            Assert::AreEqual(37u, read_uint32(&header[0]));
+            Assert::AreEqual(21u, read_uint32(&header[4]));
+            Assert::AreEqual(uint8_t(8), header[8]);
+            Assert::AreEqual(uint8_t(6), header[9]);
+        }
+
+        TEST_METHOD(ImageDataDecompressesToThePixels)
+        {
+            const unsigned int sizes[][2] = { { 1, 1 }, { 37, 21 }, { 300, 40 } };
+            for (const auto& size : sizes)
+            {
+                const hl_mdlviewer::Image image = make_image(size[0], size[1]);
+
+                std::vector<uint8_t> png;
+                hl_mdlviewer::encode_png(image, png);
+
+                std::vector<Chunk> chunks;
+                read_chunks(png, chunks);
+                const std::vector<uint8_t>& stream = chunks[1].data;
+
+                // A zlib header for deflate without a dictionary.
+                Assert::IsTrue(stream.size() > 6);
+                Assert::AreEqual(8, stream[0] & 0x0F);
+                Assert::AreEqual(0, (stream[0] * 256 + stream[1]) % 31);
+                Assert::AreEqual(0, stream[1] & 0x20);
+
+                std::vector<uint8_t> filtered;
+                inflate(stream, 2, filtered);
+
+                // The trailer is the Adler-32 of the uncompressed data.
+                Assert::AreEqual(reference_adler32(filtered), read_uint32(&stream[stream.size() - 4]));
+
+                std::vector<uint8_t> pixels;
+                unfilter(filtered, size[0], size[1], pixels);
+                Assert::IsTrue(pixels == image.pixels);
+            }
+        }
+
+        TEST_METHOD(EmptyImagesAreRejected)
+        {
+            std::vector<uint8_t> png;
+            Assert::ExpectException<std::runtime_error>([&png] {
+                hl_mdlviewer::encode_png(hl_mdlviewer::Image(0, 4), png);
+            });
+        }
+    };
+}
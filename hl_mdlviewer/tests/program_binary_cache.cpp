@@ -0,0 +1,150 @@
+/** \file program_binary_cache.cpp
+* \brief Includes tests for the program binary cache class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <filesystem>
+#include "file_system.h"
+#include "glprogram.h"
+#include "program_binary_cache.h"
+#include "recording_render_backend.h"
+#include "shader_parser.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestProgramBinaryCache)
+    {
+        std::string directory_;
+        hl_mdlviewer::RecordingRenderBackend backend_;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(CreateDirectory)
+        {
+            directory_ = (std::filesystem::temp_directory_path() / "hl_mdlviewer_program_binary_cache_test").string();
+            std::filesystem::remove_all(directory_);
+            hl_mdlviewer::set_render_backend(&backend_);
+        }
+
+        TEST_METHOD_CLEANUP(RemoveDirectory)
+        {
+            hl_mdlviewer::set_render_backend(nullptr);
+            std::filesystem::remove_all(directory_);
+        }
+
+        TEST_METHOD(StoredBinariesAreLoaded)
+        {
+            hl_mdlviewer::ProgramBinaryCache cache;
+            cache.set_directory(directory_);
+
+            const std::vector<uint8_t> binary = { 1, 2, 3, 4, 5 };
+            Assert::IsTrue(cache.store(0x1234, 0x42, binary));
+
+            GLenum format = 0;
+            std::vector<uint8_t> loaded;
+            Assert::IsTrue(cache.load(0x1234, format, loaded));
+            Assert::AreEqual(0x42u, static_cast<unsigned int>(format));
+            Assert::IsTrue(loaded == binary);
+
+            Assert::IsFalse(cache.load(0x4321, format, loaded));
+            Assert::AreEqual(size_t(1), cache.num_stored());
+            Assert::AreEqual(size_t(1), cache.num_loaded());
+        }
+
+        TEST_METHOD(DisabledCacheStoresNothing)
+        {
+            hl_mdlviewer::ProgramBinaryCache cache;
+
+            GLenum format = 0;
+            std::vector<uint8_t> binary = { 1 };
+            Assert::IsFalse(cache.enabled());
+            Assert::IsFalse(cache.store(1, 0x42, binary));
+            Assert::IsFalse(cache.load(1, format, binary));
+        }
+
+        TEST_METHOD(CachedProgramsAreNotCompiled)
+        {
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_search_path(HLMDLVIEWER_SHADERS_SEARCH_PATH);
+            hl_mdlviewer::ShaderParser shader_parser(&file_system);
+
+            hl_mdlviewer::ProgramBinaryCache cache;
+            cache.set_directory(directory_);
+
+            const std::string first_stream = record_program_build(shader_parser, cache);
+            Assert::AreEqual(size_t(1), cache.num_stored());
+            Assert::AreNotEqual(std::string::npos, first_stream.find("compile_shader"));
+
+            const std::string second_stream = record_program_build(shader_parser, cache);
+            Assert::AreEqual(size_t(1), cache.num_loaded());
+            Assert::AreEqual(std::string::npos, second_stream.find("compile_shader"));
+            Assert::AreNotEqual(std::string::npos, second_stream.find("program_binary"));
+        }
+
+        TEST_METHOD(SubmittedVariantsAreLinkedOnce)
+        {
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_search_path(HLMDLVIEWER_SHADERS_SEARCH_PATH);
+            hl_mdlviewer::ShaderParser shader_parser(&file_system);
+
+            backend_.clear();
+
+            std::vector<unsigned int> created;
+            hl_mdlviewer::glprogram program;
+            program.initialize_variants({
+                { "defines_are_injected/with_version.shader", GL_VERTEX_SHADER },
+                { "defines_are_injected/without_version.shader", GL_FRAGMENT_SHADER }
+            }, &shader_parser, { "FIRST", "SECOND" },
+                [&created](hl_mdlviewer::glprogram&, unsigned int features) { created.push_back(features); });
+            program.finish_build();
+
+            // Every variant is linked before any is finished.
+            program.submit_variants({ 1, 2, 3, 1, 0 });
+            Assert::AreEqual(size_t(4), program.num_variants());
+            Assert::AreEqual(size_t(1), created.size());
+            Assert::IsTrue(program.has_pending_variants());
+            Assert::AreEqual(size_t(4), count(backend_.to_string(), "link_program"));
+
+            // The recording backend completes programs at once.
+            program.finish_variants(false);
+            Assert::IsFalse(program.has_pending_variants());
+            Assert::IsTrue(created == std::vector<unsigned int>({ 0, 1, 2, 3 }));
+
+            program.variant(2);
+            program.variant(3);
+            Assert::AreEqual(size_t(4), count(backend_.to_string(), "link_program"));
+            Assert::AreEqual(size_t(4), created.size());
+
+            program.delete_program();
+        }
+
+    private:
+
+        static size_t count(const std::string& stream, const std::string& command)
+        {
+            size_t num_commands = 0;
+            for (size_t i = stream.find(command); i != std::string::npos; i = stream.find(command, i + 1))
+                ++num_commands;
+            return num_commands;
+        }
+
+        std::string record_program_build(hl_mdlviewer::ShaderParser& shader_parser,
+            hl_mdlviewer::ProgramBinaryCache& cache)
+        {
+            backend_.clear();
+
+            hl_mdlviewer::glprogram program;
+            program.set_binary_cache(&cache);
+            program.initialize_with_files({
+                { "defines_are_injected/with_version.shader", GL_VERTEX_SHADER },
+                { "defines_are_injected/without_version.shader", GL_FRAGMENT_SHADER }
+            }, &shader_parser);
+            program.delete_program();
+
+            return backend_.to_string();
+        }
+    };
+}
@@ -0,0 +1,219 @@
+/** \file render_backend.cpp
+* \brief Includes tests for the recording render backend class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "buffer_builder.h"
+#include "file_system.h"
+#include "glbuffer.h"
+#include "glstate.h"
+#include "hl1_studiomodel_render.h"
+#include "recording_render_backend.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestRecordingRenderBackend)
+    {
+        hl_mdlviewer::RecordingRenderBackend backend_;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(SetBackend)
+        {
+            hl_mdlviewer::set_render_backend(&backend_);
+        }
+
+        TEST_METHOD_CLEANUP(ResetBackend)
+        {
+            hl_mdlviewer::set_render_backend(nullptr);
+        }
+
+        TEST_METHOD(CommandStreamMatchesGolden)
+        {
+            hl_mdlviewer::glbuffer buffer;
+            buffer.initialize(std::vector<hl_mdlviewer::glvertex>(3), { 0, 1, 2 });
+
+            backend_.clear();
+            submit_frame(buffer);
+
+            Assert::AreEqual(std::string(
+                "enable 2929\n"
+                "depth_func 515\n"
+                "bind_vertex_array 1\n"
+                "draw_elements 4 3 5125 0 0\n"
+                "draw_elements_instanced 4 3 5125 0 0 10\n"
+                "bind_vertex_array 0\n"),
+                backend_.to_string());
+
+            const hl_mdlviewer::RenderBackendStatistics& statistics = backend_.statistics();
+            Assert::AreEqual(size_t(6), statistics.num_commands);
+            Assert::AreEqual(size_t(2), statistics.num_draw_calls);
+            Assert::AreEqual(size_t(11), statistics.num_instances);
+            Assert::AreEqual(size_t(33), statistics.num_indices);
+
+            buffer.delete_buffer();
+        };
+
+        TEST_METHOD(UploadsAreCountedAndHashed)
+        {
+            const std::string first_stream = record_buffer_creation();
+            const std::string second_stream = record_buffer_creation();
+
+            // The same data gives the same stream.
+            Assert::AreEqual(first_stream, second_stream);
+        };
+
+        TEST_METHOD(StudioModelFrameMatchesGolden)
+        {
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_search_path(HLMDLVIEWER_MODEL_SHADERS_SEARCH_PATH);
+
+            hl_mdlviewer::hl1::StudioModel studio_model;
+            make_triangle_model(studio_model);
+
+            hl_mdlviewer::hl1::StudioModelRender model_render(&studio_model, &file_system);
+            model_render.initialize();
+            fill_triangle_buffer(*model_render.get_buffer());
+
+            model_render.on_model_changed();
+            model_render.set_render_mode(hl_mdlviewer::hl1::RenderMode::SMOOTH);
+            model_render.setup_projection_matrix(64, 64);
+
+            model_render.begin_frame();
+            model_render.set_bones_transform({ glm::mat4(1.0f) });
+            model_render.setup_view();
+
+            // The frame only, without the creation of the programs and buffers.
+            backend_.clear();
+            model_render.render();
+
+            Assert::AreEqual(std::string(
+                "enable 2884\n"
+                "enable 2929\n"
+                "enable 36765\n"
+                "enable 34370\n"
+                "cull_face 1028\n"
+                "depth_func 515\n"
+                "bind_buffer_range 35345 3 22 0 8192\n"
+                "bind_vertex_array 26\n"
+                "primitive_restart_index 4294967295\n"
+                "polygon_mode 1032 6914\n"
+                "use_program 29\n"
+                "uniform_4fv 0 1065353216 1065353216 1065353216 1065353216\n"
+                "draw_elements 4 3 5125 0 0\n"
+                "depth_func 519\n"
+                "bind_vertex_array 0\n"
+                "depth_func 515\n"
+                "disable 36765\n"
+                "disable 34370\n"),
+                backend_.to_string());
+
+            const hl_mdlviewer::RenderBackendStatistics& statistics = backend_.statistics();
+            Assert::AreEqual(size_t(18), statistics.num_commands);
+            Assert::AreEqual(size_t(1), statistics.num_draw_calls);
+            Assert::AreEqual(size_t(3), statistics.num_indices);
+
+            model_render.end_frame();
+            model_render.dispose();
+        };
+
+    private:
+
+        /** \brief A model with a single triangle, in a single mesh
+        * skinned to a single bone. */
+        static void make_triangle_model(hl_mdlviewer::hl1::StudioModel& studio_model)
+        {
+            studio_model.textures.resize(1);
+            studio_model.textures[0].flags = static_cast<aiTextureFlags>(0);
+
+            studio_model.bodyparts.resize(1);
+            studio_model.models.resize(1);
+            studio_model.meshes.resize(1);
+            studio_model.bones.resize(1);
+
+            hl_mdlviewer::hl1::Bodypart& bodypart = studio_model.bodyparts[0];
+            hl_mdlviewer::hl1::Model& model = studio_model.models[0];
+            hl_mdlviewer::hl1::Mesh& mesh = studio_model.meshes[0];
+            hl_mdlviewer::hl1::Bone& bone = studio_model.bones[0];
+
+            bodypart.index = 0;
+            bodypart.models.push_back(&model);
+
+            model.index = 0;
+            model.bodypart = &bodypart;
+            model.meshes.push_back(&mesh);
+
+            mesh.index = 0;
+            mesh.model = &model;
+            mesh.texture = &studio_model.textures[0];
+
+            bone.index = 0;
+            bone.parent_index = -1;
+            bone.parent = nullptr;
+            bone.offset_matrix = glm::mat4(1.0f);
+        }
+
+        /** \brief Build the buffer of the model of make_triangle_model. */
+        static void fill_triangle_buffer(hl_mdlviewer::hl1::StudioModelBuffer& model_buffer)
+        {
+            std::vector<hl_mdlviewer::glvertex> vertices(3);
+            for (hl_mdlviewer::glvertex& vertex : vertices)
+            {
+                vertex.normal = glm::vec3(1.0f, 0.0f, 0.0f);
+                vertex.uv = glm::vec2(0.0f);
+                vertex.boneid = 0;
+            }
+
+            vertices[0].position = glm::vec3(0.0f, 0.0f, 0.0f);
+            vertices[1].position = glm::vec3(0.0f, 10.0f, 0.0f);
+            vertices[2].position = glm::vec3(0.0f, 0.0f, 10.0f);
+
+            hl_mdlviewer::BufferBuilder buffer_builder;
+            hl_mdlviewer::MeshBufferStride stride;
+            buffer_builder.append_triangles(vertices, { 0, 1, 2 }, stride);
+
+            model_buffer.meshes.push_back(stride);
+            model_buffer.buffer.initialize(buffer_builder.get_vertices(), buffer_builder.get_indices());
+        }
+
+        std::string record_buffer_creation()
+        {
+            hl_mdlviewer::RecordingRenderBackend backend;
+            hl_mdlviewer::set_render_backend(&backend);
+
+            hl_mdlviewer::glbuffer buffer;
+            buffer.initialize(std::vector<hl_mdlviewer::glvertex>(3), { 0, 1, 2 });
+            buffer.delete_buffer();
+
+            hl_mdlviewer::set_render_backend(&backend_);
+
+            Assert::AreEqual(3 * sizeof(hl_mdlviewer::glvertex) + 3 * sizeof(unsigned int),
+                backend.statistics().num_uploaded_bytes);
+
+            return backend.to_string();
+        }
+
+        void submit_frame(hl_mdlviewer::glbuffer& buffer)
+        {
+            hl_mdlviewer::glstate state;
+
+            for (int instance_count : { 0, 10 })
+            {
+                // The second pass sets the same state, which is filtered out.
+                state.enable(GL_DEPTH_TEST);
+                state.depth_func(GL_LEQUAL);
+                state.bind_vertex_array(buffer.vertex_array_id());
+
+                if (instance_count > 0)
+                    buffer.draw_elements_instanced_unbinded(GL_TRIANGLES, 3, GL_UNSIGNED_INT, 0, 0, instance_count);
+                else
+                    buffer.draw_elements_unbinded(GL_TRIANGLES, 3, GL_UNSIGNED_INT, 0, 0);
+            }
+
+            state.bind_vertex_array(0);
+        }
+    };
+}
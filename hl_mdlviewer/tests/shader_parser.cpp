@@ -4,6 +4,8 @@
 
 #include "pch.h"
 #include "CppUnitTest.h"
+#include <filesystem>
+#include <fstream>
 #include "file_system.h"
 #include "shader_parser.h"
 
@@ -47,6 +49,87 @@ namespace UnitTest1
                 parsed_shader_string, "my_matrix"));
         };
 
+        TEST_METHOD(DefinesAreInjectedAfterVersion)
+        {
+            std::string parsed_shader_string;
+
+            shader_parser_.parse("defines_are_injected/with_version.shader",
+                { "USE_CHROME", "LIGHTING" },
+                parsed_shader_string);
+
+            Assert::AreEqual(size_t(0), parsed_shader_string.find("#version 330 core\n"
+                "#define USE_CHROME\n"
+                "#define LIGHTING\n"));
+
+            parsed_shader_string.clear();
+
+            // Without a #version directive, defines go first.
+            shader_parser_.parse("defines_are_injected/without_version.shader",
+                { "USE_CHROME" },
+                parsed_shader_string);
+
+            Assert::AreEqual(size_t(0), parsed_shader_string.find("#define USE_CHROME\n"));
+            Assert::AreEqual(1, count_occurences_of_string_in_string(
+                parsed_shader_string, "#define"));
+        };
+
+        TEST_METHOD(FilesAreOnlyReadOnce)
+        {
+            hl_mdlviewer::ShaderParser shader_parser(&file_system_);
+
+            std::string first_shader_string;
+            shader_parser.parse("includes_are_only_included_once/includes_with_quotes.shader",
+                { "USE_CHROME" }, first_shader_string);
+
+            const size_t num_files_read = shader_parser.statistics().num_files_read;
+            Assert::AreEqual(size_t(0), shader_parser.statistics().num_sources_cached);
+
+            // Other defines only change the injected lines.
+            std::string second_shader_string;
+            shader_parser.parse("includes_are_only_included_once/includes_with_quotes.shader",
+                { "LIGHTING" }, second_shader_string);
+
+            Assert::AreEqual(num_files_read, shader_parser.statistics().num_files_read);
+            Assert::AreEqual(size_t(1), shader_parser.statistics().num_sources_cached);
+            Assert::AreEqual(size_t(2), shader_parser.statistics().num_parses);
+            Assert::AreEqual(first_shader_string.length(), second_shader_string.length() + 2);
+
+            // The files included by another shader are not read again.
+            std::string third_shader_string;
+            shader_parser.parse("includes_are_only_included_once/includes_with_no_quotes.shader", third_shader_string);
+            Assert::AreEqual(num_files_read + 1, shader_parser.statistics().num_files_read);
+        };
+
+        TEST_METHOD(ChangedFilesAreReadAgain)
+        {
+            namespace fs = std::filesystem;
+
+            const fs::path directory = fs::temp_directory_path() / "hl_mdlviewer_shader_parser_test";
+            fs::remove_all(directory);
+            fs::create_directories(directory);
+            std::ofstream(directory / "changed.shader") << "#include \"changed.in\"\nvoid main() {}\n";
+            std::ofstream(directory / "changed.in") << "uniform float first;\n";
+
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_search_path(directory.string().c_str());
+            hl_mdlviewer::ShaderParser shader_parser(&file_system);
+
+            std::string parsed_shader_string;
+            shader_parser.parse("changed.shader", parsed_shader_string);
+            Assert::AreEqual(std::string("uniform float first;\nvoid main() {}\n"), parsed_shader_string);
+
+            std::ofstream(directory / "changed.in") << "uniform float second;\n";
+            fs::last_write_time(directory / "changed.in",
+                fs::last_write_time(directory / "changed.in") + std::chrono::seconds(2));
+
+            parsed_shader_string.clear();
+            shader_parser.parse("changed.shader", parsed_shader_string);
+            Assert::AreEqual(std::string("uniform float second;\nvoid main() {}\n"), parsed_shader_string);
+            Assert::AreEqual(size_t(0), shader_parser.statistics().num_sources_cached);
+
+            fs::remove_all(directory);
+        };
+
     private:
         int count_occurences_of_string_in_string(const std::string& searched_string, const std::string& string_to_match)
         {
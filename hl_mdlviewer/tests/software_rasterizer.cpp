@@ -0,0 +1,145 @@
+/** \file software_rasterizer.cpp
+* \brief Includes tests for the software rasterizer class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "software_rasterizer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestSoftwareRasterizer)
+    {
+    public:
+
+        TEST_METHOD(SharedEdgesAreRasterizedOnce)
+        {
+            // Not a multiple of the tile size, so partial tiles are covered.
+            hl_mdlviewer::ThreadPool thread_pool(4);
+            hl_mdlviewer::SoftwareRasterizer rasterizer(&thread_pool);
+            rasterizer.resize(67, 45);
+            rasterizer.clear(glm::vec4(0.0f));
+
+            // A full screen grid of triangles, drawn additive so that any
+            // pixel rasterized twice would show.
+            std::vector<hl_mdlviewer::RasterVertex> vertices;
+            std::vector<unsigned int> indices;
+            const int grid_size = 7;
+
+            for (int y = 0; y <= grid_size; ++y)
+            {
+                for (int x = 0; x <= grid_size; ++x)
+                {
+                    hl_mdlviewer::RasterVertex vertex;
+                    vertex.position = glm::vec4(
+                        -1.0f + 2.0f * x / grid_size, -1.0f + 2.0f * y / grid_size, 0.0f, 1.0f);
+                    vertex.uv = glm::vec2(0.0f);
+                    vertex.intensity = 1.0f;
+                    vertices.push_back(vertex);
+                }
+            }
+
+            for (unsigned int y = 0; y < grid_size; ++y)
+            {
+                for (unsigned int x = 0; x < grid_size; ++x)
+                {
+                    const unsigned int i = y * (grid_size + 1) + x;
+                    indices.insert(indices.end(), { i, i + 1, i + grid_size + 2 });
+                    indices.insert(indices.end(), { i, i + grid_size + 2, i + grid_size + 1 });
+                }
+            }
+
+            hl_mdlviewer::RasterMaterial material;
+            material.color = glm::vec4(0.2f, 0.2f, 0.2f, 1.0f);
+            material.additive = true;
+            material.cull_mode = hl_mdlviewer::RasterCullMode::NONE;
+
+            rasterizer.draw_triangles(vertices.data(), indices.data(), indices.size(), material);
+            rasterizer.flush();
+
+            const hl_mdlviewer::Image& image = rasterizer.color_buffer();
+
+            for (size_t i = 0; i < image.pixels.size(); i += 4)
+                Assert::AreEqual(51, static_cast<int>(image.pixels[i]));
+
+            Assert::AreEqual(size_t(67 * 45), rasterizer.statistics().num_shaded_fragments);
+        };
+
+        TEST_METHOD(FrontFacesAreCulled)
+        {
+            hl_mdlviewer::SoftwareRasterizer rasterizer;
+            rasterizer.resize(16, 16);
+            rasterizer.clear(glm::vec4(0.0f));
+
+            const hl_mdlviewer::RasterVertex vertices[3] = {
+                { glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f), glm::vec2(0.0f), 1.0f },
+                { glm::vec4(1.0f, -1.0f, 0.0f, 1.0f), glm::vec2(0.0f), 1.0f },
+                { glm::vec4(-1.0f, 1.0f, 0.0f, 1.0f), glm::vec2(0.0f), 1.0f } };
+            const unsigned int counter_clockwise[3] = { 0, 1, 2 };
+            const unsigned int clockwise[3] = { 0, 2, 1 };
+
+            hl_mdlviewer::RasterMaterial material;
+            rasterizer.draw_triangles(vertices, counter_clockwise, 3, material);
+            rasterizer.flush();
+            Assert::AreEqual(size_t(0), rasterizer.statistics().num_rasterized_triangles);
+
+            rasterizer.draw_triangles(vertices, clockwise, 3, material);
+            rasterizer.flush();
+            Assert::AreEqual(size_t(1), rasterizer.statistics().num_rasterized_triangles);
+            Assert::AreEqual(255, static_cast<int>(rasterizer.color_buffer().pixel(0, 15)[0]));
+            Assert::AreEqual(0, static_cast<int>(rasterizer.color_buffer().pixel(15, 0)[0]));
+        };
+
+        TEST_METHOD(ResultDoesNotDependOnThreadCount)
+        {
+            const hl_mdlviewer::Image single_threaded = render_clipped_triangles(nullptr);
+
+            hl_mdlviewer::ThreadPool thread_pool(3);
+            const hl_mdlviewer::Image multi_threaded = render_clipped_triangles(&thread_pool);
+
+            Assert::IsTrue(single_threaded.pixels == multi_threaded.pixels);
+        };
+
+    private:
+
+        hl_mdlviewer::Image render_clipped_triangles(hl_mdlviewer::ThreadPool* thread_pool)
+        {
+            hl_mdlviewer::SoftwareRasterizer rasterizer(thread_pool);
+            rasterizer.resize(100, 70);
+            rasterizer.clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+            // Overlapping triangles crossing the near plane and the guard band.
+            std::vector<hl_mdlviewer::RasterVertex> vertices;
+
+            for (int i = 0; i < 30; ++i)
+            {
+                const float angle = i * 0.7f;
+                const float w = 0.5f + (i % 5) * 0.4f;
+
+                hl_mdlviewer::RasterVertex vertex;
+                vertex.position = glm::vec4(
+                    std::cos(angle) * 6.0f * w, std::sin(angle) * 4.0f * w, (i % 7 - 3) * 0.5f * w, w);
+                vertex.uv = glm::vec2(0.0f);
+                vertex.intensity = (i % 4) / 3.0f;
+                vertices.push_back(vertex);
+            }
+
+            std::vector<unsigned int> indices;
+
+            for (unsigned int i = 0; i + 2 < vertices.size(); ++i)
+                indices.insert(indices.end(), { i, i + 1, i + 2 });
+
+            hl_mdlviewer::RasterMaterial material;
+            material.lighting = true;
+            material.color = glm::vec4(0.9f, 0.5f, 0.25f, 1.0f);
+            material.cull_mode = hl_mdlviewer::RasterCullMode::NONE;
+
+            rasterizer.draw_triangles(vertices.data(), indices.data(), indices.size(), material);
+            rasterizer.flush();
+
+            return rasterizer.color_buffer();
+        }
+    };
+}
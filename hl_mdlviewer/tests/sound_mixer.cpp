@@ -0,0 +1,151 @@
+/** \file sound_mixer.cpp
+* \brief Includes tests for the sound mixer and its queue.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "sound_mixer.h"
+#include "spsc_queue.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestSoundMixer)
+    {
+    public:
+
+        TEST_METHOD(QueueKeepsOrderUntilFull)
+        {
+            hl_mdlviewer::SpscQueue<int> queue(3);
+            Assert::AreEqual(size_t(4), queue.capacity());
+
+            for (int i = 0; i < 4; ++i)
+                Assert::IsTrue(queue.try_push(int(i)));
+            Assert::IsFalse(queue.try_push(4));
+
+            int value = -1;
+            for (int i = 0; i < 4; ++i)
+            {
+                Assert::IsTrue(queue.try_pop(value));
+                Assert::AreEqual(i, value);
+            }
+            Assert::IsFalse(queue.try_pop(value));
+        }
+
+        TEST_METHOD(MonoSoundIsMixedToBothChannels)
+        {
+            hl_mdlviewer::SoundMixer mixer(4, 22050);
+            Assert::IsTrue(mixer.play(make_sound(22050, { 100, -200, 300 })));
+
+            std::vector<int16_t> output(8);
+            mixer.mix(output.data(), 4);
+
+            const std::vector<int16_t> expected = { 100, 100, -200, -200, 300, 300, 0, 0 };
+            Assert::IsTrue(output == expected);
+            Assert::AreEqual(size_t(0), mixer.num_playing());
+        }
+
+        TEST_METHOD(OverlappingSoundsAreSummedAndClamped)
+        {
+            hl_mdlviewer::SoundMixer mixer(4, 22050);
+            mixer.play(make_sound(22050, { 30000, 1000 }));
+            mixer.play(make_sound(22050, { 30000, 1000 }));
+
+            std::vector<int16_t> output(4);
+            mixer.mix(output.data(), 2);
+
+            Assert::AreEqual(int16_t(32767), output[0]);
+            Assert::AreEqual(int16_t(2000), output[2]);
+        }
+
+        TEST_METHOD(LowerRateSoundsAreResampled)
+        {
+            hl_mdlviewer::SoundMixer mixer(1, 22050);
+            mixer.play(make_sound(11025, { 0, 1000, 1000 }));
+
+            std::vector<int16_t> output(12);
+            mixer.mix(output.data(), 6);
+
+            // Every other frame is interpolated.
+            Assert::AreEqual(int16_t(0), output[0]);
+            Assert::AreEqual(int16_t(500), output[2]);
+            Assert::AreEqual(int16_t(1000), output[4]);
+            Assert::AreEqual(int16_t(1000), output[10]);
+        }
+
+        TEST_METHOD(FullScaleSquareWaveIsInterpolated)
+        {
+            // 16000 Hz neither divides nor is a multiple of the mixer rate,
+            // so every fraction of a frame comes up.
+            std::vector<int16_t> samples(64);
+            for (size_t i = 0; i < samples.size(); ++i)
+                samples[i] = (i & 1) ? 32767 : -32768;
+
+            hl_mdlviewer::SoundMixer mixer(1, 22050);
+            mixer.play(make_sound(16000, samples));
+
+            const size_t num_frames = 80;
+            std::vector<int16_t> output(num_frames * 2);
+            mixer.mix(output.data(), num_frames);
+
+            bool interpolated = true;
+            for (size_t i = 0; i < num_frames; ++i)
+            {
+                const double position = i * 16000.0 / 22050.0;
+                const size_t frame = static_cast<size_t>(position);
+                const double current = samples[frame];
+                const double next = samples[std::min(frame + 1, samples.size() - 1)];
+                const double expected = current + (next - current) * (position - frame);
+
+                interpolated = interpolated &&
+                    std::fabs(output[i * 2] - expected) <= 4.0 && output[i * 2] == output[i * 2 + 1];
+            }
+
+            Assert::IsTrue(interpolated);
+        }
+
+        TEST_METHOD(OldestVoiceIsStolen)
+        {
+            hl_mdlviewer::SoundMixer mixer(2, 22050);
+            mixer.play(make_sound(22050, std::vector<int16_t>(100, 1)));
+            mixer.play(make_sound(22050, std::vector<int16_t>(100, 10)));
+            mixer.play(make_sound(22050, std::vector<int16_t>(100, 100)));
+
+            std::vector<int16_t> output(2);
+            mixer.mix(output.data(), 1);
+
+            Assert::AreEqual(int16_t(110), output[0]);
+            Assert::AreEqual(size_t(1), mixer.num_stolen());
+            Assert::AreEqual(size_t(2), mixer.num_playing());
+
+            mixer.stop_all();
+            mixer.mix(output.data(), 1);
+            Assert::AreEqual(int16_t(0), output[0]);
+            Assert::AreEqual(size_t(0), mixer.num_playing());
+        }
+
+        TEST_METHOD(CommandsBeyondTheQueueAreDropped)
+        {
+            hl_mdlviewer::SoundMixer mixer(1, 22050, 2);
+            auto sound = make_sound(22050, { 1 });
+
+            Assert::IsTrue(mixer.play(sound));
+            Assert::IsTrue(mixer.play(sound));
+            Assert::IsFalse(mixer.play(sound));
+            Assert::AreEqual(size_t(1), mixer.num_dropped());
+        }
+
+    private:
+
+        static std::shared_ptr<const hl_mdlviewer::PcmSound> make_sound(uint32_t sample_rate,
+            const std::vector<int16_t>& samples)
+        {
+            std::shared_ptr<hl_mdlviewer::PcmSound> sound(new hl_mdlviewer::PcmSound());
+            sound->sample_rate = sample_rate;
+            sound->num_channels = 1;
+            sound->samples = samples;
+            return sound;
+        }
+    };
+}
@@ -0,0 +1,101 @@
+/** \file sprite_sheet_renderer.cpp
+* \brief Includes tests for the HL1 sprite sheet renderer class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <filesystem>
+#include <fstream>
+#include "hl1_sprite_sheet_renderer.h"
+#include "test_models.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestSpriteSheetRenderer)
+    {
+        std::string directory_;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(CreateDirectory)
+        {
+            directory_ = (std::filesystem::temp_directory_path() / "hl_mdlviewer_sprite_sheet_test").string();
+            std::filesystem::remove_all(directory_);
+            std::filesystem::create_directories(directory_ + "/models");
+        }
+
+        TEST_METHOD_CLEANUP(RemoveDirectory)
+        {
+            std::filesystem::remove_all(directory_);
+        }
+
+        TEST_METHOD(UnchangedModelsAreSkipped)
+        {
+            const std::string model_path = directory_ + "/models/box.mdl";
+            const std::string texture_path = directory_ + "/models/boxT.mdl";
+            const std::string output_directory = directory_ + "/sheets";
+
+            Assert::IsTrue(write_box_model(model_path));
+            write_file(texture_path, "texture file");
+
+            hl_mdlviewer::hl1::SpriteSheetSettings settings;
+            settings.cell_width = 16;
+            settings.cell_height = 16;
+            settings.frames_per_sequence = 1;
+
+            hl_mdlviewer::hl1::SpriteSheetRenderer renderer(settings, 1);
+            const std::vector<std::string> model_paths = { model_path };
+
+            hl_mdlviewer::hl1::SpriteSheetBatchResult result = renderer.render_batch(model_paths, output_directory);
+            Assert::IsTrue(result.errors.empty());
+            Assert::AreEqual(size_t(1), result.num_rendered);
+            Assert::AreEqual(size_t(0), result.num_skipped);
+            Assert::AreEqual(size_t(1), result.num_cells);
+            Assert::IsTrue(std::filesystem::exists(output_directory + "/box.png"));
+
+            result = renderer.render_batch(model_paths, output_directory);
+            Assert::AreEqual(size_t(0), result.num_rendered);
+            Assert::AreEqual(size_t(1), result.num_skipped);
+
+            // The texture file is part of the model.
+            write_file(texture_path, "changed texture file");
+
+            result = renderer.render_batch(model_paths, output_directory);
+            Assert::IsTrue(result.errors.empty());
+            Assert::AreEqual(size_t(1), result.num_rendered);
+            Assert::AreEqual(size_t(0), result.num_skipped);
+
+            // A missing sheet is rendered again, whatever the manifest says.
+            std::filesystem::remove(output_directory + "/box.png");
+
+            result = renderer.render_batch(model_paths, output_directory);
+            Assert::AreEqual(size_t(1), result.num_rendered);
+            Assert::AreEqual(size_t(0), result.num_skipped);
+
+            result = renderer.render_batch(model_paths, output_directory, true);
+            Assert::AreEqual(size_t(1), result.num_rendered);
+            Assert::AreEqual(size_t(0), result.num_skipped);
+        }
+
+        TEST_METHOD(UnreadableModelsFail)
+        {
+            hl_mdlviewer::hl1::SpriteSheetRenderer renderer(hl_mdlviewer::hl1::SpriteSheetSettings(), 1);
+
+            const hl_mdlviewer::hl1::SpriteSheetBatchResult result = renderer.render_batch(
+                { directory_ + "/models/missing.mdl" }, directory_ + "/sheets");
+            Assert::AreEqual(size_t(1), result.num_failed);
+            Assert::AreEqual(size_t(1), result.errors.size());
+            Assert::AreEqual(size_t(0), result.num_rendered);
+        }
+
+    private:
+
+        static void write_file(const std::string& file_path, const std::string& data)
+        {
+            std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+            file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+    };
+}
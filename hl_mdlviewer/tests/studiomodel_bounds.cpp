@@ -0,0 +1,66 @@
+/** \file studiomodel_bounds.cpp
+* \brief Includes tests for the HL1 Studio model bounds class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "hl1_studiomodel_bounds.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestStudioModelBounds)
+    {
+    public:
+
+        TEST_METHOD(BoundsFollowTheBones)
+        {
+            hl_mdlviewer::hl1::StudioModel studio_model;
+            studio_model.bones.resize(2);
+            for (int i = 0; i < 2; ++i)
+                studio_model.bones[i].index = i;
+
+            // Two hitboxes on the first bone are merged, the second bone
+            // has none.
+            studio_model.hitboxes.resize(2);
+            studio_model.hitboxes[0].bone = &studio_model.bones[0];
+            studio_model.hitboxes[0].bbmin = glm::vec3(-1.0f, -1.0f, 0.0f);
+            studio_model.hitboxes[0].bbmax = glm::vec3(1.0f, 1.0f, 2.0f);
+            studio_model.hitboxes[1].bone = &studio_model.bones[0];
+            studio_model.hitboxes[1].bbmin = glm::vec3(0.0f, 0.0f, 2.0f);
+            studio_model.hitboxes[1].bbmax = glm::vec3(1.0f, 1.0f, 4.0f);
+
+            hl_mdlviewer::hl1::StudioModelBuffer buffer;
+            buffer.bone_vertex_bounds.push_back({ 1, glm::vec3(-1.0f), glm::vec3(1.0f) });
+
+            hl_mdlviewer::hl1::StudioModelBounds bounds;
+            bounds.setup(studio_model, buffer);
+            Assert::IsTrue(bounds.has_hitboxes());
+
+            // Rotate the first bone a quarter turn around z, move the second.
+            std::vector<glm::mat4> bones_transform(2);
+            bones_transform[0] = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+            bones_transform[1] = glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 0.0f, 0.0f));
+
+            glm::vec3 bbmin, bbmax;
+            Assert::IsTrue(bounds.compute(bones_transform, hl_mdlviewer::hl1::BoundsMode::HITBOXES, bbmin, bbmax));
+            Assert::AreEqual(-1.0f, bbmin.x, 1e-5f);
+            Assert::AreEqual(-1.0f, bbmin.y, 1e-5f);
+            Assert::AreEqual(0.0f, bbmin.z, 1e-5f);
+            Assert::AreEqual(1.0f, bbmax.x, 1e-5f);
+            Assert::AreEqual(1.0f, bbmax.y, 1e-5f);
+            Assert::AreEqual(4.0f, bbmax.z, 1e-5f);
+
+            Assert::IsTrue(bounds.compute(bones_transform, hl_mdlviewer::hl1::BoundsMode::VERTICES, bbmin, bbmax));
+            Assert::AreEqual(9.0f, bbmin.x, 1e-5f);
+            Assert::AreEqual(11.0f, bbmax.x, 1e-5f);
+            Assert::AreEqual(-1.0f, bbmin.z, 1e-5f);
+            Assert::AreEqual(1.0f, bbmax.z, 1e-5f);
+
+            // Without bone transforms, there is nothing to bound.
+            Assert::IsFalse(bounds.compute(std::vector<glm::mat4>(), hl_mdlviewer::hl1::BoundsMode::VERTICES, bbmin, bbmax));
+        }
+    };
+}
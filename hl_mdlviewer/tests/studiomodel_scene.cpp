@@ -0,0 +1,159 @@
+/** \file studiomodel_scene.cpp
+* \brief Includes tests for the HL1 Studio model scene class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "hl1_animation_event_handler.h"
+#include "hl1_frame_interpolation.h"
+#include "hl1_studiomodel_scene.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestStudioModelScene)
+    {
+    public:
+
+        TEST_METHOD(CullsInstancesOutsideTheFrustum)
+        {
+            hl_mdlviewer::hl1::StudioModel studio_model;
+            studio_model.sequences.resize(1);
+            studio_model.sequences[0].bbmin = glm::vec3(-1.0f);
+            studio_model.sequences[0].bbmax = glm::vec3(1.0f);
+
+            // Culling with the sequence bounds does not animate.
+            hl_mdlviewer::hl1::StudioModelScene scene;
+            scene.set_bounds_source(hl_mdlviewer::hl1::SceneBoundsSource::SEQUENCE);
+            const size_t model = scene.add_model(&studio_model, nullptr, nullptr, glm::mat4(1.0f));
+
+            // Five instances on a line, looked at from 10 units away on z.
+            for (int i = 0; i < 5; ++i)
+            {
+                hl_mdlviewer::hl1::StudioModelInstance instance;
+                instance.transform = glm::translate(glm::mat4(1.0f), glm::vec3(i * 4.0f, 0.0f, 0.0f));
+                instance.sequence = 0;
+                scene.add_instance(model, instance);
+            }
+
+            // The frustum is 10 units wide at the instances, from x = -5 to 5.
+            const glm::mat4 projection = glm::perspective(2.0f * std::atan(0.5f), 1.0f, 1.0f, 100.0f);
+            const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+            scene.cull(projection * view);
+
+            // The instances at x = 0 and 4 are inside, the one at 8 is
+            // outside even though its bounds reach x = 7.
+            const std::vector<uint32_t>& visible = scene.visible_instances();
+            Assert::AreEqual(static_cast<size_t>(2), visible.size());
+            Assert::AreEqual(0u, visible[0]);
+            Assert::AreEqual(1u, visible[1]);
+
+            const hl_mdlviewer::hl1::SceneStatistics& statistics = scene.statistics();
+            Assert::AreEqual(static_cast<size_t>(5), statistics.num_instances);
+            Assert::AreEqual(static_cast<size_t>(2), statistics.num_visible);
+            Assert::AreEqual(static_cast<size_t>(3), statistics.num_culled);
+
+            // Moving an instance updates its bounds.
+            hl_mdlviewer::hl1::StudioModelInstance instance = scene.get_instance(4);
+            instance.transform = glm::translate(glm::mat4(1.0f), glm::vec3(-2.0f, 0.0f, 0.0f));
+            scene.set_instance(4, instance);
+
+            scene.cull(projection * view);
+            Assert::AreEqual(static_cast<size_t>(3), scene.visible_instances().size());
+            Assert::AreEqual(4u, scene.visible_instances()[2]);
+
+            glm::vec3 bbmin, bbmax;
+            scene.get_world_bounds(4, bbmin, bbmax);
+            Assert::AreEqual(-3.0f, bbmin.x, 1e-5f);
+            Assert::AreEqual(-1.0f, bbmax.x, 1e-5f);
+        }
+
+        TEST_METHOD(PausedInstancesAreNotPlaying)
+        {
+            hl_mdlviewer::hl1::StudioModel studio_model;
+            studio_model.sequences.resize(2);
+            studio_model.sequences[0].num_frames = 10;
+            studio_model.sequences[1].num_frames = 1;
+
+            hl_mdlviewer::hl1::AnimationEventHandler animation_event_handler;
+            hl_mdlviewer::hl1::FrameInterpolation frame_interpolation;
+            hl_mdlviewer::hl1::StudioModelAnimation animation(&studio_model, &animation_event_handler, &frame_interpolation);
+
+            hl_mdlviewer::hl1::StudioModelScene scene;
+            const size_t model = scene.add_model(&studio_model, &animation, nullptr, glm::mat4(1.0f));
+            Assert::IsFalse(scene.has_playing_instances());
+
+            // Paused, or on a sequence of a single frame.
+            hl_mdlviewer::hl1::StudioModelInstance instance;
+            instance.sequence = 0;
+            instance.playback_rate = 0.0f;
+            scene.add_instance(model, instance);
+
+            instance.sequence = 1;
+            instance.playback_rate = 1.0f;
+            scene.add_instance(model, instance);
+            Assert::IsFalse(scene.has_playing_instances());
+
+            instance.sequence = 0;
+            scene.set_instance(0, instance);
+            Assert::IsTrue(scene.has_playing_instances());
+        }
+
+        TEST_METHOD(InstancesWithoutAnimationStandInTheBindPose)
+        {
+            hl_mdlviewer::hl1::StudioModel studio_model;
+            studio_model.sequences.resize(1);
+            studio_model.sequences[0].bbmin = glm::vec3(-1.0f);
+            studio_model.sequences[0].bbmax = glm::vec3(1.0f);
+            studio_model.sequences[0].fps = 30.0f;
+            studio_model.sequences[0].num_frames = 10;
+
+            // A root bone, and a child turned a quarter around z.
+            studio_model.bones.resize(2);
+            studio_model.bones[0].index = 0;
+            studio_model.bones[0].parent_index = -1;
+            studio_model.bones[0].parent = nullptr;
+            studio_model.bones[0].local_quat = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+            studio_model.bones[0].local_position = glm::vec3(1.0f, 2.0f, 3.0f);
+            studio_model.bones[1].index = 1;
+            studio_model.bones[1].parent_index = 0;
+            studio_model.bones[1].parent = &studio_model.bones[0];
+            studio_model.bones[1].local_quat = glm::quat(std::sqrt(0.5f), 0.0f, 0.0f, std::sqrt(0.5f));
+            studio_model.bones[1].local_position = glm::vec3(0.0f, 0.0f, 1.0f);
+
+            hl_mdlviewer::hl1::StudioModelScene scene;
+            scene.set_bounds_source(hl_mdlviewer::hl1::SceneBoundsSource::SEQUENCE);
+            const size_t model = scene.add_model(&studio_model, nullptr, nullptr, glm::mat4(1.0f));
+
+            hl_mdlviewer::hl1::StudioModelInstance instance;
+            instance.transform = glm::mat4(1.0f);
+            instance.sequence = 0;
+            instance.frame = 2.0f;
+            scene.add_instance(model, instance);
+
+            const glm::mat4 view_projection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, -10.0f, 10.0f);
+            scene.cull(view_projection);
+            Assert::AreEqual(static_cast<size_t>(1), scene.visible_instances().size());
+
+            scene.animate(0.5f);
+            Assert::AreEqual(2.0f, scene.get_frame(0), 1e-5f);
+            Assert::IsFalse(scene.has_playing_instances());
+
+            std::vector<glm::mat4> bones_transform;
+            scene.compute_bone_transforms(0, bones_transform);
+            Assert::AreEqual(static_cast<size_t>(2), bones_transform.size());
+
+            // The x axis of the child points along y, from (1, 2, 4).
+            const glm::vec4 origin = bones_transform[1] * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            const glm::vec4 x_axis = bones_transform[1] * glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+            Assert::AreEqual(1.0f, origin.x, 1e-5f);
+            Assert::AreEqual(2.0f, origin.y, 1e-5f);
+            Assert::AreEqual(4.0f, origin.z, 1e-5f);
+            Assert::AreEqual(0.0f, x_axis.x, 1e-5f);
+            Assert::AreEqual(1.0f, x_axis.y, 1e-5f);
+        }
+    };
+}
@@ -0,0 +1,91 @@
+/** \file studiomodel_skinning.cpp
+* \brief Includes tests for the HL1 Studio model CPU skinning class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "hl1_studiomodel_skinning.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestStudioModelSkinning)
+    {
+    public:
+
+        TEST_METHOD(MatchesPerVertexSkinning)
+        {
+            const int num_bones = 3;
+
+            hl_mdlviewer::hl1::StudioModel studio_model;
+            studio_model.bones.resize(num_bones);
+            for (int i = 0; i < num_bones; ++i)
+                studio_model.bones[i].offset_matrix = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f * i, 2.0f, 0.5f * i));
+
+            // Meshes with runs longer and shorter than the SIMD width, and
+            // bones interleaved so that sorting matters.
+            hl_mdlviewer::hl1::StudioModelBuffer buffer;
+            const int mesh_sizes[] = { 23, 3, 0, 17 };
+
+            for (int num_vertices : mesh_sizes)
+            {
+                hl_mdlviewer::MeshBufferStride stride;
+                stride.vertex_start_index = static_cast<int>(buffer.vertices.size());
+                stride.num_vertices = num_vertices;
+                buffer.meshes.push_back(stride);
+
+                for (int v = 0; v < num_vertices; ++v)
+                {
+                    hl_mdlviewer::glvertex vertex;
+                    const float value = static_cast<float>(buffer.vertices.size());
+                    vertex.position = glm::vec3(value, -0.5f * value, 3.0f - value);
+                    vertex.normal = glm::normalize(glm::vec3(1.0f, value, 2.0f));
+                    vertex.uv = glm::vec2(0.0f);
+                    vertex.boneid = (v * 7) % num_bones;
+                    buffer.vertices.push_back(vertex);
+                }
+            }
+
+            std::vector<glm::mat4> bones_transform(num_bones);
+            for (int i = 0; i < num_bones; ++i)
+            {
+                bones_transform[i] = glm::rotate(
+                    glm::translate(glm::mat4(1.0f), glm::vec3(i, 1.0f, -2.0f)),
+                    0.3f + i, glm::vec3(0.0f, 0.6f, 0.8f));
+            }
+
+            const glm::mat4 transform = glm::scale(glm::mat4(1.0f), glm::vec3(2.0f));
+
+            hl_mdlviewer::hl1::StudioModelSkinning skinning;
+            skinning.setup(studio_model, buffer);
+            Assert::AreEqual(buffer.vertices.size(), skinning.num_vertices());
+
+            hl_mdlviewer::ThreadPool thread_pool(3);
+            hl_mdlviewer::hl1::SkinnedVertices output;
+            output.resize(skinning.num_vertices());
+            skinning.skin(bones_transform, transform, output, &thread_pool);
+
+            for (size_t i = 0; i < buffer.vertices.size(); ++i)
+            {
+                const hl_mdlviewer::glvertex& vertex = buffer.vertices[i];
+                const glm::mat4 world = transform * bones_transform[vertex.boneid] *
+                    studio_model.bones[vertex.boneid].offset_matrix;
+                const glm::vec3 position = glm::vec3(world * glm::vec4(vertex.position, 1.0f));
+                const glm::vec3 normal = glm::mat3(world) * vertex.normal;
+
+                const int index = skinning.get_output_index(static_cast<unsigned int>(i));
+                Assert::IsTrue(index >= 0);
+                Assert::AreEqual(static_cast<unsigned int>(i), skinning.get_vertex_order()[index]);
+
+                Assert::AreEqual(position.x, output.x[index], 1e-4f);
+                Assert::AreEqual(position.y, output.y[index], 1e-4f);
+                Assert::AreEqual(position.z, output.z[index], 1e-4f);
+                Assert::AreEqual(normal.x, output.normal_x[index], 1e-4f);
+                Assert::AreEqual(normal.y, output.normal_y[index], 1e-4f);
+                Assert::AreEqual(normal.z, output.normal_z[index], 1e-4f);
+            }
+        }
+    };
+}
@@ -0,0 +1,260 @@
+/** \file studiomodel_software_render.cpp
+* \brief Includes tests comparing the HL1 Studio model software render
+* class with the OpenGL renderer.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "config.h"
+
+#if defined HLMVIEWER_NANOGUI_ENABLED
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include "glad.h"
+#include <GLFW/glfw3.h>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include "file_system.h"
+#include "hl1_animation_event_handler.h"
+#include "hl1_frame_interpolation.h"
+#include "hl1_studiomodel_animation.h"
+#include "hl1_studiomodel_render.h"
+#include "hl1_studiomodel_setup.h"
+#include "hl1_studiomodel_software_render.h"
+#include "render_view_settings.h"
+#include "test_models.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestStudioModelSoftwareRender)
+    {
+        static const int WIDTH = 128;
+        static const int HEIGHT = 128;
+
+        /** \brief The largest difference of a channel for two pixels to match. */
+        static const int TOLERANCE = 24;
+
+        GLFWwindow* window_ = nullptr;
+        std::string directory_;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(CreateContext)
+        {
+            directory_ = (std::filesystem::temp_directory_path() / "hl_mdlviewer_software_render_test").string();
+            std::filesystem::remove_all(directory_);
+            std::filesystem::create_directories(directory_);
+
+            Assert::IsTrue(glfwInit() == GLFW_TRUE);
+
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+            window_ = glfwCreateWindow(WIDTH, HEIGHT, "", nullptr, nullptr);
+            Assert::IsNotNull(window_);
+
+            glfwMakeContextCurrent(window_);
+            Assert::IsTrue(gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)) != 0);
+        }
+
+        TEST_METHOD_CLEANUP(DestroyContext)
+        {
+            if (window_)
+                glfwDestroyWindow(window_);
+            window_ = nullptr;
+            glfwTerminate();
+
+            std::filesystem::remove_all(directory_);
+        }
+
+        TEST_METHOD(MatchesTheOpenGLRenderer)
+        {
+            const std::string model_path = directory_ + "/box.mdl";
+            Assert::IsTrue(write_box_model(model_path));
+
+            Assimp::Importer importer;
+            const aiScene* scene = importer.ReadFile(model_path, aiProcess_ValidateDataStructure | aiProcess_PopulateArmatureData);
+            Assert::IsNotNull(scene);
+
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_search_path(HLMDLVIEWER_MODEL_SHADERS_SEARCH_PATH);
+
+            hl_mdlviewer::hl1::StudioModel studio_model;
+            hl_mdlviewer::hl1::StudioModelRender model_render(&studio_model, &file_system);
+            model_render.initialize();
+
+            // Without the simplified meshes, which only OpenGL draws.
+            glm::mat4 scene_transform(1.0f);
+            hl_mdlviewer::hl1::StudioModelSetup model_setup;
+            model_setup.set_num_mesh_lods(0);
+            model_setup.setup_model(scene, &studio_model, model_render.get_buffer(), scene_transform,
+                hl_mdlviewer::VertexFormat::STANDARD, true, hl_mdlviewer::hl1::BufferStorage::GPU_AND_CPU);
+
+            model_render.on_model_changed();
+            model_render.set_scene_transform(scene_transform);
+            model_render.set_render_mode(hl_mdlviewer::hl1::RenderMode::TEXTURED);
+
+            hl_mdlviewer::hl1::AnimationEventHandler animation_event_handler;
+            hl_mdlviewer::hl1::FrameInterpolation frame_interpolation;
+            hl_mdlviewer::hl1::StudioModelAnimation animation(&studio_model, &animation_event_handler, &frame_interpolation);
+            animation.on_model_changed();
+
+            std::vector<glm::mat4> bones_transform;
+            animation.compute_bone_transforms(0, 0.0f, bones_transform);
+
+            // Turned so that three faces of the box are seen.
+            hl_mdlviewer::RenderViewSettings view_settings;
+            const glm::vec2 rotation(10.0f, 8.0f);
+
+            model_render.update_angles(rotation);
+            model_render.setup_projection_matrix(WIDTH, HEIGHT);
+
+            const glm::mat4 projection = hl_mdlviewer::get_projection_matrix(view_settings, WIDTH, HEIGHT);
+            const glm::mat4 model = hl_mdlviewer::get_model_matrix(glm::vec3(
+                rotation.y * view_settings.rotate_sensitivity,
+                rotation.x * view_settings.rotate_sensitivity,
+                0.0f));
+
+            const glm::vec4 background_color(0.25f, 0.5f, 0.75f, 1.0f);
+
+            hl_mdlviewer::hl1::StudioModelSoftwareRender software_render;
+            software_render.resize(WIDTH, HEIGHT);
+            software_render.set_clear_color(background_color);
+
+            GLuint framebuffer = 0, renderbuffers[2] = { 0, 0 };
+            glGenFramebuffers(1, &framebuffer);
+            glGenRenderbuffers(2, renderbuffers);
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+            glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+
+            glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, WIDTH, HEIGHT);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+
+            Assert::IsTrue(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+            // Close, the textures are magnified. Far, each face is about 9
+            // pixels wide and its 16 texels come from the second mip level,
+            // and the edges are a larger part of the box.
+            const struct
+            {
+                float zdistance;
+                size_t min_covered_pixels;
+                size_t max_different_percent;
+            } distances[] = {
+                { 80.0f, static_cast<size_t>(WIDTH) * HEIGHT / 10, 3 },
+                { 300.0f, 64, 25 }
+            };
+
+            for (const auto& distance : distances)
+            {
+                view_settings.zdistance = distance.zdistance;
+                model_render.set_zdistance(distance.zdistance);
+
+                const glm::mat4 view = hl_mdlviewer::get_view_matrix(view_settings, glm::vec2(0.0f));
+                software_render.set_matrices(projection, view, model, scene_transform);
+
+                for (bool lighting : { false, true })
+                {
+                    model_render.set_lighting_enabled(lighting);
+
+                    glViewport(0, 0, WIDTH, HEIGHT);
+                    glClearColor(background_color.x, background_color.y, background_color.z, background_color.w);
+                    glDepthMask(GL_TRUE);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                    model_render.begin_frame();
+                    model_render.set_bones_transform(bones_transform);
+                    model_render.setup_view();
+                    model_render.render();
+                    model_render.end_frame();
+
+                    const hl_mdlviewer::Image gl_image = read_framebuffer();
+
+                    software_render.render(studio_model, *model_render.get_buffer(),
+                        *model_render.render_data(), *model_render.render_settings(), bones_transform);
+
+                    compare_images(gl_image, software_render.color_buffer(),
+                        distance.min_covered_pixels, distance.max_different_percent);
+                }
+            }
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glDeleteRenderbuffers(2, renderbuffers);
+            glDeleteFramebuffers(1, &framebuffer);
+
+            model_render.dispose();
+        }
+
+    private:
+
+        /** \brief Read the color attachment, top row first like the
+        * software renderer. */
+        static hl_mdlviewer::Image read_framebuffer()
+        {
+            std::vector<uint8_t> pixels(static_cast<size_t>(WIDTH) * HEIGHT * 4);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            Assert::IsTrue(glGetError() == GL_NO_ERROR);
+
+            hl_mdlviewer::Image image(WIDTH, HEIGHT);
+            for (int y = 0; y < HEIGHT; ++y)
+            {
+                std::copy_n(&pixels[static_cast<size_t>(HEIGHT - 1 - y) * WIDTH * 4],
+                    WIDTH * 4, image.pixel(0, y));
+            }
+            return image;
+        }
+
+        /** \brief Check that the model covers at least \p min_covered_pixels,
+        * and that at most \p max_different_percent of them differ. The edges
+        * of the faces and of the texels may be rasterized or filtered
+        * differently. */
+        static void compare_images(const hl_mdlviewer::Image& expected, const hl_mdlviewer::Image& image,
+            size_t min_covered_pixels, size_t max_different_percent)
+        {
+            Assert::AreEqual(expected.width, image.width);
+            Assert::AreEqual(expected.height, image.height);
+
+            const uint8_t* background = image.pixel(0, 0);
+
+            size_t num_covered = 0, num_different = 0;
+            for (unsigned int y = 0; y < image.height; ++y)
+            {
+                for (unsigned int x = 0; x < image.width; ++x)
+                {
+                    const uint8_t* a = expected.pixel(x, y);
+                    const uint8_t* b = image.pixel(x, y);
+
+                    int difference = 0, background_difference = 0;
+                    for (int channel = 0; channel < 3; ++channel)
+                    {
+                        difference = std::max(difference, std::abs(a[channel] - b[channel]));
+                        background_difference = std::max(background_difference, std::abs(b[channel] - background[channel]));
+                    }
+
+                    if (background_difference > TOLERANCE)
+                        ++num_covered;
+                    if (difference > TOLERANCE)
+                        ++num_different;
+                }
+            }
+
+            Assert::IsTrue(num_covered >= min_covered_pixels);
+            Assert::IsTrue(num_different * 100 <= num_covered * max_different_percent);
+        }
+    };
+}
+
+#endif // HLMVIEWER_NANOGUI_ENABLED
@@ -0,0 +1,261 @@
+#ifndef HLMDLVIEWERTESTS_TEST_MODELS_H_
+#define HLMDLVIEWERTESTS_TEST_MODELS_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace UnitTest1
+{
+    /** \brief Writes the structures of a Half-Life model file, little endian. */
+    class ModelFileWriter
+    {
+    public:
+        size_t size() const { return data_.size(); }
+        int offset() const { return static_cast<int>(data_.size()); }
+
+        void put_int(int value) { put(&value, sizeof(value)); }
+        void put_short(int16_t value) { put(&value, sizeof(value)); }
+        void put_byte(uint8_t value) { put(&value, sizeof(value)); }
+        void put_float(float value) { put(&value, sizeof(value)); }
+
+        void put_vec3(float x, float y, float z)
+        {
+            put_float(x);
+            put_float(y);
+            put_float(z);
+        }
+
+        /** \brief Put a name padded with zeros to \p size bytes. */
+        void put_name(const char* name, size_t size)
+        {
+            std::vector<char> padded(size, 0);
+            std::memcpy(padded.data(), name, std::min(std::strlen(name), size - 1));
+            put(padded.data(), size);
+        }
+
+        void align()
+        {
+            while (data_.size() % 4)
+                data_.push_back(0);
+        }
+
+        void set_int(size_t offset, int value)
+        {
+            std::memcpy(&data_[offset], &value, sizeof(value));
+        }
+
+        const std::vector<uint8_t>& data() const { return data_; }
+
+    private:
+        void put(const void* data, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            data_.insert(data_.end(), bytes, bytes + size);
+        }
+
+        std::vector<uint8_t> data_;
+    };
+
+    /** \brief Write a Half-Life model of a box, 32 units wide and standing
+    * on the origin, with one bone, one sequence and a checkered texture.
+    * \return false if the file could not be written.
+    */
+    inline bool write_box_model(const std::string& file_path)
+    {
+        ModelFileWriter writer;
+
+        // The header, written last.
+        const size_t header_size = 244;
+        for (size_t i = 0; i < header_size / 4; ++i)
+            writer.put_int(0);
+
+        const int bone_index = writer.offset();
+        writer.put_name("root", 32);
+        writer.put_int(-1);                     // Parent.
+        writer.put_int(0);                      // Flags.
+        for (int i = 0; i < 6; ++i)
+            writer.put_int(-1);                 // Bone controllers.
+        for (int i = 0; i < 6; ++i)
+            writer.put_float(0.0f);             // Position and rotation.
+        for (int i = 0; i < 6; ++i)
+            writer.put_float(1.0f);             // Animation scales.
+
+        const int sequence_group_index = writer.offset();
+        writer.put_name("default", 32);
+        writer.put_name("", 64);
+        writer.put_int(0);                      // Cache.
+        writer.put_int(0);                      // Data.
+
+        // No animation values, every frame has the default bone values.
+        const int animation_index = writer.offset();
+        for (int i = 0; i < 6; ++i)
+            writer.put_short(0);
+
+        const int sequence_index = writer.offset();
+        writer.put_name("idle", 32);
+        writer.put_float(30.0f);                // Frame rate.
+        for (int i = 0; i < 5; ++i)
+            writer.put_int(0);                  // Flags, activity, weight and events.
+        writer.put_int(2);                      // Frames.
+        for (int i = 0; i < 4; ++i)
+            writer.put_int(0);                  // Pivots and motion.
+        writer.put_vec3(0.0f, 0.0f, 0.0f);      // Linear movement.
+        writer.put_int(0);
+        writer.put_int(0);
+        writer.put_vec3(-16.0f, -16.0f, 0.0f);
+        writer.put_vec3(16.0f, 16.0f, 32.0f);
+        writer.put_int(1);                      // Blends.
+        writer.put_int(animation_index);
+        for (int i = 0; i < 6; ++i)
+            writer.put_int(0);                  // Blend types and ranges.
+        for (int i = 0; i < 6; ++i)
+            writer.put_int(0);                  // Blend parent, group and nodes.
+
+        const unsigned int texture_size = 16;
+        const int texture_index = writer.offset();
+        writer.put_name("checker.bmp", 64);
+        writer.put_int(0);                      // Flags.
+        writer.put_int(texture_size);
+        writer.put_int(texture_size);
+        writer.put_int(0);                      // Data, set below.
+
+        const int texture_data_index = writer.offset();
+        writer.set_int(texture_data_index - 4, texture_data_index);
+        for (unsigned int y = 0; y < texture_size; ++y)
+        {
+            for (unsigned int x = 0; x < texture_size; ++x)
+                writer.put_byte(static_cast<uint8_t>(((x / 4) + (y / 4)) & 1));
+        }
+        for (int i = 0; i < 256; ++i)
+        {
+            writer.put_byte(static_cast<uint8_t>(i ? 240 : 200));
+            writer.put_byte(static_cast<uint8_t>(i ? 240 : 40));
+            writer.put_byte(static_cast<uint8_t>(i ? 240 : 40));
+        }
+        writer.align();
+
+        const int skin_index = writer.offset();
+        writer.put_short(0);
+        writer.align();
+
+        // The corners of the box, x in the first bit, y and z in the next.
+        const int num_vertices = 8;
+        const int vertex_info_index = writer.offset();
+        for (int i = 0; i < num_vertices; ++i)
+            writer.put_byte(0);                 // The bone of each vertex.
+
+        const int vertex_index = writer.offset();
+        for (int i = 0; i < num_vertices; ++i)
+            writer.put_vec3(i & 1 ? 16.0f : -16.0f, i & 2 ? 16.0f : -16.0f, i & 4 ? 32.0f : 0.0f);
+
+        // One strip of four corners per face, with the normal of the face.
+        const int faces[6][4] = {
+            { 0, 2, 4, 6 }, { 1, 5, 3, 7 },
+            { 0, 4, 1, 5 }, { 2, 3, 6, 7 },
+            { 0, 1, 2, 3 }, { 4, 6, 5, 7 }
+        };
+        const float normals[6][3] = {
+            { -1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f },
+            { 0.0f, -1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+            { 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f, 1.0f }
+        };
+        const int num_normals = 6;
+
+        const int normal_info_index = writer.offset();
+        for (int i = 0; i < num_normals; ++i)
+            writer.put_byte(0);
+        writer.align();
+
+        const int normal_index = writer.offset();
+        for (const auto& normal : normals)
+            writer.put_vec3(normal[0], normal[1], normal[2]);
+
+        // Each command: vertex, normal, s and t.
+        const int triangle_index = writer.offset();
+        for (int face = 0; face < 6; ++face)
+        {
+            writer.put_short(4);
+            for (int corner = 0; corner < 4; ++corner)
+            {
+                writer.put_short(static_cast<int16_t>(faces[face][corner]));
+                writer.put_short(static_cast<int16_t>(face));
+                writer.put_short(static_cast<int16_t>(corner & 1 ? texture_size : 0));
+                writer.put_short(static_cast<int16_t>(corner & 2 ? texture_size : 0));
+            }
+        }
+        writer.put_short(0);
+        writer.align();
+
+        const int mesh_index = writer.offset();
+        writer.put_int(12);                     // Triangles.
+        writer.put_int(triangle_index);
+        writer.put_int(0);                      // Skin reference.
+        writer.put_int(num_normals);
+        writer.put_int(normal_index);
+
+        const int model_index = writer.offset();
+        writer.put_name("box", 64);
+        writer.put_int(0);                      // Type.
+        writer.put_float(32.0f);                // Bounding radius.
+        writer.put_int(1);
+        writer.put_int(mesh_index);
+        writer.put_int(num_vertices);
+        writer.put_int(vertex_info_index);
+        writer.put_int(vertex_index);
+        writer.put_int(num_normals);
+        writer.put_int(normal_info_index);
+        writer.put_int(normal_index);
+        writer.put_int(0);                      // Groups.
+        writer.put_int(0);
+
+        const int bodypart_index = writer.offset();
+        writer.put_name("body", 64);
+        writer.put_int(1);                      // Models.
+        writer.put_int(1);                      // Base.
+        writer.put_int(model_index);
+
+        ModelFileWriter header;
+        header.put_int(0x54534449);             // "IDST"
+        header.put_int(10);                     // Version.
+        header.put_name("box.mdl", 64);
+        header.put_int(writer.offset());
+        header.put_vec3(0.0f, 0.0f, 16.0f);     // Eye position.
+        header.put_vec3(-16.0f, -16.0f, 0.0f);
+        header.put_vec3(16.0f, 16.0f, 32.0f);
+        header.put_vec3(0.0f, 0.0f, 0.0f);      // Clipping box.
+        header.put_vec3(0.0f, 0.0f, 0.0f);
+        header.put_int(0);                      // Flags.
+
+        const int counts_and_offsets[] = {
+            1, bone_index,                      // Bones.
+            0, 0,                               // Bone controllers.
+            0, 0,                               // Hitboxes.
+            1, sequence_index,
+            1, sequence_group_index,
+            1, texture_index, texture_data_index,
+            1, 1, skin_index,                   // Skin references and families.
+            1, bodypart_index,
+            0, 0,                               // Attachments.
+            0, 0, 0, 0,                         // Sounds.
+            0, 0                                // Transitions.
+        };
+        for (int value : counts_and_offsets)
+            header.put_int(value);
+
+        if (header.size() != header_size)
+            return false;
+
+        std::vector<uint8_t> model = writer.data();
+        std::memcpy(model.data(), header.data().data(), header_size);
+
+        std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(model.data()), static_cast<std::streamsize>(model.size()));
+        return static_cast<bool>(file);
+    }
+}
+
+#endif // HLMDLVIEWERTESTS_TEST_MODELS_H_
@@ -0,0 +1,90 @@
+/** \file texture_atlas.cpp
+* \brief Includes tests for the texture atlas packing functions.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "texture_atlas.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestTextureAtlas)
+    {
+    public:
+
+        TEST_METHOD(PaddedRectsDoNotOverlap)
+        {
+            using hl_mdlviewer::AtlasRect;
+
+            std::vector<AtlasRect> rects = {
+                AtlasRect(64, 32), AtlasRect(100, 100), AtlasRect(16, 16),
+                AtlasRect(128, 8), AtlasRect(30, 70), AtlasRect(1, 1)
+            };
+            const unsigned int padding = 1;
+
+            unsigned int width, height;
+            Assert::IsTrue(hl_mdlviewer::pack_atlas(rects, padding, 1024, width, height));
+            Assert::AreEqual(256u, width);
+
+            for (size_t i = 0; i < rects.size(); ++i)
+            {
+                const AtlasRect& a = rects[i];
+                Assert::IsTrue(a.x >= padding && a.y >= padding);
+                Assert::IsTrue(a.x + a.width + padding <= width);
+                Assert::IsTrue(a.y + a.height + padding <= height);
+
+                for (size_t j = i + 1; j < rects.size(); ++j)
+                {
+                    const AtlasRect& b = rects[j];
+                    const bool apart =
+                        a.x + a.width + padding <= b.x - padding || b.x + b.width + padding <= a.x - padding ||
+                        a.y + a.height + padding <= b.y - padding || b.y + b.height + padding <= a.y - padding;
+                    Assert::IsTrue(apart);
+                }
+            }
+
+            Assert::IsFalse(hl_mdlviewer::pack_atlas(rects, padding, 64, width, height));
+        }
+
+        TEST_METHOD(AlignedRectsKeepTheirPlaceInMipLevels)
+        {
+            using hl_mdlviewer::AtlasRect;
+
+            std::vector<AtlasRect> rects = { AtlasRect(37, 21), AtlasRect(64, 64), AtlasRect(5, 90) };
+            const unsigned int alignment = 8;
+
+            unsigned int width, height;
+            Assert::IsTrue(hl_mdlviewer::pack_atlas(rects, alignment, 1024, width, height, alignment));
+            Assert::AreEqual(0u, width % alignment);
+            Assert::AreEqual(0u, height % alignment);
+
+            for (const AtlasRect& rect : rects)
+            {
+                Assert::AreEqual(0u, rect.x % alignment);
+                Assert::AreEqual(0u, rect.y % alignment);
+            }
+        }
+
+        TEST_METHOD(PaddingRepeatsTheEdges)
+        {
+            hl_mdlviewer::AtlasRect rect(2, 2);
+            rect.x = 1;
+            rect.y = 1;
+
+            const uint8_t pixels[] = { 1, 2, 3, 4 };
+            std::vector<uint8_t> atlas(4 * 4, 0);
+            hl_mdlviewer::copy_to_atlas(pixels, 1, rect, 1, atlas.data(), 4);
+
+            const uint8_t expected[] = {
+                1, 1, 2, 2,
+                1, 1, 2, 2,
+                3, 3, 4, 4,
+                3, 3, 4, 4
+            };
+            for (int i = 0; i < 16; ++i)
+                Assert::AreEqual(expected[i], atlas[i]);
+        }
+    };
+}
@@ -0,0 +1,65 @@
+/** \file texture_cache.cpp
+* \brief Includes tests for the texture cache class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <filesystem>
+#include "texture_cache.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestTextureCache)
+    {
+        std::string directory_;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(CreateDirectory)
+        {
+            directory_ = (std::filesystem::temp_directory_path() / "hl_mdlviewer_texture_cache_test").string();
+            std::filesystem::remove_all(directory_);
+        }
+
+        TEST_METHOD_CLEANUP(RemoveDirectory)
+        {
+            std::filesystem::remove_all(directory_);
+        }
+
+        TEST_METHOD(StoredLevelsAreLoaded)
+        {
+            hl_mdlviewer::TextureCache cache;
+            cache.set_directory(directory_);
+
+            std::vector<hl_mdlviewer::MipLevel> levels = {
+                hl_mdlviewer::MipLevel(4, 2, 32), hl_mdlviewer::MipLevel(2, 1, 8)
+            };
+            levels[0].pixels[5] = 42;
+            levels[1].pixels[7] = 7;
+
+            Assert::IsTrue(cache.store(0x1234, levels));
+
+            std::vector<hl_mdlviewer::MipLevel> loaded;
+            Assert::IsTrue(cache.load(0x1234, loaded));
+            Assert::AreEqual(size_t(2), loaded.size());
+            Assert::AreEqual(4u, loaded[0].width);
+            Assert::AreEqual(1u, loaded[1].height);
+            Assert::IsTrue(loaded[0].pixels == levels[0].pixels);
+            Assert::IsTrue(loaded[1].pixels == levels[1].pixels);
+
+            Assert::IsFalse(cache.load(0x4321, loaded));
+        }
+
+        TEST_METHOD(DisabledCacheStoresNothing)
+        {
+            hl_mdlviewer::TextureCache cache;
+
+            std::vector<hl_mdlviewer::MipLevel> levels = { hl_mdlviewer::MipLevel(1, 1, 4) };
+            Assert::IsFalse(cache.enabled());
+            Assert::IsFalse(cache.store(1, levels));
+            Assert::IsFalse(cache.load(1, levels));
+        }
+    };
+}
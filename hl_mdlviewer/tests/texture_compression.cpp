@@ -0,0 +1,135 @@
+/** \file texture_compression.cpp
+* \brief Includes tests for the BC1 and BC3 texture compression functions.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "texture_compression.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestTextureCompression)
+    {
+    public:
+
+        TEST_METHOD(SolidBlockIsExact)
+        {
+            std::vector<uint8_t> texels(16 * 4);
+            for (size_t i = 0; i < 16; ++i)
+            {
+                texels[i * 4] = 0;
+                texels[i * 4 + 1] = 255;
+                texels[i * 4 + 2] = 255;
+                texels[i * 4 + 3] = 255;
+            }
+
+            uint8_t block[8];
+            hl_mdlviewer::encode_bc1_block(texels.data(), block);
+
+            std::vector<uint8_t> decoded = decode_bc1(block);
+            Assert::IsTrue(decoded == texels);
+        }
+
+        TEST_METHOD(TwoColorBlockIsExact)
+        {
+            // Colors that 5:6:5 bits represent exactly.
+            std::vector<uint8_t> texels(16 * 4);
+            for (size_t i = 0; i < 16; ++i)
+            {
+                const uint8_t value = (i % 3) == 0 ? 0 : 255;
+                texels[i * 4] = value;
+                texels[i * 4 + 1] = value;
+                texels[i * 4 + 2] = 0;
+                texels[i * 4 + 3] = 255;
+            }
+
+            uint8_t block[8];
+            hl_mdlviewer::encode_bc1_block(texels.data(), block);
+
+            std::vector<uint8_t> decoded = decode_bc1(block);
+            Assert::IsTrue(decoded == texels);
+        }
+
+        TEST_METHOD(MaskedTexelsKeepAnAlphaOfZero)
+        {
+            std::vector<uint8_t> texels(16 * 4, 255);
+            for (size_t i = 0; i < 16; i += 2)
+                texels[i * 4 + 3] = 0;
+
+            uint8_t block[16];
+            hl_mdlviewer::encode_bc3_block(texels.data(), block);
+
+            uint64_t indices = 0;
+            for (int i = 0; i < 6; ++i)
+                indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+
+            for (size_t i = 0; i < 16; ++i)
+            {
+                const unsigned int index = (indices >> (i * 3)) & 7;
+                const unsigned int alpha = index == 0 ? block[0] : block[1];
+                Assert::IsTrue(index < 2);
+                Assert::AreEqual(static_cast<unsigned int>(texels[i * 4 + 3]), alpha);
+            }
+
+            // The colors of the transparent texels are ignored.
+            std::vector<uint8_t> decoded = decode_bc1(block + 8);
+            Assert::AreEqual(255u, static_cast<unsigned int>(decoded[4]));
+        }
+
+        TEST_METHOD(ImagesArePaddedToWholeBlocks)
+        {
+            Assert::AreEqual(size_t(8 * 4), hl_mdlviewer::get_compressed_size(5, 7, hl_mdlviewer::TextureCompression::BC1));
+            Assert::AreEqual(size_t(16), hl_mdlviewer::get_compressed_size(1, 1, hl_mdlviewer::TextureCompression::BC3));
+
+            std::vector<uint8_t> pixels(5 * 7 * 4, 128);
+            std::vector<uint8_t> blocks(8 * 4);
+            hl_mdlviewer::ThreadPool thread_pool(2);
+            hl_mdlviewer::compress_image(pixels.data(), 5, 7, hl_mdlviewer::TextureCompression::BC1,
+                blocks.data(), &thread_pool);
+
+            for (size_t i = 0; i < 4; ++i)
+                Assert::IsTrue(std::equal(blocks.begin(), blocks.begin() + 8, blocks.begin() + i * 8));
+        }
+
+    private:
+
+        /** \brief Decode a BC1 block in four color mode to BGRA texels. */
+        static std::vector<uint8_t> decode_bc1(const uint8_t* block)
+        {
+            const uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+            const uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+
+            int palette[4][3];
+            expand(color0, palette[0]);
+            expand(color1, palette[1]);
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+
+            std::vector<uint8_t> texels(16 * 4);
+            for (size_t i = 0; i < 16; ++i)
+            {
+                const int* color = palette[(indices >> (i * 2)) & 3];
+                for (int c = 0; c < 3; ++c)
+                    texels[i * 4 + c] = static_cast<uint8_t>(color[c]);
+                texels[i * 4 + 3] = 255;
+            }
+
+            return texels;
+        }
+
+        static void expand(uint16_t value, int* color)
+        {
+            const int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+            color[0] = (b << 3) | (b >> 2);
+            color[1] = (g << 2) | (g >> 4);
+            color[2] = (r << 3) | (r >> 2);
+        }
+    };
+}
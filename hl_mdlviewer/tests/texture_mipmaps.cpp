@@ -0,0 +1,102 @@
+/** \file texture_mipmaps.cpp
+* \brief Includes tests for the mip level generation functions.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "texture_mipmaps.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestTextureMipmaps)
+    {
+    public:
+
+        TEST_METHOD(LevelsHalveAndRoundUp)
+        {
+            std::vector<uint8_t> pixels(5 * 3 * 4, 255);
+
+            std::vector<hl_mdlviewer::MipLevel> levels;
+            hl_mdlviewer::generate_mipmaps(pixels.data(), 5, 3, 4, levels);
+
+            Assert::AreEqual(size_t(4), levels.size());
+            Assert::AreEqual(3u, levels[1].width);
+            Assert::AreEqual(2u, levels[1].height);
+            Assert::AreEqual(1u, levels[3].width);
+            Assert::AreEqual(1u, levels[3].height);
+            Assert::AreEqual(2u, hl_mdlviewer::mip_level_size(5, 2));
+        }
+
+        TEST_METHOD(OpaqueTexelsAreAveraged)
+        {
+            // Two columns of 8 texels, wide enough for the vector path.
+            std::vector<uint8_t> pixels(8 * 2 * 4);
+            for (unsigned int x = 0; x < 8; ++x)
+            {
+                for (unsigned int y = 0; y < 2; ++y)
+                {
+                    uint8_t* texel = &pixels[(y * 8 + x) * 4];
+                    texel[0] = static_cast<uint8_t>(x * 10 + y);
+                    texel[1] = 100;
+                    texel[2] = static_cast<uint8_t>(x);
+                    texel[3] = 255;
+                }
+            }
+
+            std::vector<hl_mdlviewer::MipLevel> levels;
+            hl_mdlviewer::generate_mipmaps(pixels.data(), 8, 2, 2, levels);
+
+            for (unsigned int x = 0; x < 4; ++x)
+            {
+                const uint8_t* texel = &levels[1].pixels[x * 4];
+                const unsigned int blue = (x * 20 + (x * 20 + 10) + x * 20 + 1 + (x * 20 + 11) + 2) / 4;
+                Assert::AreEqual(blue, static_cast<unsigned int>(texel[0]));
+                Assert::AreEqual(100u, static_cast<unsigned int>(texel[1]));
+                Assert::AreEqual(255u, static_cast<unsigned int>(texel[3]));
+            }
+        }
+
+        TEST_METHOD(TransparentColorsDoNotBleed)
+        {
+            // A transparent magenta texel next to opaque green ones.
+            const uint8_t pixels[] = {
+                255, 0, 255, 0,     0, 200, 0, 255,
+                0, 200, 0, 255,     0, 200, 0, 255
+            };
+
+            std::vector<hl_mdlviewer::MipLevel> levels;
+            hl_mdlviewer::generate_mipmaps(pixels, 2, 2, 2, levels);
+
+            const uint8_t* texel = levels[1].pixels.data();
+            Assert::AreEqual(0u, static_cast<unsigned int>(texel[0]));
+            Assert::AreEqual(200u, static_cast<unsigned int>(texel[1]));
+            Assert::AreEqual(0u, static_cast<unsigned int>(texel[2]));
+            Assert::AreEqual(191u, static_cast<unsigned int>(texel[3]));
+        }
+
+        TEST_METHOD(PalettizedLevelsUseThePalette)
+        {
+            std::vector<uint8_t> palette(256 * 4, 0);
+            const uint8_t colors[][3] = { { 0, 0, 0 }, { 255, 255, 255 }, { 128, 128, 128 } };
+            for (int i = 0; i < 3; ++i)
+                std::copy(colors[i], colors[i] + 3, &palette[i * 4]);
+
+            // Black and white average to the gray of index 2, the mostly
+            // masked texels stay masked.
+            const uint8_t indices[] = {
+                0, 1,   255, 255,
+                1, 0,   255, 2
+            };
+
+            std::vector<hl_mdlviewer::MipLevel> levels;
+            hl_mdlviewer::generate_palettized_mipmaps(indices, 4, 2, palette.data(), 255, 2, levels);
+
+            Assert::AreEqual(size_t(2), levels.size());
+            Assert::AreEqual(2u, levels[1].width);
+            Assert::AreEqual(2u, static_cast<unsigned int>(levels[1].pixels[0]));
+            Assert::AreEqual(255u, static_cast<unsigned int>(levels[1].pixels[1]));
+        }
+    };
+}
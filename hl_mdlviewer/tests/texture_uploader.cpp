@@ -0,0 +1,152 @@
+/** \file texture_uploader.cpp
+* \brief Includes tests for the texture uploader class.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include "gltexture.h"
+#include "recording_render_backend.h"
+#include "texture_uploader.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestTextureUploader)
+    {
+        hl_mdlviewer::RecordingRenderBackend backend_;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(SetBackend)
+        {
+            hl_mdlviewer::set_render_backend(&backend_);
+        }
+
+        TEST_METHOD_CLEANUP(ResetBackend)
+        {
+            hl_mdlviewer::set_render_backend(nullptr);
+        }
+
+        TEST_METHOD(TextureIsReadyOnceUploaded)
+        {
+            hl_mdlviewer::TextureUploader uploader;
+            hl_mdlviewer::gltexture texture;
+
+            uploader.upload(texture, 4, 4, GL_RGBA, GL_BGRA, std::vector<uint8_t>(4 * 4 * 4, 7));
+            Assert::IsFalse(uploader.is_ready(texture));
+            Assert::IsTrue(uploader.has_pending_uploads());
+
+            backend_.clear();
+            update_until_done(uploader);
+
+            Assert::IsTrue(uploader.is_ready(texture));
+            Assert::AreEqual(size_t(1), count_commands("tex_image_2d"));
+            Assert::AreEqual(size_t(1), count_commands("delete_sync"));
+            Assert::AreEqual(size_t(1), count_commands("delete_buffer"));
+
+            uploader.dispose();
+            texture.delete_texture();
+        }
+
+        TEST_METHOD(FrameBudgetSpreadsTheUploads)
+        {
+            hl_mdlviewer::TextureUploader uploader(2, 16);
+            hl_mdlviewer::gltexture textures[3];
+
+            for (hl_mdlviewer::gltexture& texture : textures)
+                uploader.upload(texture, 4, 4, GL_RGBA, GL_BGRA, std::vector<uint8_t>(4 * 4 * 4, 1));
+
+            // Each texture is over the budget: one is specified per frame.
+            size_t num_specified = 0;
+            for (int i = 0; i < 1000 && uploader.has_pending_uploads(); ++i)
+            {
+                backend_.clear();
+                uploader.update();
+
+                const size_t count = count_commands("tex_image_2d");
+                Assert::IsTrue(count <= 1);
+                num_specified += count;
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            Assert::AreEqual(size_t(3), num_specified);
+
+            uploader.dispose();
+            for (hl_mdlviewer::gltexture& texture : textures)
+                texture.delete_texture();
+        }
+
+        TEST_METHOD(CancelledUploadIsDropped)
+        {
+            hl_mdlviewer::TextureUploader uploader;
+            hl_mdlviewer::gltexture texture;
+
+            uploader.upload(texture, 2, 2, GL_R8, GL_RED, std::vector<uint8_t>(2 * 2, 3));
+            uploader.update();
+            uploader.cancel(texture);
+            Assert::IsTrue(uploader.is_ready(texture));
+
+            backend_.clear();
+            update_until_done(uploader);
+
+            Assert::AreEqual(size_t(0), count_commands("tex_image_2d"));
+
+            uploader.dispose();
+            texture.delete_texture();
+        }
+
+        TEST_METHOD(FlushCompletesAllUploads)
+        {
+            hl_mdlviewer::TextureUploader uploader;
+            hl_mdlviewer::gltexture first, second;
+
+            uploader.upload(first, 2, 2, GL_RGBA, GL_BGRA, std::vector<uint8_t>(2 * 2 * 4, 5));
+            uploader.upload(second, 2, 2, GL_R8, GL_RED, std::vector<uint8_t>(2 * 2, 6));
+
+            backend_.clear();
+            uploader.flush();
+
+            Assert::IsFalse(uploader.has_pending_uploads());
+            Assert::IsTrue(uploader.is_ready(first));
+            Assert::IsTrue(uploader.is_ready(second));
+            Assert::AreEqual(size_t(2), count_commands("tex_image_2d"));
+
+            first.delete_texture();
+            second.delete_texture();
+        }
+
+    private:
+
+        /** \brief Update until the uploads are done, the workers run
+        *          in the background. */
+        void update_until_done(hl_mdlviewer::TextureUploader& uploader)
+        {
+            for (int i = 0; i < 1000 && uploader.has_pending_uploads(); ++i)
+            {
+                uploader.update();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            Assert::IsFalse(uploader.has_pending_uploads());
+        }
+
+        size_t count_commands(const std::string& name) const
+        {
+            std::istringstream stream(backend_.to_string());
+            std::string line;
+            size_t count = 0;
+            while (std::getline(stream, line))
+            {
+                if (line.compare(0, name.size() + 1, name + " ") == 0)
+                    ++count;
+            }
+
+            return count;
+        }
+    };
+}
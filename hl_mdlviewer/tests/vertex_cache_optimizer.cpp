@@ -0,0 +1,239 @@
+/** \file vertex_cache_optimizer.cpp
+* \brief Includes tests for the vertex cache optimization functions and
+* the 16-bit "indices" of the buffer builder.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include "buffer_builder.h"
+#include "vertex_cache_optimizer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestVertexCacheOptimizer)
+    {
+    public:
+
+        /** \brief A triangle rotated so that its smallest vertex comes first,
+        * which keeps its winding. */
+        using Triangle = std::array<unsigned int, 3>;
+
+        static Triangle make_triangle(unsigned int a, unsigned int b, unsigned int c)
+        {
+            if (b < a && b < c)
+                return { b, c, a };
+            if (c < a && c < b)
+                return { c, a, b };
+            return { a, b, c };
+        }
+
+        /** \brief Get the sorted triangles of a triangle list, each vertex
+        * mapped through \p vertex_ids. */
+        static std::vector<Triangle> get_triangles(const std::vector<unsigned int>& indices,
+            const std::vector<unsigned int>& vertex_ids)
+        {
+            std::vector<Triangle> triangles;
+            for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            {
+                triangles.push_back(make_triangle(vertex_ids[indices[i]],
+                    vertex_ids[indices[i + 1]], vertex_ids[indices[i + 2]]));
+            }
+
+            std::sort(triangles.begin(), triangles.end());
+            return triangles;
+        }
+
+        /** \brief Make a grid of \p size by \p size vertices, each with its
+        * index in "position.x". */
+        static void make_grid(unsigned int size,
+            std::vector<hl_mdlviewer::glvertex>& vertices,
+            std::vector<unsigned int>& indices)
+        {
+            vertices.resize(size * size);
+            for (unsigned int i = 0; i < vertices.size(); ++i)
+            {
+                vertices[i].position = glm::vec3(static_cast<float>(i), 0.0f, 0.0f);
+                vertices[i].normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                vertices[i].uv = glm::vec2(0.0f);
+                vertices[i].boneid = 0;
+            }
+
+            indices.clear();
+            for (unsigned int y = 0; y + 1 < size; ++y)
+            {
+                for (unsigned int x = 0; x + 1 < size; ++x)
+                {
+                    const unsigned int i = y * size + x;
+                    const unsigned int quad[] = { i, i + 1, i + size + 1, i, i + size + 1, i + size };
+                    indices.insert(indices.end(), quad, quad + 6);
+                }
+            }
+        }
+
+        static std::vector<unsigned int> get_vertex_ids(const std::vector<hl_mdlviewer::glvertex>& vertices)
+        {
+            std::vector<unsigned int> ids(vertices.size());
+            for (size_t i = 0; i < vertices.size(); ++i)
+                ids[i] = static_cast<unsigned int>(vertices[i].position.x);
+            return ids;
+        }
+
+        /** \brief Shuffle the triangles of a triangle list, keeping each one intact. */
+        static void shuffle_triangles(std::vector<unsigned int>& indices)
+        {
+            std::vector<Triangle> triangles(indices.size() / 3);
+            std::memcpy(triangles.data(), indices.data(), indices.size() * sizeof(unsigned int));
+
+            std::mt19937 random(1234);
+            std::shuffle(triangles.begin(), triangles.end(), random);
+
+            std::memcpy(indices.data(), triangles.data(), indices.size() * sizeof(unsigned int));
+        }
+
+        TEST_METHOD(TrianglesAreReorderedWithTheirWinding)
+        {
+            std::vector<hl_mdlviewer::glvertex> vertices;
+            std::vector<unsigned int> indices;
+            make_grid(9, vertices, indices);
+            shuffle_triangles(indices);
+
+            const std::vector<unsigned int> ids = get_vertex_ids(vertices);
+            const std::vector<Triangle> expected = get_triangles(indices, ids);
+
+            std::vector<unsigned int> optimized(indices);
+            hl_mdlviewer::optimize_vertex_cache(optimized, vertices.size());
+            Assert::AreEqual(indices.size(), optimized.size());
+            Assert::IsTrue(get_triangles(optimized, ids) == expected);
+
+            // Moving the vertices keeps the same triangles.
+            hl_mdlviewer::optimize_vertex_fetch(vertices, optimized);
+            Assert::AreEqual(size_t(81), vertices.size());
+            Assert::IsTrue(get_triangles(optimized, get_vertex_ids(vertices)) == expected);
+
+            // Vertices are then read in order.
+            unsigned int next_vertex = 0;
+            for (unsigned int index : optimized)
+            {
+                Assert::IsTrue(index <= next_vertex);
+                if (index == next_vertex)
+                    ++next_vertex;
+            }
+        }
+
+        TEST_METHOD(UnreferencedVerticesAreMovedToTheEnd)
+        {
+            std::vector<hl_mdlviewer::glvertex> vertices;
+            std::vector<unsigned int> indices;
+            make_grid(3, vertices, indices);
+
+            // Only the two triangles of the last quad.
+            indices.erase(indices.begin(), indices.end() - 6);
+
+            hl_mdlviewer::optimize_vertex_fetch(vertices, indices);
+            Assert::AreEqual(size_t(9), vertices.size());
+            for (unsigned int index : indices)
+                Assert::IsTrue(index < 4);
+
+            const std::vector<unsigned int> ids = get_vertex_ids(vertices);
+            std::vector<unsigned int> sorted_ids(ids);
+            std::sort(sorted_ids.begin(), sorted_ids.end());
+            for (unsigned int i = 0; i < 9; ++i)
+                Assert::AreEqual(i, sorted_ids[i]);
+        }
+
+        TEST_METHOD(CacheMissesDoNotIncreaseOnAGrid)
+        {
+            std::vector<hl_mdlviewer::glvertex> vertices;
+            std::vector<unsigned int> indices;
+            make_grid(33, vertices, indices);
+
+            // Rows of 32 quads already suit the cache fairly well.
+            std::vector<unsigned int> optimized(indices);
+            hl_mdlviewer::optimize_vertex_cache(optimized, vertices.size());
+            Assert::IsTrue(hl_mdlviewer::count_vertex_cache_misses(optimized) <=
+                hl_mdlviewer::count_vertex_cache_misses(indices));
+
+            // Shuffled, nearly every vertex is a miss before.
+            shuffle_triangles(indices);
+            const size_t misses_before = hl_mdlviewer::count_vertex_cache_misses(indices);
+
+            optimized = indices;
+            hl_mdlviewer::optimize_vertex_cache(optimized, vertices.size());
+            const size_t misses_after = hl_mdlviewer::count_vertex_cache_misses(optimized);
+
+            Assert::IsTrue(misses_after < misses_before);
+
+            // A grid can't do better than 0.5 misses per triangle, and
+            // should stay well under one.
+            const size_t num_triangles = indices.size() / 3;
+            Assert::IsTrue(misses_after >= num_triangles / 2);
+            Assert::IsTrue(misses_after < num_triangles);
+        }
+
+        TEST_METHOD(ShortIndicesAreRelativeToTheBaseVertex)
+        {
+            hl_mdlviewer::BufferBuilder buffer_builder;
+            buffer_builder.set_optimize_meshes(true);
+
+            // A first stride moves the second away from vertex 0.
+            std::vector<hl_mdlviewer::glvertex> vertices;
+            std::vector<unsigned int> indices;
+            make_grid(2, vertices, indices);
+
+            hl_mdlviewer::MeshBufferStride first_stride;
+            buffer_builder.append(vertices, indices, hl_mdlviewer::PRIMITIVE_RESTART_INDEX, first_stride);
+
+            // Three triangles, an odd number of "indices".
+            make_grid(3, vertices, indices);
+            indices.resize(9);
+
+            hl_mdlviewer::MeshBufferStride stride;
+            buffer_builder.append_triangles(vertices, indices, stride);
+
+            Assert::AreEqual(static_cast<int>(sizeof(unsigned short)), stride.index_size);
+            Assert::AreEqual(4, stride.vertex_start_index);
+            Assert::AreEqual(stride.vertex_start_index, stride.base_vertex);
+            Assert::AreEqual(9, stride.num_indices);
+            Assert::AreEqual(size_t(6) * sizeof(unsigned int), stride.index_offset);
+
+            // The 16-bit "indices" are packed two per element in memory order.
+            const std::vector<unsigned int>& buffer_indices = buffer_builder.get_indices();
+            Assert::AreEqual(size_t(6 + 5), buffer_indices.size());
+
+            std::vector<unsigned short> short_indices(10);
+            std::memcpy(short_indices.data(), &buffer_indices[6], 5 * sizeof(unsigned int));
+            Assert::IsTrue(short_indices[9] == 0);
+
+            const std::vector<hl_mdlviewer::glvertex>& buffer_vertices = buffer_builder.get_vertices();
+            std::vector<unsigned int> ids;
+            for (int i = 0; i < stride.num_vertices; ++i)
+                ids.push_back(static_cast<unsigned int>(buffer_vertices[stride.base_vertex + i].position.x));
+
+            std::vector<unsigned int> unpacked(short_indices.begin(), short_indices.begin() + 9);
+            Assert::IsTrue(get_triangles(unpacked, ids) == get_triangles(indices, get_vertex_ids(vertices)));
+
+            // Reading the stride back gives the same triangles.
+            std::vector<hl_mdlviewer::glvertex> read_vertices;
+            std::vector<unsigned int> read_indices;
+            buffer_builder.get_triangles(stride, read_vertices, read_indices);
+            Assert::IsTrue(read_indices == unpacked);
+
+            // The next stride starts on the next element.
+            hl_mdlviewer::MeshBufferStride next_stride;
+            buffer_builder.append_triangles(vertices, indices, next_stride);
+            Assert::AreEqual(size_t(11) * sizeof(unsigned int), next_stride.index_offset);
+            Assert::AreEqual(stride.vertex_start_index + stride.num_vertices, next_stride.base_vertex);
+
+            const hl_mdlviewer::BufferBuilderStatistics& statistics = buffer_builder.statistics();
+            Assert::AreEqual(size_t(2), statistics.num_strides);
+            Assert::AreEqual(size_t(2), statistics.num_short_strides);
+            Assert::AreEqual(size_t(6), statistics.num_triangles);
+        }
+    };
+}
@@ -0,0 +1,155 @@
+/** \file wav_file.cpp
+* \brief Includes tests for the WAV file functions and the WAV sound device.
+*/
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "file_system.h"
+#include "mapped_file.h"
+#include "sound_device.h"
+#include "sound_system_mixer.h"
+#include "wav_file.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest1
+{
+    TEST_CLASS(TestWavFile)
+    {
+        std::string directory_;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(CreateDirectory)
+        {
+            directory_ = (std::filesystem::temp_directory_path() / "hl_mdlviewer_wav_file_test").string();
+            std::filesystem::remove_all(directory_);
+            std::filesystem::create_directories(directory_);
+        }
+
+        TEST_METHOD_CLEANUP(RemoveDirectory)
+        {
+            std::filesystem::remove_all(directory_);
+        }
+
+        TEST_METHOD(EightBitSamplesAreDecoded)
+        {
+            // An 8-bit mono file, with a cue chunk of an odd size.
+            std::string file("RIFF\0\0\0\0WAVE", 12);
+            append_chunk(file, "fmt ", std::string("\1\0\1\0\x11\x2b\0\0\x11\x2b\0\0\1\0\x08\0", 16));
+            append_chunk(file, "cue ", std::string("\0", 1));
+            append_chunk(file, "data", std::string("\x80\xff\0", 3));
+
+            hl_mdlviewer::PcmSound sound;
+            Assert::IsTrue(hl_mdlviewer::decode_wav(
+                reinterpret_cast<const uint8_t*>(file.data()), file.size(), sound));
+            Assert::AreEqual(11025u, sound.sample_rate);
+            Assert::AreEqual(size_t(3), sound.num_frames());
+            Assert::AreEqual(int16_t(0), sound.samples[0]);
+            Assert::AreEqual(int16_t(127 << 8), sound.samples[1]);
+            Assert::AreEqual(int16_t(-32768), sound.samples[2]);
+        }
+
+        TEST_METHOD(InvalidFilesAreRejected)
+        {
+            hl_mdlviewer::PcmSound sound;
+            const std::string file("RIFF\0\0\0\0WAVEdata\0\0\0\0", 20);
+            Assert::IsFalse(hl_mdlviewer::decode_wav(
+                reinterpret_cast<const uint8_t*>(file.data()), file.size(), sound));
+            Assert::IsFalse(hl_mdlviewer::decode_wav(
+                reinterpret_cast<const uint8_t*>(file.data()), 4, sound));
+        }
+
+        TEST_METHOD(WrittenFramesAreDecoded)
+        {
+            const std::string file_path = directory_ + "/mix.wav";
+            const std::vector<int16_t> frames = { 1, -1, 1000, -1000, 32767, -32768 };
+
+            {
+                hl_mdlviewer::WavFileSoundDevice device(file_path, 22050, false);
+                device.write(frames.data(), 2);
+                device.write(frames.data() + 4, 1);
+                Assert::AreEqual(size_t(3), device.num_frames_written());
+            }
+
+            hl_mdlviewer::MappedFile file(file_path);
+            hl_mdlviewer::PcmSound sound;
+            Assert::IsTrue(hl_mdlviewer::decode_wav(file.data(), file.size(), sound));
+            Assert::AreEqual(22050u, sound.sample_rate);
+            Assert::AreEqual(uint16_t(2), sound.num_channels);
+            Assert::IsTrue(sound.samples == frames);
+        }
+
+        TEST_METHOD(PrecachedSoundsAreDecodedOnce)
+        {
+            write_sound(directory_ + "/Step.wav", { 1, 2, 3 });
+
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_search_path(directory_.c_str());
+
+            hl_mdlviewer::SoundSystemImplMixer sound_system(std::unique_ptr<hl_mdlviewer::SoundDevice>(
+                new hl_mdlviewer::NullSoundDevice(hl_mdlviewer::SOUND_MIXER_SAMPLE_RATE)));
+
+            const hl_mdlviewer::SoundHandle step = sound_system.precache_sound("step.wav", &file_system);
+            Assert::AreEqual(step, sound_system.precache_sound("STEP.WAV", &file_system));
+            Assert::AreEqual(size_t(1), sound_system.num_cached_sounds());
+
+            // Missing sounds get a handle too, that plays nothing.
+            const hl_mdlviewer::SoundHandle missing = sound_system.precache_sound("missing.wav", &file_system);
+            Assert::AreNotEqual(step, missing);
+            Assert::AreEqual(size_t(2), sound_system.num_cached_sounds());
+
+            sound_system.wait_for_precache();
+            sound_system.play_sound(step);
+            sound_system.play_sound(missing);
+            sound_system.play_sound(hl_mdlviewer::INVALID_SOUND_HANDLE);
+            Assert::AreEqual(size_t(0), sound_system.num_skipped_plays());
+        }
+
+        TEST_METHOD(MissingSoundsAreReadOnceAdded)
+        {
+            hl_mdlviewer::FileSystem file_system;
+            file_system.add_search_path(directory_.c_str());
+
+            hl_mdlviewer::SoundSystemImplMixer sound_system(std::unique_ptr<hl_mdlviewer::SoundDevice>(
+                new hl_mdlviewer::NullSoundDevice(hl_mdlviewer::SOUND_MIXER_SAMPLE_RATE)));
+
+            const hl_mdlviewer::SoundHandle handle = sound_system.precache_sound("late.wav", &file_system);
+            sound_system.wait_for_precache();
+            Assert::IsFalse(sound_system.has_sound(handle));
+
+            write_sound(directory_ + "/Late.wav", { 1, 2, 3 });
+            file_system.invalidate();
+
+            // The same handle, now with the sound.
+            Assert::AreEqual(handle, sound_system.precache_sound("late.wav", &file_system));
+            sound_system.wait_for_precache();
+            Assert::IsTrue(sound_system.has_sound(handle));
+            Assert::AreEqual(size_t(1), sound_system.num_cached_sounds());
+        }
+
+    private:
+
+        static void append_chunk(std::string& file, const char* id, const std::string& data)
+        {
+            const uint32_t size = static_cast<uint32_t>(data.size());
+            file.append(id, 4);
+            file.append(reinterpret_cast<const char*>(&size), sizeof(size));
+            file += data;
+            if (size & 1)
+                file += '\0';
+        }
+
+        static void write_sound(const std::string& file_path, const std::vector<int16_t>& samples)
+        {
+            std::ofstream file(file_path, std::ios::binary);
+            hl_mdlviewer::write_wav_header(file, 22050, 1,
+                static_cast<uint32_t>(samples.size() * sizeof(int16_t)));
+            file.write(reinterpret_cast<const char*>(samples.data()),
+                static_cast<std::streamsize>(samples.size() * sizeof(int16_t)));
+        }
+    };
+}